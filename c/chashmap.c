@@ -0,0 +1,450 @@
+/************************************************************************************
+* chashmap.c: Implementation File
+*
+* open addressing hash map
+*
+* DESCRIPTION:
+*   Swiss table like: slots in groups of 15 under 16 control bytes, a
+*   probe checks a whole group with one SSE2 compare. Fixed size keys and
+*   values live flat in the slots, hashed with murmurhash3_32.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   no tombstones: an insert that passes a full group sets the overflow
+*   bit of its hash class there, a lookup goes on past a group only if
+*   that bit is set. Erase just empties the slot, overflow bits are
+*   cleared when the map is rebuilt: on growth, or at the same size once
+*   erases since the last rebuild pass half of max_count, so a map kept
+*   at a fixed size under churn does not fill up with stale bits.
+*   not thread safe.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <chashmap.h>
+#include <murmurhash.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define _ctrl_group_size_               16
+#define _ctrl_overflow_idx_             15
+#define _ctrl_empty_                    0x00
+#define _group_slot_mask_               0x7fff
+
+#define _tag(hash)                      ((uint8_t)(0x80 | ((hash) & 0x7f)))
+#define _home(hash)                     ((int64_t)((hash) >> 7))
+#define _overflow_bit(hash)             ((uint8_t)(1u << ((hash) >> 29)))
+
+// 7/8 of the slots at most
+#define _max_count(groups)              ((groups) * CHASHMAP_GROUP_SLOTS * 7 / 8)
+
+#define _entry_at(map, slot)            ((map)->entries + (slot) * (map)->entry_size)
+#define _ctrl_at(map, slot)             ((map)->ctrl + ((slot) / CHASHMAP_GROUP_SLOTS) * _ctrl_group_size_ + ((slot) % CHASHMAP_GROUP_SLOTS))
+
+//====================================================================
+// group probes, bit i for slot i
+#if defined(__SSE2__)
+static inline uint32_t _group_match(const uint8_t *ctrl, uint8_t tag)
+{
+    __m128i c = _mm_load_si128((const __m128i*)ctrl);
+
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_set1_epi8((char)tag))) & _group_slot_mask_;
+}
+
+static inline uint32_t _group_empty(const uint8_t *ctrl)
+{
+    __m128i c = _mm_load_si128((const __m128i*)ctrl);
+
+    return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(c, _mm_setzero_si128())) & _group_slot_mask_;
+}
+
+static inline uint32_t _group_full(const uint8_t *ctrl)
+{
+    // tags have the top bit set
+    return (uint32_t)_mm_movemask_epi8(_mm_load_si128((const __m128i*)ctrl)) & _group_slot_mask_;
+}
+#else
+static inline uint32_t _group_match(const uint8_t *ctrl, uint8_t tag)
+{
+    uint32_t m = 0;
+    int i = 0;
+
+    for (i = 0; i < CHASHMAP_GROUP_SLOTS; i++) {
+        m |= (uint32_t)(ctrl[i] == tag) << i;
+    }
+
+    return m;
+}
+
+static inline uint32_t _group_empty(const uint8_t *ctrl)
+{
+    return _group_match(ctrl, _ctrl_empty_);
+}
+
+static inline uint32_t _group_full(const uint8_t *ctrl)
+{
+    return ~_group_empty(ctrl) & _group_slot_mask_;
+}
+#endif
+
+//====================================================================
+// hashing
+static uint32_t _hash_bytes(const void *key, size_t key_size, uint32_t seed)
+{
+    switch (key_size) {
+        case 4: {
+            uint32_t k = 0;
+            memcpy(&k, key, 4);
+            return murmurhash3_32_u32(k, seed);
+        }
+        case 8: {
+            uint64_t k = 0;
+            memcpy(&k, key, 8);
+            return murmurhash3_32_u64(k, seed);
+        }
+        case 16:
+            return murmurhash3_32_128bit(key, seed);
+        default:
+            return murmurhash3_32(key, key_size, seed);
+    }
+}
+
+static inline int _key_equal(const chashmap_t *map, const void *a, const void *b)
+{
+    if (map->type.equal) {
+        return map->type.equal(a, b, map->type.key_size);
+    }
+
+    return memcmp(a, b, map->type.key_size) == 0;
+}
+
+uint32_t chashmap_hash(const chashmap_t *map, const void *key)
+{
+    if (map->type.hash) {
+        return map->type.hash(key, map->type.key_size, map->seed);
+    }
+
+    return _hash_bytes(key, map->type.key_size, map->seed);
+}
+
+//====================================================================
+// table
+static int64_t _groups_for(int64_t capacity)
+{
+    int64_t groups = 1;
+
+    while (_max_count(groups) < capacity) {
+        groups *= 2;
+    }
+
+    return groups;
+}
+
+// ctrl, hashes & entries in one block
+static int _table_alloc(chashmap_t *map, int64_t groups)
+{
+    size_t slots = (size_t)groups * CHASHMAP_GROUP_SLOTS;
+    size_t ctrl_size = (size_t)groups * _ctrl_group_size_;
+    size_t hash_size = (slots * sizeof(uint32_t) + 15) & ~(size_t)15;
+    uint8_t *block = NULL;
+
+    block = (uint8_t*)malloc(ctrl_size + hash_size + slots * map->entry_size);
+    if (block == NULL) {
+        return -1;
+    }
+    memset(block, 0, ctrl_size);
+
+    map->ctrl = block;
+    map->hashes = (uint32_t*)(block + ctrl_size);
+    map->entries = block + ctrl_size + hash_size;
+    map->group_mask = groups - 1;
+    map->max_count = _max_count(groups);
+    map->erased = 0;
+    map->overflow_groups = 0;
+
+    return 0;
+}
+
+// a free slot for hash, marks the full groups on the way
+static int64_t _table_place(chashmap_t *map, uint32_t hash)
+{
+    int64_t g = _home(hash) & map->group_mask;
+    int64_t step = 0;
+    uint8_t *ctrl = NULL;
+    uint32_t m = 0;
+
+    for (;;) {
+        ctrl = map->ctrl + g * _ctrl_group_size_;
+        m = _group_empty(ctrl);
+        if (m) {
+            return g * CHASHMAP_GROUP_SLOTS + __builtin_ctz(m);
+        }
+
+        map->overflow_groups += (ctrl[_ctrl_overflow_idx_] == 0);
+        ctrl[_ctrl_overflow_idx_] |= _overflow_bit(hash);
+        step++;
+        g = (g + step) & map->group_mask; // triangular, visits every group
+    }
+}
+
+static void _table_set(chashmap_t *map, int64_t slot, uint32_t hash)
+{
+    *_ctrl_at(map, slot) = _tag(hash);
+    map->hashes[slot] = hash;
+}
+
+static int _table_rebuild(chashmap_t *map, int64_t groups)
+{
+    chashmap_t old = *map;
+    int64_t slots = (old.group_mask + 1) * CHASHMAP_GROUP_SLOTS;
+    int64_t i = 0;
+    int64_t slot = 0;
+
+    if (_table_alloc(map, groups) < 0) {
+        *map = old;
+        return -1;
+    }
+
+    for (i = 0; i < slots; i++) {
+        if (*_ctrl_at(&old, i) == _ctrl_empty_) {
+            continue;
+        }
+        slot = _table_place(map, old.hashes[i]);
+        _table_set(map, slot, old.hashes[i]);
+        memcpy(_entry_at(map, slot), _entry_at(&old, i), map->entry_size);
+    }
+
+    free(old.ctrl);
+
+    return 0;
+}
+
+static void* _table_lookup(const chashmap_t *map, uint32_t hash, const void *key, pfn_chashmap_match_t match, void *ctx)
+{
+    int64_t g = _home(hash) & map->group_mask;
+    int64_t step = 0;
+    int64_t slot = 0;
+    const uint8_t *ctrl = NULL;
+    uint8_t tag = _tag(hash);
+    uint32_t m = 0;
+    void *e = NULL;
+
+    for (;;) {
+        ctrl = map->ctrl + g * _ctrl_group_size_;
+        for (m = _group_match(ctrl, tag); m; m &= m - 1) {
+            slot = g * CHASHMAP_GROUP_SLOTS + __builtin_ctz(m);
+            if (map->hashes[slot] != hash) {
+                continue;
+            }
+            e = _entry_at(map, slot);
+            if (match ? match(ctx, key, e) : _key_equal(map, key, e)) {
+                return e;
+            }
+        }
+
+        // nothing of this hash class went on past this group
+        if ((ctrl[_ctrl_overflow_idx_] & _overflow_bit(hash)) == 0 || step >= map->group_mask) {
+            return NULL;
+        }
+        step++;
+        g = (g + step) & map->group_mask;
+    }
+}
+
+//====================================================================
+// map
+chashmap_t* chashmap_create(const chashmap_type_t *type, int64_t capacity)
+{
+    chashmap_t *map = NULL;
+
+    if (type == NULL || type->key_size == 0) {
+        return NULL;
+    }
+
+    map = (chashmap_t*)malloc(sizeof(chashmap_t));
+    if (map == NULL) {
+        return NULL;
+    }
+    memset(map, 0, sizeof(chashmap_t));
+
+    map->type = *type;
+    map->seed = CHASHMAP_SEED;
+    // values 8 bytes aligned if the key leaves them so
+    map->val_off = (type->val_size >= 8 && (type->key_size & 7) != 0) ? ((type->key_size + 7) & ~(size_t)7) : type->key_size;
+    map->entry_size = map->val_off + type->val_size;
+
+    if (_table_alloc(map, _groups_for(capacity)) < 0) {
+        free(map);
+        return NULL;
+    }
+
+    return map;
+}
+
+void chashmap_free(chashmap_t *map)
+{
+    if (map == NULL) {
+        return;
+    }
+
+    free(map->ctrl);
+    free(map);
+}
+
+void chashmap_clear(chashmap_t *map)
+{
+    memset(map->ctrl, 0, (map->group_mask + 1) * _ctrl_group_size_);
+    map->count = 0;
+    map->erased = 0;
+    map->overflow_groups = 0;
+}
+
+int chashmap_reserve(chashmap_t *map, int64_t capacity)
+{
+    int64_t groups = _groups_for(capacity);
+
+    if (groups <= map->group_mask + 1) {
+        return 0;
+    }
+
+    return _table_rebuild(map, groups);
+}
+
+size_t chashmap_memory(const chashmap_t *map)
+{
+    size_t slots = (size_t)(map->group_mask + 1) * CHASHMAP_GROUP_SLOTS;
+
+    return sizeof(chashmap_t) + (size_t)(map->group_mask + 1) * _ctrl_group_size_
+        + ((slots * sizeof(uint32_t) + 15) & ~(size_t)15) + slots * map->entry_size;
+}
+
+int64_t chashmap_count(const chashmap_t *map)
+{
+    return map->count;
+}
+
+void* chashmap_find(const chashmap_t *map, const void *key)
+{
+    return _table_lookup(map, chashmap_hash(map, key), key, NULL, NULL);
+}
+
+void* chashmap_find_h(const chashmap_t *map, const void *key, uint32_t hash)
+{
+    return _table_lookup(map, hash, key, NULL, NULL);
+}
+
+void* chashmap_find_with(const chashmap_t *map, uint32_t hash, pfn_chashmap_match_t match, void *ctx, const void *probe)
+{
+    return _table_lookup(map, hash, probe, match, ctx);
+}
+
+void* chashmap_insert(chashmap_t *map, const void *key, const void *val, int *inserted)
+{
+    return chashmap_insert_h(map, key, chashmap_hash(map, key), val, inserted);
+}
+
+void* chashmap_insert_h(chashmap_t *map, const void *key, uint32_t hash, const void *val, int *inserted)
+{
+    int64_t slot = 0;
+    uint8_t *e = NULL;
+
+    e = (uint8_t*)_table_lookup(map, hash, key, NULL, NULL);
+    if (e) {
+        if (inserted) {
+            *inserted = 0;
+        }
+        return e;
+    }
+
+    if (map->count >= map->max_count) {
+        if (_table_rebuild(map, (map->group_mask + 1) * 2) < 0) {
+            return NULL;
+        }
+    } else if (map->overflow_groups && map->erased > map->max_count / 2) {
+        // stale overflow bits, same size; the old table still works if it fails
+        _table_rebuild(map, map->group_mask + 1);
+    }
+
+    slot = _table_place(map, hash);
+    _table_set(map, slot, hash);
+
+    e = _entry_at(map, slot);
+    memcpy(e, key, map->type.key_size);
+    if (val) {
+        memcpy(e + map->val_off, val, map->type.val_size);
+    } else {
+        memset(e + map->val_off, 0, map->type.val_size);
+    }
+    map->count++;
+
+    if (inserted) {
+        *inserted = 1;
+    }
+
+    return e;
+}
+
+int chashmap_erase(chashmap_t *map, const void *key)
+{
+    return chashmap_erase_h(map, key, chashmap_hash(map, key));
+}
+
+int chashmap_erase_h(chashmap_t *map, const void *key, uint32_t hash)
+{
+    void *e = _table_lookup(map, hash, key, NULL, NULL);
+
+    if (e == NULL) {
+        return -1;
+    }
+
+    chashmap_erase_entry(map, e);
+
+    return 0;
+}
+
+void chashmap_erase_entry(chashmap_t *map, void *entry)
+{
+    int64_t slot = ((uint8_t*)entry - map->entries) / map->entry_size;
+
+    *_ctrl_at(map, slot) = _ctrl_empty_;
+    map->count--;
+    map->erased++;
+}
+
+//====================================================================
+// iteration, a group at a time
+static void* _table_scan(const chashmap_t *map, int64_t *pos, int64_t slot)
+{
+    int64_t g = slot / CHASHMAP_GROUP_SLOTS;
+    uint32_t m = 0;
+
+    // slots of the first group before slot are done
+    m = _group_full(map->ctrl + g * _ctrl_group_size_) & ~((1u << (slot % CHASHMAP_GROUP_SLOTS)) - 1);
+    for (;;) {
+        if (m) {
+            *pos = g * CHASHMAP_GROUP_SLOTS + __builtin_ctz(m);
+            return _entry_at(map, *pos);
+        }
+        if (++g > map->group_mask) {
+            return NULL;
+        }
+        m = _group_full(map->ctrl + g * _ctrl_group_size_);
+    }
+}
+
+void* chashmap_first(const chashmap_t *map, int64_t *pos)
+{
+    return _table_scan(map, pos, 0);
+}
+
+void* chashmap_next(const chashmap_t *map, int64_t *pos)
+{
+    return _table_scan(map, pos, *pos + 1);
+}
@@ -0,0 +1,125 @@
+/************************************************************************************
+* chashmap.h : header file
+*
+* Open addressing hash map Definition header
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+* Copyright (c) 2026. All Rights Reserved.
+*
+* This code may be used in compiled form in any way you desire. This
+* file may be redistributed unmodified by any means PROVIDING it is
+* not sold for profit without the authors written consent, and
+* providing that this notice and the authors name and all copyright
+* notices remains intact.
+*
+* An email letting me know how you are using it would be nice as well.
+*
+* This file is provided "as is" with no expressed or implied warranty.
+* The author accepts no liability for any damage/loss of business that
+* this product may cause.
+*
+************************************************************************************/
+
+#if !defined(__CHASHMAP_H__)
+#define __CHASHMAP_H__
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/********************************************************************
+*        Macros
+*********************************************************************/
+// a group is 16 control bytes: 15 slot tags & 1 overflow byte
+#define CHASHMAP_GROUP_SLOTS            15
+#define CHASHMAP_SEED                   0x9747b28c
+
+/********************************************************************
+*        Data Types
+*********************************************************************/
+// hash of key_size bytes at key, NULL for murmurhash3_32 of the bytes
+typedef uint32_t (*pfn_chashmap_hash_t)(const void *key, size_t key_size, uint32_t seed);
+// 1 if the keys are equal, NULL for memcmp() of the bytes
+typedef int (*pfn_chashmap_equal_t)(const void *a, const void *b, size_t key_size);
+// 1 if key, an entry's key, is what probe stands for
+typedef int (*pfn_chashmap_match_t)(void *ctx, const void *probe, const void *key);
+
+struct _chashmap_type_t {
+    size_t                  key_size;   // bytes
+    size_t                  val_size;   // bytes, 0 for a set
+    pfn_chashmap_hash_t     hash;
+    pfn_chashmap_equal_t    equal;
+};
+typedef struct _chashmap_type_t         chashmap_type_t;
+
+// Swiss table like layout, one block:
+//   ctrl    : 16 bytes per group, tag (0x80 | 7 bits of hash) or 0 for empty,
+//             byte 15 has a bit set for every hash class that moved on
+//             past the full group, lookups stop at a group without it
+//   hashes  : 32-bit hash per slot, rehash never calls the hash function
+//   entries : key, value, per slot
+// erase empties the slot, there are no tombstones; the overflow bits it
+// leaves behind go when an insert rebuilds the table
+struct _chashmap_t {
+    uint8_t                 *ctrl;
+    uint32_t                *hashes;
+    uint8_t                 *entries;
+    int64_t                 group_mask; // groups - 1, groups is a power of 2
+    int64_t                 count;
+    int64_t                 max_count;  // grows beyond this
+    int64_t                 erased;     // since the last rebuild
+    int64_t                 overflow_groups; // with an overflow bit set
+    size_t                  entry_size;
+    size_t                  val_off;    // in the entry
+    uint32_t                seed;
+    chashmap_type_t         type;
+};
+typedef struct _chashmap_t              chashmap_t;
+
+// entry => key & value
+#define chashmap_entry_key(map, e)      ((void*)(e))
+#define chashmap_entry_val(map, e)      ((void*)((uint8_t*)(e) + (map)->val_off))
+
+/********************************************************************
+*        Functions
+*********************************************************************/
+// room for capacity entries without growing
+chashmap_t* chashmap_create(const chashmap_type_t *type, int64_t capacity);
+void chashmap_free(chashmap_t *map);
+void chashmap_clear(chashmap_t *map);
+int chashmap_reserve(chashmap_t *map, int64_t capacity);
+int64_t chashmap_count(const chashmap_t *map);
+uint32_t chashmap_hash(const chashmap_t *map, const void *key);
+// bytes of the map & its table
+size_t chashmap_memory(const chashmap_t *map);
+
+// entry of key, or NULL
+void* chashmap_find(const chashmap_t *map, const void *key);
+void* chashmap_find_h(const chashmap_t *map, const void *key, uint32_t hash);
+// entry with hash that match() accepts, for keys kept outside the map
+void* chashmap_find_with(const chashmap_t *map, uint32_t hash, pfn_chashmap_match_t match, void *ctx, const void *probe);
+
+// entry of key, a new one with val (zeros if NULL) if there was none,
+// *inserted tells which, may be NULL. Entries move when the map grows
+// or is rebuilt.
+void* chashmap_insert(chashmap_t *map, const void *key, const void *val, int *inserted);
+void* chashmap_insert_h(chashmap_t *map, const void *key, uint32_t hash, const void *val, int *inserted);
+
+// 0 if erased, -1 if there was no such key
+int chashmap_erase(chashmap_t *map, const void *key);
+int chashmap_erase_h(chashmap_t *map, const void *key, uint32_t hash);
+void chashmap_erase_entry(chashmap_t *map, void *entry);
+
+// entries in slot order, pos is the slot
+void* chashmap_first(const chashmap_t *map, int64_t *pos);
+void* chashmap_next(const chashmap_t *map, int64_t *pos);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /*__CHASHMAP_H__*/
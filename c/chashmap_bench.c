@@ -0,0 +1,378 @@
+/************************************************************************************
+* chashmap_bench.c: Implementation File
+*
+* chashmap against a chained hash map
+*
+* DESCRIPTION:
+*   insert, hit, miss, iterate & erase, ns per operation, for 8 byte
+*   integer keys & string keys, 1K to 1M entries. The chained map is the
+*   usual bucket array of malloc'ed nodes, with the same hash, so the
+*   difference is the layout.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   one JSON line per result on stdout.
+*   usage: chashmap_bench [max entries]
+*
+************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <chashmap.h>
+#include <murmurhash.h>
+
+//gcc -O2 -I. chashmap_bench.c chashmap.c murmurhash.c -o chashmap_bench
+
+#define _str_key_len_               24
+
+static volatile uint64_t _sink = 0; // keeps the timed lookups
+
+static uint64_t _now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t _rnd_state = 0x2545f4914f6cdd1dull;
+
+static uint64_t _rnd(void)
+{
+    // xorshift64*, fixed sequence
+    _rnd_state ^= _rnd_state >> 12;
+    _rnd_state ^= _rnd_state << 25;
+    _rnd_state ^= _rnd_state >> 27;
+
+    return _rnd_state * 0x2545f4914f6cdd1dull;
+}
+
+//===================================================================
+// keys: u64 by value, strings by pointer
+struct __bench_keys_t {
+    const char      *name;
+    size_t          key_size;   // bytes in the map
+    int64_t         count;
+    uint8_t         *keys;      // count keys, then count keys not inserted
+    char            *strs;      // string keys
+};
+typedef struct __bench_keys_t       _bench_keys_t;
+
+static uint32_t _str_hash(const void *key, size_t key_size, uint32_t seed)
+{
+    const char *s = *(const char* const*)key;
+
+    (void)key_size;
+
+    return murmurhash3_32(s, strlen(s), seed);
+}
+
+static int _str_equal(const void *a, const void *b, size_t key_size)
+{
+    (void)key_size;
+
+    return strcmp(*(const char* const*)a, *(const char* const*)b) == 0;
+}
+
+static void _keys_make(_bench_keys_t *k, int str, int64_t count)
+{
+    int64_t i = 0;
+    uint64_t u = 0;
+    char *s = NULL;
+
+    k->name = str ? "str" : "u64";
+    k->key_size = str ? sizeof(char*) : sizeof(uint64_t);
+    k->count = count;
+    k->keys = (uint8_t*)malloc(2 * count * k->key_size);
+    k->strs = str ? (char*)malloc(2 * count * _str_key_len_) : NULL;
+
+    // distinct: the low bit tells inserted keys from the missing ones
+    for (i = 0; i < 2 * count; i++) {
+        u = (_rnd() & ~1ull) | (i >= count);
+        if (str) {
+            s = k->strs + i * _str_key_len_;
+            snprintf(s, _str_key_len_, "user:%016llx", (unsigned long long)u);
+            memcpy(k->keys + i * k->key_size, &s, sizeof(char*));
+        } else {
+            memcpy(k->keys + i * k->key_size, &u, sizeof(uint64_t));
+        }
+    }
+}
+
+static void _keys_free(_bench_keys_t *k)
+{
+    free(k->keys);
+    free(k->strs);
+}
+
+#define _key_at(k, i)               ((k)->keys + (i) * (k)->key_size)
+
+//===================================================================
+// chained baseline
+struct __chain_node_t {
+    struct __chain_node_t   *next;
+    uint32_t                hash;
+    uint64_t                val;
+    uint8_t                 key[]; // key_size bytes
+};
+typedef struct __chain_node_t       _chain_node_t;
+
+struct __chain_map_t {
+    _chain_node_t   **buckets;
+    int64_t         bucket_mask;
+    int64_t         count;
+    size_t          key_size;
+    int             str;
+};
+typedef struct __chain_map_t        _chain_map_t;
+
+static uint32_t _chain_hash(const _chain_map_t *m, const void *key)
+{
+    uint64_t u = 0;
+
+    if (m->str) {
+        return _str_hash(key, m->key_size, CHASHMAP_SEED);
+    }
+    memcpy(&u, key, sizeof(uint64_t));
+
+    return murmurhash3_32_u64(u, CHASHMAP_SEED);
+}
+
+static int _chain_equal(const _chain_map_t *m, const void *a, const void *b)
+{
+    return m->str ? _str_equal(a, b, m->key_size) : memcmp(a, b, m->key_size) == 0;
+}
+
+static void _chain_grow(_chain_map_t *m)
+{
+    int64_t n = (m->bucket_mask + 1) * 2;
+    int64_t i = 0;
+    _chain_node_t **b = (_chain_node_t**)calloc(n, sizeof(_chain_node_t*));
+    _chain_node_t *node = NULL;
+    _chain_node_t *next = NULL;
+
+    for (i = 0; i <= m->bucket_mask; i++) {
+        for (node = m->buckets[i]; node; node = next) {
+            next = node->next;
+            node->next = b[node->hash & (n - 1)];
+            b[node->hash & (n - 1)] = node;
+        }
+    }
+    free(m->buckets);
+    m->buckets = b;
+    m->bucket_mask = n - 1;
+}
+
+static _chain_map_t* _chain_create(size_t key_size, int str)
+{
+    _chain_map_t *m = (_chain_map_t*)calloc(1, sizeof(_chain_map_t));
+
+    m->buckets = (_chain_node_t**)calloc(16, sizeof(_chain_node_t*));
+    m->bucket_mask = 15;
+    m->key_size = key_size;
+    m->str = str;
+
+    return m;
+}
+
+static _chain_node_t* _chain_find(const _chain_map_t *m, const void *key)
+{
+    uint32_t hash = _chain_hash(m, key);
+    _chain_node_t *node = m->buckets[hash & m->bucket_mask];
+
+    for (; node; node = node->next) {
+        if (node->hash == hash && _chain_equal(m, node->key, key)) {
+            return node;
+        }
+    }
+
+    return NULL;
+}
+
+static void _chain_insert(_chain_map_t *m, const void *key, uint64_t val)
+{
+    uint32_t hash = _chain_hash(m, key);
+    _chain_node_t *node = NULL;
+    _chain_node_t **b = NULL;
+
+    for (node = m->buckets[hash & m->bucket_mask]; node; node = node->next) {
+        if (node->hash == hash && _chain_equal(m, node->key, key)) {
+            node->val = val;
+            return;
+        }
+    }
+
+    // load factor 1
+    if (m->count > m->bucket_mask) {
+        _chain_grow(m);
+    }
+
+    node = (_chain_node_t*)malloc(sizeof(_chain_node_t) + m->key_size);
+    node->hash = hash;
+    node->val = val;
+    memcpy(node->key, key, m->key_size);
+    b = &(m->buckets[hash & m->bucket_mask]);
+    node->next = *b;
+    *b = node;
+    m->count++;
+}
+
+static void _chain_erase(_chain_map_t *m, const void *key)
+{
+    uint32_t hash = _chain_hash(m, key);
+    _chain_node_t **p = &(m->buckets[hash & m->bucket_mask]);
+    _chain_node_t *node = NULL;
+
+    for (; *p; p = &((*p)->next)) {
+        node = *p;
+        if (node->hash == hash && _chain_equal(m, node->key, key)) {
+            *p = node->next;
+            free(node);
+            m->count--;
+            return;
+        }
+    }
+}
+
+static void _chain_free(_chain_map_t *m)
+{
+    int64_t i = 0;
+    _chain_node_t *node = NULL;
+    _chain_node_t *next = NULL;
+
+    for (i = 0; i <= m->bucket_mask; i++) {
+        for (node = m->buckets[i]; node; node = next) {
+            next = node->next;
+            free(node);
+        }
+    }
+    free(m->buckets);
+    free(m);
+}
+
+//===================================================================
+static void _report(const char *map, const _bench_keys_t *k, const char *op, uint64_t ns, int64_t ops)
+{
+    printf("{\"map\": \"%s\", \"key\": \"%s\", \"n\": %lld, \"op\": \"%s\", \"ns_op\": %.2f}\n",
+        map, k->name, (long long)k->count, op, (double)ns / (double)ops);
+}
+
+static void _bench_swiss(const _bench_keys_t *k)
+{
+    chashmap_type_t type = { k->key_size, sizeof(uint64_t), NULL, NULL };
+    chashmap_t *m = NULL;
+    int64_t i = 0;
+    int64_t pos = 0;
+    uint64_t t = 0;
+    uint64_t sum = 0;
+    void *e = NULL;
+
+    if (k->strs) {
+        type.hash = _str_hash;
+        type.equal = _str_equal;
+    }
+
+    m = chashmap_create(&type, 0);
+    t = _now_ns();
+    for (i = 0; i < k->count; i++) {
+        chashmap_insert(m, _key_at(k, i), &i, NULL);
+    }
+    _report("swiss", k, "insert", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (i = 0; i < k->count; i++) {
+        e = chashmap_find(m, _key_at(k, i));
+        sum += *(uint64_t*)chashmap_entry_val(m, e);
+    }
+    _report("swiss", k, "hit", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (i = k->count; i < 2 * k->count; i++) {
+        sum += (chashmap_find(m, _key_at(k, i)) != NULL);
+    }
+    _report("swiss", k, "miss", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (e = chashmap_first(m, &pos); e; e = chashmap_next(m, &pos)) {
+        sum += *(uint64_t*)chashmap_entry_val(m, e);
+    }
+    _report("swiss", k, "iterate", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (i = 0; i < k->count; i++) {
+        chashmap_erase(m, _key_at(k, i));
+    }
+    _report("swiss", k, "erase", _now_ns() - t, k->count);
+
+    _sink += sum;
+    chashmap_free(m);
+}
+
+static void _bench_chain(const _bench_keys_t *k)
+{
+    _chain_map_t *m = _chain_create(k->key_size, k->strs != NULL);
+    _chain_node_t *node = NULL;
+    int64_t i = 0;
+    uint64_t t = 0;
+    uint64_t sum = 0;
+
+    t = _now_ns();
+    for (i = 0; i < k->count; i++) {
+        _chain_insert(m, _key_at(k, i), (uint64_t)i);
+    }
+    _report("chain", k, "insert", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (i = 0; i < k->count; i++) {
+        sum += _chain_find(m, _key_at(k, i))->val;
+    }
+    _report("chain", k, "hit", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (i = k->count; i < 2 * k->count; i++) {
+        sum += (_chain_find(m, _key_at(k, i)) != NULL);
+    }
+    _report("chain", k, "miss", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (i = 0; i <= m->bucket_mask; i++) {
+        for (node = m->buckets[i]; node; node = node->next) {
+            sum += node->val;
+        }
+    }
+    _report("chain", k, "iterate", _now_ns() - t, k->count);
+
+    t = _now_ns();
+    for (i = 0; i < k->count; i++) {
+        _chain_erase(m, _key_at(k, i));
+    }
+    _report("chain", k, "erase", _now_ns() - t, k->count);
+
+    _sink += sum;
+    _chain_free(m);
+}
+
+int main(int argc, char *arg[])
+{
+    int64_t max = (argc > 1) ? atoll(arg[1]) : (1 << 20);
+    int64_t n = 0;
+    int str = 0;
+    _bench_keys_t k;
+
+    for (n = 1024; n <= max; n *= 4) {
+        for (str = 0; str < 2; str++) {
+            _keys_make(&k, str, n);
+            _bench_swiss(&k);
+            _bench_chain(&k);
+            _keys_free(&k);
+        }
+    }
+
+    return 0;
+}
@@ -28,6 +28,8 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <stddef.h>
 
 #if defined(JEMALLOC_NO_DEMANGLE)
 #include <jemalloc/jemalloc.h>
@@ -46,15 +48,34 @@ typedef char                    tchar_t;
 *********************************************************************/
 #define CJSON_KEY_BUF_LEN               32 // bytes
 
-#define CJSON_KEY_LEN_MAX               (CJSON_KEY_BUF_LEN - 2 - 1) // 2 of quotation mark & 1 of \0
+#define CJSON_KEY_LEN_MAX               (CJSON_KEY_BUF_LEN - 2 - 1) // 1 of \0, 1 of length & 1 of long key flag
+
+// string values of up to 13 chars are kept inline in cjson_value_t,
+// longer ones in a cjson_string_t
+#define CJSON_SSTR_BUF_LEN              14 // bytes, the 8 byte payload union plus the 6 byte tail
+#define CJSON_SSTR_LEN_MAX              (CJSON_SSTR_BUF_LEN - 1) // 1 of \0
+
+// numbers are kept inline as mantissa / 10^scale
+#define CJSON_NUMBER_SCALE_MAX          18
+
+// the encoders return it when buf is too small, -1 for other errors
+#define CJSON_ENCODE_SHORT              (-2)
 
 #define _token_stack_buf_size_          64 // tchars
 
+// cjson_decode_file() flags
+#define CJSON_FILE_SEQUENTIAL           0x0001 // madvise(MADV_SEQUENTIAL)
+#define CJSON_FILE_HUGEPAGE             0x0002 // madvise(MADV_HUGEPAGE), where supported
+#define CJSON_FILE_POPULATE             0x0004 // MAP_POPULATE, fault the whole file in before parsing
+#define CJSON_FILE_PREFETCH             0x0008 // populate the mapping from a background thread while parsing
+
 #if defined(JEMALLOC_NO_DEMANGLE)
 #define my_malloc(s)                    je_malloc((s))
+#define my_realloc(p, s)                je_realloc((p), (s))
 #define my_free(p)                      je_free((p))
 #else
 #define my_malloc(s)                    malloc((s))
+#define my_realloc(p, s)                realloc((p), (s))
 #define my_free(p)                      free((p))
 #endif
 
@@ -63,6 +84,27 @@ typedef char                    tchar_t;
 *********************************************************************/
 typedef struct {}               *position_t;
 
+// allocator counters. Threads count in blocks of their own, a snapshot adds
+// them up, the stats of the allocator only hold what no block had room for
+struct _cjson_alloc_stats_t {
+    int64_t             allocs;
+    int64_t             frees;
+    int64_t             bytes;      // allocated in total
+    int64_t             live_bytes; // allocated, not freed yet
+};
+typedef struct _cjson_alloc_stats_t     cjson_alloc_stats_t;
+
+// runtime allocator
+// free() & realloc() get the size of the block, realloc() may be NULL
+struct _cjson_allocator_t {
+    void*               (*alloc)(void *ctx, size_t size);
+    void*               (*realloc)(void *ctx, void *p, size_t old_size, size_t size);
+    void                (*free)(void *ctx, void *p, size_t size);
+    void                *ctx;
+    cjson_alloc_stats_t stats;
+};
+typedef struct _cjson_allocator_t       cjson_allocator_t;
+
 typedef tchar_t                 cjson_key_t[CJSON_KEY_BUF_LEN];
 typedef struct _cjson_array_t   cjson_array_t;
 typedef struct _cjson_kv_t      cjson_kv_t;
@@ -85,8 +127,9 @@ typedef enum _cjson_valuetype_e         cjson_valuetype_e;
 
 // string
 struct _cjson_string_t {
-    unsigned short      capacity;
-    unsigned short      len;
+    cjson_allocator_t   *allocator;
+    int64_t             capacity; // chars, with the '\0'
+    int64_t             len;
     tchar_t             s[0];
 };
 typedef struct _cjson_string_t          cjson_string_t;
@@ -98,77 +141,570 @@ struct _cjson_number_t {
 };
 typedef struct _cjson_number_t          cjson_number_t;
 
-// value
+// value, 16 bytes
+// null, bool, number and strings of up to CJSON_SSTR_LEN_MAX (13) chars
+// are kept inline, containers hold their elements in arrays, so there is
+// no link in the value
 struct _cjson_value_t {
-    struct _cjson_value_t   *next;
-    // value
     union {
         int                 boolval;  // boolean value
-        cjson_string_t      *strval;  // string value
-        cjson_number_t      *numval;  // number value
+        int64_t             numval;   // number value, mantissa
+        cjson_string_t      *strval;  // string value, longer than CJSON_SSTR_LEN_MAX
         cjson_array_t       *arrval;  // array value
         cjson_object_t      *objval;  // object value
         void                *_valptr; // for common data type use
     } __value;
-    cjson_valuetype_e       value_type;
+    tchar_t                 __sstr_tail[CJSON_SSTR_BUF_LEN - sizeof(void*)]; // short string continues here
+    unsigned char           __aux;      // short string length / _cjson_sstr_long_, number scale
+    unsigned char           value_type; // cjson_valuetype_e
 
 #define cjson_boolval       __value.boolval
 #define cjson_strval        __value.strval
 #define cjson_numval        __value.numval
+#define cjson_numscale      __aux       // number == numval / 10^numscale
 #define cjson_arrval        __value.arrval
 #define cjson_objval        __value.objval
 #define cjson_valptr        __value._valptr
 };
 typedef struct _cjson_value_t           cjson_value_t;
 
+#define _cjson_sstr_long_               0xff
+
+// short string chars start at __value and run into __sstr_tail
+#define cjson_sstrval(v)                ((tchar_t*)(v) + offsetof(cjson_value_t, __value))
+#define cjson_value_str_is_long(v)      ((v)->__aux == _cjson_sstr_long_)
+// string value chars & length, for both short and long strings
+#define cjson_value_str(v)              (cjson_value_str_is_long(v) ? (v)->cjson_strval->s : cjson_sstrval(v))
+#define cjson_value_strlen(v)           (cjson_value_str_is_long(v) ? (v)->cjson_strval->len : (int64_t)(v)->__aux)
+
+// source span of a container, for incremental encoding
+//
+// a container decoded with CJSON_DECODE_SPANS remembers its chars in the
+// source text. The encoder copies a span as is while the container and
+// all below it are unchanged. Mutations mark the container and all its
+// ancestors dirty, after an in place change of a value call
+// cjson_object_touch() / cjson_array_touch() on its container.
+struct _cjson_span_t {
+    const tchar_t           *text;      // NULL if none
+    int64_t                 len;        // chars
+    struct _cjson_span_t    *parent;    // span of the enclosing container
+    int64_t                 dirty;
+};
+typedef struct _cjson_span_t            cjson_span_t;
+
 // array
 struct _cjson_array_t {
-    cjson_value_t           *elem;
-    int                     count;
+    cjson_value_t           *elem;      // count elements, room for capacity
+    int64_t                 count;
+    int64_t                 capacity;
     cjson_valuetype_e       value_type;
+    cjson_allocator_t       *allocator; // of the array & its elements, NULL for the default
+    cjson_span_t            span;
+    int64_t                 refs;       // other owners, see cjson_share()
 };
 
+// object key
+union _cjson_objkey_t {
+    cjson_key_t             sbuf;   // short key, inline
+    cjson_string_t          *lkey;  // long key, longer than CJSON_KEY_LEN_MAX
+};
+typedef union _cjson_objkey_t           cjson_objkey_t;
+
+#define _cjson_key_len_idx_             (CJSON_KEY_BUF_LEN - 2)
+#define _cjson_key_flag_idx_            (CJSON_KEY_BUF_LEN - 1)
+
+#define cjson_key_is_long(k)            ((k)->sbuf[_cjson_key_flag_idx_] != 0)
+// key chars & length, for both short and long keys
+#define cjson_key_str(k)                (cjson_key_is_long(k) ? (k)->lkey->s : (k)->sbuf)
+#define cjson_key_len(k)                (cjson_key_is_long(k) ? (k)->lkey->len : (int64_t)(unsigned char)(k)->sbuf[_cjson_key_len_idx_])
+
 // key - value
 struct _cjson_kv_t {
-    cjson_string_t          *key;
+    cjson_objkey_t          __key;
     cjson_value_t           value;
-    struct _cjson_kv_t      *next;
 };
 
-// object
+#define cjson_kv_key_is_long(kv)        cjson_key_is_long(&(kv)->__key)
+#define cjson_kv_key(kv)                cjson_key_str(&(kv)->__key)
+#define cjson_kv_keylen(kv)             cjson_key_len(&(kv)->__key)
+
+// object shape, the ordered key list shared by objects of the same layout
+//
+// shapes are interned in a cjson_shape_cache_t and owned by it, objects
+// decoded with the cache only point to their shape. Free such objects
+// before the cache.
+struct _cjson_shape_t {
+    cjson_objkey_t          *keys;
+    int64_t                 count;
+    uint32_t                hash;       // of the key sequence
+    uint32_t                *key_hashes; // of each key, see CJSON_KEY_HASH_SEED
+    struct _cjson_shape_t   *next;      // hash chain in the cache
+};
+typedef struct _cjson_shape_t           cjson_shape_t;
+
+// key hash of cjson_object_get_value_h(),
+// murmurhash3_32(key, len * sizeof(tchar_t), CJSON_KEY_HASH_SEED)
+#define CJSON_KEY_HASH_SEED             0
+
+// smaller objects are faster to scan than to hash
+#define CJSON_OBJECT_INDEX_MIN          16
+
+#define CJSON_SHAPE_KEYS_MAX            64   // larger objects keep their own keys
+#define CJSON_SHAPE_CACHE_MAX           4096 // shapes per cache
+#define CJSON_SHAPE_HINT_SLOTS          256  // last shape seen, by first key
+
+// not thread safe, one cache per decoding thread
+struct _cjson_shape_cache_t {
+    cjson_shape_t           **buckets;
+    int64_t                 bucket_count; // power of 2
+    int64_t                 count;
+    const cjson_shape_t     *hints[CJSON_SHAPE_HINT_SLOTS];
+};
+typedef struct _cjson_shape_cache_t     cjson_shape_cache_t;
+
+// object, keys & values in separate arrays
 struct _cjson_object_t {
-    cjson_kv_t              *kvs;
-    int                     count;
+    cjson_objkey_t          *keys;      // own keys, NULL for a shaped object
+    cjson_value_t           *vals;      // count values, room for capacity
+    const cjson_shape_t     *shape;     // shaped object: keys are shape->keys
+    int64_t                 count;
+    int64_t                 capacity;
+    cjson_allocator_t       *allocator; // of the object, its keys & values, NULL for the default
+    cjson_span_t            span;
+    int64_t                 refs;       // other owners, see cjson_share()
+    struct _chashmap_t      *index;     // key => position, NULL if none, see cjson_object_index()
+};
+
+// encode plan of a fixed shape object
+struct _cjson_plan_t {
+    int64_t                 count;
+    cjson_objkey_t          *keys;      // escaped
+    cjson_valuetype_e       *types;     // _cjson_value_unknown_ for any type
+    tchar_t                 *frags;     // '{"k0":' ',"k1":' ... back to back
+    int64_t                 *frag_off;  // count + 1 offsets in frags
+    const cjson_shape_t     *shape;     // objects of this shape skip the key check
+};
+typedef struct _cjson_plan_t            cjson_plan_t;
+
+// direct binding of json text into C structs
+enum _cjson_field_type_e {
+    _cjson_field_int32_ = 1,    // int32_t, numbers are truncated, out of range is an error
+    _cjson_field_int64_,        // int64_t, numbers are truncated
+    _cjson_field_double_,       // double
+    _cjson_field_bool_,         // int, or a 1 byte bool
+    _cjson_field_string_,       // tchar_t [size], escapes decoded, '\0' ended
+    _cjson_field_number_,       // cjson_number_t
+    _cjson_field_object_,       // nested struct, with its own binding
+
+    _cjson_field_end_
+};
+typedef enum _cjson_field_type_e        cjson_field_type_e;
+
+typedef struct _cjson_binding_t         cjson_binding_t;
+
+struct _cjson_field_t {
+    const tchar_t           *name;
+    cjson_field_type_e      type;
+    size_t                  offset;     // in the struct
+    size_t                  size;
+    const cjson_binding_t   *binding;   // _cjson_field_object_ only
+};
+typedef struct _cjson_field_t           cjson_field_t;
+
+#define CJSON_FIELD(st, member, type)           { _T(#member), (type), offsetof(st, member), sizeof(((st*)0)->member), NULL }
+#define CJSON_FIELD_OBJECT(st, member, binding) { _T(#member), _cjson_field_object_, offsetof(st, member), sizeof(((st*)0)->member), (binding) }
+
+// fields & a perfect hash of their names
+struct _cjson_binding_t {
+    const cjson_field_t     *fields;
+    int64_t                 count;
+    uint32_t                seed;       // murmurhash3_32 seed, no collisions
+    uint32_t                slot_mask;
+    int32_t                 *slots;     // hash & slot_mask => field index, -1 for none
+};
+
+// compiled JSON Schema subset
+//   type, enum, required, properties, items, minimum, maximum,
+//   exclusiveMinimum, exclusiveMaximum, minLength, maxLength,
+//   minItems, maxItems. Other keywords are ignored.
+#define CJSON_SCHEMA_REQUIRED_MAX       64 // required properties per object
+
+struct _cjson_schema_node_t {
+    uint32_t                types;      // 1 << cjson_valuetype_e, 0 for any
+    uint32_t                flags;      // _cjson_schema_xxx_
+    long double             minimum;
+    long double             maximum;
+    int64_t                 min_len;    // string chars, array items, -1 for none
+    int64_t                 max_len;
+    int64_t                 items;      // node of array items, -1 for any
+    int64_t                 prop_first; // in schema->props
+    int64_t                 prop_count;
+    uint64_t                required;   // bits of properties
+    int64_t                 enum_first; // in schema->enums
+    int64_t                 enum_count;
+};
+typedef struct _cjson_schema_node_t     cjson_schema_node_t;
+
+#define _cjson_schema_integer_          0x0001
+#define _cjson_schema_minimum_          0x0002
+#define _cjson_schema_maximum_          0x0004
+#define _cjson_schema_exclusive_min_    0x0008
+#define _cjson_schema_exclusive_max_    0x0010
+
+struct _cjson_schema_prop_t {
+    cjson_objkey_t          name;
+    int64_t                 node;
 };
+typedef struct _cjson_schema_prop_t     cjson_schema_prop_t;
+
+// nodes, properties & enum values, referenced by index, node 0 is the root
+struct _cjson_schema_t {
+    cjson_schema_node_t     *nodes;
+    int64_t                 node_count;
+    int64_t                 node_capacity;
+    cjson_schema_prop_t     *props;
+    int64_t                 prop_count;
+    int64_t                 prop_capacity;
+    cjson_value_t           *enums;
+    int64_t                 enum_count;
+    int64_t                 enum_capacity;
+};
+typedef struct _cjson_schema_t          cjson_schema_t;
+
+// compiled query
+//   JSONPath: $ .name ['name'] [n] .* [*] [?(@.path)] [?(@.path OP literal)]
+//     OP: == != < <= > >=, literal: number, 'string', "string", true, false, null
+//   JSON Pointer: "" or /a/b/0, ~0 & ~1 escapes
+// keys & strings are matched as they are in the text, escapes not decoded
+enum _cjson_query_op_e {
+    _cjson_query_child_ = 1,    // object member key and/or array element index
+    _cjson_query_wild_,         // all members / elements
+    _cjson_query_filter_,       // members / elements passing the predicate
+};
+typedef enum _cjson_query_op_e          cjson_query_op_e;
+
+enum _cjson_query_cmp_e {
+    _cjson_query_exists_ = 0,
+    _cjson_query_eq_,
+    _cjson_query_ne_,
+    _cjson_query_lt_,
+    _cjson_query_le_,
+    _cjson_query_gt_,
+    _cjson_query_ge_,
+};
+typedef enum _cjson_query_cmp_e         cjson_query_cmp_e;
+
+struct _cjson_query_instr_t {
+    cjson_query_op_e        op;
+    cjson_query_cmp_e       cmp;        // filter
+    const tchar_t           *key;       // child: member key, NULL for none
+    int64_t                 key_len;
+    int64_t                 index;      // child: element index, -1 for none; filter: first instr of the path
+    int64_t                 count;      // filter: instrs of the path, children only
+    cjson_valuetype_e       lit_type;   // filter literal
+    const tchar_t           *lit_str;
+    int64_t                 lit_len;
+    long double             lit_num;
+};
+typedef struct _cjson_query_instr_t     cjson_query_instr_t;
+
+// instrs of the path, then those of the filter paths
+struct _cjson_query_t {
+    cjson_query_instr_t     *instrs;
+    int64_t                 count;      // instrs of the path
+    int64_t                 total;
+    tchar_t                 *text;      // copy of the expression, keys & literals point here
+};
+typedef struct _cjson_query_t           cjson_query_t;
+
+// matches, return non zero to stop
+typedef int (*pfn_cjson_query_t)(void *ctx, int64_t query, const cjson_value_t *val);
+typedef int (*pfn_cjson_query_text_t)(void *ctx, int64_t query, const tchar_t *text, int64_t len);
+
+// cjson_decode_ex() flags
+#define CJSON_DECODE_SPANS              0x0001 // keep source spans, the text must outlive the document
+#define CJSON_DECODE_INDEX              0x0002 // index objects of CJSON_OBJECT_INDEX_MIN keys or more
+
+// cjson_decode_ex() options
+struct _cjson_decode_opt_t {
+    cjson_shape_cache_t     *shapes;    // learn & share object shapes, may be NULL
+    cjson_allocator_t       *allocator; // for the document nodes, NULL for the default
+    int                     flags;      // CJSON_DECODE_xxx
+    const cjson_schema_t    *schema;    // validate while decoding, may be NULL
+    int64_t                 *error_offset; // offset of the value the schema rejected, may be NULL
+};
+typedef struct _cjson_decode_opt_t      cjson_decode_opt_t;
 
 struct _cjson_t {
     cjson_object_t          *object;
 };
 
+// frozen document image
+//
+// A frozen image is one contiguous, pointer free blob. Every reference
+// inside it is a byte offset from the start of the image, so it can be
+// written to a file or a kvdb_t value and used again after mmap() or a
+// plain read, by any process, at any address.
+//
+// layout, all nodes 8 bytes aligned:
+//   cjson_frozen_header_t
+//   object : count * cjson_fkv_t
+//   array  : count * cjson_fvalue_t
+//   string : len chars, '\0'
+#define CJSON_FROZEN_MAGIC              0x5a464a43 // "CJFZ"
+#define CJSON_FROZEN_VERSION            1
+
+// frozen value slot, 16 bytes
+struct _cjson_fvalue_t {
+    uint8_t                 value_type; // cjson_valuetype_e
+    uint8_t                 scale;      // number: divisor == 10^scale
+    uint16_t                reserved;
+    uint32_t                len;        // string: length, array/object: count
+    union {
+        int64_t             number;     // number value
+        int64_t             boolval;    // boolean value
+        uint64_t            off;        // string/array/object: offset in image
+    } __fv;
+};
+typedef struct _cjson_fvalue_t          cjson_fvalue_t;
+
+// frozen object entry
+struct _cjson_fkv_t {
+    uint32_t                key_off;
+    uint32_t                key_len;
+    cjson_fvalue_t          value;
+};
+typedef struct _cjson_fkv_t             cjson_fkv_t;
+
+struct _cjson_frozen_header_t {
+    uint32_t                magic;
+    uint32_t                version;
+    uint32_t                size;       // total image bytes
+    uint32_t                reserved;
+    cjson_fvalue_t          root;       // the root object
+};
+typedef struct _cjson_frozen_header_t   cjson_frozen_header_t;
+
+// read only view of an image
+struct _cjson_frozen_t {
+    const uint8_t           *base;
+    uint32_t                size;
+};
+typedef struct _cjson_frozen_t          cjson_frozen_t;
+
+// memory of a document by category, bytes
+struct _cjson_memory_t {
+    int64_t                 nodes;      // containers & the slots of null, bool & container values
+    int64_t                 keys;       // own key slots & long keys, shaped objects share theirs
+    int64_t                 strings;    // string value slots & long string payloads
+    int64_t                 numbers;    // number value slots
+    int64_t                 overhead;   // allocator rounding & headers, estimated
+    int64_t                 slack;      // unused capacity of containers & long strings
+    int64_t                 index;      // object indexes
+    int64_t                 total;
+    int64_t                 containers;
+    int64_t                 values;
+};
+typedef struct _cjson_memory_t          cjson_memory_t;
+
+// decode profile, counted in CJSON_PROFILE builds only
+#define CJSON_STATS_HANDLERS            11 // decoder token handlers
+#define CJSON_STATS_DEPTH_MAX           64 // the decoder nests 62 deep at most
+
+// containers count the bytes & cycles of the values inside them too
+struct _cjson_handler_stats_t {
+    uint64_t                calls;
+    uint64_t                bytes;      // chars consumed
+    uint64_t                cycles;     // rdtsc, or nanoseconds where there is none
+};
+typedef struct _cjson_handler_stats_t   cjson_handler_stats_t;
+
+struct _cjson_stats_t {
+    cjson_handler_stats_t   handlers[CJSON_STATS_HANDLERS];
+    uint64_t                docs;
+    uint64_t                allocs;     // cjson_alloc() & cjson_realloc() calls
+    uint64_t                alloc_bytes;
+    uint64_t                depth[CJSON_STATS_DEPTH_MAX]; // containers by nesting depth
+};
+typedef struct _cjson_stats_t           cjson_stats_t;
+
 /********************************************************************
 *        Functions
 *********************************************************************/
-// jsxon text => data
+// jsxon text => data, -1 unless the root is an object
 int cjson_decode(const tchar_t *json_text, cjson_t *data);
-// data => jsxon text
-int cjson_encode(const cjson_t *json, tchar_t *buf, int buflen);
+int cjson_decode_ex(const tchar_t *json_text, cjson_t *data, const cjson_decode_opt_t *opt);
+// json file => data, the file is mmap()'d and parsed in place
+int cjson_decode_file(const char *path, cjson_t *data, int flags);
+// data => jsxon text, return chars written, no '\0'
+int64_t cjson_encode(const cjson_t *json, tchar_t *buf, int64_t buflen);
+
+// direct binding
+// fields => binding, the fields table must outlive the binding
+cjson_binding_t* cjson_binding_compile(const cjson_field_t *fields, int64_t count);
+void cjson_binding_free(cjson_binding_t *binding);
+// json object text => out struct, unknown keys & nulls leave out as is
+// return chars consumed, or -1 for error
+int64_t cjson_bind(const cjson_binding_t *binding, const tchar_t *json_text, void *out);
+
+// schema
+// schema document => compiled schema
+cjson_schema_t* cjson_schema_compile(const cjson_t *schema_doc);
+void cjson_schema_free(cjson_schema_t *schema);
+const cjson_schema_node_t* cjson_schema_property(const cjson_schema_t *schema, const cjson_schema_node_t *node, const tchar_t *key, int64_t len, int64_t *index);
+const cjson_schema_node_t* cjson_schema_items(const cjson_schema_t *schema, const cjson_schema_node_t *node);
+// 0 if the node accepts the type
+int cjson_schema_check_type(const cjson_schema_node_t *node, cjson_valuetype_e type);
+// 0 if the node accepts the value, containers are checked for their size only
+int cjson_schema_check_value(const cjson_schema_t *schema, const cjson_schema_node_t *node, const cjson_value_t *val);
+// 0 if all required properties are in seen, bit i for property i
+int cjson_schema_check_required(const cjson_schema_node_t *node, uint64_t seen);
+
+// query
+// JSONPath / JSON Pointer expression => query
+cjson_query_t* cjson_query_compile(const tchar_t *expr);
+void cjson_query_free(cjson_query_t *q);
+// return matches, or -1 for error
+int64_t cjson_query_exec(const cjson_t *json, const cjson_query_t *q, pfn_cjson_query_t cb, void *ctx);
+// on the text, without a document, unmatched values are skipped
+int64_t cjson_query_exec_text(const tchar_t *json_text, const cjson_query_t *q, pfn_cjson_query_text_t cb, void *ctx);
+// all queries in one pass, query is the index in qs
+int64_t cjson_query_exec_many(const cjson_t *json, const cjson_query_t *const qs[], int64_t count, pfn_cjson_query_t cb, void *ctx);
+int64_t cjson_query_exec_many_text(const tchar_t *json_text, const cjson_query_t *const qs[], int64_t count, pfn_cjson_query_text_t cb, void *ctx);
+
+// patch
+// another owner of the document, nothing is copied. The patch functions
+// copy shared containers on write, so the other version never changes,
+// shared containers must not be changed through other functions.
+int cjson_share(const cjson_t *json, cjson_t *copy);
+int cjson_value_copy(cjson_value_t *dst, const cjson_value_t *src);
+// 1 if equal, object keys in any order
+int cjson_value_equal(const cjson_value_t *a, const cjson_value_t *b);
+// RFC 6902 JSON Patch, an array of op objects. All ops apply or the
+// document stays as it was. The containers on the changed paths are new
+// ones then, values taken from them before are gone.
+int cjson_patch_apply(cjson_t *json, const cjson_array_t *patch);
+// RFC 7396 JSON Merge Patch, all or nothing as well
+int cjson_merge_patch_apply(cjson_t *json, const cjson_object_t *patch);
+// from => to as a JSON Patch, shared containers are equal without a look
+cjson_array_t* cjson_diff(const cjson_t *from, const cjson_t *to);
+
+// decode profile
+// all threads added up, -1 if not a CJSON_PROFILE build
+int cjson_stats_snapshot(cjson_stats_t *stats);
+void cjson_stats_reset(void);
+// stats => document
+int cjson_stats_to_json(const cjson_stats_t *stats, cjson_t *json);
+#if defined(CJSON_PROFILE)
+// counters of the calling thread
+cjson_stats_t* cjson_stats_local(void);
+#endif
+
+// raw text scanners, return chars consumed, or -1 for error
+int64_t cjson_scan_ws(const tchar_t *json_text);
+int64_t cjson_scan_string(const tchar_t *json_text, const tchar_t **s, int64_t *len);
+int64_t cjson_scan_number(const tchar_t *json_text, cjson_value_t *val);
+int64_t cjson_skip_value(const tchar_t *json_text);
+// len chars of a string as in the text => buf, escapes decoded, \uXXXX to
+// utf-8, no '\0' added. Return the chars written, -1 for a bad escape or
+// more than buflen chars
+int64_t cjson_unescape(const tchar_t *s, int64_t len, tchar_t *buf, int64_t buflen);
+
+// allocators
+cjson_allocator_t* cjson_default_allocator(void);
+// thread local size class slabs, for the nodes of long lived documents
+cjson_allocator_t* cjson_slab_allocator(void);
+void* cjson_alloc(cjson_allocator_t *a, size_t size);
+void* cjson_realloc(cjson_allocator_t *a, void *p, size_t old_size, size_t size);
+void cjson_free(cjson_allocator_t *a, void *p, size_t size);
+void cjson_allocator_stats(const cjson_allocator_t *a, cjson_alloc_stats_t *stats);
+// bytes a block of size really takes from the allocator, estimated for malloc()
+size_t cjson_alloc_usable(const cjson_allocator_t *a, size_t size);
+
+// memory accounting
+int cjson_memory_usage(const cjson_t *json, cjson_memory_t *usage);
+// live bytes of all cjson allocators, process wide, summed over the threads
+int64_t cjson_memory_live(void);
+
+// encode plans
+// keys & types => plan, types may be NULL for any types
+cjson_plan_t* cjson_plan_compile(const tchar_t *keys[], const cjson_valuetype_e types[], int64_t count);
+void cjson_plan_free(cjson_plan_t *plan);
+// intern the plan's keys, objects decoded with the cache then match by shape pointer
+int cjson_plan_bind(cjson_plan_t *plan, cjson_shape_cache_t *cache);
+// object => text, -1 if the object's keys or value types don't fit the plan
+int64_t cjson_plan_encode(const cjson_plan_t *plan, const cjson_object_t *obj, tchar_t *buf, int64_t buflen);
+// values in key order => text
+int64_t cjson_plan_encode_values(const cjson_plan_t *plan, const cjson_value_t *vals, int64_t count, tchar_t *buf, int64_t buflen);
 
 // array
 int cjson_array_add(cjson_array_t *data, cjson_value_t *elem);
 int cjson_array_free(cjson_array_t *val);
 cjson_value_t* cjson_array_first(cjson_array_t *data, position_t *pos);
 cjson_value_t* cjson_array_next(cjson_array_t *data, position_t *pos);
+cjson_value_t* cjson_array_get(const cjson_array_t *data, int64_t index);
+// replace the element at index, the old one is freed
+int cjson_array_set(cjson_array_t *data, int64_t index, cjson_value_t *elem);
+// insert before index, index == count appends
+int cjson_array_insert(cjson_array_t *data, int64_t index, cjson_value_t *elem);
+// remove the element at index, moved into out, or freed if out is NULL
+int cjson_array_remove(cjson_array_t *data, int64_t index, cjson_value_t *out);
+void cjson_array_touch(cjson_array_t *data);
 
 // object
 int cjson_object_addkv(cjson_object_t *data, cjson_kv_t *kv);
-cjson_kv_t* cjson_object_first(cjson_object_t *data, position_t *pos);
-cjson_kv_t* cjson_object_next(cjson_object_t *data, position_t *pos);
+// entries as key & value, copied into kv, return kv or NULL at the end. The
+// object isn't changed, the copy shares its key & value: read it only.
+cjson_kv_t* cjson_object_first(cjson_object_t *data, position_t *pos, cjson_kv_t *kv);
+cjson_kv_t* cjson_object_next(cjson_object_t *data, position_t *pos, cjson_kv_t *kv);
+// values in place, shaped objects included, cjson_object_key() gives the key
+cjson_value_t* cjson_object_first_value(cjson_object_t *data, position_t *pos);
+cjson_value_t* cjson_object_next_value(cjson_object_t *data, position_t *pos);
+// key of a value in the object
+const tchar_t* cjson_object_key(const cjson_object_t *data, const cjson_value_t *val, int64_t *len);
+int cjson_key_set(cjson_objkey_t *k, const tchar_t *key, int64_t len);
+int cjson_key_free(cjson_objkey_t *k);
+int cjson_kv_set_key(cjson_kv_t *kv, const tchar_t *key, int64_t len);
 int cjson_kv_free(cjson_kv_t *kv);
 int cjson_object_free(cjson_object_t *data);
+cjson_value_t* cjson_object_get_value(const cjson_object_t *data, const tchar_t *key);
+// hash index of the keys, lookups take O(1) then, kept up to date by the
+// object functions. The first of duplicate keys wins, as without one.
+int cjson_object_index(cjson_object_t *data);
+// key of len chars with its CJSON_KEY_HASH_SEED hash, precomputed e.g. at compile time
+cjson_value_t* cjson_object_get_value_h(const cjson_object_t *data, const tchar_t *key, int64_t len, uint32_t hash);
+// replace the value of key, or add the key, val is moved into the object
+int cjson_object_set_value(cjson_object_t *data, const tchar_t *key, cjson_value_t *val);
+// remove key, its value is moved into out, or freed if out is NULL
+int cjson_object_remove(cjson_object_t *data, const tchar_t *key, cjson_value_t *out);
+void cjson_object_touch(cjson_object_t *data);
+
+// shape cache
+cjson_shape_cache_t* cjson_shape_cache_create(void);
+void cjson_shape_cache_free(cjson_shape_cache_t *cache);
+// keys => interned shape, NULL if the cache is full
+const cjson_shape_t* cjson_shape_cache_intern(cjson_shape_cache_t *cache, const cjson_objkey_t *keys, int64_t count);
+// the last shape interned with this first key, may be NULL
+const cjson_shape_t* cjson_shape_cache_hint(const cjson_shape_cache_t *cache, const tchar_t *key, int64_t len);
 
 // value
+int cjson_value_set_string(cjson_value_t *val, const tchar_t *s, int64_t len);
+int cjson_value_set_number(cjson_value_t *val, int64_t number, int64_t divisor);
+int cjson_value_get_number(const cjson_value_t *val, cjson_number_t *num);
 int cjson_value_free(cjson_value_t *val);
 
+// frozen image
+// data => image, return image size, or -1 for error / buffer too small
+// buf == NULL to query the image size only
+int64_t cjson_freeze(const cjson_t *json, void *buf, int64_t buflen);
+int cjson_frozen_open(cjson_frozen_t *fz, const void *image, int64_t size);
+const cjson_fvalue_t* cjson_frozen_root(const cjson_frozen_t *fz);
+const cjson_fvalue_t* cjson_frozen_object_get(const cjson_frozen_t *fz, const cjson_fvalue_t *obj, const tchar_t *key);
+const cjson_fvalue_t* cjson_frozen_object_at(const cjson_frozen_t *fz, const cjson_fvalue_t *obj, int64_t index, const tchar_t **key);
+const cjson_fvalue_t* cjson_frozen_array_at(const cjson_frozen_t *fz, const cjson_fvalue_t *arr, int64_t index);
+const tchar_t* cjson_frozen_string(const cjson_frozen_t *fz, const cjson_fvalue_t *val, int64_t *len);
+int cjson_frozen_number(const cjson_fvalue_t *val, cjson_number_t *num);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,547 @@
+/************************************************************************************
+* cjson.hpp : header file
+*
+* C++20 layer over the lite json lib
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+* Copyright (c) 2026. All Rights Reserved.
+*
+* This code may be used in compiled form in any way you desire. This
+* file may be redistributed unmodified by any means PROVIDING it is
+* not sold for profit without the authors written consent, and
+* providing that this notice and the authors name and all copyright
+* notices remains intact.
+*
+* An email letting me know how you are using it would be nice as well.
+*
+* This file is provided "as is" with no expressed or implied warranty.
+* The author accepts no liability for any damage/loss of business that
+* this product may cause.
+*
+* REMARKS:
+*   header only. cjson::document owns a decoded cjson_t and frees it, it
+*   can be moved but not copied, share() makes another owner instead.
+*   value_ref, object_ref & array_ref are views into a document, keys and
+*   raw strings come out as std::string_view of the document's own chars,
+*   escapes as they are in the text, nothing is copied. get_string()
+*   decodes the escapes, into the caller's buffer when there are any.
+*   Views must not outlive their document.
+*
+*   cjson::resource_allocator routes every node of a document to a
+*   std::pmr::memory_resource, e.g. a request scoped
+*   std::pmr::monotonic_buffer_resource. The resource must outlive the
+*   documents decoded with it.
+*
+************************************************************************************/
+
+#if !defined(__CLITEJSON_HPP__)
+#define __CLITEJSON_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <memory_resource>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include <cjson.h>
+#include <murmurhash.hpp>
+
+namespace cjson {
+
+class error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+class value_ref;
+class object_ref;
+class array_ref;
+
+// object key with its length & hash, computed at compile time for
+// literals: obj["user_id"_key]
+class key {
+public:
+    constexpr explicit key(std::string_view s) noexcept
+        : _s(s), _hash(murmurhash::murmurhash3_32(s, CJSON_KEY_HASH_SEED)) {}
+
+    constexpr std::string_view str() const noexcept { return _s; }
+    constexpr uint32_t hash() const noexcept { return _hash; }
+
+private:
+    std::string_view    _s;
+    uint32_t            _hash;
+};
+
+inline namespace literals {
+
+consteval key operator""_key(const char *s, size_t len) noexcept
+{
+    return key(std::string_view(s, len));
+}
+
+} // namespace literals
+
+// the key hash of the C side: the key's bytes, CJSON_KEY_HASH_SEED
+static_assert(sizeof(tchar_t) == sizeof(char), "key hashes the chars as bytes");
+static_assert("user_id"_key.hash() == 0x520109d5u);
+static_assert("a_rather_long_key_name_here"_key.hash() == 0xdf8f73c4u);
+
+//====================================================================
+// pmr
+class resource_allocator {
+public:
+    explicit resource_allocator(std::pmr::memory_resource *mr = std::pmr::get_default_resource()) noexcept
+    {
+        _a.alloc = &resource_allocator::_alloc;
+        _a.realloc = nullptr; // alloc, copy & free
+        _a.free = &resource_allocator::_free;
+        _a.ctx = mr;
+        _a.stats = cjson_alloc_stats_t{};
+    }
+
+    // the C side keeps a pointer to _a
+    resource_allocator(const resource_allocator&) = delete;
+    resource_allocator& operator=(const resource_allocator&) = delete;
+
+    cjson_allocator_t* get() noexcept { return &_a; }
+    std::pmr::memory_resource* resource() const noexcept { return static_cast<std::pmr::memory_resource*>(_a.ctx); }
+
+private:
+    static void* _alloc(void *ctx, size_t size) noexcept
+    {
+        try {
+            return static_cast<std::pmr::memory_resource*>(ctx)->allocate(size, alignof(std::max_align_t));
+        }
+        catch (...) {
+            return nullptr; // the C side sees out of memory
+        }
+    }
+
+    static void _free(void *ctx, void *p, size_t size) noexcept
+    {
+        static_cast<std::pmr::memory_resource*>(ctx)->deallocate(p, size, alignof(std::max_align_t));
+    }
+
+    cjson_allocator_t   _a;
+};
+
+//====================================================================
+// views
+class value_ref {
+public:
+    value_ref() noexcept = default;
+    explicit value_ref(const cjson_value_t *v) noexcept : _v(v) {}
+
+    const cjson_value_t* get() const noexcept { return _v; }
+    explicit operator bool() const noexcept { return _v != nullptr; }
+
+    cjson_valuetype_e type() const noexcept
+    {
+        return _v ? static_cast<cjson_valuetype_e>(_v->value_type) : _cjson_value_unknown_;
+    }
+
+    bool is_null() const noexcept { return type() == _cjson_value_null_; }
+    bool is_bool() const noexcept { return type() == _cjson_value_bool_; }
+    bool is_number() const noexcept { return type() == _cjson_value_number_; }
+    bool is_string() const noexcept { return type() == _cjson_value_string_; }
+    bool is_array() const noexcept { return type() == _cjson_value_array_; }
+    bool is_object() const noexcept { return type() == _cjson_value_object_; }
+
+    // nullopt for another type
+    std::optional<bool> get_bool() const noexcept
+    {
+        if (!is_bool()) {
+            return std::nullopt;
+        }
+        return _v->cjson_boolval != 0;
+    }
+
+    std::optional<cjson_number_t> get_number() const noexcept
+    {
+        cjson_number_t num;
+
+        if (_v == nullptr || cjson_value_get_number(_v, &num) < 0) {
+            return std::nullopt;
+        }
+        return num;
+    }
+
+    std::optional<double> get_double() const noexcept
+    {
+        auto num = get_number();
+        if (!num) {
+            return std::nullopt;
+        }
+        return static_cast<double>(num->number) / static_cast<double>(num->divisor);
+    }
+
+    // integers only, no fraction digits
+    std::optional<int64_t> get_int64() const noexcept
+    {
+        if (!is_number() || _v->cjson_numscale != 0) {
+            return std::nullopt;
+        }
+        return _v->cjson_numval;
+    }
+
+    // chars in the document, escapes as they are in the text
+    std::optional<std::string_view> get_raw_string() const noexcept
+    {
+        if (!is_string()) {
+            return std::nullopt;
+        }
+        return std::string_view(cjson_value_str(_v), static_cast<size_t>(cjson_value_strlen(_v)));
+    }
+
+    // escapes decoded, the chars in the document if there are none, else
+    // the chars in buf. nullopt for another type or a bad escape
+    std::optional<std::string_view> get_string(std::string &buf) const
+    {
+        auto raw = get_raw_string();
+        int64_t n = 0;
+
+        if (!raw || raw->find('\\') == std::string_view::npos) {
+            return raw;
+        }
+
+        // never longer than escaped
+        buf.resize(raw->size());
+        n = cjson_unescape(raw->data(), static_cast<int64_t>(raw->size()), buf.data(), static_cast<int64_t>(buf.size()));
+        if (n < 0) {
+            return std::nullopt;
+        }
+        buf.resize(static_cast<size_t>(n));
+
+        return std::string_view(buf);
+    }
+
+    // error for another type
+    bool as_bool() const { return _must(get_bool(), "not a bool"); }
+    double as_double() const { return _must(get_double(), "not a number"); }
+    int64_t as_int64() const { return _must(get_int64(), "not an integer"); }
+    std::string_view as_raw_string() const { return _must(get_raw_string(), "not a string"); }
+    std::string as_string() const
+    {
+        std::string buf;
+        return std::string(_must(get_string(buf), "not a string"));
+    }
+    inline object_ref as_object() const;
+    inline array_ref as_array() const;
+
+    // member / element, an empty ref if there is none
+    inline value_ref operator[](std::string_view key) const noexcept;
+    inline value_ref operator[](const key &k) const noexcept;
+    inline value_ref operator[](size_t index) const noexcept;
+
+private:
+    template <typename T>
+    static T _must(std::optional<T> v, const char *what)
+    {
+        if (!v) {
+            throw error(what);
+        }
+        return *v;
+    }
+
+    const cjson_value_t *_v = nullptr;
+};
+
+// member of an object
+struct member {
+    std::string_view    key;
+    value_ref           value;
+};
+
+class object_ref {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = member;
+        using difference_type = std::ptrdiff_t;
+        using reference = member;
+
+        iterator() noexcept = default;
+        iterator(const cjson_object_t *o, int64_t i) noexcept : _o(o), _i(i) {}
+
+        member operator*() const noexcept
+        {
+            const cjson_value_t *val = &_o->vals[_i];
+            int64_t len = 0;
+            const tchar_t *key = cjson_object_key(_o, val, &len);
+
+            return member{ std::string_view(key, static_cast<size_t>(len)), value_ref(val) };
+        }
+
+        iterator& operator++() noexcept { ++_i; return *this; }
+        iterator operator++(int) noexcept { iterator it = *this; ++_i; return it; }
+        bool operator==(const iterator &rhs) const noexcept { return _i == rhs._i && _o == rhs._o; }
+
+    private:
+        const cjson_object_t *_o = nullptr;
+        int64_t _i = 0;
+    };
+
+    object_ref() noexcept = default;
+    explicit object_ref(const cjson_object_t *o) noexcept : _o(o) {}
+
+    const cjson_object_t* get() const noexcept { return _o; }
+    size_t size() const noexcept { return _o ? static_cast<size_t>(_o->count) : 0; }
+    bool empty() const noexcept { return size() == 0; }
+
+    iterator begin() const noexcept { return iterator(_o, 0); }
+    iterator end() const noexcept { return iterator(_o, static_cast<int64_t>(size())); }
+
+    // an empty ref if there is no such key
+    value_ref find(std::string_view key) const noexcept
+    {
+        tchar_t buf[CJSON_KEY_BUF_LEN];
+
+        if (_o == nullptr) {
+            return value_ref();
+        }
+
+        // short keys go the C way, it wants them terminated
+        if (key.size() < sizeof(buf)) {
+            key.copy(buf, key.size());
+            buf[key.size()] = 0;
+            return value_ref(cjson_object_get_value(_o, buf));
+        }
+
+        for (member m : *this) {
+            if (m.key == key) {
+                return m.value;
+            }
+        }
+        return value_ref();
+    }
+
+    // hashed key, no hashing at run time
+    value_ref find(const key &k) const noexcept
+    {
+        return value_ref(cjson_object_get_value_h(_o, k.str().data(), static_cast<int64_t>(k.str().size()), k.hash()));
+    }
+
+    value_ref operator[](std::string_view key) const noexcept { return find(key); }
+    value_ref operator[](const key &k) const noexcept { return find(k); }
+    bool contains(std::string_view key) const noexcept { return static_cast<bool>(find(key)); }
+    bool contains(const key &k) const noexcept { return static_cast<bool>(find(k)); }
+
+private:
+    const cjson_object_t *_o = nullptr;
+};
+
+class array_ref {
+public:
+    class iterator {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = value_ref;
+        using difference_type = std::ptrdiff_t;
+        using reference = value_ref;
+
+        iterator() noexcept = default;
+        explicit iterator(const cjson_value_t *p) noexcept : _p(p) {}
+
+        value_ref operator*() const noexcept { return value_ref(_p); }
+        value_ref operator[](difference_type n) const noexcept { return value_ref(_p + n); }
+
+        iterator& operator++() noexcept { ++_p; return *this; }
+        iterator operator++(int) noexcept { iterator it = *this; ++_p; return it; }
+        iterator& operator--() noexcept { --_p; return *this; }
+        iterator operator--(int) noexcept { iterator it = *this; --_p; return it; }
+        iterator& operator+=(difference_type n) noexcept { _p += n; return *this; }
+        iterator& operator-=(difference_type n) noexcept { _p -= n; return *this; }
+        friend iterator operator+(iterator it, difference_type n) noexcept { return it += n; }
+        friend iterator operator+(difference_type n, iterator it) noexcept { return it += n; }
+        friend iterator operator-(iterator it, difference_type n) noexcept { return it -= n; }
+        friend difference_type operator-(const iterator &a, const iterator &b) noexcept { return a._p - b._p; }
+
+        bool operator==(const iterator &rhs) const noexcept { return _p == rhs._p; }
+        auto operator<=>(const iterator &rhs) const noexcept { return _p <=> rhs._p; }
+
+    private:
+        const cjson_value_t *_p = nullptr;
+    };
+
+    array_ref() noexcept = default;
+    explicit array_ref(const cjson_array_t *a) noexcept : _a(a) {}
+
+    const cjson_array_t* get() const noexcept { return _a; }
+    size_t size() const noexcept { return _a ? static_cast<size_t>(_a->count) : 0; }
+    bool empty() const noexcept { return size() == 0; }
+
+    iterator begin() const noexcept { return iterator(_a ? _a->elem : nullptr); }
+    iterator end() const noexcept { return iterator(_a ? _a->elem + _a->count : nullptr); }
+
+    // an empty ref if out of range
+    value_ref operator[](size_t index) const noexcept
+    {
+        return index < size() ? value_ref(&_a->elem[index]) : value_ref();
+    }
+
+private:
+    const cjson_array_t *_a = nullptr;
+};
+
+inline object_ref value_ref::as_object() const
+{
+    if (!is_object()) {
+        throw error("not an object");
+    }
+    return object_ref(_v->cjson_objval);
+}
+
+inline array_ref value_ref::as_array() const
+{
+    if (!is_array()) {
+        throw error("not an array");
+    }
+    return array_ref(_v->cjson_arrval);
+}
+
+inline value_ref value_ref::operator[](std::string_view key) const noexcept
+{
+    return is_object() ? object_ref(_v->cjson_objval).find(key) : value_ref();
+}
+
+inline value_ref value_ref::operator[](const key &k) const noexcept
+{
+    return is_object() ? object_ref(_v->cjson_objval).find(k) : value_ref();
+}
+
+inline value_ref value_ref::operator[](size_t index) const noexcept
+{
+    return is_array() ? array_ref(_v->cjson_arrval)[index] : value_ref();
+}
+
+//====================================================================
+// document
+class document {
+public:
+    // chars dump() makes at most
+    static constexpr size_t dump_max = static_cast<size_t>(1) << 32;
+
+    document() noexcept = default;
+
+    // takes over a decoded cjson_t
+    explicit document(cjson_t json) noexcept : _json(json) {}
+
+    document(document &&rhs) noexcept : _json(std::exchange(rhs._json, cjson_t{ nullptr })) {}
+
+    document& operator=(document &&rhs) noexcept
+    {
+        if (this != &rhs) {
+            reset();
+            _json = std::exchange(rhs._json, cjson_t{ nullptr });
+        }
+        return *this;
+    }
+
+    document(const document&) = delete;
+    document& operator=(const document&) = delete;
+
+    ~document() { reset(); }
+
+    // text must be '\0' terminated, nodes come from allocator, nullptr for the default
+    static document parse(const tchar_t *text, cjson_allocator_t *allocator = nullptr, int flags = 0)
+    {
+        cjson_decode_opt_t opt{};
+        cjson_t json{ nullptr };
+
+        opt.allocator = allocator;
+        opt.flags = flags;
+        if (cjson_decode_ex(text, &json, &opt) < 0 || json.object == nullptr) {
+            throw error("cjson decode failed");
+        }
+        return document(json);
+    }
+
+    static document parse(const std::string &text, cjson_allocator_t *allocator = nullptr, int flags = 0)
+    {
+        return parse(text.c_str(), allocator, flags);
+    }
+
+    static document parse(const tchar_t *text, resource_allocator &allocator, int flags = 0)
+    {
+        return parse(text, allocator.get(), flags);
+    }
+
+    static document parse(const std::string &text, resource_allocator &allocator, int flags = 0)
+    {
+        return parse(text.c_str(), allocator.get(), flags);
+    }
+
+    // another owner of the same nodes, see cjson_share()
+    document share() const
+    {
+        cjson_t copy{ nullptr };
+
+        if (cjson_share(&_json, &copy) < 0) {
+            throw error("cjson share failed");
+        }
+        return document(copy);
+    }
+
+    // gives the cjson_t up, the caller frees it
+    cjson_t release() noexcept { return std::exchange(_json, cjson_t{ nullptr }); }
+
+    void reset() noexcept
+    {
+        if (_json.object) {
+            cjson_object_free(_json.object);
+            _json.object = nullptr;
+        }
+    }
+
+    const cjson_t* get() const noexcept { return &_json; }
+    cjson_t* get() noexcept { return &_json; }
+    explicit operator bool() const noexcept { return _json.object != nullptr; }
+
+    object_ref root() const noexcept { return object_ref(_json.object); }
+    value_ref operator[](std::string_view key) const noexcept { return root().find(key); }
+    value_ref operator[](const key &k) const noexcept { return root().find(k); }
+    object_ref::iterator begin() const noexcept { return root().begin(); }
+    object_ref::iterator end() const noexcept { return root().end(); }
+    size_t size() const noexcept { return root().size(); }
+
+    std::string dump() const
+    {
+        std::string out;
+        int64_t n = -1;
+
+        if (_json.object == nullptr) {
+            throw error("cjson encode of an empty document");
+        }
+
+        // grow while the buffer is too small, up to dump_max
+        for (out.resize(256); ; out.resize(out.size() * 2)) {
+            n = cjson_encode(&_json, out.data(), static_cast<int64_t>(out.size()));
+            if (n >= 0) {
+                break;
+            }
+            if (n != CJSON_ENCODE_SHORT) {
+                throw error("cjson encode failed");
+            }
+            if (out.size() >= dump_max) {
+                throw error("cjson encode longer than dump_max");
+            }
+        }
+        out.resize(static_cast<size_t>(n));
+
+        return out;
+    }
+
+private:
+    cjson_t _json{ nullptr };
+};
+
+} // namespace cjson
+
+#endif /*__CLITEJSON_HPP__*/
@@ -0,0 +1,632 @@
+/************************************************************************************
+* cjson_alloc.c: Implementation File
+*
+* cjson allocators
+*
+* DESCRIPTION:
+*   the runtime allocator interface, the default allocator on top of
+*   my_malloc(), and a slab allocator with thread local pools for the
+*   fixed size nodes of long lived documents.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   slab pool:
+*   - blocks up to _slab_class_max_ bytes come from 64KB slabs of one size
+*     class, larger ones go to my_malloc().
+*   - every thread allocates from its own pool, without locks. A block
+*     freed by another thread is pushed to the remote list of its slab
+*     with a CAS, and the owner takes the whole list back on its next
+*     allocation from that slab.
+*   - slabs are kept by the pool once allocated. When a thread exits its
+*     empty slabs are released, the others are orphaned and adopted by
+*     the next pool running out of room in that class.
+*
+************************************************************************************/
+
+#include <cjson.h>
+#include <pthread.h>
+
+//===========================================================
+// counters
+//
+// every thread counts into its own block, a plain add, for up to
+// _alloc_slot_amount_ allocators. The blocks are kept after their thread
+// exits, a snapshot adds all of them up. Allocators past the slots of a
+// thread are counted in their own stats, atomically.
+#define _alloc_slot_amount_             8
+#define _stat_add(a, f, n)              __atomic_fetch_add(&((a)->stats.f), (n), __ATOMIC_RELAXED)
+
+struct __alloc_slot_t {
+    const cjson_allocator_t *allocator; // NULL for a free slot
+    cjson_alloc_stats_t     stats;
+};
+typedef struct __alloc_slot_t           _alloc_slot_t;
+
+struct __alloc_block_t {
+    _alloc_slot_t           slots[_alloc_slot_amount_];
+    int64_t                 live_bytes; // of all allocators
+    struct __alloc_block_t  *next;
+};
+typedef struct __alloc_block_t          _alloc_block_t;
+
+// live bytes counted in the allocators' own stats
+static int64_t _live_bytes = 0;
+
+static __thread _alloc_block_t *_alloc_local = NULL;
+static _alloc_block_t *_alloc_blocks = NULL;
+static pthread_mutex_t _alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static _alloc_block_t* _alloc_block_get(void)
+{
+    _alloc_block_t *block = _alloc_local;
+
+    if (block) {
+        return block;
+    }
+
+    block = (_alloc_block_t*)calloc(1, sizeof(_alloc_block_t));
+    if (block == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&_alloc_lock);
+    block->next = _alloc_blocks;
+    _alloc_blocks = block;
+    pthread_mutex_unlock(&_alloc_lock);
+
+    _alloc_local = block;
+
+    return block;
+}
+
+// the counters of a in this thread, NULL if they are a's own
+static cjson_alloc_stats_t* _alloc_slot(_alloc_block_t *block, const cjson_allocator_t *a)
+{
+    int i = 0;
+
+    for (i = 0; i < _alloc_slot_amount_; i++) {
+        if (block->slots[i].allocator == a) {
+            return &(block->slots[i].stats);
+        }
+
+        if (block->slots[i].allocator == NULL) {
+            __atomic_store_n(&(block->slots[i].allocator), a, __ATOMIC_RELEASE);
+            return &(block->slots[i].stats);
+        }
+    }
+
+    return NULL;
+}
+
+static void _alloc_stats_on_alloc(cjson_allocator_t *a, size_t size)
+{
+    _alloc_block_t *block = _alloc_block_get();
+    cjson_alloc_stats_t *st = (block ? _alloc_slot(block, a) : NULL);
+
+    if (st == NULL) {
+        _stat_add(a, allocs, 1);
+        _stat_add(a, bytes, (int64_t)size);
+        _stat_add(a, live_bytes, (int64_t)size);
+        __atomic_fetch_add(&_live_bytes, (int64_t)size, __ATOMIC_RELAXED);
+        return;
+    }
+
+    st->allocs++;
+    st->bytes += (int64_t)size;
+    st->live_bytes += (int64_t)size;
+    block->live_bytes += (int64_t)size;
+}
+
+// a block freed by another thread than its allocating one takes the live
+// bytes of this thread below zero, the sum is right
+static void _alloc_stats_on_free(cjson_allocator_t *a, size_t size)
+{
+    _alloc_block_t *block = _alloc_block_get();
+    cjson_alloc_stats_t *st = (block ? _alloc_slot(block, a) : NULL);
+
+    if (st == NULL) {
+        _stat_add(a, frees, 1);
+        _stat_add(a, live_bytes, -(int64_t)size);
+        __atomic_fetch_sub(&_live_bytes, (int64_t)size, __ATOMIC_RELAXED);
+        return;
+    }
+
+    st->frees++;
+    st->live_bytes -= (int64_t)size;
+    block->live_bytes -= (int64_t)size;
+}
+
+//===========================================================
+// default allocator, my_malloc()
+static void* _default_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+
+    return my_malloc(size);
+}
+
+static void* _default_realloc(void *ctx, void *p, size_t old_size, size_t size)
+{
+    (void)ctx;
+    (void)old_size;
+
+    return my_realloc(p, size);
+}
+
+static void _default_free(void *ctx, void *p, size_t size)
+{
+    (void)ctx;
+    (void)size;
+
+    my_free(p);
+}
+
+static cjson_allocator_t _default_allocator = {
+    _default_alloc, _default_realloc, _default_free, NULL, { 0, 0, 0, 0 },
+};
+
+cjson_allocator_t* cjson_default_allocator(void)
+{
+    return &_default_allocator;
+}
+
+//===========================================================
+// slab allocator
+#define _slab_size_                     (64 * 1024) // bytes, slabs are aligned to it
+#define _slab_header_size_              64
+#define _slab_class_max_                512
+#define _slab_class_amount_             10
+
+// block sizes of the classes, multiples of 16
+static const uint32_t _slab_class_sizes[_slab_class_amount_] = {
+    16, 32, 48, 64, 96, 128, 192, 256, 384, 512,
+};
+
+// (size + 15) / 16 => class
+static const uint8_t _slab_class_table[_slab_class_max_ / 16 + 1] = {
+    0, 0, 1, 2, 3, 4, 4, 5, 5, 6, 6, 6, 6, 7, 7, 7, 7,
+    8, 8, 8, 8, 8, 8, 8, 8, 9, 9, 9, 9, 9, 9, 9, 9,
+};
+
+struct __slab_block_t {
+    struct __slab_block_t       *next;
+};
+typedef struct __slab_block_t       _slab_block_t;
+
+struct __slab_pool_t;
+
+struct __slab_t {
+    struct __slab_pool_t        *owner;     // NULL for an orphan, atomic
+    struct __slab_t             *next;      // slabs of the class
+    _slab_block_t               *free;      // freed by the owner
+    _slab_block_t               *remote;    // freed by other threads, atomic
+    char                        *bump;      // never allocated yet from here
+    char                        *end;
+    int64_t                     used;       // blocks out, owner only
+    uint32_t                    block_size;
+};
+typedef struct __slab_t             _slab_t;
+
+struct __slab_pool_t {
+    _slab_t                     *slabs[_slab_class_amount_];
+    _slab_t                     *current[_slab_class_amount_];
+};
+typedef struct __slab_pool_t        _slab_pool_t;
+
+#define _slab_of(p)                     ((_slab_t*)((uintptr_t)(p) & ~((uintptr_t)_slab_size_ - 1)))
+
+static void _slab_collect(_slab_t *s);
+
+static __thread _slab_pool_t *_tls_pool = NULL;
+static pthread_key_t _pool_key;
+static pthread_once_t _pool_key_once = PTHREAD_ONCE_INIT;
+
+// slabs of exited threads with blocks still out
+static pthread_mutex_t _orphan_lock = PTHREAD_MUTEX_INITIALIZER;
+static _slab_t *_orphans[_slab_class_amount_];
+
+// thread exit, release the empty slabs, orphan the others
+static void _slab_pool_release(void *arg)
+{
+    _slab_pool_t *pool = (_slab_pool_t*)arg;
+    _slab_t *s = NULL;
+    _slab_t *next = NULL;
+    int i = 0;
+
+    for (i = 0; i < _slab_class_amount_; i++) {
+        for (s = pool->slabs[i]; s; s = next) {
+            next = s->next;
+            _slab_collect(s);
+            if (s->used == 0) {
+                free(s);
+                continue;
+            }
+
+            __atomic_store_n(&(s->owner), NULL, __ATOMIC_RELEASE);
+            pthread_mutex_lock(&_orphan_lock);
+            s->next = _orphans[i];
+            _orphans[i] = s;
+            pthread_mutex_unlock(&_orphan_lock);
+        }
+    }
+
+    _tls_pool = NULL;
+    free(pool);
+}
+
+static _slab_t* _slab_adopt(_slab_pool_t *pool, int cls)
+{
+    _slab_t *s = NULL;
+
+    if (__atomic_load_n(&(_orphans[cls]), __ATOMIC_RELAXED) == NULL) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&_orphan_lock);
+    s = _orphans[cls];
+    if (s) {
+        _orphans[cls] = s->next;
+    }
+    pthread_mutex_unlock(&_orphan_lock);
+
+    if (s == NULL) {
+        return NULL;
+    }
+
+    __atomic_store_n(&(s->owner), pool, __ATOMIC_RELEASE);
+    s->next = pool->slabs[cls];
+    pool->slabs[cls] = s;
+
+    return s;
+}
+
+static void _slab_pool_key_init(void)
+{
+    pthread_key_create(&_pool_key, _slab_pool_release);
+}
+
+static _slab_pool_t* _slab_pool_get(void)
+{
+    if (_tls_pool) {
+        return _tls_pool;
+    }
+
+    pthread_once(&_pool_key_once, _slab_pool_key_init);
+
+    _tls_pool = (_slab_pool_t*)calloc(1, sizeof(_slab_pool_t));
+    if (_tls_pool) {
+        pthread_setspecific(_pool_key, _tls_pool);
+    }
+
+    return _tls_pool;
+}
+
+static _slab_t* _slab_new(_slab_pool_t *pool, int cls)
+{
+    _slab_t *s = NULL;
+
+    s = (_slab_t*)aligned_alloc(_slab_size_, _slab_size_);
+    if (s == NULL) {
+        return NULL;
+    }
+
+    s->owner = pool;
+    s->free = NULL;
+    s->remote = NULL;
+    s->bump = (char*)s + _slab_header_size_;
+    s->end = (char*)s + _slab_size_;
+    s->used = 0;
+    s->block_size = _slab_class_sizes[cls];
+
+    s->next = pool->slabs[cls];
+    pool->slabs[cls] = s;
+
+    return s;
+}
+
+// take back the blocks freed by other threads
+static void _slab_collect(_slab_t *s)
+{
+    _slab_block_t *b = NULL;
+    _slab_block_t *last = NULL;
+    int64_t n = 1;
+
+    if (__atomic_load_n(&(s->remote), __ATOMIC_RELAXED) == NULL) {
+        return;
+    }
+
+    b = __atomic_exchange_n(&(s->remote), NULL, __ATOMIC_ACQUIRE);
+    if (b == NULL) {
+        return;
+    }
+
+    for (last = b; last->next; last = last->next) {
+        n++;
+    }
+
+    last->next = s->free;
+    s->free = b;
+    s->used -= n;
+}
+
+static void* _slab_take(_slab_t *s)
+{
+    _slab_block_t *b = NULL;
+
+    if (s->free == NULL) {
+        _slab_collect(s);
+    }
+
+    if (s->free) {
+        b = s->free;
+        s->free = b->next;
+    } else if (s->bump + s->block_size <= s->end) {
+        b = (_slab_block_t*)s->bump;
+        s->bump += s->block_size;
+    } else {
+        return NULL;
+    }
+
+    s->used++;
+
+    return b;
+}
+
+static void* _slab_alloc(void *ctx, size_t size)
+{
+    int cls = 0;
+    void *p = NULL;
+    _slab_t *s = NULL;
+    _slab_pool_t *pool = NULL;
+
+    (void)ctx;
+
+    if (size > _slab_class_max_) {
+        return my_malloc(size);
+    }
+
+    pool = _slab_pool_get();
+    if (pool == NULL) {
+        return NULL;
+    }
+
+    cls = _slab_class_table[(size + 15) / 16];
+
+    if (pool->current[cls]) {
+        p = _slab_take(pool->current[cls]);
+        if (p) {
+            return p;
+        }
+    }
+
+    // any slab of the class with room
+    for (s = pool->slabs[cls]; s; s = s->next) {
+        p = _slab_take(s);
+        if (p) {
+            pool->current[cls] = s;
+            return p;
+        }
+    }
+
+    while ((s = _slab_adopt(pool, cls)) != NULL) {
+        p = _slab_take(s);
+        if (p) {
+            pool->current[cls] = s;
+            return p;
+        }
+    }
+
+    s = _slab_new(pool, cls);
+    if (s == NULL) {
+        return NULL;
+    }
+    pool->current[cls] = s;
+
+    return _slab_take(s);
+}
+
+static void _slab_free(void *ctx, void *p, size_t size)
+{
+    _slab_t *s = NULL;
+    _slab_block_t *b = (_slab_block_t*)p;
+
+    (void)ctx;
+
+    if (size > _slab_class_max_) {
+        my_free(p);
+        return;
+    }
+
+    s = _slab_of(p);
+    if (_tls_pool && __atomic_load_n(&(s->owner), __ATOMIC_ACQUIRE) == _tls_pool) {
+        b->next = s->free;
+        s->free = b;
+        s->used--;
+        return;
+    }
+
+    // another thread's slab
+    b->next = __atomic_load_n(&(s->remote), __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&(s->remote), &(b->next), b, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+}
+
+static void* _slab_realloc(void *ctx, void *p, size_t old_size, size_t size)
+{
+    void *np = NULL;
+
+    if (p == NULL) {
+        return _slab_alloc(ctx, size);
+    }
+
+    // same block still fits
+    if (old_size <= _slab_class_max_ && size <= _slab_class_max_
+        && _slab_class_table[(old_size + 15) / 16] == _slab_class_table[(size + 15) / 16]) {
+        return p;
+    }
+
+    if (old_size > _slab_class_max_ && size > _slab_class_max_) {
+        return my_realloc(p, size);
+    }
+
+    np = _slab_alloc(ctx, size);
+    if (np == NULL) {
+        return NULL;
+    }
+
+    memcpy(np, p, old_size < size ? old_size : size);
+    _slab_free(ctx, p, old_size);
+
+    return np;
+}
+
+static cjson_allocator_t _slab_allocator = {
+    _slab_alloc, _slab_realloc, _slab_free, NULL, { 0, 0, 0, 0 },
+};
+
+cjson_allocator_t* cjson_slab_allocator(void)
+{
+    return &_slab_allocator;
+}
+
+//===========================================================
+// allocation through an allocator, NULL for the default one
+void* cjson_alloc(cjson_allocator_t *a, size_t size)
+{
+    void *p = NULL;
+
+    if (a == NULL) {
+        a = &_default_allocator;
+    }
+
+    p = a->alloc(a->ctx, size);
+    if (p) {
+        _alloc_stats_on_alloc(a, size);
+    }
+
+#if defined(CJSON_PROFILE)
+    cjson_stats_local()->allocs++;
+    cjson_stats_local()->alloc_bytes += size;
+#endif
+
+    return p;
+}
+
+void* cjson_realloc(cjson_allocator_t *a, void *p, size_t old_size, size_t size)
+{
+    void *np = NULL;
+
+    if (a == NULL) {
+        a = &_default_allocator;
+    }
+
+    if (a->realloc) {
+        np = a->realloc(a->ctx, p, old_size, size);
+    } else {
+        np = a->alloc(a->ctx, size);
+        if (np && p) {
+            memcpy(np, p, old_size < size ? old_size : size);
+            a->free(a->ctx, p, old_size);
+        }
+    }
+
+    if (np) {
+        if (p) {
+            _alloc_stats_on_free(a, old_size);
+        }
+        _alloc_stats_on_alloc(a, size);
+    }
+
+#if defined(CJSON_PROFILE)
+    cjson_stats_local()->allocs++;
+    cjson_stats_local()->alloc_bytes += size;
+#endif
+
+    return np;
+}
+
+void cjson_free(cjson_allocator_t *a, void *p, size_t size)
+{
+    if (p == NULL) {
+        return;
+    }
+
+    if (a == NULL) {
+        a = &_default_allocator;
+    }
+
+    a->free(a->ctx, p, size);
+    _alloc_stats_on_free(a, size);
+}
+
+// approximate while other threads allocate
+void cjson_allocator_stats(const cjson_allocator_t *a, cjson_alloc_stats_t *stats)
+{
+    int i = 0;
+    _alloc_block_t *block = NULL;
+
+    if (a == NULL) {
+        a = &_default_allocator;
+    }
+
+    stats->allocs = __atomic_load_n(&(a->stats.allocs), __ATOMIC_RELAXED);
+    stats->frees = __atomic_load_n(&(a->stats.frees), __ATOMIC_RELAXED);
+    stats->bytes = __atomic_load_n(&(a->stats.bytes), __ATOMIC_RELAXED);
+    stats->live_bytes = __atomic_load_n(&(a->stats.live_bytes), __ATOMIC_RELAXED);
+
+    pthread_mutex_lock(&_alloc_lock);
+    for (block = _alloc_blocks; block; block = block->next) {
+        for (i = 0; i < _alloc_slot_amount_; i++) {
+            if (__atomic_load_n(&(block->slots[i].allocator), __ATOMIC_ACQUIRE) == a) {
+                stats->allocs += block->slots[i].stats.allocs;
+                stats->frees += block->slots[i].stats.frees;
+                stats->bytes += block->slots[i].stats.bytes;
+                stats->live_bytes += block->slots[i].stats.live_bytes;
+                break;
+            }
+        }
+    }
+    pthread_mutex_unlock(&_alloc_lock);
+}
+
+int64_t cjson_memory_live(void)
+{
+    int64_t live = __atomic_load_n(&_live_bytes, __ATOMIC_RELAXED);
+    _alloc_block_t *block = NULL;
+
+    pthread_mutex_lock(&_alloc_lock);
+    for (block = _alloc_blocks; block; block = block->next) {
+        live += block->live_bytes;
+    }
+    pthread_mutex_unlock(&_alloc_lock);
+
+    return live;
+}
+
+// malloc() chunk of size, glibc like: 8 bytes header, 16 bytes aligned, 32 at least
+static size_t _malloc_usable(size_t size)
+{
+    size = (size + 8 + 15) & ~(size_t)15;
+
+    return (size < 32 ? 32 : size);
+}
+
+size_t cjson_alloc_usable(const cjson_allocator_t *a, size_t size)
+{
+    if (a == NULL || a == &_default_allocator) {
+        return _malloc_usable(size);
+    }
+
+    if (a == &_slab_allocator) {
+        if (size > _slab_class_max_) {
+            return _malloc_usable(size);
+        }
+        return _slab_class_sizes[_slab_class_table[(size + 15) / 16]];
+    }
+
+    return size; // unknown
+}
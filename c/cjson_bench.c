@@ -0,0 +1,472 @@
+/************************************************************************************
+* cjson_bench.c: Implementation File
+*
+* cjson decode/encode benchmark
+*
+* DESCRIPTION:
+*   a synthetic corpus generated from a fixed seed, so every run sees the
+*   same bytes: twitter like, numeric heavy, deeply nested, long strings,
+*   wide objects and NDJSON, each at several sizes. Decode, encode and
+*   round trip are timed over it.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   one JSON line per case on stdout:
+*   {"op":"decode","corpus":"twitter","size":"small","bytes":..,"docs":..,
+*    "iters":..,"mb_s":..,"ns_doc":..,"allocs_doc":..,"peak_rss_kb":..}
+*   usage: cjson_bench [corpus|all] [seconds per case]
+*
+************************************************************************************/
+
+#if defined(CJSON_BENCH_MAIN)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include <cjson.h>
+
+#define _BENCH_SEED_                0x5EED2024u
+#define _BENCH_MIN_ITERS_           3
+
+typedef struct {
+    char                *s;
+    size_t              len;
+    size_t              cap;
+} _bench_buf_t;
+
+typedef struct {
+    char                *text;      // the whole corpus text
+    size_t              len;
+    char                **docs;     // docs in text, 0 terminated
+    int64_t             count;
+} _bench_corpus_t;
+
+typedef void (*_bench_gen_t)(_bench_buf_t *b, size_t target);
+
+static uint32_t _rnd_state = _BENCH_SEED_;
+
+//====================================================================
+// corpus
+static uint32_t _rnd(void)
+{
+    // xorshift32, fixed sequence for a fixed seed
+    _rnd_state ^= _rnd_state << 13;
+    _rnd_state ^= _rnd_state >> 17;
+    _rnd_state ^= _rnd_state << 5;
+
+    return _rnd_state;
+}
+
+static void _buf_printf(_bench_buf_t *b, const char *fmt, ...)
+{
+    va_list ap;
+    int n = 0;
+
+    for (;;) {
+        va_start(ap, fmt);
+        n = vsnprintf(b->s + b->len, b->cap - b->len, fmt, ap);
+        va_end(ap);
+
+        if (n >= 0 && b->len + n < b->cap) {
+            b->len += n;
+            return;
+        }
+
+        b->cap = (b->cap + n + 1) * 2;
+        b->s = (char*)realloc(b->s, b->cap);
+        if (b->s == NULL) {
+            fprintf(stderr, "out of memory\n");
+            exit(1);
+        }
+    }
+}
+
+static void _buf_word(_bench_buf_t *b, int min, int max)
+{
+    static const char *const _letters = "abcdefghijklmnopqrstuvwxyz";
+    int n = min + (int)(_rnd() % (uint32_t)(max - min + 1));
+    int i = 0;
+
+    for (i = 0; i < n; i++) {
+        _buf_printf(b, "%c", _letters[_rnd() % 26]);
+    }
+}
+
+static void _buf_text(_bench_buf_t *b, int words)
+{
+    int i = 0;
+
+    for (i = 0; i < words; i++) {
+        if (i > 0) {
+            _buf_printf(b, (_rnd() % 16) == 0 ? "\\n" : " ");
+        }
+        if ((_rnd() % 32) == 0) {
+            _buf_printf(b, "\\\"");
+        }
+        _buf_word(b, 2, 9);
+    }
+}
+
+static void _gen_twitter(_bench_buf_t *b, size_t target)
+{
+    int64_t id = 0;
+    int first = 1;
+
+    _buf_printf(b, "{\"statuses\": [");
+    while (b->len < target) {
+        id = 1000000000 + (int64_t)(_rnd() % 1000000000);
+        _buf_printf(b, "%s\n{\"id\": %lld, \"created_at\": \"Mon Nov 25 0%u:%02u:%02u +0000 2024\", \"text\": \"",
+            first ? "" : ",", (long long)id, _rnd() % 10, _rnd() % 60, _rnd() % 60);
+        _buf_text(b, 8 + (int)(_rnd() % 16));
+        _buf_printf(b, "\", \"truncated\": false, \"in_reply_to_status_id\": null, \"user\": {\"id\": %u, \"name\": \"",
+            _rnd() % 100000000);
+        _buf_word(b, 4, 12);
+        _buf_printf(b, "\", \"screen_name\": \"");
+        _buf_word(b, 4, 15);
+        _buf_printf(b, "\", \"followers_count\": %u, \"friends_count\": %u, \"verified\": %s, \"lang\": \"en\"}, ",
+            _rnd() % 100000, _rnd() % 5000, (_rnd() & 1) ? "true" : "false");
+        _buf_printf(b, "\"entities\": {\"hashtags\": [\"");
+        _buf_word(b, 3, 10);
+        _buf_printf(b, "\", \"");
+        _buf_word(b, 3, 10);
+        _buf_printf(b, "\"], \"urls\": []}, \"retweet_count\": %u, \"favorite_count\": %u, \"favorited\": false}",
+            _rnd() % 1000, _rnd() % 5000);
+        first = 0;
+    }
+    _buf_printf(b, "\n]}");
+}
+
+static void _gen_numeric(_bench_buf_t *b, size_t target)
+{
+    int i = 0;
+
+    _buf_printf(b, "{\"points\": [");
+    while (b->len < target) {
+        _buf_printf(b, "%s\n[", i ? "," : "");
+        _buf_printf(b, "%d.%06u, %d.%06u, %u, -%u.%03u, %ue-%u",
+            (int)(_rnd() % 360) - 180, _rnd() % 1000000, (int)(_rnd() % 180) - 90, _rnd() % 1000000,
+            _rnd(), _rnd() % 10000, _rnd() % 1000, _rnd() % 1000, 1 + _rnd() % 9);
+        _buf_printf(b, "]");
+        i++;
+    }
+    _buf_printf(b, "\n], \"count\": %d}", i);
+}
+
+static void _gen_nested(_bench_buf_t *b, size_t target)
+{
+    // the decoder stack holds 62 levels, stay well inside it
+    int depth = 0;
+    int d = 0;
+    int i = 0;
+
+    _buf_printf(b, "{\"trees\": [");
+    while (b->len < target) {
+        depth = 16 + (int)(_rnd() % 40);
+        _buf_printf(b, "%s\n", i ? "," : "");
+        for (d = 0; d < depth; d++) {
+            if (d & 1) {
+                _buf_printf(b, "[%d, ", d);
+            }
+            else {
+                _buf_printf(b, "{\"level\": %d, \"child\": ", d);
+            }
+        }
+        _buf_printf(b, "\"leaf\"");
+        for (d = depth - 1; d >= 0; d--) {
+            _buf_printf(b, (d & 1) ? "]" : "}");
+        }
+        i++;
+    }
+    _buf_printf(b, "\n]}");
+}
+
+static void _gen_longstr(_bench_buf_t *b, size_t target)
+{
+    int i = 0;
+
+    _buf_printf(b, "{");
+    while (b->len < target) {
+        _buf_printf(b, "%s\n\"s%d\": \"", i ? "," : "", i);
+        _buf_text(b, 200 + (int)(_rnd() % 800));
+        _buf_printf(b, "\"");
+        i++;
+    }
+    _buf_printf(b, "\n}");
+}
+
+static void _gen_wide(_bench_buf_t *b, size_t target)
+{
+    int i = 0;
+
+    _buf_printf(b, "{");
+    while (b->len < target) {
+        _buf_printf(b, "%s\n\"", i ? "," : "");
+        _buf_word(b, 3, 12);
+        switch (_rnd() % 4) {
+        case 0:
+            _buf_printf(b, "_%d\": %u", i, _rnd() % 100000);
+            break;
+        case 1:
+            _buf_printf(b, "_%d\": \"", i);
+            _buf_word(b, 1, 20);
+            _buf_printf(b, "\"");
+            break;
+        case 2:
+            _buf_printf(b, "_%d\": %s", i, (_rnd() & 1) ? "true" : "null");
+            break;
+        default:
+            _buf_printf(b, "_%d\": %u.%02u", i, _rnd() % 1000, _rnd() % 100);
+            break;
+        }
+        i++;
+    }
+    _buf_printf(b, "\n}");
+}
+
+static void _gen_ndjson(_bench_buf_t *b, size_t target)
+{
+    while (b->len < target) {
+        _buf_printf(b, "{\"ts\": %u, \"level\": \"%s\", \"host\": \"",
+            1732500000u + _rnd() % 100000, (_rnd() & 1) ? "info" : "warn");
+        _buf_word(b, 5, 10);
+        _buf_printf(b, "\", \"latency_ms\": %u.%03u, \"tags\": [\"", _rnd() % 500, _rnd() % 1000);
+        _buf_word(b, 2, 6);
+        _buf_printf(b, "\"], \"msg\": \"");
+        _buf_text(b, 4 + (int)(_rnd() % 8));
+        _buf_printf(b, "\"}\n");
+    }
+}
+
+static const struct {
+    const char          *name;
+    _bench_gen_t        gen;
+    int                 lines;      // one document per line
+} _bench_shapes[] = {
+    { "twitter",    _gen_twitter,   0 },
+    { "numeric",    _gen_numeric,   0 },
+    { "nested",     _gen_nested,    0 },
+    { "longstr",    _gen_longstr,   0 },
+    { "wide",       _gen_wide,      0 },
+    { "ndjson",     _gen_ndjson,    1 },
+};
+
+static const struct {
+    const char          *name;
+    size_t              bytes;
+} _bench_sizes[] = {
+    { "small",      1 << 10 },
+    { "medium",     64 << 10 },
+    { "large",      1 << 20 },
+};
+
+#define _countof(a)                 ((int)(sizeof(a) / sizeof((a)[0])))
+
+static void _corpus_make(_bench_corpus_t *c, int shape, int size)
+{
+    _bench_buf_t b = { NULL, 0, 0 };
+    int64_t i = 0;
+    char *p = NULL;
+
+    // every (shape, size) pair starts over from its own seed
+    _rnd_state = _BENCH_SEED_ ^ (uint32_t)(shape * 131 + size * 7 + 1);
+    _bench_shapes[shape].gen(&b, _bench_sizes[size].bytes);
+
+    c->text = b.s;
+    c->len = b.len;
+    c->count = 1;
+
+    if (_bench_shapes[shape].lines) {
+        c->count = 0;
+        for (i = 0; i < (int64_t)b.len; i++) {
+            c->count += (b.s[i] == '\n');
+        }
+    }
+
+    c->docs = (char**)malloc(c->count * sizeof(char*));
+    if (!_bench_shapes[shape].lines) {
+        c->docs[0] = b.s;
+        return;
+    }
+
+    for (i = 0, p = b.s; i < c->count; i++) {
+        c->docs[i] = p;
+        p = strchr(p, '\n');
+        *p++ = 0;
+    }
+}
+
+static void _corpus_free(_bench_corpus_t *c)
+{
+    free(c->docs);
+    free(c->text);
+}
+
+//====================================================================
+// measure
+static double _now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static long _peak_rss_kb(void)
+{
+    struct rusage ru;
+
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+static int64_t _allocs(void)
+{
+    cjson_alloc_stats_t st;
+
+    cjson_allocator_stats(cjson_default_allocator(), &st);
+    return st.allocs;
+}
+
+static void _report(const char *op, int shape, int size, const _bench_corpus_t *c,
+    int64_t iters, double secs, int64_t allocs)
+{
+    int64_t docs = iters * c->count;
+
+    printf("{\"op\": \"%s\", \"corpus\": \"%s\", \"size\": \"%s\", \"bytes\": %zu, \"docs\": %lld, "
+        "\"iters\": %lld, \"mb_s\": %.2f, \"ns_doc\": %.1f, \"allocs_doc\": %.2f, \"peak_rss_kb\": %ld}\n",
+        op, _bench_shapes[shape].name, _bench_sizes[size].name, c->len, (long long)c->count,
+        (long long)iters, (double)c->len * iters / secs / (1024.0 * 1024.0),
+        secs * 1e9 / docs, (double)allocs / docs, _peak_rss_kb());
+    fflush(stdout);
+}
+
+static int _bench_case(int shape, int size, double min_secs)
+{
+    _bench_corpus_t c;
+    cjson_t *trees = NULL;
+    char *out = NULL;
+    int64_t out_len = 0;
+    int64_t iters = 0;
+    int64_t allocs = 0;
+    int64_t i = 0;
+    int64_t n = 0;
+    double t0 = 0;
+    double secs = 0;
+    int ret = 0;
+
+    _corpus_make(&c, shape, size);
+
+    trees = (cjson_t*)calloc(c.count, sizeof(cjson_t));
+    out_len = (int64_t)c.len * 2 + 4096;
+    out = (char*)malloc(out_len);
+
+    // decode, the last pass keeps its trees for encode
+    for (iters = 0, secs = 0, allocs = _allocs(), t0 = _now(); ret == 0; iters++) {
+        for (i = 0; i < c.count; i++) {
+            if (iters > 0) {
+                cjson_object_free(trees[i].object);
+            }
+            if (cjson_decode(c.docs[i], &trees[i]) < 0 || trees[i].object == NULL) {
+                fprintf(stderr, "%s/%s: decode failed at doc %lld\n",
+                    _bench_shapes[shape].name, _bench_sizes[size].name, (long long)i);
+                trees[i].object = NULL;
+                ret = -1;
+            }
+        }
+        secs = _now() - t0;
+        if (iters + 1 >= _BENCH_MIN_ITERS_ && secs >= min_secs) {
+            iters++;
+            break;
+        }
+    }
+    if (ret < 0) {
+        goto release;
+    }
+    _report("decode", shape, size, &c, iters, secs, _allocs() - allocs);
+
+    // encode
+    for (iters = 0, allocs = _allocs(), t0 = _now(); ; ) {
+        for (i = 0; i < c.count; i++) {
+            if (cjson_encode(&trees[i], out, out_len) < 0) {
+                fprintf(stderr, "%s/%s: encode failed\n", _bench_shapes[shape].name, _bench_sizes[size].name);
+                ret = -1;
+                goto release;
+            }
+        }
+        iters++;
+        secs = _now() - t0;
+        if (iters >= _BENCH_MIN_ITERS_ && secs >= min_secs) {
+            break;
+        }
+    }
+    _report("encode", shape, size, &c, iters, secs, _allocs() - allocs);
+
+    // round trip, text => tree => text
+    for (iters = 0, allocs = _allocs(), t0 = _now(); ; ) {
+        for (i = 0; i < c.count; i++) {
+            cjson_t tree;
+
+            if (cjson_decode(c.docs[i], &tree) < 0 || tree.object == NULL) {
+                ret = -1;
+                goto release;
+            }
+            n = cjson_encode(&tree, out, out_len);
+            cjson_object_free(tree.object);
+            if (n < 0) {
+                ret = -1;
+                goto release;
+            }
+        }
+        iters++;
+        secs = _now() - t0;
+        if (iters >= _BENCH_MIN_ITERS_ && secs >= min_secs) {
+            break;
+        }
+    }
+    _report("roundtrip", shape, size, &c, iters, secs, _allocs() - allocs);
+
+release:
+    for (i = 0; i < c.count; i++) {
+        if (trees[i].object) {
+            cjson_object_free(trees[i].object);
+        }
+    }
+    free(trees);
+    free(out);
+    _corpus_free(&c);
+
+    return ret;
+}
+
+//gcc -O2 -I. -DCJSON_BENCH_MAIN cjson_*.c murmurhash.c chashmap.c -o cjson_bench -lpthread -lm
+int main(int argc, char *arg[])
+{
+    const char *only = (argc > 1 ? arg[1] : "all");
+    double min_secs = (argc > 2 ? atof(arg[2]) : 0.2);
+    int shape = 0;
+    int size = 0;
+    int ret = 0;
+
+    for (shape = 0; shape < _countof(_bench_shapes); shape++) {
+        if (strcmp(only, "all") != 0 && strcmp(only, _bench_shapes[shape].name) != 0) {
+            continue;
+        }
+        for (size = 0; size < _countof(_bench_sizes); size++) {
+            if (_bench_case(shape, size, min_secs) < 0) {
+                ret = 1;
+            }
+        }
+    }
+
+    return ret;
+}
+
+#endif
@@ -0,0 +1,311 @@
+/************************************************************************************
+* cjson_bind.c: Implementation File
+*
+* cjson direct binding
+*
+* DESCRIPTION:
+*   decode json text straight into a C struct, described by a table of
+*   fields, without building a document.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   a key is dispatched by murmurhash3_32 with a seed picked at compile
+*   time so that the field names don't collide, one hash, one compare.
+*   names must be unique. Seeds alone need about count^2 / 16 slots, the
+*   table stops growing at _binding_slots_max_, some thousands of fields.
+*
+************************************************************************************/
+
+#include <cjson.h>
+#include <murmurhash.h>
+#include <chashmap.h>
+
+#define _binding_seed_tries_            1024
+#define _binding_slots_min_             8
+#define _binding_slots_max_             (1 << 22)
+
+#define _binding_slot(b, key, len)      (murmurhash3_32((key), (len) * sizeof(tchar_t), (b)->seed) & (b)->slot_mask)
+
+// try seeds until every name has a slot of its own
+static int _binding_perfect_hash(cjson_binding_t *b)
+{
+    int64_t i = 0;
+    uint32_t seed = 0;
+    uint32_t slot = 0;
+
+    for (seed = 1; seed <= _binding_seed_tries_; seed++) {
+        b->seed = seed;
+        memset(b->slots, 0xff, (b->slot_mask + 1) * sizeof(int32_t));
+
+        for (i = 0; i < b->count; i++) {
+            slot = _binding_slot(b, b->fields[i].name, strlen(b->fields[i].name));
+            if (b->slots[slot] >= 0) {
+                break;
+            }
+            b->slots[slot] = (int32_t)i;
+        }
+
+        if (i == b->count) {
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+static uint32_t _name_hash(const void *key, size_t key_size, uint32_t seed)
+{
+    const tchar_t *name = *(const tchar_t* const*)key;
+
+    (void)key_size;
+
+    return murmurhash3_32(name, strlen(name) * sizeof(tchar_t), seed);
+}
+
+static int _name_equal(const void *a, const void *b, size_t key_size)
+{
+    (void)key_size;
+
+    return strcmp(*(const tchar_t* const*)a, *(const tchar_t* const*)b) == 0;
+}
+
+// no seed separates equal names
+static int _binding_unique(const cjson_field_t *fields, int64_t count)
+{
+    chashmap_type_t type = { sizeof(const tchar_t*), 0, _name_hash, _name_equal };
+    chashmap_t *names = NULL;
+    int64_t i = 0;
+    int inserted = 1;
+
+    names = chashmap_create(&type, count);
+    if (names == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < count && inserted; i++) {
+        if (fields[i].name == NULL || chashmap_insert(names, &(fields[i].name), NULL, &inserted) == NULL) {
+            inserted = 0;
+        }
+    }
+    chashmap_free(names);
+
+    return (inserted ? 0 : -1);
+}
+
+cjson_binding_t* cjson_binding_compile(const cjson_field_t *fields, int64_t count)
+{
+    int64_t n = _binding_slots_min_;
+    cjson_binding_t *b = NULL;
+
+    if (fields == NULL || count <= 0 || count > _binding_slots_max_ / 2) {
+        return NULL;
+    }
+    if (_binding_unique(fields, count) < 0) {
+        return NULL;
+    }
+
+    b = (cjson_binding_t*)my_malloc(sizeof(cjson_binding_t));
+    if (b == NULL) {
+        return NULL;
+    }
+    memset(b, 0, sizeof(cjson_binding_t));
+    b->fields = fields;
+    b->count = count;
+
+    while (n < count * 2) {
+        n *= 2;
+    }
+
+    // a larger table when no seed works
+    for (; n <= _binding_slots_max_; n *= 2) {
+        b->slots = (int32_t*)my_malloc(n * sizeof(int32_t));
+        if (b->slots == NULL) {
+            break;
+        }
+        b->slot_mask = (uint32_t)(n - 1);
+
+        if (_binding_perfect_hash(b) == 0) {
+            return b;
+        }
+
+        my_free(b->slots);
+        b->slots = NULL;
+    }
+
+    my_free(b);
+
+    return NULL;
+}
+
+void cjson_binding_free(cjson_binding_t *binding)
+{
+    if (binding == NULL) {
+        return;
+    }
+
+    if (binding->slots) {
+        my_free(binding->slots);
+    }
+
+    my_free(binding);
+}
+
+static const cjson_field_t* _binding_find(const cjson_binding_t *b, const tchar_t *key, int64_t len)
+{
+    int32_t idx = b->slots[_binding_slot(b, key, len)];
+    const cjson_field_t *f = NULL;
+
+    if (idx < 0) {
+        return NULL;
+    }
+
+    f = &(b->fields[idx]);
+    if (strncmp(f->name, key, len) != 0 || f->name[len] != 0) {
+        return NULL;
+    }
+
+    return f;
+}
+
+// one value => the field, return chars consumed, or -1 for error
+static int64_t _bind_field(const cjson_field_t *f, const tchar_t *json_text, uint8_t *out)
+{
+    int64_t ret = 0;
+    int64_t len = 0;
+    const tchar_t *s = NULL;
+    cjson_value_t val;
+    cjson_number_t num;
+
+    // null leaves the field as is
+    if (strncmp(json_text, _T("null"), 4) == 0) {
+        return 4;
+    }
+
+    switch (f->type) {
+    case _cjson_field_int32_:
+    case _cjson_field_int64_:
+    case _cjson_field_double_:
+    case _cjson_field_number_:
+        ret = cjson_scan_number(json_text, &val);
+        if (ret <= 0 || cjson_value_get_number(&val, &num) < 0) {
+            return -1;
+        }
+        if (f->type == _cjson_field_int32_) {
+            if (num.number / num.divisor < INT32_MIN || num.number / num.divisor > INT32_MAX) {
+                return -1;
+            }
+            *(int32_t*)(out + f->offset) = (int32_t)(num.number / num.divisor);
+        } else if (f->type == _cjson_field_int64_) {
+            *(int64_t*)(out + f->offset) = num.number / num.divisor;
+        } else if (f->type == _cjson_field_double_) {
+            *(double*)(out + f->offset) = (double)num.number / (double)num.divisor;
+        } else {
+            *(cjson_number_t*)(out + f->offset) = num;
+        }
+        return ret;
+
+    case _cjson_field_bool_:
+        if (strncmp(json_text, _T("true"), 4) == 0) {
+            ret = 4;
+        } else if (strncmp(json_text, _T("false"), 5) == 0) {
+            ret = 5;
+        } else {
+            return -1;
+        }
+        if (f->size == 1) {
+            *(uint8_t*)(out + f->offset) = (ret == 4);
+        } else {
+            *(int*)(out + f->offset) = (ret == 4);
+        }
+        return ret;
+
+    case _cjson_field_string_:
+        ret = cjson_scan_string(json_text, &s, &len);
+        if (ret < 0 || f->size < sizeof(tchar_t)) {
+            return -1;
+        }
+        // -1 if too long for the buffer, with the '\0'
+        len = cjson_unescape(s, len, (tchar_t*)(out + f->offset), (int64_t)(f->size / sizeof(tchar_t)) - 1);
+        if (len < 0) {
+            return -1;
+        }
+        ((tchar_t*)(out + f->offset))[len] = 0;
+        return ret;
+
+    case _cjson_field_object_:
+        return cjson_bind(f->binding, json_text, out + f->offset);
+
+    default:
+        break;
+    }
+
+    return -1;
+}
+
+int64_t cjson_bind(const cjson_binding_t *binding, const tchar_t *json_text, void *out)
+{
+    int64_t i = 0;
+    int64_t ret = 0;
+    int64_t len = 0;
+    const tchar_t *key = NULL;
+    const cjson_field_t *f = NULL;
+
+    if (binding == NULL || json_text == NULL || out == NULL) {
+        return -1;
+    }
+
+    i += cjson_scan_ws(json_text);
+    if (json_text[i] != _T('{')) {
+        return -1;
+    }
+    i++;
+
+    i += cjson_scan_ws(&json_text[i]);
+    if (json_text[i] == _T('}')) {
+        return i + 1;
+    }
+
+    for (;;) {
+        // "key"
+        ret = cjson_scan_string(&json_text[i], &key, &len);
+        if (ret < 0) {
+            return -1;
+        }
+        i += ret;
+
+        // ':'
+        i += cjson_scan_ws(&json_text[i]);
+        if (json_text[i] != _T(':')) {
+            return -1;
+        }
+        i++;
+        i += cjson_scan_ws(&json_text[i]);
+
+        // value, unknown keys are skipped
+        f = _binding_find(binding, key, len);
+        if (f) {
+            ret = _bind_field(f, &json_text[i], (uint8_t*)out);
+        } else {
+            ret = cjson_skip_value(&json_text[i]);
+        }
+        if (ret <= 0) {
+            return -1;
+        }
+        i += ret;
+
+        // ',' or '}'
+        i += cjson_scan_ws(&json_text[i]);
+        if (json_text[i] == _T('}')) {
+            return i + 1;
+        }
+        if (json_text[i] != _T(',')) {
+            return -1;
+        }
+        i++;
+        i += cjson_scan_ws(&json_text[i]);
+    }
+}
@@ -16,143 +16,574 @@
 ************************************************************************************/
 
 #include <cjson.h>
+#include <chashmap.h>
+#include <murmurhash.h>
+
+static int _key_set(cjson_objkey_t *k, const tchar_t *key, int64_t len, cjson_allocator_t *a);
+
+//===========================================================
+// elements & kvs are kept in arrays, grown by doubling
+#define _container_init_capacity_       4
+
+static int _container_grow(cjson_allocator_t *a, void **items, int64_t *capacity, int64_t count, size_t item_size)
+{
+    int64_t n = 0;
+    void *p = NULL;
+
+    if (count < *capacity) {
+        return 0;
+    }
+
+    n = (*capacity == 0) ? _container_init_capacity_ : *capacity * 2;
+    p = cjson_realloc(a, *items, *capacity * item_size, n * item_size);
+    if (p == NULL) {
+        return -1;
+    }
+
+    *items = p;
+    *capacity = n;
+
+    return 0;
+}
+
+//===========================================================
+// spans, a change marks the container & its ancestors dirty
+static void _span_touch(cjson_span_t *span)
+{
+    for (; span && !span->dirty; span = span->parent) {
+        span->dirty = 1;
+    }
+}
+
+// a container value moved under span
+static void _span_adopt(cjson_value_t *val, cjson_span_t *span)
+{
+    if (val->value_type == _cjson_value_array_) {
+        val->cjson_arrval->span.parent = span;
+    } else if (val->value_type == _cjson_value_object_) {
+        val->cjson_objval->span.parent = span;
+    }
+}
 
 //===========================================================
 // cjson array
+static int _array_add(cjson_array_t *data, cjson_value_t *elem)
+{
+    if (_container_grow(data->allocator, (void**)&(data->elem), &(data->capacity), data->count, sizeof(cjson_value_t)) < 0) {
+        return -1;
+    }
+
+    data->elem[data->count] = *elem;
+    _span_adopt(&(data->elem[data->count]), &(data->span));
+    data->count++;
+
+    return 0;
+}
+
+// elem is moved into the array, the array owns its payload then
 int cjson_array_add(cjson_array_t *data, cjson_value_t *elem)
 {
-    int i = 0;
-    cjson_value_t dummy;
-    cjson_value_t *tail = NULL;
+    if (_array_add(data, elem) < 0) {
+        return -1;
+    }
 
-    dummy.next = data->elem;
-    tail = &dummy;
-    for (i = 0; i < data->count; i++) {
-        tail = tail->next;
+    _span_touch(&(data->span));
+
+    return 0;
+}
+
+int cjson_array_set(cjson_array_t *data, int64_t index, cjson_value_t *elem)
+{
+    if (index < 0 || index >= data->count) {
+        return -1;
     }
 
-    tail->next = elem;
-    elem->next = NULL;
+    cjson_value_free(&(data->elem[index]));
+    data->elem[index] = *elem;
+    _span_adopt(&(data->elem[index]), &(data->span));
+    _span_touch(&(data->span));
 
-    data->count++;
+    return 0;
+}
+
+int cjson_array_insert(cjson_array_t *data, int64_t index, cjson_value_t *elem)
+{
+    if (index < 0 || index > data->count) {
+        return -1;
+    }
 
-    if (data->count == 1) {
-        data->elem = elem;
+    if (_container_grow(data->allocator, (void**)&(data->elem), &(data->capacity), data->count, sizeof(cjson_value_t)) < 0) {
+        return -1;
     }
 
+    memmove(&(data->elem[index + 1]), &(data->elem[index]), (data->count - index) * sizeof(cjson_value_t));
+    data->elem[index] = *elem;
+    _span_adopt(&(data->elem[index]), &(data->span));
+    data->count++;
+    _span_touch(&(data->span));
+
     return 0;
 }
 
-cjson_value_t* cjson_array_get(const cjson_array_t *data, int index)
+int cjson_array_remove(cjson_array_t *data, int64_t index, cjson_value_t *out)
 {
-    cjson_value_t *ret = NULL;
-    int i = 0;
     if (index < 0 || index >= data->count) {
-        return NULL;
+        return -1;
     }
 
-    do {
-        ret = data->elem;
-        i++;
-    } while (i <= index);
+    if (out) {
+        *out = data->elem[index];
+    } else {
+        cjson_value_free(&(data->elem[index]));
+    }
+
+    data->count--;
+    memmove(&(data->elem[index]), &(data->elem[index + 1]), (data->count - index) * sizeof(cjson_value_t));
+    _span_touch(&(data->span));
 
-    for (i = 1; ; i++) {
-        ret = ret->next;
+    return 0;
+}
+
+void cjson_array_touch(cjson_array_t *data)
+{
+    _span_touch(&(data->span));
+}
+
+cjson_value_t* cjson_array_get(const cjson_array_t *data, int64_t index)
+{
+    if (index < 0 || index >= data->count) {
+        return NULL;
     }
 
-    return ret;
+    return &(data->elem[index]);
 }
 
 int cjson_array_free(cjson_array_t *val)
 {
-    int i = 0;
+    int64_t i = 0;
     int ret = 0;
-    cjson_value_t *tmp = NULL;
+
+    // shared, another owner frees it
+    if (__atomic_load_n(&(val->refs), __ATOMIC_ACQUIRE) > 0 && __atomic_fetch_sub(&(val->refs), 1, __ATOMIC_ACQ_REL) > 0) {
+        return 0;
+    }
 
     for (i = 0; i < val->count; i++) {
-        tmp = val->elem;
-        val->elem = val->elem->next;
-        cjson_value_free(tmp);
+        cjson_value_free(&(val->elem[i]));
+    }
+
+    if (val->elem) {
+        cjson_free(val->allocator, val->elem, val->capacity * sizeof(cjson_value_t));
     }
 
+    cjson_free(val->allocator, val, sizeof(cjson_array_t));
+
     return ret;
 }
 
 //===========================================================
 // cjson object
-int cjson_object_addkv(cjson_object_t *data, cjson_kv_t *kv)
+#define _object_keys(obj)               ((obj)->shape ? (obj)->shape->keys : (obj)->keys)
+
+//===========================================================
+// object index, the positions of the keys in a hash map. The map keeps
+// no keys, they are compared where the object has them.
+struct __index_probe_t {
+    const tchar_t           *key;
+    int64_t                 len;
+};
+typedef struct __index_probe_t      _index_probe_t;
+
+static const chashmap_type_t _index_type = { sizeof(uint32_t), 0, NULL, NULL };
+
+#define _index_hash(key, len)           murmurhash3_32((key), (len) * sizeof(tchar_t), CJSON_KEY_HASH_SEED)
+
+static int _index_match(void *ctx, const void *probe, const void *key)
+{
+    const cjson_object_t *obj = (const cjson_object_t*)ctx;
+    const _index_probe_t *p = (const _index_probe_t*)probe;
+    const cjson_objkey_t *k = &(_object_keys(obj)[*(const uint32_t*)key]);
+
+    return cjson_key_len(k) == p->len && memcmp(cjson_key_str(k), p->key, p->len * sizeof(tchar_t)) == 0;
+}
+
+static cjson_value_t* _index_find(const cjson_object_t *data, const tchar_t *key, int64_t len, uint32_t hash)
+{
+    _index_probe_t probe = { key, len };
+    const uint32_t *pos = NULL;
+
+    pos = (const uint32_t*)chashmap_find_with(data->index, hash, _index_match, (void*)data, &probe);
+
+    return (pos ? &(data->vals[*pos]) : NULL);
+}
+
+// the key at i, unless an earlier one has it
+static int _index_add(cjson_object_t *data, int64_t i)
 {
-    int i = 0;
-    cjson_kv_t dummy;
-    cjson_kv_t *tail = NULL;
+    const cjson_objkey_t *k = &(_object_keys(data)[i]);
+    uint32_t pos = (uint32_t)i;
+    uint32_t hash = 0;
 
-    //printf("addkv 1: count: %d, value-addr: %p\n", data->count, data->kvs);
+    hash = data->shape ? data->shape->key_hashes[i] : _index_hash(cjson_key_str(k), cjson_key_len(k));
+    if (_index_find(data, cjson_key_str(k), cjson_key_len(k), hash)) {
+        return 0;
+    }
+
+    return (chashmap_insert_h(data->index, &pos, hash, NULL, NULL) ? 0 : -1);
+}
+
+static int _index_match_pos(void *ctx, const void *probe, const void *key)
+{
+    (void)ctx;
+
+    return *(const uint32_t*)probe == *(const uint32_t*)key;
+}
+
+// the entry of position i goes & the positions after it move down, hash
+// was its key's, dup the position the next equal key has now, -1 if none
+static int _index_remove(cjson_object_t *data, int64_t i, uint32_t hash, int64_t dup)
+{
+    uint32_t pos = (uint32_t)i;
+    uint32_t *e = NULL;
+    int64_t it = 0;
+
+    e = (uint32_t*)chashmap_find_with(data->index, hash, _index_match_pos, NULL, &pos);
+    if (e) {
+        chashmap_erase_entry(data->index, e);
+    }
+
+    for (e = (uint32_t*)chashmap_first(data->index, &it); e; e = (uint32_t*)chashmap_next(data->index, &it)) {
+        *e -= (*e > pos);
+    }
+
+    return (dup < 0 ? 0 : _index_add(data, dup));
+}
+
+static void _index_drop(cjson_object_t *data)
+{
+    chashmap_free(data->index);
+    data->index = NULL;
+}
+
+int cjson_object_index(cjson_object_t *data)
+{
+    int64_t i = 0;
+
+    if (data->index) {
+        return 0;
+    }
+
+    data->index = chashmap_create(&_index_type, data->count);
+    if (data->index == NULL) {
+        return -1;
+    }
 
-    dummy.next = data->kvs;
-    tail = &dummy;
     for (i = 0; i < data->count; i++) {
-        tail = tail->next;
+        if (_index_add(data, i) < 0) {
+            _index_drop(data);
+            return -1;
+        }
     }
 
-    tail->next = kv;
-    kv->next = NULL;
+    return 0;
+}
 
+// room for one more value, and key if the object has its own keys
+static int _object_grow(cjson_object_t *data)
+{
+    int64_t n = 0;
+    void *p = NULL;
+
+    if (data->count < data->capacity) {
+        return 0;
+    }
+
+    n = (data->capacity == 0) ? _container_init_capacity_ : data->capacity * 2;
+
+    p = cjson_realloc(data->allocator, data->vals, data->capacity * sizeof(cjson_value_t), n * sizeof(cjson_value_t));
+    if (p == NULL) {
+        return -1;
+    }
+    data->vals = (cjson_value_t*)p;
+
+    if (data->shape == NULL) {
+        p = cjson_realloc(data->allocator, data->keys, data->capacity * sizeof(cjson_objkey_t), n * sizeof(cjson_objkey_t));
+        if (p == NULL) {
+            return -1;
+        }
+        data->keys = (cjson_objkey_t*)p;
+    }
+
+    data->capacity = n;
+
+    return 0;
+}
+
+// shaped object => own keys, copied from the shape
+static int _object_unshape(cjson_object_t *data)
+{
+    int64_t i = 0;
+    cjson_objkey_t *keys = NULL;
+    const cjson_objkey_t *k = NULL;
+
+    if (data->shape == NULL) {
+        return 0;
+    }
+
+    if (data->capacity > 0) {
+        keys = (cjson_objkey_t*)cjson_alloc(data->allocator, data->capacity * sizeof(cjson_objkey_t));
+        if (keys == NULL) {
+            return -1;
+        }
+    }
+
+    for (i = 0; i < data->count; i++) {
+        k = &(data->shape->keys[i]);
+        if (_key_set(&keys[i], cjson_key_str(k), cjson_key_len(k), data->allocator) < 0) {
+            while (i-- > 0) {
+                cjson_key_free(&keys[i]);
+            }
+            cjson_free(data->allocator, keys, data->capacity * sizeof(cjson_objkey_t));
+            return -1;
+        }
+    }
+
+    data->keys = keys;
+    data->shape = NULL;
+
+    return 0;
+}
+
+static int _object_addkv(cjson_object_t *data, cjson_kv_t *kv)
+{
+    if (_object_unshape(data) < 0 || _object_grow(data) < 0) {
+        return -1;
+    }
+
+    data->keys[data->count] = kv->__key;
+    data->vals[data->count] = kv->value;
+    _span_adopt(&(data->vals[data->count]), &(data->span));
     data->count++;
 
-    if (data->count == 1) {
-        data->kvs = kv;
+    // without the index lookups just scan again
+    if (data->index && _index_add(data, data->count - 1) < 0) {
+        _index_drop(data);
+    }
+
+    return 0;
+}
+
+// kv is moved into the object, the object owns its key & value then
+int cjson_object_addkv(cjson_object_t *data, cjson_kv_t *kv)
+{
+    if (_object_addkv(data, kv) < 0) {
+        return -1;
     }
 
-    //printf("addkv 2: count: %d, value: %s\n", data->count, data->kvs->value.cjson_strval);
+    _span_touch(&(data->span));
 
     return 0;
 }
 
+void cjson_object_touch(cjson_object_t *data)
+{
+    _span_touch(&(data->span));
+}
+
 int cjson_object_free(cjson_object_t *data)
 {
-    int i = 0;
-    cjson_kv_t *tmp = NULL;
+    int64_t i = 0;
+
+    // shared, another owner frees it
+    if (__atomic_load_n(&(data->refs), __ATOMIC_ACQUIRE) > 0 && __atomic_fetch_sub(&(data->refs), 1, __ATOMIC_ACQ_REL) > 0) {
+        return 0;
+    }
 
     for (i = 0; i < data->count; i++) {
-        tmp = data->kvs;
-        data->kvs = data->kvs->next;
+        if (data->shape == NULL) {
+            cjson_key_free(&(data->keys[i]));
+        }
+        cjson_value_free(&(data->vals[i]));
+    }
 
-        cjson_kv_free(tmp);
+    if (data->keys) {
+        cjson_free(data->allocator, data->keys, data->capacity * sizeof(cjson_objkey_t));
     }
 
-    my_free(data);
+    if (data->vals) {
+        cjson_free(data->allocator, data->vals, data->capacity * sizeof(cjson_value_t));
+    }
+
+    chashmap_free(data->index);
+
+    cjson_free(data->allocator, data, sizeof(cjson_object_t));
 
     return 0;
 }
 
-cjson_kv_t* cjson_object_first(cjson_object_t *data, position_t *pos)
+cjson_value_t* cjson_object_first_value(cjson_object_t *data, position_t *pos)
 {
     if (data->count == 0) {
         return NULL;
     }
 
-    *pos = (position_t)(data->kvs);
+    *pos = (position_t)(data->vals);
 
-    return data->kvs;
+    return data->vals;
 }
 
-cjson_kv_t* cjson_object_next(cjson_object_t *data, position_t *pos)
+cjson_value_t* cjson_object_next_value(cjson_object_t *data, position_t *pos)
 {
-    cjson_kv_t *kv = NULL;
+    cjson_value_t *val = NULL;
 
     if (pos == NULL) {
         return NULL;
     }
 
-    kv = (cjson_kv_t*)(*pos);
-    kv = kv->next;
+    val = (cjson_value_t*)(*pos);
+    val++;
+    if (val >= data->vals + data->count) {
+        return NULL;
+    }
+
+    *pos = (position_t)(val);
+
+    return val;
+}
+
+// kv holds copies, the key & value stay with the object
+static cjson_kv_t* _object_kv_copy(const cjson_object_t *data, const cjson_value_t *val, cjson_kv_t *kv)
+{
+    if (val == NULL || kv == NULL) {
+        return NULL;
+    }
 
-    *pos = (position_t)(kv);
+    kv->__key = _object_keys(data)[val - data->vals];
+    kv->value = *val;
 
     return kv;
 }
 
+cjson_kv_t* cjson_object_first(cjson_object_t *data, position_t *pos, cjson_kv_t *kv)
+{
+    return _object_kv_copy(data, cjson_object_first_value(data, pos), kv);
+}
+
+cjson_kv_t* cjson_object_next(cjson_object_t *data, position_t *pos, cjson_kv_t *kv)
+{
+    return _object_kv_copy(data, cjson_object_next_value(data, pos), kv);
+}
+
+const tchar_t* cjson_object_key(const cjson_object_t *data, const cjson_value_t *val, int64_t *len)
+{
+    int64_t i = val - data->vals;
+    const cjson_objkey_t *k = NULL;
+
+    if (i < 0 || i >= data->count) {
+        return NULL;
+    }
+
+    k = &(_object_keys(data)[i]);
+    if (len) {
+        *len = cjson_key_len(k);
+    }
+
+    return cjson_key_str(k);
+}
+
 //===========================================================
+// long strings & keys
+static cjson_string_t* _string_new(cjson_allocator_t *a, const tchar_t *s, int64_t len)
+{
+    cjson_string_t *str = NULL;
+
+    str = (cjson_string_t*)cjson_alloc(a, sizeof(cjson_string_t) + ((len + 1) * sizeof(tchar_t)));
+    if (str == NULL) {
+        return NULL;
+    }
+    str->allocator = a;
+    str->capacity = len + 1;
+    str->len = len;
+    memcpy(str->s, s, len * sizeof(tchar_t));
+    str->s[len] = 0;
+
+    return str;
+}
+
+static void _string_free(cjson_string_t *str)
+{
+    cjson_free(str->allocator, str, sizeof(cjson_string_t) + (str->capacity * sizeof(tchar_t)));
+}
+
+// string => short string inline, or a cjson_string_t
+static int _value_set_string(cjson_value_t *val, const tchar_t *s, int64_t len, cjson_allocator_t *a)
+{
+    tchar_t *sstr = NULL;
+
+    val->value_type = _cjson_value_string_;
+
+    if (len <= CJSON_SSTR_LEN_MAX) {
+        sstr = cjson_sstrval(val);
+        memcpy(sstr, s, len * sizeof(tchar_t));
+        sstr[len] = 0;
+        val->__aux = (unsigned char)len;
+        return 0;
+    }
+
+    val->cjson_strval = _string_new(a, s, len);
+    if (val->cjson_strval == NULL) {
+        val->value_type = _cjson_value_unknown_;
+        return -1;
+    }
+    val->__aux = _cjson_sstr_long_;
+
+    return 0;
+}
+
+int cjson_value_set_string(cjson_value_t *val, const tchar_t *s, int64_t len)
+{
+    return _value_set_string(val, s, len, NULL);
+}
+
+static const int64_t _pow10_table[CJSON_NUMBER_SCALE_MAX + 1] = {
+    1LL, 10LL, 100LL, 1000LL, 10000LL, 100000LL, 1000000LL, 10000000LL, 100000000LL,
+    1000000000LL, 10000000000LL, 100000000000LL, 1000000000000LL, 10000000000000LL,
+    100000000000000LL, 1000000000000000LL, 10000000000000000LL, 100000000000000000LL,
+    1000000000000000000LL,
+};
+
+// number => inline mantissa & decimal scale, divisor must be a power of 10
+int cjson_value_set_number(cjson_value_t *val, int64_t number, int64_t divisor)
+{
+    int scale = 0;
+
+    while (scale <= CJSON_NUMBER_SCALE_MAX && _pow10_table[scale] != divisor) {
+        scale++;
+    }
+
+    if (scale > CJSON_NUMBER_SCALE_MAX) {
+        return -1;
+    }
+
+    val->value_type = _cjson_value_number_;
+    val->cjson_numval = number;
+    val->cjson_numscale = (unsigned char)scale;
+
+    return 0;
+}
+
+int cjson_value_get_number(const cjson_value_t *val, cjson_number_t *num)
+{
+    if (val->value_type != _cjson_value_number_ || val->cjson_numscale > CJSON_NUMBER_SCALE_MAX) {
+        return -1;
+    }
+
+    num->number = val->cjson_numval;
+    num->divisor = _pow10_table[val->cjson_numscale];
+
+    return 0;
+}
+
 int cjson_value_free(cjson_value_t *val)
 {
     if (val->value_type == _cjson_value_object_) {
@@ -161,16 +592,58 @@ int cjson_value_free(cjson_value_t *val)
     else if (val->value_type == _cjson_value_array_) {
         cjson_array_free(val->cjson_arrval);
     }
+    else if (val->value_type == _cjson_value_string_ && cjson_value_str_is_long(val)) {
+        _string_free(val->cjson_strval);
+    }
+
+    val->value_type = _cjson_value_unknown_;
 
     return 0;
 }
 
-int cjson_kv_free(cjson_kv_t *kv)
+// key => short key inline, or a cjson_string_t
+static int _key_set(cjson_objkey_t *k, const tchar_t *key, int64_t len, cjson_allocator_t *a)
+{
+    if (len <= CJSON_KEY_LEN_MAX) {
+        memcpy(k->sbuf, key, len * sizeof(tchar_t));
+        k->sbuf[len] = 0;
+        k->sbuf[_cjson_key_len_idx_] = (tchar_t)len;
+        k->sbuf[_cjson_key_flag_idx_] = 0;
+        return 0;
+    }
+
+    k->lkey = _string_new(a, key, len);
+    if (k->lkey == NULL) {
+        return -1;
+    }
+    k->sbuf[_cjson_key_flag_idx_] = 1;
+
+    return 0;
+}
+
+int cjson_key_set(cjson_objkey_t *k, const tchar_t *key, int64_t len)
 {
-    if (kv->key) {
-        my_free(kv->key);
+    return _key_set(k, key, len, NULL);
+}
+
+int cjson_key_free(cjson_objkey_t *k)
+{
+    if (cjson_key_is_long(k)) {
+        _string_free(k->lkey);
+        k->sbuf[_cjson_key_flag_idx_] = 0;
     }
 
+    return 0;
+}
+
+int cjson_kv_set_key(cjson_kv_t *kv, const tchar_t *key, int64_t len)
+{
+    return cjson_key_set(&(kv->__key), key, len);
+}
+
+int cjson_kv_free(cjson_kv_t *kv)
+{
+    cjson_key_free(&(kv->__key));
     cjson_value_free(&(kv->value));
 
     return 0;
@@ -178,28 +651,142 @@ int cjson_kv_free(cjson_kv_t *kv)
 
 cjson_value_t* cjson_object_get_value(const cjson_object_t *data, const tchar_t *key)
 {
-    int i = 0;
+    int64_t i = 0;
     cjson_value_t *ret = NULL;
-    cjson_kv_t *kv = NULL;
+    const cjson_objkey_t *k = NULL;
 
     if (data == NULL) {
         //printf("data is NULL\n");
         return NULL;
     }
 
-    kv = data->kvs;
-    for (i = 0; i < data->count; i++) {
-        //printf("get value key: %s\n", kv->key);
-        if (strcmp(kv->key->s, key) == 0) {
-            ret = &(kv->value);
+    if (data->index) {
+        i = strlen(key);
+        return _index_find(data, key, i, _index_hash(key, i));
+    }
+
+    k = _object_keys(data);
+    for (i = 0; i < data->count; i++, k++) {
+        if (strcmp(cjson_key_str(k), key) == 0) {
+            ret = &(data->vals[i]);
             break;
         }
-        kv = kv->next;
     }
 
     return ret;
 }
 
+cjson_value_t* cjson_object_get_value_h(const cjson_object_t *data, const tchar_t *key, int64_t len, uint32_t hash)
+{
+    int64_t i = 0;
+    const cjson_objkey_t *k = NULL;
+
+    if (data == NULL) {
+        return NULL;
+    }
+
+    if (data->index) {
+        return _index_find(data, key, len, hash);
+    }
+
+    // shaped objects carry the hash of every key, one compare per key
+    if (data->shape) {
+        for (i = 0; i < data->count; i++) {
+            if (data->shape->key_hashes[i] == hash) {
+                k = &(data->shape->keys[i]);
+                if (cjson_key_len(k) == len && memcmp(cjson_key_str(k), key, len * sizeof(tchar_t)) == 0) {
+                    return &(data->vals[i]);
+                }
+            }
+        }
+        return NULL;
+    }
+
+    k = data->keys;
+    for (i = 0; i < data->count; i++, k++) {
+        if (cjson_key_len(k) == len && memcmp(cjson_key_str(k), key, len * sizeof(tchar_t)) == 0) {
+            return &(data->vals[i]);
+        }
+    }
+
+    return NULL;
+}
+
+int cjson_object_set_value(cjson_object_t *data, const tchar_t *key, cjson_value_t *val)
+{
+    cjson_kv_t kv;
+    cjson_value_t *old = NULL;
+
+    old = cjson_object_get_value(data, key);
+    if (old) {
+        cjson_value_free(old);
+        *old = *val;
+        _span_adopt(old, &(data->span));
+        _span_touch(&(data->span));
+        return 0;
+    }
+
+    if (_key_set(&(kv.__key), key, strlen(key), data->allocator) < 0) {
+        return -1;
+    }
+    kv.value = *val;
+
+    if (_object_addkv(data, &kv) < 0) {
+        cjson_key_free(&(kv.__key));
+        return -1;
+    }
+
+    _span_touch(&(data->span));
+
+    return 0;
+}
+
+int cjson_object_remove(cjson_object_t *data, const tchar_t *key, cjson_value_t *out)
+{
+    int64_t i = 0;
+    int64_t dup = -1;
+    uint32_t hash = 0;
+    const cjson_objkey_t *k = NULL;
+    cjson_value_t *val = NULL;
+
+    val = cjson_object_get_value(data, key);
+    if (val == NULL || _object_unshape(data) < 0) {
+        return -1;
+    }
+    i = val - data->vals;
+
+    // an equal key later on is the one found once this goes
+    if (data->index) {
+        k = &(data->keys[i]);
+        hash = _index_hash(cjson_key_str(k), cjson_key_len(k));
+        for (dup = i + 1; dup < data->count; dup++) {
+            if (cjson_key_len(&(data->keys[dup])) == cjson_key_len(k)
+                && memcmp(cjson_key_str(&(data->keys[dup])), cjson_key_str(k), cjson_key_len(k) * sizeof(tchar_t)) == 0) {
+                break;
+            }
+        }
+        dup = (dup < data->count) ? dup - 1 : -1;
+    }
+
+    if (out) {
+        *out = *val;
+    } else {
+        cjson_value_free(val);
+    }
+    cjson_key_free(&(data->keys[i]));
+
+    data->count--;
+    memmove(&(data->keys[i]), &(data->keys[i + 1]), (data->count - i) * sizeof(cjson_objkey_t));
+    memmove(&(data->vals[i]), &(data->vals[i + 1]), (data->count - i) * sizeof(cjson_value_t));
+    _span_touch(&(data->span));
+
+    if (data->index && _index_remove(data, i, hash, dup) < 0) {
+        _index_drop(data);
+    }
+
+    return 0;
+}
+
 cjson_value_t* cjson_array_first(cjson_array_t *data, position_t *pos)
 {
     if (data->count == 0) {
@@ -220,8 +807,11 @@ cjson_value_t* cjson_array_next(cjson_array_t *data, position_t *pos)
     }
 
     val = (cjson_value_t*)(*pos);
+    val++;
+    if (val >= data->elem + data->count) {
+        return NULL;
+    }
 
-    val = val->next;
     *pos = (position_t)(val);
 
     return val;
@@ -262,6 +852,9 @@ static const tchar_t _token_fsm_table[128] = {
     -1, -1, -1, -1,    9, -1, -1, -1,   -1, -1, -1,  4,   -1,  5, -1, -1,
 };
 
+// token of a char, -1 to ignore, non ASCII chars are ignored too
+#define _token_of(c)                    ((unsigned char)(c) < 128 ? _token_fsm_table[(unsigned char)(c)] : -1)
+
 //==============================================================
 
 #define _token_stack_capacity_          (_token_stack_buf_size_ - 1) // nests depth
@@ -284,8 +877,9 @@ struct __token_stack_t {
 
 typedef struct __token_stack_t      _stack_t;
 
-#define _stack_top(stk)             (stk)->stk_data[(stk)->stk_top]
-#define _stack_peek(stk)            _stack_top(stk)
+#define _stack_top(stk)             (stk)->stk_data[(int)(stk)->stk_top]
+// 0 when empty, a value outside of any container peeks too
+#define _stack_peek(stk)            ((stk)->stk_top == _token_stack_bottom_ ? 0 : _stack_top(stk))
 
 int _stack_push(_stack_t *stk, tchar_t c)
 {
@@ -295,7 +889,7 @@ int _stack_push(_stack_t *stk, tchar_t c)
     }
 
     stk->stk_top++;
-    stk->stk_data[stk->stk_top] = c;
+    stk->stk_data[(int)stk->stk_top] = c;
     //printf("=== push[%d]: %c\n", stk->stk_top,  c);
     return c;
 }
@@ -309,7 +903,7 @@ int _stack_pop(_stack_t *stk)
         return -1;
     }
     //printf("=== pop[%d] %c\n", stk->stk_top, _stack_peek(stk));
-    ret = stk->stk_data[stk->stk_top];
+    ret = stk->stk_data[(int)stk->stk_top];
     stk->stk_top--;
     return ret;
 }
@@ -341,25 +935,44 @@ struct _decode_context_t {
         decode_object_state_e       object_state;
         decode_array_state_e        array_state;
     } s_un;
+    // raw chars of the last string token, keys are copied from here
+    const tchar_t                   *str;
+    int64_t                         str_len;
+    const cjson_decode_opt_t        *opt;
+    // schema node of the value being decoded, NULL for any
+    const cjson_schema_node_t       *vnode;
+    const tchar_t                   *base; // the whole text, for error offsets
 };
 
 typedef struct _decode_context_t        decode_context_t;
 
+#define _ctx_allocator(ctx)             ((ctx)->opt ? (ctx)->opt->allocator : NULL)
+
+// the schema rejected the value at text
+static int64_t _decode_reject(const decode_context_t *ctx, const tchar_t *text)
+{
+    if (ctx->opt && ctx->opt->error_offset) {
+        *(ctx->opt->error_offset) = text - ctx->base;
+    }
+
+    return -1;
+}
+
 // return characters length that processed
 // return 0 for end of token processing
 // return -1 for error
-typedef int (*_pfn_cjson_decoder_t)(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_string(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_escape(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_array(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_array_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_object_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_item_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_colon_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_value_number(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_value_bool(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
-static int _decode_value_null(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+typedef int64_t (*_pfn_cjson_decoder_t)(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_string(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_escape(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_array(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_array_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_object_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_item_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_colon_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_value_number(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_value_bool(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
+static int64_t _decode_value_null(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx);
 
 static const _pfn_cjson_decoder_t _token_handlers[] = {
     _decode_string,         // 0, string
@@ -375,39 +988,58 @@ static const _pfn_cjson_decoder_t _token_handlers[] = {
     _decode_value_null      // 10, null/NULL
 };
 
-static int __str_cpy(tchar_t *dest, const tchar_t *src, int len)
+//==============================================================
+// profile, CJSON_PROFILE builds count calls, bytes & cycles per handler
+#if defined(CJSON_PROFILE)
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define _profile_clock()                __rdtsc()
+#else
+#include <time.h>
+static uint64_t _profile_clock(void)
 {
-    int i = 0;
-    int round = 0;
-    int remain = 0;
-    uint32_t *_src = NULL;
-    uint32_t *_dest = NULL;
-
-    round = len / sizeof(uint32_t);
-    remain = len % sizeof(uint32_t);
+    struct timespec ts;
 
-    _src = (uint32_t*)src;
-    _dest = (uint32_t*)dest;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    for (i = 0; i < round; i++) {
-        _dest[i] = _src[i];
-    }
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+#endif
 
-    for (i = 0; i < remain; i++) {
-        dest[round * sizeof(uint32_t) + i] = src[round * sizeof(uint32_t) + i];
+static int64_t _profile_dispatch(int h, const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
+{
+    int64_t ret = 0;
+    uint64_t t0 = 0;
+    cjson_handler_stats_t *hs = &(cjson_stats_local()->handlers[h]);
+
+    t0 = _profile_clock();
+    ret = _token_handlers[h](json_text, in_value, out_value, ctx);
+    hs->cycles += _profile_clock() - t0;
+    hs->calls++;
+    if (ret > 0) {
+        hs->bytes += ret;
     }
 
-    return i;
+    return ret;
 }
 
-static int _decode_string(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
+#define _token_dispatch(h, text, in, out, ctx)  _profile_dispatch((h), (text), (in), (out), (ctx))
+#define _profile_depth(stk)                     (cjson_stats_local()->depth[(int)(stk)->stk_top]++)
+#define _profile_doc()                          (cjson_stats_local()->docs++)
+#else
+#define _token_dispatch(h, text, in, out, ctx)  _token_handlers[(h)]((text), (in), (out), (ctx))
+#define _profile_depth(stk)
+#define _profile_doc()
+#endif
+
+static int64_t _decode_string(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
 {
     //===========================================
     // onlye cares about these tokens:
     //        '"' '\'
     //===========================================
-    int ret = 0;
-    int i = 0;
+    int64_t ret = 0;
+    int64_t i = 0;
 
     // '"' has been pushed into stack before,
     // so, it's the second " that we met,
@@ -433,10 +1065,16 @@ static int _decode_string(const tchar_t *json_text, cjson_value_t *in_value, cjs
 
     // to test the string length
     while (json_text[i]) {
+        // skip plain characters in bulk
+        i += strcspn(&json_text[i], _T("\\\""));
+        if (json_text[i] == 0) {
+            break;
+        }
+
         //printf("[%d]%c\n", i, json_text[i]);
         if (json_text[i] == _T('\\') || json_text[i] == _T('"')) {
             // call token handler
-            ret = _token_handlers[_token_fsm_table[json_text[i]]](&json_text[i], in_value, out_value, ctx);
+            ret = _token_dispatch(_token_of(json_text[i]), &json_text[i], in_value, out_value, ctx);
             if (ret == 0) { // a pair of " done processing
                 break;
             }
@@ -454,34 +1092,41 @@ static int _decode_string(const tchar_t *json_text, cjson_value_t *in_value, cjs
         i++;
     }
 
-    // string copy
-    // buffer length is i == capacity
-    // string length is i - 1
-    out_value->value_type = _cjson_value_string_;
-    out_value->cjson_strval = (cjson_string_t*)my_malloc(sizeof(cjson_string_t) + (i * sizeof(tchar_t)));
-    if (out_value->cjson_strval == NULL) {
+    if (json_text[i] == 0) { // no closing '"'
         return -1;
     }
-    out_value->cjson_strval->capacity = i;
-    out_value->cjson_strval->len = i - 1;
-    out_value->cjson_strval->s[out_value->cjson_strval->capacity] = 0;
 
-    __str_cpy(out_value->cjson_strval->s, json_text + 1, out_value->cjson_strval->len); // (json_text + 1) to skip the first '"'
-    //printf("%s\n", out_value->cjson_strval);
+    // string length is i - 1
+    ctx->str = json_text + 1; // (json_text + 1) to skip the first '"'
+    ctx->str_len = i - 1;
+
+    // a key, the object copies it into the kv from ctx->str
+    if (in_value && in_value->value_type == _cjson_value_object_
+        && ctx->s_un.object_state == _object_key_expected_) {
+        out_value->value_type = _cjson_value_string_;
+        out_value->__aux = 0;
+        return i + 1;
+    }
+
+    // string copy
+    if (_value_set_string(out_value, ctx->str, ctx->str_len, _ctx_allocator(ctx)) < 0) {
+        return -1;
+    }
+    //printf("%s\n", cjson_value_str(out_value));
     return i + 1;
 
 lbl_err:
 
-    if (out_value->__value.strval) {
-        my_free(out_value->__value.strval);
-    }
-
     return -1;
 }
 
-static int _decode_escape(const tchar_t *json_text,cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
+static int64_t _decode_escape(const tchar_t *json_text,cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
 {
-    int i = 0;
+    int64_t i = 0;
+
+    (void)in_value;
+    (void)out_value;
+    (void)ctx;
 
     //printf("=== _decode_escape\n");
 
@@ -498,38 +1143,48 @@ static int _decode_escape(const tchar_t *json_text,cjson_value_t *in_value, cjso
 }
 
 // decode
-static int _decode_array(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
+static int64_t _decode_array(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
 {
 #define _the_token_char_            _T('[')
-    int ret = 0;
+    int64_t ret = 0;
     int retv = 0;
-    int i = 0;
+    int64_t i = 0;
 
     decode_context_t my_ctx;
     cjson_value_t my_out_data;
-    cjson_value_t *elem = NULL;
+
+    (void)in_value;
 
     //printf("=== _decode_array\n");
 
+    if (cjson_schema_check_type(ctx->vnode, _cjson_value_array_) < 0) {
+        return _decode_reject(ctx, json_text);
+    }
+
     ret = _stack_push(ctx->stack, _the_token_char_);
     if (ret < 0) {
         return -1; // error
     }
     i++;
+    _profile_depth(ctx->stack);
 
     // out value
-    out_value->cjson_arrval = (cjson_array_t*)my_malloc(sizeof(cjson_array_t));
+    out_value->cjson_arrval = (cjson_array_t*)cjson_alloc(_ctx_allocator(ctx), sizeof(cjson_array_t));
     if (out_value->cjson_arrval == NULL) {
         return -1;
     }
     memset(out_value->cjson_arrval, 0, sizeof(cjson_array_t));
+    out_value->cjson_arrval->allocator = _ctx_allocator(ctx);
     out_value->value_type = _cjson_value_array_;
 
     my_ctx.stack = ctx->stack;
+    my_ctx.opt = ctx->opt;
+    my_ctx.base = ctx->base;
+    my_ctx.vnode = (ctx->vnode ? cjson_schema_items(ctx->opt->schema, ctx->vnode) : NULL);
     my_ctx.s_un.array_state = _array_element_done_;
 
     while (json_text[i] && _stack_peek(ctx->stack) == _the_token_char_) {
-        if (_token_fsm_table[json_text[i]] == -1) { // ignore
+        if (_token_of(json_text[i]) == -1) { // ignore
             i++;
             continue;
         }
@@ -537,33 +1192,31 @@ static int _decode_array(const tchar_t *json_text, cjson_value_t *in_value, cjso
         // call token handler
         my_out_data.value_type = _cjson_value_unknown_;
         my_out_data.cjson_valptr = NULL;
-        ret = _token_handlers[_token_fsm_table[json_text[i]]](&json_text[i], out_value, &my_out_data, &my_ctx);
+        ret = _token_dispatch(_token_of(json_text[i]), &json_text[i], out_value, &my_out_data, &my_ctx);
         if (ret == 0) { // token end
             break;
         }
 
         if (ret < 0) {
-            break;
+            goto lbl_err;
         }
 
         // value ','
         switch (my_ctx.s_un.array_state)
         {
         case _array_element_done_:
-            elem = (cjson_value_t*)my_malloc(sizeof(cjson_value_t));
-            if (elem == NULL) {
+            if (my_ctx.vnode && cjson_schema_check_value(ctx->opt->schema, my_ctx.vnode, &my_out_data) < 0) {
+                cjson_value_free(&my_out_data);
+                _decode_reject(ctx, &json_text[i]);
                 goto lbl_err;
             }
-            elem->value_type = my_out_data.value_type;
-            elem->cjson_valptr = my_out_data.cjson_valptr;
-            elem->next = NULL;
 
             // mount element to out_value->cjson_arrval
-            retv = cjson_array_add(out_value->cjson_arrval, elem);
+            retv = _array_add(out_value->cjson_arrval, &my_out_data);
             if (retv < 0) {
+                cjson_value_free(&my_out_data);
                 goto lbl_err;
             }
-            elem = NULL;
 
             break;
         case _array_comma_done_:
@@ -576,6 +1229,22 @@ static int _decode_array(const tchar_t *json_text, cjson_value_t *in_value, cjso
         i += ret;
     }
 
+    // ran out of text, or closed by another token
+    if (json_text[i] != _T(']')) {
+        goto lbl_err;
+    }
+
+    // minItems, maxItems
+    if (ctx->vnode && cjson_schema_check_value(ctx->opt->schema, ctx->vnode, out_value) < 0) {
+        _decode_reject(ctx, json_text);
+        goto lbl_err;
+    }
+
+    if (ctx->opt && (ctx->opt->flags & CJSON_DECODE_SPANS)) {
+        out_value->cjson_arrval->span.text = json_text;
+        out_value->cjson_arrval->span.len = i + 1;
+    }
+
     return i + 1;
 
 lbl_err:
@@ -589,9 +1258,13 @@ lbl_err:
 }
 
 // decode
-static int _decode_array_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
+static int64_t _decode_array_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
 {
-    int ret = 0;
+    int64_t ret = 0;
+
+    (void)json_text;
+    (void)in_value;
+    (void)out_value;
 
     //printf("=== _decode_array_done\n");
     if (_stack_peek(ctx->stack) == '[') {
@@ -602,40 +1275,139 @@ static int _decode_array_done(const tchar_t *json_text, cjson_value_t *in_value,
     return ret;
 }
 
+//==============================================================
+// object shapes
+//
+// with a shape cache, an object starts with the last shape seen for its
+// first key, and each following key is checked against the shape's next
+// key. While they match, only values are stored. On a mismatch the object
+// takes its own keys and goes on as usual, when it's done its keys are
+// interned, so the next object of that layout matches.
+
+// return 1 if key is the shape's next key, 0 if not, -1 for error
+static int _decode_shape_key(cjson_object_t *obj, const tchar_t *key, int64_t len, const cjson_decode_opt_t *opt)
+{
+    const cjson_objkey_t *k = NULL;
+
+    if (opt == NULL || opt->shapes == NULL) {
+        return 0;
+    }
+
+    if (obj->count == 0 && obj->shape == NULL) {
+        obj->shape = cjson_shape_cache_hint(opt->shapes, key, len);
+    }
+
+    if (obj->shape == NULL) {
+        return 0;
+    }
+
+    if (obj->count < obj->shape->count) {
+        k = &(obj->shape->keys[obj->count]);
+        if (cjson_key_len(k) == len && memcmp(cjson_key_str(k), key, len * sizeof(tchar_t)) == 0) {
+            return 1;
+        }
+    }
+
+    // mispredicted
+    return (_object_unshape(obj) < 0 ? -1 : 0);
+}
+
+static int _decode_shape_add(cjson_object_t *obj, cjson_value_t *val)
+{
+    if (_object_grow(obj) < 0) {
+        return -1;
+    }
+
+    obj->vals[obj->count] = *val;
+    _span_adopt(&(obj->vals[obj->count]), &(obj->span));
+    obj->count++;
+
+    return 0;
+}
+
+// object done, share its keys with the same shaped objects
+static int _decode_shape_done(cjson_object_t *obj, const cjson_decode_opt_t *opt)
+{
+    int64_t i = 0;
+    const cjson_shape_t *shape = NULL;
+
+    if (obj->shape && obj->count == obj->shape->count) {
+        return 0;
+    }
+
+    // a prefix of the shape only, or no shape yet
+    if (_object_unshape(obj) < 0) {
+        return -1;
+    }
+
+    if (opt == NULL || opt->shapes == NULL || obj->count == 0) {
+        return 0;
+    }
+
+    shape = cjson_shape_cache_intern(opt->shapes, obj->keys, obj->count);
+    if (shape == NULL) { // too many keys, or the cache is full
+        return 0;
+    }
+
+    for (i = 0; i < obj->count; i++) {
+        cjson_key_free(&(obj->keys[i]));
+    }
+    cjson_free(obj->allocator, obj->keys, obj->capacity * sizeof(cjson_objkey_t));
+    obj->keys = NULL;
+    obj->shape = shape;
+
+    return 0;
+}
+
 // decode object
-static int _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
+static int64_t _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_value, decode_context_t *ctx)
 {
 #define _the_token_char_            _T('{')
 
-    int ret = 0;
+    int64_t ret = 0;
     int retv = 0;
-    int i = 0;
+    int64_t i = 0;
+    int shaped = 0; // the pending key is the shape's
+    int64_t prop = 0;
+    uint64_t seen = 0; // required properties met
 
     //printf("=== _decode_object\n");
 
     decode_context_t my_ctx;
     cjson_value_t my_out_data;
-    cjson_kv_t *kv = NULL;
+    cjson_kv_t my_kv;
+    cjson_kv_t *kv = NULL; // &my_kv, while it holds a key
+
+    (void)in_value;
+
+    if (cjson_schema_check_type(ctx->vnode, _cjson_value_object_) < 0) {
+        return _decode_reject(ctx, json_text);
+    }
 
     ret = _stack_push(ctx->stack, _the_token_char_); // push token '{'
     if (ret < 0) {
         return -1; // error
     }
     i++;
+    _profile_depth(ctx->stack);
 
     // out value
-    out_value->cjson_objval = (cjson_object_t*)my_malloc(sizeof(cjson_object_t));
+    out_value->cjson_objval = (cjson_object_t*)cjson_alloc(_ctx_allocator(ctx), sizeof(cjson_object_t));
     if (out_value->cjson_objval == NULL) {
         return -1;
     }
     memset(out_value->cjson_objval, 0, sizeof(cjson_object_t));
+    out_value->cjson_objval->allocator = _ctx_allocator(ctx);
     out_value->value_type = _cjson_value_object_;
 
     my_ctx.stack = ctx->stack;
+    my_ctx.opt = ctx->opt;
+    my_ctx.base = ctx->base;
+    my_ctx.vnode = NULL;
     my_ctx.s_un.object_state = _object_key_expected_;
 
     while (json_text[i] && _stack_peek(ctx->stack) == _the_token_char_) {
-        if (_token_fsm_table[json_text[i]] == -1) { // ignore
+        if (_token_of(json_text[i]) == -1) { // ignore
             i++;
             continue;
         }
@@ -643,7 +1415,7 @@ static int _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjs
         // call token handler
         my_out_data.value_type = _cjson_value_unknown_;
         my_out_data.cjson_valptr = NULL;
-        ret = _token_handlers[_token_fsm_table[json_text[i]]](&json_text[i], out_value, &my_out_data, &my_ctx);
+        ret = _token_dispatch(_token_of(json_text[i]), &json_text[i], out_value, &my_out_data, &my_ctx);
         if (ret == 0) { // token end
             break;
         }
@@ -660,11 +1432,23 @@ static int _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjs
         {
         case _object_key_expected_:
             if (my_out_data.value_type == _cjson_value_string_) {
-                kv = (cjson_kv_t*)my_malloc(sizeof(cjson_kv_t));
-                if (kv == NULL) {
+                shaped = _decode_shape_key(out_value->cjson_objval, my_ctx.str, my_ctx.str_len, my_ctx.opt);
+                if (shaped < 0) {
                     goto lbl_err;
                 }
-                kv->key = my_out_data.cjson_strval;
+                if (!shaped) {
+                    if (_key_set(&(my_kv.__key), my_ctx.str, my_ctx.str_len, _ctx_allocator(&my_ctx)) < 0) {
+                        goto lbl_err;
+                    }
+                    kv = &my_kv;
+                    kv->value.value_type = _cjson_value_null_;
+                }
+                if (ctx->vnode) {
+                    my_ctx.vnode = cjson_schema_property(ctx->opt->schema, ctx->vnode, my_ctx.str, my_ctx.str_len, &prop);
+                    if (prop >= 0 && prop < CJSON_SCHEMA_REQUIRED_MAX) {
+                        seen |= (1ULL << prop);
+                    }
+                }
                 my_ctx.s_un.object_state++;
 
                 //printf("create key: %s\n", kv->key);
@@ -676,11 +1460,26 @@ static int _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjs
             my_ctx.s_un.object_state++;
             break;
         case _object_value_expected_:
-            kv->value.value_type = my_out_data.value_type;
-            kv->value.cjson_valptr = my_out_data.cjson_valptr;
-            kv->value.next = NULL;
+            if (my_ctx.vnode && cjson_schema_check_value(ctx->opt->schema, my_ctx.vnode, &my_out_data) < 0) {
+                cjson_value_free(&my_out_data);
+                _decode_reject(ctx, &json_text[i]);
+                goto lbl_err;
+            }
+
+            if (shaped) { // the key is in the shape already
+                retv = _decode_shape_add(out_value->cjson_objval, &my_out_data);
+                if (retv < 0) {
+                    cjson_value_free(&my_out_data);
+                    goto lbl_err;
+                }
+                shaped = 0;
+                my_ctx.s_un.object_state = _object_key_expected_;
+                break;
+            }
+
+            kv->value = my_out_data;
             // mount kv to out_value->cjson_objval
-            retv = cjson_object_addkv(out_value->cjson_objval, kv);
+            retv = _object_addkv(out_value->cjson_objval, kv);
             if (retv < 0) {
                 goto lbl_err;
             }
@@ -702,9 +1501,38 @@ static int _decode_object(const tchar_t *json_text, cjson_value_t *in_value, cjs
         i += ret;
     }
 
+    // ran out of text, or closed by another token
+    if (json_text[i] != _T('}')) {
+        goto lbl_err;
+    }
+
+    if (ctx->vnode && cjson_schema_check_required(ctx->vnode, seen) < 0) {
+        _decode_reject(ctx, json_text);
+        goto lbl_err;
+    }
+
+    if (_decode_shape_done(out_value->cjson_objval, my_ctx.opt) < 0) {
+        goto lbl_err;
+    }
+
+    if (ctx->opt && (ctx->opt->flags & CJSON_DECODE_INDEX) && out_value->cjson_objval->count >= CJSON_OBJECT_INDEX_MIN) {
+        if (cjson_object_index(out_value->cjson_objval) < 0) {
+            goto lbl_err;
+        }
+    }
+
+    if (ctx->opt && (ctx->opt->flags & CJSON_DECODE_SPANS)) {
+        out_value->cjson_objval->span.text = json_text;
+        out_value->cjson_objval->span.len = i + 1;
+    }
+
     return i + 1;
 
 lbl_err:
+    if (kv) {
+        cjson_kv_free(kv);
+    }
+
     if (out_value->cjson_objval) {
         cjson_object_free(out_value->cjson_objval);
     }
@@ -713,10 +1541,14 @@ lbl_err:
 #undef _the_token_char_
 }
 
-static int _decode_object_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
+static int64_t _decode_object_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
 {
 #define _the_token_char_                _T('{')
-    int ret = 0;
+    int64_t ret = 0;
+
+    (void)json_text;
+    (void)in_value;
+    (void)out_data;
 
     if (_stack_peek(ctx->stack) == _the_token_char_) {
         _stack_pop(ctx->stack);
@@ -728,8 +1560,11 @@ static int _decode_object_done(const tchar_t *json_text, cjson_value_t *in_value
 }
 
 // decode item done
-static int _decode_item_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
+static int64_t _decode_item_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
 {
+    (void)json_text;
+    (void)out_data;
+
     // proecess ','
 
     //printf("=== _decode_item_done\n");
@@ -743,8 +1578,11 @@ static int _decode_item_done(const tchar_t *json_text, cjson_value_t *in_value,
     return 1;
 }
 
-static int _decode_colon_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
+static int64_t _decode_colon_done(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
 {
+    (void)json_text;
+    (void)out_data;
+
     // proecess ':'
 
     if (in_value->value_type == _cjson_value_object_ && ctx->s_un.object_state == _object_key_done_) {
@@ -754,95 +1592,27 @@ static int _decode_colon_done(const tchar_t *json_text, cjson_value_t *in_value,
     return 1;
 }
 
-static int _decode_value_number(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
+static int64_t _decode_value_number(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
 {
-    int ret = 0;
-    int i = 0;
-    int sign = 1;
-    int exponent = 0;
-    int exponent_sign = 1;
+    (void)in_value;
+    (void)ctx;
 
     //printf("=== _decode_value_number\n");
 
-    out_data->cjson_numval = (cjson_number_t*)my_malloc(sizeof(cjson_number_t));
-    if (out_data->cjson_numval == NULL) {
-        return -1;
-    }
-    memset(out_data->cjson_numval, 0, sizeof(cjson_number_t));
-
-    if (json_text[i] == _T('-')) {
-        sign = -1;
-        i++;
-    } else if (json_text[i] == _T('+')) {
-        i++;
-    }
-
-    while (json_text[i]) {
-        if (json_text[i] >= _T('0') && json_text[i] <= _T('9')) {
-            out_data->cjson_numval->number = out_data->cjson_numval->number * 10 + (json_text[i] - '0');
-            out_data->cjson_numval->divisor *= 10;
-        } else if (json_text[i] == _T('.')) {
-            out_data->cjson_numval->divisor = 1;
-        } else { // maybe json_text[i] == _T('e') || json_text[i] == _T('E')
-            break;
-        }
-
-        i++;
-    }
-
-    out_data->cjson_numval->divisor = (out_data->cjson_numval->divisor == 0 ? 1 : out_data->cjson_numval->divisor); // to prevent from division by zero
-
-    // scientific notation
-    if (json_text[i] == _T('e') || json_text[i] == _T('E')) {
-        i++; // skip 'e'
-        if (json_text[i] == _T('-')) {
-            exponent_sign = -1;
-            i++;
-        } else if (json_text[i] == _T('+')) {
-            i++;
-        }
-
-        // e-5 : 10^-5
-        while (json_text[i]) {
-            if (json_text[i] >= _T('0') && json_text[i] <= _T('9')) {
-                exponent = exponent * 10 + (json_text[i] - '0');
-            } else {
-                break;
-            }
-
-            i++;
-        }
-
-        while (exponent) {
-            if (exponent_sign == -1) {
-                out_data->cjson_numval->divisor *= 10;
-            } else {
-                out_data->cjson_numval->number *= 10;
-            }
-            exponent--;
-        }
-    }
-
-    out_data->cjson_numval->number *= sign;
-    out_data->value_type = _cjson_value_number_;
-    return i + 1;
-
-lbl_err:
-
-    if (out_data->cjson_numval) {
-        my_free(out_data->cjson_numval);
-    }
-
-    return -1;
+    return cjson_scan_number(json_text, out_data);
 }
-static int _decode_value_bool(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
+
+static int64_t _decode_value_bool(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
 {
-    int ret = 0;
-    int i = 0;
+    int64_t ret = 0;
+    int64_t i = 0;
 
     const tchar_t *true_str = _T("true");
     const tchar_t *false_str = _T("false");
 
+    (void)in_value;
+    (void)ctx;
+
     //printf("=== _decode_value_bool\n");
 
     // true
@@ -859,7 +1629,7 @@ static int _decode_value_bool(const tchar_t *json_text, cjson_value_t *in_value,
     if (ret == 4) {
         out_data->value_type = _cjson_value_bool_;
         out_data->cjson_boolval = 1;
-        return i + 1;
+        return i;
     }
 
     // false
@@ -877,20 +1647,20 @@ static int _decode_value_bool(const tchar_t *json_text, cjson_value_t *in_value,
     if (ret == 5) {
         out_data->value_type = _cjson_value_bool_;
         out_data->cjson_boolval = 0;
-        return i + 1;
+        return i;
     }
 
     out_data->value_type = _cjson_value_unknown_;
     return -1;
 }
-static int _decode_value_null(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
+static int64_t _decode_value_null(const tchar_t *json_text, cjson_value_t *in_value, cjson_value_t *out_data, decode_context_t *ctx)
 {
-    const uint32_t *p = (uint32_t*)_T("null");
-    uint32_t *p2 = (uint32_t*)json_text;
+    (void)in_value;
+    (void)ctx;
 
     //printf("=== _decode_null\n");
 
-    if (*p == *p2) {
+    if (strncmp(json_text, _T("null"), 4) == 0) {
         out_data->value_type = _cjson_value_null_;
         out_data->cjson_valptr = NULL;
         return sizeof(tchar_t) * 4;
@@ -903,8 +1673,13 @@ static int _decode_value_null(const tchar_t *json_text, cjson_value_t *in_value,
 // jsxon text => data
 int cjson_decode(const tchar_t *json_text, cjson_t *data)
 {
-    int ret = 0;
-    int i = 0;
+    return cjson_decode_ex(json_text, data, NULL);
+}
+
+int cjson_decode_ex(const tchar_t *json_text, cjson_t *data, const cjson_decode_opt_t *opt)
+{
+    int64_t ret = 0;
+    int64_t i = 0;
 
     _stack_t *stk = NULL;
 
@@ -926,18 +1701,25 @@ int cjson_decode(const tchar_t *json_text, cjson_t *data)
     stk->stk_top = _token_stack_bottom_;
 
     ctx.stack = stk;
+    ctx.opt = opt;
+    ctx.base = json_text;
+    ctx.vnode = ((opt && opt->schema) ? &(opt->schema->nodes[0]) : NULL);
+
+    if (opt && opt->error_offset) {
+        *(opt->error_offset) = -1;
+    }
 
     memset(&root_data, 0, sizeof(root_data));
 
     i = 0;
     while (json_text[i]) {
-        if (_token_fsm_table[json_text[i]] == -1) {
+        if (_token_of(json_text[i]) == -1) {
             i++; // ignore
             continue;
         }
 
         // call token handler
-        ret = _token_handlers[_token_fsm_table[json_text[i]]](&json_text[i], NULL, &root_data, &ctx);
+        ret = _token_dispatch(_token_of(json_text[i]), &json_text[i], NULL, &root_data, &ctx);
         if (ret == 0) {
             break;
         }
@@ -953,11 +1735,15 @@ int cjson_decode(const tchar_t *json_text, cjson_t *data)
         goto release;
     }
 
+    // the root must be an object, anything else is freed & rejected
     if (root_data.value_type != _cjson_value_object_) {
+        cjson_value_free(&root_data);
+        ret = -1;
         goto release;
     }
 
     data->object = root_data.cjson_objval;
+    _profile_doc();
 
 release:
 
@@ -968,7 +1754,8 @@ release:
     return (ret < 0 ? -1 : 0);
 }
 
-//gcc -I. cjson_decoder.c cjson_encoder.c -o cjson -g
+#if defined(CJSON_DECODER_MAIN)
+//gcc -I. -DCJSON_DECODER_MAIN cjson_*.c murmurhash.c chashmap.c -o cjson -g -lpthread
 int main(int argc, char *argv[])
 {
     const char *text_json = "{\n"
@@ -993,24 +1780,25 @@ int main(int argc, char *argv[])
         // Successfully parsed
         cjson_value_t *name = cjson_object_get_value(data.object, "name");
         if (name && name->value_type == _cjson_value_string_) {
-            printf("Name: \"%s\"\n", name->cjson_strval->s);
+            printf("Name: \"%s\"\n", cjson_value_str(name));
         }
 
+        cjson_number_t num;
         cjson_value_t *age = cjson_object_get_value(data.object, "age");
-        if (age && age->value_type == _cjson_value_number_) {
-            printf("age: %lld\n", age->cjson_numval->number / age->cjson_numval->divisor);
+        if (age && cjson_value_get_number(age, &num) == 0) {
+            printf("age: %lld\n", (long long)(num.number / num.divisor));
         }
         cjson_value_t *is_active = cjson_object_get_value(data.object, "is_active");
         if (is_active && is_active->value_type == _cjson_value_bool_) {
             printf("is_active: %d\n", is_active->cjson_boolval);
         }
         cjson_value_t *numbera = cjson_object_get_value(data.object, "numbera");
-        if (numbera && numbera->value_type == _cjson_value_number_) {
-            printf("numbera: %0.8lf\n", (float)(numbera->cjson_numval->number) / (float)(numbera->cjson_numval->divisor));
+        if (numbera && cjson_value_get_number(numbera, &num) == 0) {
+            printf("numbera: %0.8lf\n", (float)(num.number) / (float)(num.divisor));
         }
         cjson_value_t *numberb = cjson_object_get_value(data.object, "numberb");
-        if (numberb && numberb->value_type == _cjson_value_number_) {
-            printf("numberb: %lf\n", (float)(numberb->cjson_numval->number) / (float)(numberb->cjson_numval->divisor));
+        if (numberb && cjson_value_get_number(numberb, &num) == 0) {
+            printf("numberb: %lf\n", (float)(num.number) / (float)(num.divisor));
         }
     } else {
         printf("Failed to parse json text\n");
@@ -1025,3 +1813,4 @@ int main(int argc, char *argv[])
     
     return 0;
 }
+#endif
@@ -19,15 +19,15 @@
 
 // return characters length that writen to buffer
 // return 0 for end of token processing
-// return -1 for error
-typedef int (*_pfn_cjson_encoder_t)(const cjson_value_t *value, tchar_t *buf, int buflen);
-static int _encode_unknown(const cjson_value_t *value, tchar_t *buf, int buflen);
-static int _encode_null(const cjson_value_t *value, tchar_t *buf, int buflen);
-static int _encode_string(const cjson_value_t *value, tchar_t *buf, int buflen);
-static int _encode_number(const cjson_value_t *value, tchar_t *buf, int buflen);
-static int _encode_bool(const cjson_value_t *value, tchar_t *buf, int buflen);
-static int _encode_array(const cjson_value_t *value, tchar_t *buf, int buflen);
-static int _encode_object(const cjson_value_t *value, tchar_t *buf, int buflen);
+// return CJSON_ENCODE_SHORT if buf is too small, -1 for other errors
+typedef int64_t (*_pfn_cjson_encoder_t)(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
+static int64_t _encode_unknown(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
+static int64_t _encode_null(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
+static int64_t _encode_string(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
+static int64_t _encode_number(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
+static int64_t _encode_bool(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
+static int64_t _encode_array(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
+static int64_t _encode_object(const cjson_value_t *value, tchar_t *buf, int64_t buflen);
 static const _pfn_cjson_encoder_t _encode_handlers[] = {
     _encode_unknown,    // 0,
     _encode_null,       // 1, value null
@@ -40,7 +40,7 @@ static const _pfn_cjson_encoder_t _encode_handlers[] = {
 
 struct __bool_str_entry_t {
     const tchar_t *str;
-    int str_len;
+    int64_t str_len;
 };
 typedef struct __bool_str_entry_t _bool_str_entry_t;
 static const _bool_str_entry_t _bool_str_entries[2] = {
@@ -48,149 +48,141 @@ static const _bool_str_entry_t _bool_str_entries[2] = {
     { _T("true"),   4 },
 };
 
-static int _encode_unknown(const cjson_value_t *value, tchar_t *buf, int buflen)
+static int64_t _encode_unknown(const cjson_value_t *value, tchar_t *buf, int64_t buflen)
 {
+    (void)value;
+    (void)buf;
+    (void)buflen;
+
     return -1;
 }
 
-static int _encode_null(const cjson_value_t *value, tchar_t *buf, int buflen)
+static int64_t _encode_null(const cjson_value_t *value, tchar_t *buf, int64_t buflen)
 {
-    if (buflen > 3) { // null is always 4 chars
-        strcpy(buf, _T("null"));
+    (void)value;
+
+    if (buflen > 3) { // null is always 4 chars, no '\0'
+        memcpy(buf, _T("null"), 4 * sizeof(tchar_t));
         return 4;
     }
 
-    return -1;
+    return CJSON_ENCODE_SHORT;
 }
 
-static int _encode_string(const cjson_value_t *value, tchar_t *buf, int buflen)
+// quoted chars, for string values and keys
+static int64_t _encode_chars(const tchar_t *s, int64_t len, tchar_t *buf, int64_t buflen)
 {
-    int ret = 0;
-    int i = 0;
-
-    if (buflen < value->cjson_strval->len + 2) { // 2 for quotation mark
-        return -1;  // buffer is too small
+    if (buflen < len + 2) { // 2 for quotation mark
+        return CJSON_ENCODE_SHORT;
     }
 
     buf[0] = _T('"');
+    memcpy(buf + 1, s, len * sizeof(tchar_t));
+    buf[len + 1] = _T('"');
 
-    while (i < value->cjson_strval->len) {
-        buf[i+1] = value->cjson_strval->s[i];
-        i++;
+    return len + 2;
+}
+
+// unchanged container, its source chars as is
+static int64_t _encode_span(const cjson_span_t *span, tchar_t *buf, int64_t buflen)
+{
+    if (buflen < span->len) {
+        return CJSON_ENCODE_SHORT;
     }
 
-    buf[i + 1] = _T('"');
+    memcpy(buf, span->text, span->len * sizeof(tchar_t));
 
-    return i + 2;
+    return span->len;
 }
 
-static int _encode_number(const cjson_value_t *value, tchar_t *buf, int buflen)
+static int64_t _encode_string(const cjson_value_t *value, tchar_t *buf, int64_t buflen)
 {
-    int from = 0;
-    int buf_idx = 0;
-    int i = 0;
-    int point_pos = 0;
-
-    int64_t n = value->cjson_numval->number;
-    int64_t d = (value->cjson_numval->divisor == 1) ? 0 : value->cjson_numval->divisor;
-
-    if (n < 0){
-        if (buf_idx < buflen) {
-            buf[0] = _T('-');
-            buf_idx++;
-        } else {
-            return -1;
-        }
+    return _encode_chars(cjson_value_str(value), cjson_value_strlen(value), buf, buflen);
+}
 
-        n *= -1;
-    }
+#define _number_chars_max_               24 // '-', 20 digits, '.', '0'
 
-    from = buf_idx;
+// number => chars, written backwards from the end of tmp
+// return the first char in tmp
+static tchar_t* _format_number(const cjson_value_t *value, tchar_t tmp[_number_chars_max_])
+{
+    tchar_t *p = tmp + _number_chars_max_;
+    int64_t i = 0;
+    uint64_t n = (uint64_t)value->cjson_numval;
 
-    // decimal point position
-    while (d > 1) {
-        point_pos++;
-        d /= 10;
+    if (value->cjson_numval < 0) {
+        n = 0 - n;
     }
 
     // decimal digits
-    i = 0;
-    while (i < point_pos) {
-        if (buf_idx < buflen) {
-            buf[buf_idx] = n % 10 + _T('0');
-        } else  {
-            return -1;
-        }
-
+    for (i = 0; i < value->cjson_numscale; i++) {
+        *--p = (tchar_t)(n % 10 + _T('0'));
         n /= 10;
-        buf_idx++;
-        i++;
     }
 
     // decimal point
-    if (value->cjson_numval->divisor > 1) {
-        if (buf_idx < buflen) {
-            buf[buf_idx] = _T('.');
-            buf_idx++;
-        } else {
-            return -1;
-        }
+    if (value->cjson_numscale > 0) {
+        *--p = _T('.');
     }
 
-    // integer digits
-    if (n) {
-        while (n) {
-            if (buf_idx < buflen) {
-                buf[buf_idx] = n % 10 + _T('0');
-            } else {
-                return -1;
-            }
-            n /= 10;
-            buf_idx++;
-        }
-    } else if (value->cjson_numval->divisor > 1) {
-        buf[buf_idx] = _T('0');
-        buf_idx++;
+    // integer digits, 0 for 0.xxx
+    do {
+        *--p = (tchar_t)(n % 10 + _T('0'));
+        n /= 10;
+    } while (n);
+
+    if (value->cjson_numval < 0) {
+        *--p = _T('-');
     }
 
-    // reverse the string
-    // buf_idx + 1 - from : count of chars
-    for (i = from; (i - from) < (buf_idx + 1 - from) / 2; i++) {
-        tchar_t tmp = buf[i];
-        buf[i] = buf[buf_idx - i - 1 + from];
-        buf[buf_idx - i - 1 + from] = tmp;
+    return p;
+}
+
+static int64_t _encode_number(const cjson_value_t *value, tchar_t *buf, int64_t buflen)
+{
+    tchar_t tmp[_number_chars_max_];
+    tchar_t *p = _format_number(value, tmp);
+    int64_t len = tmp + _number_chars_max_ - p;
+
+    if (buflen < len) {
+        return CJSON_ENCODE_SHORT;
     }
 
-    return buf_idx;
+    memcpy(buf, p, len * sizeof(tchar_t));
+
+    return len;
 }
 
-static int _encode_bool(const cjson_value_t *value, tchar_t *buf, int buflen)
+static int64_t _encode_bool(const cjson_value_t *value, tchar_t *buf, int64_t buflen)
 {
-    int idx = 1;
+    int64_t idx = 1;
 
     if (value->cjson_boolval == 0) {
         idx = 0;
     }
 
     if (buflen < _bool_str_entries[idx].str_len) {
-        return -1;
+        return CJSON_ENCODE_SHORT;
     }
 
-    strcpy(buf, _bool_str_entries[idx].str);
+    memcpy(buf, _bool_str_entries[idx].str, _bool_str_entries[idx].str_len * sizeof(tchar_t)); // no '\0'
 
     return _bool_str_entries[idx].str_len;
 }
 
-static int _encode_object(const cjson_value_t *value, tchar_t *buf, int buflen)
+static int64_t _encode_object(const cjson_value_t *value, tchar_t *buf, int64_t buflen)
 {
-    int ret = 0;
+    int64_t ret = 0;
 
-    cjson_kv_t *kv = NULL;
-    cjson_value_t dummy;
+    cjson_value_t *val = NULL;
+    const tchar_t *key = NULL;
+    int64_t key_len = 0;
     position_t pos;
-    int i = 0;
+    int64_t i = 0;
 
-    dummy.next = NULL;
+    if (value->cjson_objval->span.text && !value->cjson_objval->span.dirty) {
+        return _encode_span(&(value->cjson_objval->span), buf, buflen);
+    }
 
     if (i < buflen) {
         buf[0] = _T('{');
@@ -198,35 +190,38 @@ static int _encode_object(const cjson_value_t *value, tchar_t *buf, int buflen)
     }
 
     // key : value
-    kv = cjson_object_first(value->cjson_objval, &pos);
-    while (kv) {
+    val = cjson_object_first_value(value->cjson_objval, &pos);
+    while (val) {
         // key
+        key = cjson_object_key(value->cjson_objval, val, &key_len);
         if (i < buflen) {
-            dummy.value_type = _cjson_value_string_;
-            dummy.cjson_strval = kv->key;
-            ret = _encode_handlers[dummy.value_type](&dummy, buf + i, buflen - i);
+            ret = _encode_chars(key, key_len, buf + i, buflen - i);
             if (ret < 0) {
                 break;
             }
             i += ret;
         } else {
-            ret = -1;
+            ret = CJSON_ENCODE_SHORT;
             break;
         }
 
         // colon
+        if (i >= buflen) {
+            ret = CJSON_ENCODE_SHORT;
+            break;
+        }
         buf[i] = _T(':');
         i++;
 
         // value
         if (i < buflen) {
-            ret = _encode_handlers[kv->value.value_type](&(kv->value), buf + i, buflen - i);
+            ret = _encode_handlers[val->value_type](val, buf + i, buflen - i);
             if (ret < 0) {
                 break;
             }
             i += ret;
         } else {
-            ret = -1;
+            ret = CJSON_ENCODE_SHORT;
             break;
         }
 
@@ -235,31 +230,41 @@ static int _encode_object(const cjson_value_t *value, tchar_t *buf, int buflen)
             buf[i] = _T(',');
             i++;
         } else {
-            ret = -1;
+            ret = CJSON_ENCODE_SHORT;
             break;
         }
 
-        kv = cjson_object_next(value->cjson_objval, &pos);
+        val = cjson_object_next_value(value->cjson_objval, &pos);
     }
 
     if (ret < 0) {
-        return -1;
+        return ret;
     }
 
-    if (i > 0) { // change the last ',' to '}'
+    if (value->cjson_objval->count == 0) { // empty, no ',' to change
+        if (i >= buflen) {
+            return CJSON_ENCODE_SHORT;
+        }
+        buf[i] = _T('}');
+        i++;
+    } else if (i > 0) { // change the last ',' to '}'
         buf[i - 1] = _T('}');
     }
 
     return i;
 }
 
-static int _encode_array(const cjson_value_t *value, tchar_t *buf, int buflen)
+static int64_t _encode_array(const cjson_value_t *value, tchar_t *buf, int64_t buflen)
 {
-    int ret = 0;
-    int i = 0;
+    int64_t ret = 0;
+    int64_t i = 0;
     cjson_value_t *val = NULL;
     position_t pos;
 
+    if (value->cjson_arrval->span.text && !value->cjson_arrval->span.dirty) {
+        return _encode_span(&(value->cjson_arrval->span), buf, buflen);
+    }
+
     if (i < buflen) {
         buf[0] = _T('[');
         i++;
@@ -276,7 +281,7 @@ static int _encode_array(const cjson_value_t *value, tchar_t *buf, int buflen)
             }
             i += ret;
         } else {
-            ret = -1;
+            ret = CJSON_ENCODE_SHORT;
             break;
         }
 
@@ -285,7 +290,7 @@ static int _encode_array(const cjson_value_t *value, tchar_t *buf, int buflen)
             buf[i] = _T(',');
             i++;
         } else {
-            ret = -1;
+            ret = CJSON_ENCODE_SHORT;
             break;
         }
 
@@ -294,10 +299,16 @@ static int _encode_array(const cjson_value_t *value, tchar_t *buf, int buflen)
     }
 
     if (ret < 0) {
-        return -1;
+        return ret;
     }
 
-    if (i > 0) { // change the last ',' to ']'
+    if (value->cjson_arrval->count == 0) { // empty, no ',' to change
+        if (i >= buflen) {
+            return CJSON_ENCODE_SHORT;
+        }
+        buf[i] = _T(']');
+        i++;
+    } else if (i > 0) { // change the last ',' to ']'
         buf[i - 1] = _T(']');
     }
 
@@ -305,7 +316,7 @@ static int _encode_array(const cjson_value_t *value, tchar_t *buf, int buflen)
 }
 
 // data => jsxon text
-int cjson_encode(const cjson_t *json, tchar_t *buf, int buflen)
+int64_t cjson_encode(const cjson_t *json, tchar_t *buf, int64_t buflen)
 {
     cjson_value_t root_data;
 
@@ -313,10 +324,220 @@ int cjson_encode(const cjson_t *json, tchar_t *buf, int buflen)
         return -1;
     }
 
-    root_data.next = NULL;
-
     root_data.value_type = _cjson_value_object_;
     root_data.cjson_objval = json->object;
 
     return _encode_object(&root_data, buf, buflen);
 }
+
+//===========================================================
+// encode plans
+//
+// a plan holds the keys of a fixed shape object as ready made fragments,
+// '{"k0":' ',"k1":' ..., so an object of that shape is encoded by copying
+// a fragment and formatting a value, key by key.
+
+// chars of key escaped, into buf if not NULL, return the length
+static int64_t _plan_escape(const tchar_t *key, tchar_t *buf)
+{
+    static const tchar_t *hex = _T("0123456789abcdef");
+    int64_t n = 0;
+
+    for (; *key; key++) {
+        if (*key == _T('"') || *key == _T('\\')) {
+            if (buf) {
+                buf[n] = _T('\\');
+                buf[n + 1] = *key;
+            }
+            n += 2;
+        } else if ((unsigned char)*key < 0x20) { // control chars, \u00XX
+            if (buf) {
+                memcpy(buf + n, _T("\\u00"), 4 * sizeof(tchar_t));
+                buf[n + 4] = hex[(*key >> 4) & 0x0f];
+                buf[n + 5] = hex[*key & 0x0f];
+            }
+            n += 6;
+        } else {
+            if (buf) {
+                buf[n] = *key;
+            }
+            n++;
+        }
+    }
+
+    return n;
+}
+
+cjson_plan_t* cjson_plan_compile(const tchar_t *keys[], const cjson_valuetype_e types[], int64_t count)
+{
+    int64_t i = 0;
+    int64_t len = 0;
+    int64_t total = 0;
+    tchar_t *p = NULL;
+    cjson_plan_t *plan = NULL;
+
+    if (keys == NULL || count < 0) {
+        return NULL;
+    }
+
+    plan = (cjson_plan_t*)my_malloc(sizeof(cjson_plan_t));
+    if (plan == NULL) {
+        return NULL;
+    }
+    memset(plan, 0, sizeof(cjson_plan_t));
+
+    // "key": & a leading '{' or ','
+    for (i = 0; i < count; i++) {
+        total += _plan_escape(keys[i], NULL) + 4;
+    }
+
+    plan->keys = (cjson_objkey_t*)my_malloc((count + 1) * sizeof(cjson_objkey_t));
+    plan->types = (cjson_valuetype_e*)my_malloc((count + 1) * sizeof(cjson_valuetype_e));
+    plan->frag_off = (int64_t*)my_malloc((count + 1) * sizeof(int64_t));
+    plan->frags = (tchar_t*)my_malloc((total + 1) * sizeof(tchar_t));
+    if (plan->keys == NULL || plan->types == NULL || plan->frag_off == NULL || plan->frags == NULL) {
+        goto lbl_err;
+    }
+
+    p = plan->frags;
+    for (i = 0; i < count; i++) {
+        plan->frag_off[i] = p - plan->frags;
+        *p++ = (i == 0) ? _T('{') : _T(',');
+        *p++ = _T('"');
+        len = _plan_escape(keys[i], p);
+
+        // keys are matched as objects keep them, escaped
+        if (cjson_key_set(&(plan->keys[i]), p, len) < 0) {
+            goto lbl_err;
+        }
+        plan->count++;
+
+        p += len;
+        *p++ = _T('"');
+        *p++ = _T(':');
+
+        plan->types[i] = types ? types[i] : _cjson_value_unknown_;
+    }
+    plan->frag_off[count] = p - plan->frags;
+
+    return plan;
+
+lbl_err:
+
+    cjson_plan_free(plan);
+
+    return NULL;
+}
+
+void cjson_plan_free(cjson_plan_t *plan)
+{
+    int64_t i = 0;
+
+    if (plan == NULL) {
+        return;
+    }
+
+    for (i = 0; i < plan->count; i++) {
+        cjson_key_free(&(plan->keys[i]));
+    }
+
+    if (plan->keys) {
+        my_free(plan->keys);
+    }
+    if (plan->types) {
+        my_free(plan->types);
+    }
+    if (plan->frag_off) {
+        my_free(plan->frag_off);
+    }
+    if (plan->frags) {
+        my_free(plan->frags);
+    }
+
+    my_free(plan);
+}
+
+int cjson_plan_bind(cjson_plan_t *plan, cjson_shape_cache_t *cache)
+{
+    if (plan->count == 0) {
+        return -1;
+    }
+
+    plan->shape = cjson_shape_cache_intern(cache, plan->keys, plan->count);
+
+    return (plan->shape ? 0 : -1);
+}
+
+int64_t cjson_plan_encode_values(const cjson_plan_t *plan, const cjson_value_t *vals, int64_t count, tchar_t *buf, int64_t buflen)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+    int64_t ret = 0;
+    int64_t frag_len = 0;
+
+    if (count != plan->count) {
+        return -1;
+    }
+
+    if (count == 0) {
+        if (buflen < 2) {
+            return CJSON_ENCODE_SHORT;
+        }
+        buf[0] = _T('{');
+        buf[1] = _T('}');
+        return 2;
+    }
+
+    for (i = 0; i < count; i++) {
+        // null always fits
+        if (plan->types[i] != _cjson_value_unknown_ && vals[i].value_type != plan->types[i]
+            && vals[i].value_type != _cjson_value_null_) {
+            return -1;
+        }
+
+        frag_len = plan->frag_off[i + 1] - plan->frag_off[i];
+        if (buflen - n < frag_len) {
+            return CJSON_ENCODE_SHORT;
+        }
+        memcpy(buf + n, plan->frags + plan->frag_off[i], frag_len * sizeof(tchar_t));
+        n += frag_len;
+
+        ret = _encode_handlers[vals[i].value_type](&vals[i], buf + n, buflen - n);
+        if (ret < 0) {
+            return ret;
+        }
+        n += ret;
+    }
+
+    if (n >= buflen) {
+        return CJSON_ENCODE_SHORT;
+    }
+    buf[n] = _T('}');
+
+    return n + 1;
+}
+
+int64_t cjson_plan_encode(const cjson_plan_t *plan, const cjson_object_t *obj, tchar_t *buf, int64_t buflen)
+{
+    int64_t i = 0;
+    int64_t len = 0;
+    const cjson_objkey_t *keys = NULL;
+
+    if (obj->count != plan->count) {
+        return -1;
+    }
+
+    // objects of the bound shape have the plan's keys
+    if (obj->shape == NULL || obj->shape != plan->shape) {
+        keys = obj->shape ? obj->shape->keys : obj->keys;
+        for (i = 0; i < plan->count; i++) {
+            len = cjson_key_len(&(plan->keys[i]));
+            if (cjson_key_len(&keys[i]) != len
+                || memcmp(cjson_key_str(&keys[i]), cjson_key_str(&(plan->keys[i])), len * sizeof(tchar_t)) != 0) {
+                return -1;
+            }
+        }
+    }
+
+    return cjson_plan_encode_values(plan, obj->vals, obj->count, buf, buflen);
+}
@@ -0,0 +1,156 @@
+/************************************************************************************
+* cjson_file.c: Implementation File
+*
+* cjson file decoder
+*
+* DESCRIPTION:
+*   decode a json file straight from a read only mapping, without reading
+*   it into a malloc'd buffer and without a copy for NUL termination.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   the decoder stops at '\0'. The file is mapped on top of an anonymous
+*   reservation one page longer than the file, so the bytes following the
+*   last file byte are always zero, even when the file size is a multiple
+*   of the page size.
+*
+************************************************************************************/
+
+#include <cjson.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if !defined(MAP_POPULATE)
+#define MAP_POPULATE                    0
+#endif
+
+#define _prefetch_chunk_size_           (2 * 1024 * 1024) // bytes
+
+struct __file_prefetch_t {
+    pthread_t           thread;
+    const uint8_t       *addr;
+    size_t              len;
+    size_t              page_size;
+    volatile int        stop;
+};
+typedef struct __file_prefetch_t    _file_prefetch_t;
+
+// fault the mapping in ahead of the parser, chunk by chunk
+static void* _prefetch_routine(void *arg)
+{
+    _file_prefetch_t *pf = (_file_prefetch_t*)arg;
+    size_t off = 0;
+    size_t len = 0;
+    size_t i = 0;
+    volatile uint8_t sink = 0;
+
+    for (off = 0; off < pf->len && !pf->stop; off += len) {
+        len = pf->len - off;
+        if (len > _prefetch_chunk_size_) {
+            len = _prefetch_chunk_size_;
+        }
+
+#if defined(MADV_POPULATE_READ)
+        if (madvise((void*)(pf->addr + off), len, MADV_POPULATE_READ) == 0) {
+            continue;
+        }
+#endif
+        for (i = 0; i < len; i += pf->page_size) {
+            sink = pf->addr[off + i];
+        }
+    }
+
+    (void)sink;
+
+    return NULL;
+}
+
+// json file => data
+int cjson_decode_file(const char *path, cjson_t *data, int flags)
+{
+    int ret = -1;
+    int fd = -1;
+    int mflags = MAP_PRIVATE | MAP_FIXED;
+    size_t page_size = 0;
+    size_t file_len = 0;
+    size_t map_len = 0;
+    void *addr = MAP_FAILED;
+    struct stat st;
+    _file_prefetch_t pf;
+    int prefetching = 0;
+
+    if (path == NULL || data == NULL) {
+        return -1;
+    }
+
+    data->object = NULL;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -1;
+    }
+
+    if (fstat(fd, &st) < 0 || st.st_size <= 0) {
+        goto release;
+    }
+
+    page_size = (size_t)sysconf(_SC_PAGESIZE);
+    file_len = (size_t)st.st_size;
+    map_len = (file_len + page_size - 1) / page_size * page_size + page_size; // + 1 zero page
+
+    // reserve the range, the trailing zero page stays anonymous
+    addr = mmap(NULL, map_len, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (addr == MAP_FAILED) {
+        goto release;
+    }
+
+    if (flags & CJSON_FILE_POPULATE) {
+        mflags |= MAP_POPULATE;
+    }
+
+    if (mmap(addr, file_len, PROT_READ, mflags, fd, 0) == MAP_FAILED) {
+        goto release;
+    }
+
+    // hints only, failures are harmless
+    if (flags & CJSON_FILE_SEQUENTIAL) {
+        madvise(addr, file_len, MADV_SEQUENTIAL);
+    }
+#if defined(MADV_HUGEPAGE)
+    if (flags & CJSON_FILE_HUGEPAGE) {
+        madvise(addr, file_len, MADV_HUGEPAGE);
+    }
+#endif
+
+    if ((flags & CJSON_FILE_PREFETCH) && !(flags & CJSON_FILE_POPULATE)) {
+        pf.addr = (const uint8_t*)addr;
+        pf.len = file_len;
+        pf.page_size = page_size;
+        pf.stop = 0;
+        prefetching = (pthread_create(&pf.thread, NULL, _prefetch_routine, &pf) == 0);
+    }
+
+    ret = cjson_decode((const tchar_t*)addr, data);
+
+    if (prefetching) {
+        pf.stop = 1;
+        pthread_join(pf.thread, NULL);
+    }
+
+release:
+
+    if (addr != MAP_FAILED) {
+        munmap(addr, map_len);
+    }
+
+    close(fd);
+
+    return ret;
+}
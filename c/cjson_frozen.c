@@ -0,0 +1,359 @@
+/************************************************************************************
+* cjson_frozen.c: Implementation File
+*
+* cjson frozen document image
+*
+* DESCRIPTION:
+*   freeze a decoded document into one position independent blob, and
+*   query the blob in place, without parsing and without allocation.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   offsets are 32 bits, an image is limited to 4GB.
+*
+************************************************************************************/
+
+#include <cjson.h>
+
+#define _frozen_align_                  8
+#define _frozen_align_up(n)             (((n) + (_frozen_align_ - 1)) & ~((int64_t)_frozen_align_ - 1))
+
+struct __freeze_writer_t {
+    uint8_t     *buf;   // NULL for size query
+    int64_t     buflen;
+    int64_t     pos;    // next free offset
+};
+typedef struct __freeze_writer_t    _freeze_writer_t;
+
+static int _freeze_value(_freeze_writer_t *w, const cjson_value_t *value, cjson_fvalue_t *slot);
+
+// reserve bytes in the image, return offset, -1 for error
+static int64_t _freeze_alloc(_freeze_writer_t *w, int64_t size)
+{
+    int64_t off = w->pos;
+
+    if (size < 0 || off + size > UINT32_MAX) {
+        return -1;
+    }
+
+    w->pos = _frozen_align_up(off + size);
+
+    if (w->buf) {
+        if (w->pos > w->buflen) {
+            return -1;
+        }
+        memset(w->buf + off, 0, w->pos - off);
+    }
+
+    return off;
+}
+
+// string => image, return offset, -1 for error
+static int64_t _freeze_string(_freeze_writer_t *w, const tchar_t *s, int64_t len)
+{
+    int64_t off = _freeze_alloc(w, len + 1);
+
+    if (off < 0) {
+        return -1;
+    }
+
+    if (w->buf) {
+        memcpy(w->buf + off, s, len * sizeof(tchar_t));
+    }
+
+    return off;
+}
+
+static int _freeze_array(_freeze_writer_t *w, cjson_array_t *arr, cjson_fvalue_t *slot)
+{
+    int64_t off = 0;
+    int64_t i = 0;
+    cjson_value_t *val = NULL;
+    cjson_fvalue_t elem;
+    position_t pos;
+
+    off = _freeze_alloc(w, (int64_t)arr->count * sizeof(cjson_fvalue_t));
+    if (off < 0) {
+        return -1;
+    }
+
+    val = cjson_array_first(arr, &pos);
+    while (val) {
+        if (_freeze_value(w, val, &elem) < 0) {
+            return -1;
+        }
+
+        if (w->buf) {
+            memcpy(w->buf + off + i * sizeof(cjson_fvalue_t), &elem, sizeof(elem));
+        }
+
+        i++;
+        val = cjson_array_next(arr, &pos);
+    }
+
+    slot->len = (uint32_t)arr->count;
+    slot->__fv.off = (uint64_t)off;
+
+    return 0;
+}
+
+static int _freeze_object(_freeze_writer_t *w, cjson_object_t *obj, cjson_fvalue_t *slot)
+{
+    int64_t off = 0;
+    int64_t key_off = 0;
+    int64_t i = 0;
+    int64_t key_len = 0;
+    const tchar_t *key = NULL;
+    cjson_value_t *val = NULL;
+    cjson_fkv_t entry;
+    position_t pos;
+
+    off = _freeze_alloc(w, (int64_t)obj->count * sizeof(cjson_fkv_t));
+    if (off < 0) {
+        return -1;
+    }
+
+    val = cjson_object_first_value(obj, &pos);
+    while (val) {
+        memset(&entry, 0, sizeof(entry));
+
+        key = cjson_object_key(obj, val, &key_len);
+        key_off = _freeze_string(w, key, key_len);
+        if (key_off < 0) {
+            return -1;
+        }
+        entry.key_off = (uint32_t)key_off;
+        entry.key_len = (uint32_t)key_len;
+
+        if (_freeze_value(w, val, &(entry.value)) < 0) {
+            return -1;
+        }
+
+        if (w->buf) {
+            memcpy(w->buf + off + i * sizeof(cjson_fkv_t), &entry, sizeof(entry));
+        }
+
+        i++;
+        val = cjson_object_next_value(obj, &pos);
+    }
+
+    slot->len = (uint32_t)obj->count;
+    slot->__fv.off = (uint64_t)off;
+
+    return 0;
+}
+
+static int _freeze_value(_freeze_writer_t *w, const cjson_value_t *value, cjson_fvalue_t *slot)
+{
+    int64_t off = 0;
+
+    memset(slot, 0, sizeof(cjson_fvalue_t));
+    slot->value_type = (uint8_t)value->value_type;
+
+    switch (value->value_type) {
+    case _cjson_value_null_:
+        return 0;
+    case _cjson_value_bool_:
+        slot->__fv.boolval = value->cjson_boolval ? 1 : 0;
+        return 0;
+    case _cjson_value_number_:
+        slot->scale = value->cjson_numscale;
+        slot->__fv.number = value->cjson_numval;
+        return 0;
+    case _cjson_value_string_:
+        off = _freeze_string(w, cjson_value_str(value), cjson_value_strlen(value));
+        if (off < 0) {
+            return -1;
+        }
+        slot->len = (uint32_t)cjson_value_strlen(value);
+        slot->__fv.off = (uint64_t)off;
+        return 0;
+    case _cjson_value_array_:
+        return _freeze_array(w, value->cjson_arrval, slot);
+    case _cjson_value_object_:
+        return _freeze_object(w, value->cjson_objval, slot);
+    default:
+        break;
+    }
+
+    return -1;
+}
+
+// data => image
+int64_t cjson_freeze(const cjson_t *json, void *buf, int64_t buflen)
+{
+    _freeze_writer_t w;
+    cjson_value_t root_data;
+    cjson_frozen_header_t hdr;
+
+    if (json == NULL || json->object == NULL) {
+        return -1;
+    }
+
+    w.buf = (uint8_t*)buf;
+    w.buflen = buflen;
+    w.pos = 0;
+
+    if (_freeze_alloc(&w, sizeof(cjson_frozen_header_t)) < 0) {
+        return -1;
+    }
+
+    root_data.value_type = _cjson_value_object_;
+    root_data.cjson_objval = json->object;
+
+    memset(&hdr, 0, sizeof(hdr));
+    if (_freeze_value(&w, &root_data, &(hdr.root)) < 0) {
+        return -1;
+    }
+
+    hdr.magic = CJSON_FROZEN_MAGIC;
+    hdr.version = CJSON_FROZEN_VERSION;
+    hdr.size = (uint32_t)w.pos;
+
+    if (w.buf) {
+        memcpy(w.buf, &hdr, sizeof(hdr));
+    }
+
+    return w.pos;
+}
+
+//===========================================================
+// in place accessors
+
+// return 0 if [off, off + len) lies inside the image, off is untrusted,
+// off + len may wrap
+#define _frozen_check(fz, off, len)     ((uint64_t)(off) <= (fz)->size && (uint64_t)(len) <= (fz)->size - (uint64_t)(off) ? 0 : -1)
+// nodes are aligned as cjson_freeze() writes them
+#define _frozen_check_node(fz, off, len) ((((uint64_t)(off) & (_frozen_align_ - 1)) == 0) ? _frozen_check((fz), (off), (len)) : -1)
+
+int cjson_frozen_open(cjson_frozen_t *fz, const void *image, int64_t size)
+{
+    const cjson_frozen_header_t *hdr = (const cjson_frozen_header_t*)image;
+
+    if (fz == NULL || image == NULL || size < (int64_t)sizeof(cjson_frozen_header_t)) {
+        return -1;
+    }
+
+    if (((uintptr_t)image & (_frozen_align_ - 1)) != 0) {
+        return -1; // mmap()/malloc() memory is always aligned
+    }
+
+    if (hdr->magic != CJSON_FROZEN_MAGIC || hdr->version != CJSON_FROZEN_VERSION
+        || (int64_t)hdr->size > size || hdr->root.value_type != _cjson_value_object_) {
+        return -1;
+    }
+
+    fz->base = (const uint8_t*)image;
+    fz->size = hdr->size;
+
+    return 0;
+}
+
+const cjson_fvalue_t* cjson_frozen_root(const cjson_frozen_t *fz)
+{
+    return &(((const cjson_frozen_header_t*)fz->base)->root);
+}
+
+const cjson_fvalue_t* cjson_frozen_object_at(const cjson_frozen_t *fz, const cjson_fvalue_t *obj, int64_t index, const tchar_t **key)
+{
+    const cjson_fkv_t *kv = NULL;
+
+    if (obj == NULL || obj->value_type != _cjson_value_object_ || index < 0 || (uint64_t)index >= obj->len) {
+        return NULL;
+    }
+
+    if (_frozen_check_node(fz, obj->__fv.off, (uint64_t)obj->len * sizeof(cjson_fkv_t)) < 0) {
+        return NULL;
+    }
+
+    kv = (const cjson_fkv_t*)(fz->base + obj->__fv.off) + index;
+    if (key) {
+        if (_frozen_check(fz, kv->key_off, (uint64_t)kv->key_len + 1) < 0 || ((const tchar_t*)(fz->base + kv->key_off))[kv->key_len] != 0) {
+            return NULL;
+        }
+        *key = (const tchar_t*)(fz->base + kv->key_off);
+    }
+
+    return &(kv->value);
+}
+
+const cjson_fvalue_t* cjson_frozen_object_get(const cjson_frozen_t *fz, const cjson_fvalue_t *obj, const tchar_t *key)
+{
+    uint32_t i = 0;
+    size_t len = 0;
+    const cjson_fkv_t *kv = NULL;
+
+    if (obj == NULL || obj->value_type != _cjson_value_object_ || key == NULL) {
+        return NULL;
+    }
+
+    if (_frozen_check_node(fz, obj->__fv.off, (uint64_t)obj->len * sizeof(cjson_fkv_t)) < 0) {
+        return NULL;
+    }
+
+    len = strlen(key);
+    kv = (const cjson_fkv_t*)(fz->base + obj->__fv.off);
+    for (i = 0; i < obj->len; i++, kv++) {
+        if (kv->key_len != len || _frozen_check(fz, kv->key_off, len) < 0) {
+            continue;
+        }
+
+        if (memcmp(fz->base + kv->key_off, key, len * sizeof(tchar_t)) == 0) {
+            return &(kv->value);
+        }
+    }
+
+    return NULL;
+}
+
+const cjson_fvalue_t* cjson_frozen_array_at(const cjson_frozen_t *fz, const cjson_fvalue_t *arr, int64_t index)
+{
+    if (arr == NULL || arr->value_type != _cjson_value_array_ || index < 0 || (uint64_t)index >= arr->len) {
+        return NULL;
+    }
+
+    if (_frozen_check_node(fz, arr->__fv.off, (uint64_t)arr->len * sizeof(cjson_fvalue_t)) < 0) {
+        return NULL;
+    }
+
+    return (const cjson_fvalue_t*)(fz->base + arr->__fv.off) + index;
+}
+
+const tchar_t* cjson_frozen_string(const cjson_frozen_t *fz, const cjson_fvalue_t *val, int64_t *len)
+{
+    if (val == NULL || val->value_type != _cjson_value_string_) {
+        return NULL;
+    }
+
+    // '\0' ended, as cjson_freeze() writes it
+    if (_frozen_check(fz, val->__fv.off, (uint64_t)val->len + 1) < 0 || ((const tchar_t*)(fz->base + val->__fv.off))[val->len] != 0) {
+        return NULL;
+    }
+
+    if (len) {
+        *len = (int64_t)val->len;
+    }
+
+    return (const tchar_t*)(fz->base + val->__fv.off);
+}
+
+int cjson_frozen_number(const cjson_fvalue_t *val, cjson_number_t *num)
+{
+    int i = 0;
+
+    if (val == NULL || val->value_type != _cjson_value_number_ || val->scale > CJSON_NUMBER_SCALE_MAX) {
+        return -1;
+    }
+
+    num->number = val->__fv.number;
+    num->divisor = 1;
+    for (i = 0; i < val->scale; i++) {
+        num->divisor *= 10;
+    }
+
+    return 0;
+}
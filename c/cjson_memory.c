@@ -0,0 +1,135 @@
+/************************************************************************************
+* cjson_memory.c: Implementation File
+*
+* cjson memory accounting
+*
+* DESCRIPTION:
+*   bytes held by a decoded document, by category, to size caches of
+*   documents and to spot bloat.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   a value slot is counted by the type of the value in it. Containers
+*   shared by cjson_share() are counted in every document holding them.
+*
+************************************************************************************/
+
+#include <cjson.h>
+#include <chashmap.h>
+
+// one block from allocator a, what it costs over size
+#define _memory_block(m, a, size)       ((m)->overhead += (int64_t)cjson_alloc_usable((a), (size)) - (int64_t)(size))
+
+static void _memory_container(cjson_memory_t *m, const cjson_value_t *val);
+
+static void _memory_string(cjson_memory_t *m, const cjson_string_t *str, int64_t *category)
+{
+    size_t size = sizeof(cjson_string_t) + str->capacity * sizeof(tchar_t);
+
+    *category += sizeof(cjson_string_t) + (str->len + 1) * sizeof(tchar_t);
+    m->slack += (str->capacity - str->len - 1) * sizeof(tchar_t);
+    _memory_block(m, str->allocator, size);
+}
+
+// the slot of a value & what it points to
+static void _memory_value(cjson_memory_t *m, const cjson_value_t *val)
+{
+    m->values++;
+
+    switch (val->value_type) {
+    case _cjson_value_string_:
+        m->strings += sizeof(cjson_value_t);
+        if (cjson_value_str_is_long(val)) {
+            _memory_string(m, val->cjson_strval, &(m->strings));
+        }
+        break;
+    case _cjson_value_number_:
+        m->numbers += sizeof(cjson_value_t);
+        break;
+    case _cjson_value_array_:
+    case _cjson_value_object_:
+        m->nodes += sizeof(cjson_value_t);
+        _memory_container(m, val);
+        break;
+    default:
+        m->nodes += sizeof(cjson_value_t);
+        break;
+    }
+}
+
+static void _memory_container(cjson_memory_t *m, const cjson_value_t *val)
+{
+    int64_t i = 0;
+    const cjson_object_t *obj = NULL;
+    const cjson_array_t *arr = NULL;
+
+    m->containers++;
+
+    if (val->value_type == _cjson_value_object_) {
+        obj = val->cjson_objval;
+        m->nodes += sizeof(cjson_object_t);
+        _memory_block(m, obj->allocator, sizeof(cjson_object_t));
+
+        if (obj->capacity > 0) {
+            m->slack += (obj->capacity - obj->count) * sizeof(cjson_value_t);
+            _memory_block(m, obj->allocator, obj->capacity * sizeof(cjson_value_t));
+        }
+
+        if (obj->keys) {
+            m->keys += obj->count * sizeof(cjson_objkey_t);
+            m->slack += (obj->capacity - obj->count) * sizeof(cjson_objkey_t);
+            _memory_block(m, obj->allocator, obj->capacity * sizeof(cjson_objkey_t));
+
+            for (i = 0; i < obj->count; i++) {
+                if (cjson_key_is_long(&(obj->keys[i]))) {
+                    _memory_string(m, obj->keys[i].lkey, &(m->keys));
+                }
+            }
+        }
+
+        if (obj->index) {
+            m->index += chashmap_memory(obj->index);
+        }
+
+        for (i = 0; i < obj->count; i++) {
+            _memory_value(m, &(obj->vals[i]));
+        }
+        return;
+    }
+
+    arr = val->cjson_arrval;
+    m->nodes += sizeof(cjson_array_t);
+    _memory_block(m, arr->allocator, sizeof(cjson_array_t));
+
+    if (arr->capacity > 0) {
+        m->slack += (arr->capacity - arr->count) * sizeof(cjson_value_t);
+        _memory_block(m, arr->allocator, arr->capacity * sizeof(cjson_value_t));
+    }
+
+    for (i = 0; i < arr->count; i++) {
+        _memory_value(m, &(arr->elem[i]));
+    }
+}
+
+int cjson_memory_usage(const cjson_t *json, cjson_memory_t *usage)
+{
+    cjson_value_t root_data;
+
+    if (json == NULL || json->object == NULL || usage == NULL) {
+        return -1;
+    }
+
+    memset(usage, 0, sizeof(cjson_memory_t));
+
+    root_data.value_type = _cjson_value_object_;
+    root_data.cjson_objval = json->object;
+    _memory_container(usage, &root_data);
+
+    usage->total = usage->nodes + usage->keys + usage->strings + usage->numbers + usage->overhead + usage->slack + usage->index;
+
+    return 0;
+}
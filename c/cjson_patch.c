@@ -0,0 +1,1004 @@
+/************************************************************************************
+* cjson_patch.c: Implementation File
+*
+* cjson patch
+*
+* DESCRIPTION:
+*   RFC 6902 JSON Patch & RFC 7396 JSON Merge Patch applied in place, and
+*   the diff of two documents as a JSON Patch.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   versions made by cjson_share() share their containers. A shared
+*   container is copied before a change, its children become shared by the
+*   copy then, so only the containers on the changed path are copied.
+*   A patch works on such a version of the document and replaces the
+*   document only if all of it applies.
+*
+************************************************************************************/
+
+#include <cjson.h>
+
+#define _patch_refs(val)                ((val)->value_type == _cjson_value_object_ ? &((val)->cjson_objval->refs) : &((val)->cjson_arrval->refs))
+#define _patch_span(val)                ((val)->value_type == _cjson_value_object_ ? &((val)->cjson_objval->span) : &((val)->cjson_arrval->span))
+#define _patch_is_container(val)        ((val)->value_type == _cjson_value_object_ || (val)->value_type == _cjson_value_array_)
+
+static cjson_object_t* _patch_new_object(void)
+{
+    cjson_object_t *obj = NULL;
+
+    obj = (cjson_object_t*)cjson_alloc(NULL, sizeof(cjson_object_t));
+    if (obj) {
+        memset(obj, 0, sizeof(cjson_object_t));
+    }
+
+    return obj;
+}
+
+static cjson_array_t* _patch_new_array(void)
+{
+    cjson_array_t *arr = NULL;
+
+    arr = (cjson_array_t*)cjson_alloc(NULL, sizeof(cjson_array_t));
+    if (arr) {
+        memset(arr, 0, sizeof(cjson_array_t));
+    }
+
+    return arr;
+}
+
+// src => dst, deep, or sharing the child containers
+static int _patch_copy(cjson_value_t *dst, const cjson_value_t *src, int deep)
+{
+    int64_t len = 0;
+    const tchar_t *key = NULL;
+    cjson_value_t *val = NULL;
+    cjson_object_t *obj = NULL;
+    cjson_array_t *arr = NULL;
+    cjson_kv_t kv;
+    cjson_value_t elem;
+    position_t pos;
+
+    *dst = *src;
+
+    switch (src->value_type) {
+    case _cjson_value_string_:
+        if (cjson_value_str_is_long(src)) {
+            return cjson_value_set_string(dst, cjson_value_str(src), cjson_value_strlen(src));
+        }
+        return 0;
+
+    case _cjson_value_object_:
+        if (!deep) {
+            __atomic_add_fetch(_patch_refs(src), 1, __ATOMIC_ACQ_REL);
+            return 0;
+        }
+
+        obj = _patch_new_object();
+        if (obj == NULL) {
+            return -1;
+        }
+        dst->cjson_objval = obj;
+
+        for (val = cjson_object_first_value(src->cjson_objval, &pos); val; val = cjson_object_next_value(src->cjson_objval, &pos)) {
+            key = cjson_object_key(src->cjson_objval, val, &len);
+            if (cjson_kv_set_key(&kv, key, len) < 0) {
+                goto lbl_err;
+            }
+            if (_patch_copy(&(kv.value), val, 1) < 0) {
+                cjson_key_free(&(kv.__key));
+                goto lbl_err;
+            }
+            if (cjson_object_addkv(obj, &kv) < 0) {
+                cjson_kv_free(&kv);
+                goto lbl_err;
+            }
+        }
+        return 0;
+
+    case _cjson_value_array_:
+        if (!deep) {
+            __atomic_add_fetch(_patch_refs(src), 1, __ATOMIC_ACQ_REL);
+            return 0;
+        }
+
+        arr = _patch_new_array();
+        if (arr == NULL) {
+            return -1;
+        }
+        arr->value_type = src->cjson_arrval->value_type;
+        dst->cjson_arrval = arr;
+
+        for (val = cjson_array_first(src->cjson_arrval, &pos); val; val = cjson_array_next(src->cjson_arrval, &pos)) {
+            if (_patch_copy(&elem, val, 1) < 0) {
+                goto lbl_err;
+            }
+            if (cjson_array_add(arr, &elem) < 0) {
+                cjson_value_free(&elem);
+                goto lbl_err;
+            }
+        }
+        return 0;
+
+    default:
+        break;
+    }
+
+    return 0;
+
+lbl_err:
+
+    cjson_value_free(dst);
+
+    return -1;
+}
+
+// shallow copy of a shared container, its children become shared
+static int _patch_clone(cjson_value_t *dst, const cjson_value_t *src)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+    cjson_object_t *obj = NULL;
+    cjson_array_t *arr = NULL;
+    const cjson_object_t *sobj = NULL;
+    const cjson_array_t *sarr = NULL;
+
+    *dst = *src;
+
+    if (src->value_type == _cjson_value_object_) {
+        sobj = src->cjson_objval;
+        obj = _patch_new_object();
+        if (obj == NULL) {
+            return -1;
+        }
+        dst->cjson_objval = obj;
+
+        n = sobj->count;
+        if (n > 0) {
+            obj->vals = (cjson_value_t*)cjson_alloc(NULL, n * sizeof(cjson_value_t));
+            if (obj->vals == NULL) {
+                goto lbl_err;
+            }
+            if (sobj->shape == NULL) {
+                obj->keys = (cjson_objkey_t*)cjson_alloc(NULL, n * sizeof(cjson_objkey_t));
+                if (obj->keys == NULL) {
+                    goto lbl_err;
+                }
+            }
+        }
+        obj->shape = sobj->shape;
+        obj->capacity = n;
+
+        for (i = 0; i < n; i++) {
+            if (obj->keys && cjson_key_set(&(obj->keys[i]), cjson_key_str(&(sobj->keys[i])), cjson_key_len(&(sobj->keys[i]))) < 0) {
+                goto lbl_err;
+            }
+            if (_patch_copy(&(obj->vals[i]), &(sobj->vals[i]), 0) < 0) {
+                if (obj->keys) {
+                    cjson_key_free(&(obj->keys[i]));
+                }
+                goto lbl_err;
+            }
+            obj->count++;
+        }
+
+        if (sobj->index && cjson_object_index(obj) < 0) {
+            goto lbl_err;
+        }
+        return 0;
+    }
+
+    sarr = src->cjson_arrval;
+    arr = _patch_new_array();
+    if (arr == NULL) {
+        return -1;
+    }
+    arr->value_type = sarr->value_type;
+    dst->cjson_arrval = arr;
+
+    n = sarr->count;
+    if (n > 0) {
+        arr->elem = (cjson_value_t*)cjson_alloc(NULL, n * sizeof(cjson_value_t));
+        if (arr->elem == NULL) {
+            goto lbl_err;
+        }
+    }
+    arr->capacity = n;
+
+    for (i = 0; i < n; i++) {
+        if (_patch_copy(&(arr->elem[i]), &(sarr->elem[i]), 0) < 0) {
+            goto lbl_err;
+        }
+        arr->count++;
+    }
+
+    return 0;
+
+lbl_err:
+
+    cjson_value_free(dst);
+
+    return -1;
+}
+
+// the container in slot is about to change, copy it if shared
+static int _patch_own(cjson_value_t *slot, cjson_span_t *parent)
+{
+    cjson_value_t copy;
+
+    if (!_patch_is_container(slot)) {
+        return 0;
+    }
+
+    if (__atomic_load_n(_patch_refs(slot), __ATOMIC_ACQUIRE) == 0) {
+        _patch_span(slot)->parent = parent; // the parent may be a copy
+        return 0;
+    }
+
+    if (_patch_clone(&copy, slot) < 0) {
+        return -1;
+    }
+
+    cjson_value_free(slot); // one owner less
+    *slot = copy;
+
+    // a copy has no span, the parent is dirty
+    _patch_span(slot)->parent = parent;
+    if (slot->value_type == _cjson_value_object_) {
+        cjson_object_touch(slot->cjson_objval);
+    } else {
+        cjson_array_touch(slot->cjson_arrval);
+    }
+
+    return 0;
+}
+
+int cjson_share(const cjson_t *json, cjson_t *copy)
+{
+    if (json == NULL || json->object == NULL || copy == NULL) {
+        return -1;
+    }
+
+    __atomic_add_fetch(&(json->object->refs), 1, __ATOMIC_ACQ_REL);
+    copy->object = json->object;
+
+    return 0;
+}
+
+int cjson_value_copy(cjson_value_t *dst, const cjson_value_t *src)
+{
+    return _patch_copy(dst, src, 1);
+}
+
+//===========================================================
+// equal
+static int _patch_number_equal(const cjson_value_t *a, const cjson_value_t *b)
+{
+    int64_t an = a->cjson_numval;
+    int64_t bn = b->cjson_numval;
+    int as = a->cjson_numscale;
+    int bs = b->cjson_numscale;
+
+    while (as > 0 && an % 10 == 0) {
+        an /= 10;
+        as--;
+    }
+    while (bs > 0 && bn % 10 == 0) {
+        bn /= 10;
+        bs--;
+    }
+
+    return (an == bn && as == bs);
+}
+
+int cjson_value_equal(const cjson_value_t *a, const cjson_value_t *b)
+{
+    int64_t i = 0;
+    const cjson_value_t *val = NULL;
+    const cjson_value_t *other = NULL;
+
+    if (a->value_type != b->value_type) {
+        return 0;
+    }
+
+    switch (a->value_type) {
+    case _cjson_value_null_:
+        return 1;
+    case _cjson_value_bool_:
+        return (!a->cjson_boolval == !b->cjson_boolval);
+    case _cjson_value_number_:
+        return _patch_number_equal(a, b);
+    case _cjson_value_string_:
+        return (cjson_value_strlen(a) == cjson_value_strlen(b)
+            && memcmp(cjson_value_str(a), cjson_value_str(b), cjson_value_strlen(a) * sizeof(tchar_t)) == 0);
+    case _cjson_value_array_:
+        if (a->cjson_arrval == b->cjson_arrval) {
+            return 1;
+        }
+        if (a->cjson_arrval->count != b->cjson_arrval->count) {
+            return 0;
+        }
+        for (i = 0; i < a->cjson_arrval->count; i++) {
+            if (!cjson_value_equal(&(a->cjson_arrval->elem[i]), &(b->cjson_arrval->elem[i]))) {
+                return 0;
+            }
+        }
+        return 1;
+    case _cjson_value_object_:
+        if (a->cjson_objval == b->cjson_objval) {
+            return 1;
+        }
+        if (a->cjson_objval->count != b->cjson_objval->count) {
+            return 0;
+        }
+        for (i = 0; i < a->cjson_objval->count; i++) {
+            val = &(a->cjson_objval->vals[i]);
+            other = cjson_object_get_value(b->cjson_objval, cjson_object_key(a->cjson_objval, val, NULL));
+            if (other == NULL || !cjson_value_equal(val, other)) {
+                return 0;
+            }
+        }
+        return 1;
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+//===========================================================
+// JSON Patch
+
+// next token of a pointer, unescaped & '\0' ended into token
+// return chars consumed, or -1 for error
+static int64_t _patch_token(const tchar_t *path, tchar_t *token)
+{
+    int64_t i = 1;
+    int64_t n = 0;
+
+    if (path[0] != _T('/')) {
+        return -1;
+    }
+
+    for (; path[i] && path[i] != _T('/'); i++) {
+        if (path[i] == _T('~')) {
+            if (path[i + 1] != _T('0') && path[i + 1] != _T('1')) {
+                return -1;
+            }
+            token[n++] = (path[i + 1] == _T('0')) ? _T('~') : _T('/');
+            i++;
+        } else {
+            token[n++] = path[i];
+        }
+    }
+    token[n] = 0;
+
+    return i;
+}
+
+// array index token, "-" is the end if end is set, -1 for error
+static int64_t _patch_index(const tchar_t *token, int64_t count, int end)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+
+    if (end && strcmp(token, _T("-")) == 0) {
+        return count;
+    }
+
+    if (token[0] == 0 || (token[0] == _T('0') && token[1] != 0)) {
+        return -1;
+    }
+
+    for (i = 0; token[i]; i++) {
+        if (token[i] < _T('0') || token[i] > _T('9') || n > count) {
+            return -1;
+        }
+        n = n * 10 + (token[i] - _T('0'));
+    }
+
+    return (n < count + (end ? 1 : 0) ? n : -1);
+}
+
+static cjson_value_t* _patch_child(cjson_value_t *val, const tchar_t *token)
+{
+    int64_t i = 0;
+
+    if (val->value_type == _cjson_value_object_) {
+        return cjson_object_get_value(val->cjson_objval, token);
+    }
+
+    if (val->value_type == _cjson_value_array_) {
+        i = _patch_index(token, val->cjson_arrval->count, 0);
+        return (i < 0 ? NULL : &(val->cjson_arrval->elem[i]));
+    }
+
+    return NULL;
+}
+
+// the container of the last token of path, copied on the way if own is set
+static cjson_value_t* _patch_parent(cjson_value_t *root, const tchar_t *path, int own, tchar_t *token)
+{
+    int64_t ret = 0;
+    cjson_value_t *cur = root;
+    cjson_value_t *child = NULL;
+
+    if (own && _patch_own(cur, NULL) < 0) {
+        return NULL;
+    }
+
+    for (;;) {
+        ret = _patch_token(path, token);
+        if (ret < 0) {
+            return NULL;
+        }
+        path += ret;
+
+        if (*path == 0) {
+            return cur;
+        }
+
+        child = _patch_child(cur, token);
+        if (child == NULL) {
+            return NULL;
+        }
+
+        if (own && _patch_own(child, _patch_span(cur)) < 0) {
+            return NULL;
+        }
+        cur = child;
+    }
+}
+
+static const cjson_value_t* _patch_get(cjson_value_t *root, const tchar_t *path, tchar_t *token)
+{
+    cjson_value_t *parent = NULL;
+
+    if (path[0] == 0) {
+        return root;
+    }
+
+    parent = _patch_parent(root, path, 0, token);
+
+    return (parent ? _patch_child(parent, token) : NULL);
+}
+
+// val is moved into the document on success
+static int _patch_add(cjson_value_t *root, const tchar_t *path, cjson_value_t *val, tchar_t *token)
+{
+    int64_t i = 0;
+    cjson_value_t *parent = NULL;
+
+    if (path[0] == 0) { // the whole document
+        if (val->value_type != _cjson_value_object_) {
+            return -1;
+        }
+        cjson_value_free(root);
+        *root = *val;
+        return 0;
+    }
+
+    parent = _patch_parent(root, path, 1, token);
+    if (parent == NULL) {
+        return -1;
+    }
+
+    if (parent->value_type == _cjson_value_object_) {
+        return cjson_object_set_value(parent->cjson_objval, token, val);
+    }
+
+    if (parent->value_type == _cjson_value_array_) {
+        i = _patch_index(token, parent->cjson_arrval->count, 1);
+        return (i < 0 ? -1 : cjson_array_insert(parent->cjson_arrval, i, val));
+    }
+
+    return -1;
+}
+
+static int _patch_remove(cjson_value_t *root, const tchar_t *path, cjson_value_t *out, tchar_t *token)
+{
+    cjson_value_t *parent = NULL;
+
+    parent = _patch_parent(root, path, 1, token);
+    if (parent == NULL) {
+        return -1;
+    }
+
+    if (parent->value_type == _cjson_value_object_) {
+        return cjson_object_remove(parent->cjson_objval, token, out);
+    }
+
+    if (parent->value_type == _cjson_value_array_) {
+        return cjson_array_remove(parent->cjson_arrval, _patch_index(token, parent->cjson_arrval->count, 0), out);
+    }
+
+    return -1;
+}
+
+static int _patch_replace(cjson_value_t *root, const tchar_t *path, cjson_value_t *val, tchar_t *token)
+{
+    cjson_value_t *parent = NULL;
+
+    if (path[0] == 0) {
+        return _patch_add(root, path, val, token);
+    }
+
+    parent = _patch_parent(root, path, 1, token);
+    if (parent == NULL) {
+        return -1;
+    }
+
+    if (parent->value_type == _cjson_value_object_) {
+        if (cjson_object_get_value(parent->cjson_objval, token) == NULL) {
+            return -1;
+        }
+        return cjson_object_set_value(parent->cjson_objval, token, val);
+    }
+
+    if (parent->value_type == _cjson_value_array_) {
+        return cjson_array_set(parent->cjson_arrval, _patch_index(token, parent->cjson_arrval->count, 0), val);
+    }
+
+    return -1;
+}
+
+static const tchar_t* _patch_member_str(const cjson_object_t *op, const tchar_t *name)
+{
+    const cjson_value_t *val = NULL;
+
+    val = cjson_object_get_value(op, name);
+    if (val == NULL || val->value_type != _cjson_value_string_) {
+        return NULL;
+    }
+
+    return cjson_value_str(val);
+}
+
+static int _patch_op(cjson_value_t *root, const cjson_object_t *op)
+{
+    int ret = -1;
+    size_t len = 0;
+    tchar_t *token = NULL;
+    const tchar_t *name = NULL;
+    const tchar_t *path = NULL;
+    const tchar_t *from = NULL;
+    const cjson_value_t *value = NULL;
+    const cjson_value_t *src = NULL;
+    cjson_value_t val;
+
+    name = _patch_member_str(op, _T("op"));
+    path = _patch_member_str(op, _T("path"));
+    from = _patch_member_str(op, _T("from"));
+    value = cjson_object_get_value(op, _T("value"));
+    if (name == NULL || path == NULL) {
+        return -1;
+    }
+
+    len = strlen(path);
+    if (from && strlen(from) > len) {
+        len = strlen(from);
+    }
+    token = (tchar_t*)my_malloc((len + 1) * sizeof(tchar_t));
+    if (token == NULL) {
+        return -1;
+    }
+
+    val.value_type = _cjson_value_unknown_;
+
+    if (strcmp(name, _T("add")) == 0 || strcmp(name, _T("replace")) == 0) {
+        if (value == NULL || cjson_value_copy(&val, value) < 0) {
+            goto lbl_done;
+        }
+        ret = (name[0] == _T('a')) ? _patch_add(root, path, &val, token) : _patch_replace(root, path, &val, token);
+    } else if (strcmp(name, _T("remove")) == 0) {
+        ret = _patch_remove(root, path, NULL, token);
+    } else if (strcmp(name, _T("move")) == 0) {
+        if (from == NULL) {
+            goto lbl_done;
+        }
+        if (strcmp(from, path) == 0) {
+            ret = 0;
+            goto lbl_done;
+        }
+        // not into itself
+        len = strlen(from);
+        if (strncmp(path, from, len) == 0 && path[len] == _T('/')) {
+            goto lbl_done;
+        }
+        if (_patch_remove(root, from, &val, token) < 0) {
+            goto lbl_done;
+        }
+        ret = _patch_add(root, path, &val, token);
+    } else if (strcmp(name, _T("copy")) == 0) {
+        src = (from ? _patch_get(root, from, token) : NULL);
+        if (src == NULL || cjson_value_copy(&val, src) < 0) {
+            goto lbl_done;
+        }
+        ret = _patch_add(root, path, &val, token);
+    } else if (strcmp(name, _T("test")) == 0) {
+        src = _patch_get(root, path, token);
+        ret = (src && value && cjson_value_equal(src, value)) ? 0 : -1;
+        goto lbl_done;
+    }
+
+    if (ret < 0) {
+        cjson_value_free(&val);
+    }
+
+lbl_done:
+
+    my_free(token);
+
+    return ret;
+}
+
+// a version of the document to change, the document is left as it is
+static void _patch_begin(const cjson_t *json, cjson_value_t *root)
+{
+    __atomic_add_fetch(&(json->object->refs), 1, __ATOMIC_ACQ_REL);
+    root->value_type = _cjson_value_object_;
+    root->cjson_objval = json->object;
+}
+
+// the version replaces the document if ret is 0, or is dropped
+static int _patch_end(cjson_t *json, cjson_value_t *root, int ret)
+{
+    if (ret < 0) {
+        cjson_value_free(root);
+        return -1;
+    }
+
+    cjson_object_free(json->object);
+    json->object = root->cjson_objval;
+
+    return 0;
+}
+
+int cjson_patch_apply(cjson_t *json, const cjson_array_t *patch)
+{
+    int64_t i = 0;
+    int ret = 0;
+    cjson_value_t root_data;
+
+    if (json == NULL || json->object == NULL || patch == NULL) {
+        return -1;
+    }
+
+    _patch_begin(json, &root_data);
+
+    for (i = 0; i < patch->count && ret == 0; i++) {
+        if (patch->elem[i].value_type != _cjson_value_object_) {
+            ret = -1;
+            break;
+        }
+        ret = _patch_op(&root_data, patch->elem[i].cjson_objval);
+    }
+
+    return _patch_end(json, &root_data, ret);
+}
+
+//===========================================================
+// JSON Merge Patch
+static int _merge_patch(cjson_value_t *target, const cjson_object_t *patch)
+{
+    const tchar_t *key = NULL;
+    const cjson_value_t *pv = NULL;
+    cjson_value_t *tv = NULL;
+    cjson_object_t *obj = target->cjson_objval;
+    cjson_value_t val;
+    position_t pos;
+
+    for (pv = cjson_object_first_value((cjson_object_t*)patch, &pos); pv; pv = cjson_object_next_value((cjson_object_t*)patch, &pos)) {
+        key = cjson_object_key(patch, pv, NULL);
+
+        if (pv->value_type == _cjson_value_null_) {
+            cjson_object_remove(obj, key, NULL); // may be none
+            continue;
+        }
+
+        if (pv->value_type != _cjson_value_object_) {
+            if (cjson_value_copy(&val, pv) < 0) {
+                return -1;
+            }
+        } else {
+            tv = cjson_object_get_value(obj, key);
+            if (tv && tv->value_type == _cjson_value_object_) {
+                if (_patch_own(tv, &(obj->span)) < 0 || _merge_patch(tv, pv->cjson_objval) < 0) {
+                    return -1;
+                }
+                continue;
+            }
+
+            val.value_type = _cjson_value_object_;
+            val.cjson_objval = _patch_new_object();
+            if (val.cjson_objval == NULL) {
+                return -1;
+            }
+            if (_merge_patch(&val, pv->cjson_objval) < 0) {
+                cjson_value_free(&val);
+                return -1;
+            }
+        }
+
+        if (cjson_object_set_value(obj, key, &val) < 0) {
+            cjson_value_free(&val);
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int cjson_merge_patch_apply(cjson_t *json, const cjson_object_t *patch)
+{
+    int ret = 0;
+    cjson_value_t root_data;
+
+    if (json == NULL || json->object == NULL || patch == NULL) {
+        return -1;
+    }
+
+    _patch_begin(json, &root_data);
+
+    ret = _patch_own(&root_data, NULL);
+    if (ret == 0) {
+        ret = _merge_patch(&root_data, patch);
+    }
+
+    return _patch_end(json, &root_data, ret);
+}
+
+//===========================================================
+// diff
+struct __diff_ctx_t {
+    cjson_array_t           *patch;
+    tchar_t                 *path;      // pointer of the values compared
+    int64_t                 len;
+    int64_t                 capacity;
+};
+typedef struct __diff_ctx_t             _diff_ctx_t;
+
+// path += "/token", return the old length, or -1 for error
+static int64_t _diff_push(_diff_ctx_t *dc, const tchar_t *token, int64_t len)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+    int64_t old = dc->len;
+    tchar_t *p = NULL;
+
+    if (dc->len + 2 * len + 2 > dc->capacity) {
+        n = (dc->len + 2 * len + 2) * 2;
+        p = (tchar_t*)my_realloc(dc->path, n * sizeof(tchar_t));
+        if (p == NULL) {
+            return -1;
+        }
+        dc->path = p;
+        dc->capacity = n;
+    }
+
+    dc->path[dc->len++] = _T('/');
+    for (i = 0; i < len; i++) {
+        if (token[i] == _T('~') || token[i] == _T('/')) {
+            dc->path[dc->len++] = _T('~');
+            dc->path[dc->len++] = (token[i] == _T('~')) ? _T('0') : _T('1');
+        } else {
+            dc->path[dc->len++] = token[i];
+        }
+    }
+    dc->path[dc->len] = 0;
+
+    return old;
+}
+
+static int64_t _diff_push_index(_diff_ctx_t *dc, int64_t index)
+{
+    tchar_t buf[24];
+
+    snprintf(buf, sizeof(buf), "%lld", (long long)index);
+
+    return _diff_push(dc, buf, strlen(buf));
+}
+
+static void _diff_pop(_diff_ctx_t *dc, int64_t old)
+{
+    dc->len = old;
+    if (dc->path) {
+        dc->path[old] = 0;
+    }
+}
+
+static int _diff_op(_diff_ctx_t *dc, const tchar_t *name, const cjson_value_t *value)
+{
+    cjson_value_t op;
+    cjson_value_t val;
+
+    op.value_type = _cjson_value_object_;
+    op.cjson_objval = _patch_new_object();
+    if (op.cjson_objval == NULL) {
+        return -1;
+    }
+
+    if (cjson_value_set_string(&val, name, strlen(name)) < 0
+        || cjson_object_set_value(op.cjson_objval, _T("op"), &val) < 0) {
+        goto lbl_err;
+    }
+
+    if (cjson_value_set_string(&val, (dc->path ? dc->path : _T("")), dc->len) < 0) {
+        goto lbl_err;
+    }
+    if (cjson_object_set_value(op.cjson_objval, _T("path"), &val) < 0) {
+        cjson_value_free(&val);
+        goto lbl_err;
+    }
+
+    if (value) {
+        if (cjson_value_copy(&val, value) < 0) {
+            goto lbl_err;
+        }
+        if (cjson_object_set_value(op.cjson_objval, _T("value"), &val) < 0) {
+            cjson_value_free(&val);
+            goto lbl_err;
+        }
+    }
+
+    if (cjson_array_add(dc->patch, &op) < 0) {
+        goto lbl_err;
+    }
+
+    return 0;
+
+lbl_err:
+
+    cjson_value_free(&op);
+
+    return -1;
+}
+
+static int _diff_value(_diff_ctx_t *dc, const cjson_value_t *a, const cjson_value_t *b);
+
+static int _diff_object(_diff_ctx_t *dc, cjson_object_t *a, cjson_object_t *b)
+{
+    int64_t old = 0;
+    int64_t len = 0;
+    const tchar_t *key = NULL;
+    const cjson_value_t *val = NULL;
+    const cjson_value_t *other = NULL;
+    position_t pos;
+
+    for (val = cjson_object_first_value(a, &pos); val; val = cjson_object_next_value(a, &pos)) {
+        key = cjson_object_key(a, val, &len);
+        old = _diff_push(dc, key, len);
+        if (old < 0) {
+            return -1;
+        }
+
+        other = cjson_object_get_value(b, key);
+        if ((other ? _diff_value(dc, val, other) : _diff_op(dc, _T("remove"), NULL)) < 0) {
+            return -1;
+        }
+        _diff_pop(dc, old);
+    }
+
+    for (val = cjson_object_first_value(b, &pos); val; val = cjson_object_next_value(b, &pos)) {
+        key = cjson_object_key(b, val, &len);
+        if (cjson_object_get_value(a, key)) {
+            continue;
+        }
+
+        old = _diff_push(dc, key, len);
+        if (old < 0 || _diff_op(dc, _T("add"), val) < 0) {
+            return -1;
+        }
+        _diff_pop(dc, old);
+    }
+
+    return 0;
+}
+
+// equal head & tail skipped, the rest element by element, the longer
+// middle added or removed
+static int _diff_array(_diff_ctx_t *dc, const cjson_array_t *a, const cjson_array_t *b)
+{
+    int64_t i = 0;
+    int64_t old = 0;
+    int64_t head = 0;
+    int64_t tail = 0;
+    int64_t na = 0;
+    int64_t nb = 0;
+    int64_t n = (a->count < b->count) ? a->count : b->count;
+
+    while (head < n && cjson_value_equal(&(a->elem[head]), &(b->elem[head]))) {
+        head++;
+    }
+    while (tail < n - head && cjson_value_equal(&(a->elem[a->count - 1 - tail]), &(b->elem[b->count - 1 - tail]))) {
+        tail++;
+    }
+
+    na = a->count - head - tail;
+    nb = b->count - head - tail;
+    n = (na < nb) ? na : nb;
+
+    for (i = head; i < head + n; i++) {
+        old = _diff_push_index(dc, i);
+        if (old < 0 || _diff_value(dc, &(a->elem[i]), &(b->elem[i])) < 0) {
+            return -1;
+        }
+        _diff_pop(dc, old);
+    }
+
+    for (i = head + n; i < head + nb; i++) {
+        old = _diff_push_index(dc, i);
+        if (old < 0 || _diff_op(dc, _T("add"), &(b->elem[i])) < 0) {
+            return -1;
+        }
+        _diff_pop(dc, old);
+    }
+
+    // from the end, the indexes before stay
+    for (i = head + na - 1; i >= head + n; i--) {
+        old = _diff_push_index(dc, i);
+        if (old < 0 || _diff_op(dc, _T("remove"), NULL) < 0) {
+            return -1;
+        }
+        _diff_pop(dc, old);
+    }
+
+    return 0;
+}
+
+static int _diff_value(_diff_ctx_t *dc, const cjson_value_t *a, const cjson_value_t *b)
+{
+    if (a->value_type == b->value_type) {
+        if (a->value_type == _cjson_value_object_) {
+            return (a->cjson_objval == b->cjson_objval ? 0 : _diff_object(dc, a->cjson_objval, b->cjson_objval));
+        }
+        if (a->value_type == _cjson_value_array_) {
+            return (a->cjson_arrval == b->cjson_arrval ? 0 : _diff_array(dc, a->cjson_arrval, b->cjson_arrval));
+        }
+        if (cjson_value_equal(a, b)) {
+            return 0;
+        }
+    }
+
+    return _diff_op(dc, _T("replace"), b);
+}
+
+cjson_array_t* cjson_diff(const cjson_t *from, const cjson_t *to)
+{
+    int ret = 0;
+    _diff_ctx_t dc;
+    cjson_value_t a;
+    cjson_value_t b;
+
+    if (from == NULL || from->object == NULL || to == NULL || to->object == NULL) {
+        return NULL;
+    }
+
+    memset(&dc, 0, sizeof(dc));
+    dc.patch = _patch_new_array();
+    if (dc.patch == NULL) {
+        return NULL;
+    }
+
+    a.value_type = _cjson_value_object_;
+    a.cjson_objval = from->object;
+    b.value_type = _cjson_value_object_;
+    b.cjson_objval = to->object;
+
+    ret = _diff_value(&dc, &a, &b);
+
+    if (dc.path) {
+        my_free(dc.path);
+    }
+
+    if (ret < 0) {
+        cjson_array_free(dc.patch);
+        return NULL;
+    }
+
+    return dc.patch;
+}
@@ -0,0 +1,953 @@
+/************************************************************************************
+* cjson_query.c: Implementation File
+*
+* cjson query
+*
+* DESCRIPTION:
+*   compile JSONPath / JSON Pointer expressions into flat instructions, and
+*   run them over a document or over the json text itself. Any number of
+*   queries run in one pass, each container is walked once for all.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   instruction i of a query matches values at depth i + 1, so the state of
+*   a running query is its index only.
+*
+************************************************************************************/
+
+#include <cjson.h>
+
+struct __query_parser_t {
+    cjson_query_instr_t     *path;
+    int64_t                 path_count;
+    int64_t                 path_capacity;
+    cjson_query_instr_t     *sub;       // filter paths
+    int64_t                 sub_count;
+    int64_t                 sub_capacity;
+    tchar_t                 *p;
+};
+typedef struct __query_parser_t         _query_parser_t;
+
+// a scalar, from a document or from the text
+struct __query_scalar_t {
+    cjson_valuetype_e       type;
+    const tchar_t           *s;
+    int64_t                 len;
+    long double             num;
+    int                     boolval;
+};
+typedef struct __query_scalar_t         _query_scalar_t;
+
+struct __query_run_t {
+    const cjson_query_t *const *qs;
+    pfn_cjson_query_t       cb;
+    pfn_cjson_query_text_t  text_cb;
+    void                    *ctx;
+    int64_t                 count;      // queries
+    int64_t                 *states;    // count slots per depth
+    int64_t                 matches;
+    int                     stop;
+};
+typedef struct __query_run_t            _query_run_t;
+
+static long double _query_number(const cjson_value_t *val)
+{
+    long double n = (long double)val->cjson_numval;
+    int i = 0;
+
+    for (i = 0; i < val->cjson_numscale; i++) {
+        n /= 10.0L;
+    }
+
+    return n;
+}
+
+//===========================================================
+// compile
+static int _query_add(cjson_query_instr_t **instrs, int64_t *count, int64_t *capacity, const cjson_query_instr_t *instr)
+{
+    int64_t n = 0;
+    cjson_query_instr_t *p = NULL;
+
+    if (*count >= *capacity) {
+        n = (*capacity == 0) ? 8 : *capacity * 2;
+        p = (cjson_query_instr_t*)my_realloc(*instrs, n * sizeof(cjson_query_instr_t));
+        if (p == NULL) {
+            return -1;
+        }
+        *instrs = p;
+        *capacity = n;
+    }
+
+    (*instrs)[(*count)++] = *instr;
+
+    return 0;
+}
+
+static void _query_skip_ws(_query_parser_t *ps)
+{
+    ps->p += cjson_scan_ws(ps->p);
+}
+
+// [n] or ['name'] or .name or .*, stop: chars ending a bare name
+static int _query_parse_step(_query_parser_t *ps, cjson_query_instr_t *instr, const tchar_t *stop)
+{
+    tchar_t quote = 0;
+    int64_t n = 0;
+
+    memset(instr, 0, sizeof(cjson_query_instr_t));
+    instr->op = _cjson_query_child_;
+    instr->index = -1;
+
+    if (*ps->p == _T('.')) {
+        ps->p++;
+        if (*ps->p == _T('*')) {
+            ps->p++;
+            instr->op = _cjson_query_wild_;
+            return 0;
+        }
+
+        instr->key = ps->p;
+        while (*ps->p && strchr(stop, *ps->p) == NULL) {
+            ps->p++;
+        }
+        instr->key_len = ps->p - instr->key;
+
+        return (instr->key_len > 0 ? 0 : -1);
+    }
+
+    if (*ps->p != _T('[')) {
+        return -1;
+    }
+    ps->p++;
+
+    if (*ps->p == _T('*')) {
+        ps->p++;
+        instr->op = _cjson_query_wild_;
+    } else if (*ps->p == _T('\'') || *ps->p == _T('"')) {
+        quote = *ps->p++;
+        instr->key = ps->p;
+        while (*ps->p && *ps->p != quote) {
+            ps->p++;
+        }
+        if (*ps->p != quote) {
+            return -1;
+        }
+        instr->key_len = ps->p - instr->key;
+        ps->p++;
+    } else if (*ps->p >= _T('0') && *ps->p <= _T('9')) {
+        for (n = 0; *ps->p >= _T('0') && *ps->p <= _T('9'); ps->p++) {
+            if (n > (INT64_MAX - (*ps->p - _T('0'))) / 10) {
+                return -1; // no array has that many elements
+            }
+            n = n * 10 + (*ps->p - _T('0'));
+        }
+        instr->index = n;
+    } else {
+        return -1;
+    }
+
+    if (*ps->p != _T(']')) {
+        return -1;
+    }
+    ps->p++;
+
+    return 0;
+}
+
+static int _query_parse_literal(_query_parser_t *ps, cjson_query_instr_t *instr)
+{
+    tchar_t quote = 0;
+    int64_t ret = 0;
+    cjson_value_t number;
+
+    switch (*ps->p) {
+    case _T('\''):
+    case _T('"'):
+        quote = *ps->p++;
+        instr->lit_type = _cjson_value_string_;
+        instr->lit_str = ps->p;
+        while (*ps->p && *ps->p != quote) {
+            ps->p += (*ps->p == _T('\\') && ps->p[1]) ? 2 : 1;
+        }
+        if (*ps->p != quote) {
+            return -1;
+        }
+        instr->lit_len = ps->p - instr->lit_str;
+        ps->p++;
+        return 0;
+    case _T('t'):
+    case _T('f'):
+        instr->lit_type = _cjson_value_bool_;
+        instr->lit_num = (*ps->p == _T('t'));
+        ret = (instr->lit_num ? 4 : 5);
+        if (strncmp(ps->p, (instr->lit_num ? _T("true") : _T("false")), ret) != 0) {
+            return -1;
+        }
+        ps->p += ret;
+        return 0;
+    case _T('n'):
+        instr->lit_type = _cjson_value_null_;
+        if (strncmp(ps->p, _T("null"), 4) != 0) {
+            return -1;
+        }
+        ps->p += 4;
+        return 0;
+    default:
+        break;
+    }
+
+    ret = cjson_scan_number(ps->p, &number);
+    if (ret <= 0) {
+        return -1;
+    }
+    instr->lit_type = _cjson_value_number_;
+    instr->lit_num = _query_number(&number);
+    ps->p += ret;
+
+    return 0;
+}
+
+// [?(@.path OP literal)], '[' is consumed
+static int _query_parse_filter(_query_parser_t *ps, cjson_query_instr_t *instr)
+{
+    static const struct {
+        const tchar_t       *op;
+        cjson_query_cmp_e   cmp;
+    } ops[] = {
+        { _T("=="), _cjson_query_eq_ },
+        { _T("!="), _cjson_query_ne_ },
+        { _T("<="), _cjson_query_le_ },
+        { _T(">="), _cjson_query_ge_ },
+        { _T("<"),  _cjson_query_lt_ },
+        { _T(">"),  _cjson_query_gt_ },
+    };
+    size_t i = 0;
+    cjson_query_instr_t step;
+
+    memset(instr, 0, sizeof(cjson_query_instr_t));
+    instr->op = _cjson_query_filter_;
+    instr->cmp = _cjson_query_exists_;
+    instr->index = ps->sub_count;
+
+    if (strncmp(ps->p, _T("?("), 2) != 0) {
+        return -1;
+    }
+    ps->p += 2;
+    _query_skip_ws(ps);
+
+    if (*ps->p != _T('@')) {
+        return -1;
+    }
+    ps->p++;
+
+    while (*ps->p == _T('.') || *ps->p == _T('[')) {
+        if (_query_parse_step(ps, &step, _T(".[ \t=!<>)")) < 0 || step.op != _cjson_query_child_) {
+            return -1;
+        }
+        if (_query_add(&(ps->sub), &(ps->sub_count), &(ps->sub_capacity), &step) < 0) {
+            return -1;
+        }
+        instr->count++;
+    }
+    _query_skip_ws(ps);
+
+    for (i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+        if (strncmp(ps->p, ops[i].op, strlen(ops[i].op)) == 0) {
+            ps->p += strlen(ops[i].op);
+            instr->cmp = ops[i].cmp;
+            _query_skip_ws(ps);
+            if (_query_parse_literal(ps, instr) < 0) {
+                return -1;
+            }
+            _query_skip_ws(ps);
+            break;
+        }
+    }
+
+    if (ps->p[0] != _T(')') || ps->p[1] != _T(']')) {
+        return -1;
+    }
+    ps->p += 2;
+
+    return 0;
+}
+
+static int _query_parse_path(_query_parser_t *ps)
+{
+    cjson_query_instr_t instr;
+
+    ps->p++; // '$'
+
+    while (*ps->p) {
+        if (ps->p[0] == _T('[') && ps->p[1] == _T('?')) {
+            ps->p++;
+            if (_query_parse_filter(ps, &instr) < 0) {
+                return -1;
+            }
+        } else if (_query_parse_step(ps, &instr, _T(".[")) < 0) {
+            return -1; // '..' included
+        }
+
+        if (_query_add(&(ps->path), &(ps->path_count), &(ps->path_capacity), &instr) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+// /a/b/0, tokens are unescaped in place
+static int _query_parse_pointer(_query_parser_t *ps)
+{
+    tchar_t *w = NULL;
+    int digits = 0;
+    cjson_query_instr_t instr;
+
+    while (*ps->p == _T('/')) {
+        ps->p++;
+
+        memset(&instr, 0, sizeof(instr));
+        instr.op = _cjson_query_child_;
+        instr.key = ps->p;
+        instr.index = 0;
+        digits = 1;
+
+        for (w = ps->p; *ps->p && *ps->p != _T('/'); ps->p++, w++) {
+            *w = *ps->p;
+            if (*ps->p == _T('~')) {
+                if (ps->p[1] != _T('0') && ps->p[1] != _T('1')) {
+                    return -1;
+                }
+                *w = (ps->p[1] == _T('0')) ? _T('~') : _T('/');
+                ps->p++;
+            }
+
+            // too large for an index, a member name only
+            if (digits && *w >= _T('0') && *w <= _T('9') && instr.index <= (INT64_MAX - (*w - _T('0'))) / 10) {
+                instr.index = instr.index * 10 + (*w - _T('0'));
+            } else {
+                digits = 0;
+            }
+        }
+
+        instr.key_len = w - instr.key;
+        // a number is an element index too, without leading zeros
+        if (!digits || instr.key_len == 0 || (instr.key_len > 1 && instr.key[0] == _T('0'))) {
+            instr.index = -1;
+        }
+
+        if (_query_add(&(ps->path), &(ps->path_count), &(ps->path_capacity), &instr) < 0) {
+            return -1;
+        }
+    }
+
+    return (*ps->p == 0 ? 0 : -1);
+}
+
+cjson_query_t* cjson_query_compile(const tchar_t *expr)
+{
+    int64_t i = 0;
+    size_t len = 0;
+    int ret = -1;
+    cjson_query_t *q = NULL;
+    _query_parser_t ps;
+
+    if (expr == NULL) {
+        return NULL;
+    }
+
+    q = (cjson_query_t*)my_malloc(sizeof(cjson_query_t));
+    if (q == NULL) {
+        return NULL;
+    }
+    memset(q, 0, sizeof(cjson_query_t));
+    memset(&ps, 0, sizeof(ps));
+
+    len = strlen(expr);
+    q->text = (tchar_t*)my_malloc((len + 1) * sizeof(tchar_t));
+    if (q->text == NULL) {
+        goto lbl_done;
+    }
+    memcpy(q->text, expr, (len + 1) * sizeof(tchar_t));
+    ps.p = q->text;
+
+    if (*ps.p == _T('$')) {
+        ret = _query_parse_path(&ps);
+    } else {
+        ret = _query_parse_pointer(&ps);
+    }
+    if (ret < 0) {
+        goto lbl_done;
+    }
+
+    // filter paths follow the path
+    ret = -1;
+    q->count = ps.path_count;
+    q->total = ps.path_count + ps.sub_count;
+    q->instrs = (cjson_query_instr_t*)my_malloc((q->total + 1) * sizeof(cjson_query_instr_t));
+    if (q->instrs == NULL) {
+        goto lbl_done;
+    }
+
+    if (ps.path_count > 0) {
+        memcpy(q->instrs, ps.path, ps.path_count * sizeof(cjson_query_instr_t));
+    }
+    if (ps.sub_count > 0) {
+        memcpy(q->instrs + ps.path_count, ps.sub, ps.sub_count * sizeof(cjson_query_instr_t));
+    }
+    for (i = 0; i < q->count; i++) {
+        if (q->instrs[i].op == _cjson_query_filter_) {
+            q->instrs[i].index += q->count;
+        }
+    }
+    ret = 0;
+
+lbl_done:
+
+    if (ps.path) {
+        my_free(ps.path);
+    }
+    if (ps.sub) {
+        my_free(ps.sub);
+    }
+
+    if (ret < 0) {
+        cjson_query_free(q);
+        return NULL;
+    }
+
+    return q;
+}
+
+void cjson_query_free(cjson_query_t *q)
+{
+    if (q == NULL) {
+        return;
+    }
+
+    if (q->instrs) {
+        my_free(q->instrs);
+    }
+    if (q->text) {
+        my_free(q->text);
+    }
+
+    my_free(q);
+}
+
+//===========================================================
+// predicates
+static int _query_compare(const cjson_query_instr_t *instr, const _query_scalar_t *v)
+{
+    int64_t n = 0;
+    int c = 0;
+
+    if (instr->cmp == _cjson_query_exists_) {
+        return 1;
+    }
+
+    if (v->type != instr->lit_type) {
+        return (instr->cmp == _cjson_query_ne_);
+    }
+
+    switch (v->type) {
+    case _cjson_value_number_:
+        c = (v->num < instr->lit_num) ? -1 : (v->num > instr->lit_num);
+        break;
+    case _cjson_value_string_:
+        n = (v->len < instr->lit_len) ? v->len : instr->lit_len;
+        c = memcmp(v->s, instr->lit_str, n * sizeof(tchar_t));
+        if (c == 0) {
+            c = (v->len < instr->lit_len) ? -1 : (v->len > instr->lit_len);
+        }
+        break;
+    case _cjson_value_bool_:
+        if (instr->cmp != _cjson_query_eq_ && instr->cmp != _cjson_query_ne_) {
+            return 0;
+        }
+        c = (!v->boolval != !instr->lit_num);
+        break;
+    case _cjson_value_null_:
+        if (instr->cmp != _cjson_query_eq_ && instr->cmp != _cjson_query_ne_) {
+            return 0;
+        }
+        break;
+    default:
+        return 0;
+    }
+
+    switch (instr->cmp) {
+    case _cjson_query_eq_:
+        return (c == 0);
+    case _cjson_query_ne_:
+        return (c != 0);
+    case _cjson_query_lt_:
+        return (c < 0);
+    case _cjson_query_le_:
+        return (c <= 0);
+    case _cjson_query_gt_:
+        return (c > 0);
+    case _cjson_query_ge_:
+        return (c >= 0);
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static const cjson_value_t* _query_member(cjson_object_t *obj, const tchar_t *key, int64_t len)
+{
+    int64_t n = 0;
+    const tchar_t *k = NULL;
+    const cjson_value_t *val = NULL;
+    position_t pos;
+
+    for (val = cjson_object_first_value(obj, &pos); val; val = cjson_object_next_value(obj, &pos)) {
+        k = cjson_object_key(obj, val, &n);
+        if (n == len && memcmp(k, key, len * sizeof(tchar_t)) == 0) {
+            return val;
+        }
+    }
+
+    return NULL;
+}
+
+static int _query_filter(const cjson_query_t *q, const cjson_query_instr_t *instr, const cjson_value_t *val)
+{
+    int64_t i = 0;
+    const cjson_query_instr_t *step = NULL;
+    _query_scalar_t v;
+
+    for (i = 0; i < instr->count && val; i++) {
+        step = &(q->instrs[instr->index + i]);
+        if (val->value_type == _cjson_value_object_ && step->key) {
+            val = _query_member(val->cjson_objval, step->key, step->key_len);
+        } else if (val->value_type == _cjson_value_array_ && step->index >= 0) {
+            val = cjson_array_get(val->cjson_arrval, step->index);
+        } else {
+            val = NULL;
+        }
+    }
+
+    if (val == NULL) {
+        return 0;
+    }
+
+    memset(&v, 0, sizeof(v));
+    v.type = (cjson_valuetype_e)val->value_type;
+    if (v.type == _cjson_value_string_) {
+        v.s = cjson_value_str(val);
+        v.len = cjson_value_strlen(val);
+    } else if (v.type == _cjson_value_number_) {
+        v.num = _query_number(val);
+    } else if (v.type == _cjson_value_bool_) {
+        v.boolval = val->cjson_boolval;
+    }
+
+    return _query_compare(instr, &v);
+}
+
+// value at the filter path, NULL if none
+static const tchar_t* _query_filter_text_at(const cjson_query_t *q, const cjson_query_instr_t *instr, const tchar_t *text)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+    int64_t ret = 0;
+    int64_t len = 0;
+    const tchar_t *key = NULL;
+    const cjson_query_instr_t *step = NULL;
+
+    for (i = 0; i < instr->count; i++) {
+        step = &(q->instrs[instr->index + i]);
+        text += cjson_scan_ws(text);
+
+        if (*text == _T('{') && step->key) {
+            text++;
+            for (;;) {
+                text += cjson_scan_ws(text);
+                ret = cjson_scan_string(text, &key, &len);
+                if (ret < 0) {
+                    return NULL;
+                }
+                text += ret;
+                text += cjson_scan_ws(text);
+                if (*text != _T(':')) {
+                    return NULL;
+                }
+                text++;
+
+                if (len == step->key_len && memcmp(key, step->key, len * sizeof(tchar_t)) == 0) {
+                    break;
+                }
+
+                ret = cjson_skip_value(text);
+                if (ret < 0) {
+                    return NULL;
+                }
+                text += ret;
+                text += cjson_scan_ws(text);
+                if (*text != _T(',')) {
+                    return NULL; // '}', not found
+                }
+                text++;
+            }
+        } else if (*text == _T('[') && step->index >= 0) {
+            text++;
+            for (n = 0; n < step->index; n++) {
+                ret = cjson_skip_value(text);
+                if (ret < 0) {
+                    return NULL;
+                }
+                text += ret;
+                text += cjson_scan_ws(text);
+                if (*text != _T(',')) {
+                    return NULL;
+                }
+                text++;
+            }
+            text += cjson_scan_ws(text);
+            if (*text == _T(']')) {
+                return NULL;
+            }
+        } else {
+            return NULL;
+        }
+    }
+
+    return text + cjson_scan_ws(text);
+}
+
+static int _query_filter_text(const cjson_query_t *q, const cjson_query_instr_t *instr, const tchar_t *text)
+{
+    cjson_value_t number;
+    _query_scalar_t v;
+
+    text = _query_filter_text_at(q, instr, text);
+    if (text == NULL) {
+        return 0;
+    }
+
+    memset(&v, 0, sizeof(v));
+    switch (*text) {
+    case _T('"'):
+        v.type = _cjson_value_string_;
+        if (cjson_scan_string(text, &(v.s), &(v.len)) < 0) {
+            return 0;
+        }
+        break;
+    case _T('{'):
+        v.type = _cjson_value_object_;
+        break;
+    case _T('['):
+        v.type = _cjson_value_array_;
+        break;
+    case _T('t'):
+    case _T('f'):
+        v.type = _cjson_value_bool_;
+        v.boolval = (*text == _T('t'));
+        break;
+    case _T('n'):
+        v.type = _cjson_value_null_;
+        break;
+    default:
+        if (cjson_scan_number(text, &number) <= 0) {
+            return 0;
+        }
+        v.type = _cjson_value_number_;
+        v.num = _query_number(&number);
+        break;
+    }
+
+    return _query_compare(instr, &v);
+}
+
+//===========================================================
+// run
+
+// queries of states going on into the child, return their count
+//   key: member key, NULL for an element; val / text: the child
+static int64_t _query_next(_query_run_t *run, const int64_t *states, int64_t n, int64_t depth,
+    const tchar_t *key, int64_t len, int64_t index, const cjson_value_t *val, const tchar_t *text, int64_t *next)
+{
+    int64_t i = 0;
+    int64_t m = 0;
+    int match = 0;
+    const cjson_query_t *q = NULL;
+    const cjson_query_instr_t *instr = NULL;
+
+    for (i = 0; i < n; i++) {
+        q = run->qs[states[i]];
+        if (depth >= q->count) {
+            continue;
+        }
+
+        instr = &(q->instrs[depth]);
+        switch (instr->op) {
+        case _cjson_query_child_:
+            if (key) {
+                match = (instr->key && instr->key_len == len && memcmp(instr->key, key, len * sizeof(tchar_t)) == 0);
+            } else {
+                match = (instr->index == index);
+            }
+            break;
+        case _cjson_query_wild_:
+            match = 1;
+            break;
+        case _cjson_query_filter_:
+            match = (val ? _query_filter(q, instr, val) : _query_filter_text(q, instr, text));
+            break;
+        default:
+            match = 0;
+            break;
+        }
+
+        if (match) {
+            next[m++] = states[i];
+        }
+    }
+
+    return m;
+}
+
+static void _query_walk(_query_run_t *run, const cjson_value_t *val, const int64_t *states, int64_t n, int64_t depth)
+{
+    int64_t i = 0;
+    int64_t m = 0;
+    int64_t len = 0;
+    int more = 0;
+    const tchar_t *key = NULL;
+    const cjson_value_t *child = NULL;
+    int64_t *next = run->states + (depth + 1) * run->count;
+    position_t pos;
+
+    for (i = 0; i < n; i++) {
+        if (depth < run->qs[states[i]]->count) {
+            more = 1;
+            continue;
+        }
+
+        run->matches++;
+        if (run->cb(run->ctx, states[i], val) != 0) {
+            run->stop = 1;
+            return;
+        }
+    }
+
+    if (!more) {
+        return;
+    }
+
+    if (val->value_type == _cjson_value_object_) {
+        for (child = cjson_object_first_value(val->cjson_objval, &pos); child; child = cjson_object_next_value(val->cjson_objval, &pos)) {
+            key = cjson_object_key(val->cjson_objval, child, &len);
+            m = _query_next(run, states, n, depth, key, len, -1, child, NULL, next);
+            if (m > 0) {
+                _query_walk(run, child, next, m, depth + 1);
+                if (run->stop) {
+                    return;
+                }
+            }
+        }
+    } else if (val->value_type == _cjson_value_array_) {
+        for (i = 0; i < val->cjson_arrval->count; i++) {
+            child = &(val->cjson_arrval->elem[i]);
+            m = _query_next(run, states, n, depth, NULL, 0, i, child, NULL, next);
+            if (m > 0) {
+                _query_walk(run, child, next, m, depth + 1);
+                if (run->stop) {
+                    return;
+                }
+            }
+        }
+    }
+}
+
+// return chars consumed, or -1 for error
+static int64_t _query_walk_text(_query_run_t *run, const tchar_t *text, const int64_t *states, int64_t n, int64_t depth)
+{
+    int64_t i = 0;
+    int64_t j = 0;
+    int64_t m = 0;
+    int64_t ret = 0;
+    int64_t len = 0;
+    int64_t index = 0;
+    int more = 0;
+    tchar_t end = 0;
+    const tchar_t *key = NULL;
+    int64_t *next = run->states + (depth + 1) * run->count;
+
+    i = cjson_scan_ws(text);
+
+    for (j = 0; j < n; j++) {
+        if (depth < run->qs[states[j]]->count) {
+            more = 1;
+            continue;
+        }
+
+        ret = cjson_skip_value(&text[i]);
+        if (ret < 0) {
+            return -1;
+        }
+
+        run->matches++;
+        if (run->text_cb(run->ctx, states[j], &text[i], ret) != 0) {
+            run->stop = 1;
+            return i + ret;
+        }
+    }
+
+    if (!more || (text[i] != _T('{') && text[i] != _T('['))) {
+        ret = cjson_skip_value(&text[i]);
+        return (ret < 0 ? -1 : i + ret);
+    }
+
+    end = (text[i] == _T('{')) ? _T('}') : _T(']');
+    i++;
+    i += cjson_scan_ws(&text[i]);
+    if (text[i] == end) {
+        return i + 1;
+    }
+
+    for (index = 0; ; index++) {
+        key = NULL;
+        if (end == _T('}')) {
+            i += cjson_scan_ws(&text[i]);
+            ret = cjson_scan_string(&text[i], &key, &len);
+            if (ret < 0) {
+                return -1;
+            }
+            i += ret;
+            i += cjson_scan_ws(&text[i]);
+            if (text[i] != _T(':')) {
+                return -1;
+            }
+            i++;
+        }
+
+        // unmatched values are skipped as a whole
+        i += cjson_scan_ws(&text[i]);
+        m = _query_next(run, states, n, depth, key, len, index, NULL, &text[i], next);
+        if (m > 0) {
+            ret = _query_walk_text(run, &text[i], next, m, depth + 1);
+            if (run->stop) {
+                return i + (ret < 0 ? 0 : ret);
+            }
+        } else {
+            ret = cjson_skip_value(&text[i]);
+        }
+        if (ret < 0) {
+            return -1;
+        }
+        i += ret;
+
+        i += cjson_scan_ws(&text[i]);
+        if (text[i] == end) {
+            return i + 1;
+        }
+        if (text[i] != _T(',')) {
+            return -1;
+        }
+        i++;
+    }
+}
+
+// the states of all depths, one slot per query each
+static int _query_run_init(_query_run_t *run, const cjson_query_t *const qs[], int64_t count)
+{
+    int64_t i = 0;
+    int64_t depth = 0;
+
+    if (qs == NULL || count <= 0) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        if (qs[i] == NULL) {
+            return -1;
+        }
+        if (qs[i]->count > depth) {
+            depth = qs[i]->count;
+        }
+    }
+
+    run->states = (int64_t*)my_malloc((depth + 2) * count * sizeof(int64_t));
+    if (run->states == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        run->states[i] = i;
+    }
+
+    run->qs = qs;
+    run->count = count;
+    run->matches = 0;
+    run->stop = 0;
+
+    return 0;
+}
+
+int64_t cjson_query_exec_many(const cjson_t *json, const cjson_query_t *const qs[], int64_t count, pfn_cjson_query_t cb, void *ctx)
+{
+    _query_run_t run;
+    cjson_value_t root_data;
+
+    if (json == NULL || json->object == NULL || cb == NULL) {
+        return -1;
+    }
+
+    memset(&run, 0, sizeof(run));
+    if (_query_run_init(&run, qs, count) < 0) {
+        return -1;
+    }
+    run.cb = cb;
+    run.ctx = ctx;
+
+    root_data.value_type = _cjson_value_object_;
+    root_data.cjson_objval = json->object;
+
+    _query_walk(&run, &root_data, run.states, count, 0);
+
+    my_free(run.states);
+
+    return run.matches;
+}
+
+int64_t cjson_query_exec_many_text(const tchar_t *json_text, const cjson_query_t *const qs[], int64_t count, pfn_cjson_query_text_t cb, void *ctx)
+{
+    int64_t ret = 0;
+    _query_run_t run;
+
+    if (json_text == NULL || cb == NULL) {
+        return -1;
+    }
+
+    memset(&run, 0, sizeof(run));
+    if (_query_run_init(&run, qs, count) < 0) {
+        return -1;
+    }
+    run.text_cb = cb;
+    run.ctx = ctx;
+
+    ret = _query_walk_text(&run, json_text, run.states, count, 0);
+
+    my_free(run.states);
+
+    return (ret < 0 ? -1 : run.matches);
+}
+
+int64_t cjson_query_exec(const cjson_t *json, const cjson_query_t *q, pfn_cjson_query_t cb, void *ctx)
+{
+    return cjson_query_exec_many(json, &q, 1, cb, ctx);
+}
+
+int64_t cjson_query_exec_text(const tchar_t *json_text, const cjson_query_t *q, pfn_cjson_query_text_t cb, void *ctx)
+{
+    return cjson_query_exec_many_text(json_text, &q, 1, cb, ctx);
+}
@@ -0,0 +1,327 @@
+/************************************************************************************
+* cjson_scanner.c: Implementation File
+*
+* cjson raw text scanner
+*
+* DESCRIPTION:
+*   token scanners working on the json text itself, without a document,
+*   shared by the decoder and the direct binding decoder.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   all scanners return the chars consumed, or -1 for error. Strings are
+*   returned as they are in the text, cjson_unescape() decodes them.
+*
+************************************************************************************/
+
+#include <cjson.h>
+
+int64_t cjson_scan_ws(const tchar_t *json_text)
+{
+    int64_t i = 0;
+
+    while (json_text[i] == _T(' ') || json_text[i] == _T('\t') || json_text[i] == _T('\n') || json_text[i] == _T('\r')) {
+        i++;
+    }
+
+    return i;
+}
+
+// json_text starts with '"', s & len are the chars between the quotes
+int64_t cjson_scan_string(const tchar_t *json_text, const tchar_t **s, int64_t *len)
+{
+    int64_t i = 1;
+
+    if (json_text[0] != _T('"')) {
+        return -1;
+    }
+
+    for (;;) {
+        i += strcspn(&json_text[i], _T("\\\""));
+        if (json_text[i] == 0) { // no closing '"'
+            return -1;
+        }
+
+        if (json_text[i] == _T('"')) {
+            break;
+        }
+
+        // '\' & the escaped char
+        if (json_text[i + 1] == 0) {
+            return -1;
+        }
+        i += 2;
+    }
+
+    if (s) {
+        *s = json_text + 1;
+    }
+    if (len) {
+        *len = i - 1;
+    }
+
+    return i + 1;
+}
+
+// exponents beyond this saturate, the value is 0 or out of range anyway
+#define _scan_exponent_max_         1000000
+
+static int _scan_hex4(const tchar_t *s, uint32_t *cp)
+{
+    int i = 0;
+
+    *cp = 0;
+    for (i = 0; i < 4; i++) {
+        if (s[i] >= _T('0') && s[i] <= _T('9')) {
+            *cp = (*cp << 4) | (uint32_t)(s[i] - _T('0'));
+        } else if ((s[i] | 0x20) >= _T('a') && (s[i] | 0x20) <= _T('f')) {
+            *cp = (*cp << 4) | (uint32_t)((s[i] | 0x20) - _T('a') + 10);
+        } else {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int64_t cjson_unescape(const tchar_t *s, int64_t len, tchar_t *buf, int64_t buflen)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+    uint32_t cp = 0;
+    uint32_t lo = 0;
+    tchar_t u[4];
+    int ulen = 0;
+
+    while (i < len) {
+        if (s[i] != _T('\\')) {
+            if (n >= buflen) {
+                return -1;
+            }
+            buf[n++] = s[i++];
+            continue;
+        }
+
+        if (i + 1 >= len) {
+            return -1;
+        }
+        switch (s[i + 1]) {
+        case _T('"'): u[0] = _T('"'); ulen = 1; break;
+        case _T('\\'): u[0] = _T('\\'); ulen = 1; break;
+        case _T('/'): u[0] = _T('/'); ulen = 1; break;
+        case _T('b'): u[0] = _T('\b'); ulen = 1; break;
+        case _T('f'): u[0] = _T('\f'); ulen = 1; break;
+        case _T('n'): u[0] = _T('\n'); ulen = 1; break;
+        case _T('r'): u[0] = _T('\r'); ulen = 1; break;
+        case _T('t'): u[0] = _T('\t'); ulen = 1; break;
+        case _T('u'):
+            if (i + 6 > len || _scan_hex4(&s[i + 2], &cp) < 0) {
+                return -1;
+            }
+            // a surrogate pair is one code point
+            if (cp >= 0xd800 && cp <= 0xdbff) {
+                if (i + 12 > len || s[i + 6] != _T('\\') || s[i + 7] != _T('u')
+                    || _scan_hex4(&s[i + 8], &lo) < 0 || lo < 0xdc00 || lo > 0xdfff) {
+                    return -1;
+                }
+                cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                i += 6;
+            } else if (cp >= 0xdc00 && cp <= 0xdfff) {
+                return -1;
+            }
+
+            if (cp < 0x80) {
+                u[0] = (tchar_t)cp;
+                ulen = 1;
+            } else if (cp < 0x800) {
+                u[0] = (tchar_t)(0xc0 | (cp >> 6));
+                u[1] = (tchar_t)(0x80 | (cp & 0x3f));
+                ulen = 2;
+            } else if (cp < 0x10000) {
+                u[0] = (tchar_t)(0xe0 | (cp >> 12));
+                u[1] = (tchar_t)(0x80 | ((cp >> 6) & 0x3f));
+                u[2] = (tchar_t)(0x80 | (cp & 0x3f));
+                ulen = 3;
+            } else {
+                u[0] = (tchar_t)(0xf0 | (cp >> 18));
+                u[1] = (tchar_t)(0x80 | ((cp >> 12) & 0x3f));
+                u[2] = (tchar_t)(0x80 | ((cp >> 6) & 0x3f));
+                u[3] = (tchar_t)(0x80 | (cp & 0x3f));
+                ulen = 4;
+            }
+            i += 4;
+            break;
+        default:
+            return -1;
+        }
+        i += 2;
+
+        if (n + ulen > buflen) {
+            return -1;
+        }
+        memcpy(&buf[n], u, ulen * sizeof(tchar_t));
+        n += ulen;
+    }
+
+    return n;
+}
+
+// number = mantissa * 10^exp10, the mantissa keeps the leading digits that
+// fit int64, an int64 & a scale up to CJSON_NUMBER_SCALE_MAX must hold it
+int64_t cjson_scan_number(const tchar_t *json_text, cjson_value_t *out_data)
+{
+    int64_t i = 0;
+    uint64_t number = 0;
+    uint64_t limit = INT64_MAX;
+    uint64_t digit = 0;
+    int64_t exp10 = 0;
+    int64_t exponent = 0;
+    int64_t scale = 0;
+    int fraction = 0;
+    int full = 0;
+    int sign = 1;
+    int exponent_sign = 1;
+
+    if (json_text[i] == _T('-')) {
+        sign = -1;
+        limit = (uint64_t)INT64_MAX + 1;
+        i++;
+    } else if (json_text[i] == _T('+')) {
+        i++;
+    }
+
+    while (json_text[i]) {
+        if (json_text[i] >= _T('0') && json_text[i] <= _T('9')) {
+            digit = (uint64_t)(json_text[i] - '0');
+            if (!full && number <= (limit - digit) / 10) {
+                number = number * 10 + digit;
+                exp10 -= fraction;
+            } else if (fraction) {
+                full = 1; // dropped, past the precision
+            } else if (digit == 0) {
+                full = 1;
+                exp10++;
+            } else { // does not fit int64
+                return -1;
+            }
+        } else if (json_text[i] == _T('.')) {
+            fraction = 1;
+        } else { // maybe json_text[i] == _T('e') || json_text[i] == _T('E')
+            break;
+        }
+
+        i++;
+    }
+
+    // scientific notation
+    if (json_text[i] == _T('e') || json_text[i] == _T('E')) {
+        i++; // skip 'e'
+        if (json_text[i] == _T('-')) {
+            exponent_sign = -1;
+            i++;
+        } else if (json_text[i] == _T('+')) {
+            i++;
+        }
+
+        // e-5 : 10^-5
+        while (json_text[i] >= _T('0') && json_text[i] <= _T('9')) {
+            if (exponent < _scan_exponent_max_) {
+                exponent = exponent * 10 + (json_text[i] - '0');
+            }
+            i++;
+        }
+
+        exp10 += exponent * exponent_sign;
+    }
+
+    if (exp10 > 0) {
+        for (; exp10 > 0 && number; exp10--) {
+            if (number > limit / 10) { // does not fit int64
+                return -1;
+            }
+            number *= 10;
+        }
+    } else {
+        // out of scale, drop the least significant digits
+        for (scale = -exp10; scale > CJSON_NUMBER_SCALE_MAX; scale--) {
+            if (number == 0) {
+                scale = CJSON_NUMBER_SCALE_MAX;
+                break;
+            }
+            number /= 10;
+        }
+    }
+
+    out_data->value_type = _cjson_value_number_;
+    out_data->cjson_numval = (sign < 0) ? (int64_t)(0 - number) : (int64_t)number;
+    out_data->cjson_numscale = (unsigned char)scale;
+    return i;
+}
+// skip one value of any type, nested containers included
+int64_t cjson_skip_value(const tchar_t *json_text)
+{
+    int64_t i = 0;
+    int64_t ret = 0;
+    int64_t depth = 0;
+    cjson_value_t number;
+
+    for (;;) {
+        i += cjson_scan_ws(&json_text[i]);
+
+        switch (json_text[i]) {
+        case _T('"'):
+            ret = cjson_scan_string(&json_text[i], NULL, NULL);
+            break;
+        case _T('{'):
+        case _T('['):
+            depth++;
+            i++;
+            continue;
+        case _T('}'):
+        case _T(']'):
+            if (depth == 0) {
+                return -1;
+            }
+            depth--;
+            ret = 1;
+            break;
+        case _T(','):
+        case _T(':'):
+            if (depth == 0) {
+                return -1;
+            }
+            i++;
+            continue;
+        case _T('t'):
+            ret = (strncmp(&json_text[i], _T("true"), 4) == 0) ? 4 : -1;
+            break;
+        case _T('f'):
+            ret = (strncmp(&json_text[i], _T("false"), 5) == 0) ? 5 : -1;
+            break;
+        case _T('n'):
+            ret = (strncmp(&json_text[i], _T("null"), 4) == 0) ? 4 : -1;
+            break;
+        case _T('-'):
+        case _T('+'):
+        case _T('0'): case _T('1'): case _T('2'): case _T('3'): case _T('4'):
+        case _T('5'): case _T('6'): case _T('7'): case _T('8'): case _T('9'):
+            ret = cjson_scan_number(&json_text[i], &number);
+            break;
+        default:
+            return -1;
+        }
+
+        if (ret <= 0) {
+            return -1;
+        }
+        i += ret;
+
+        if (depth == 0) {
+            return i;
+        }
+    }
+}
@@ -0,0 +1,592 @@
+/************************************************************************************
+* cjson_schema.c: Implementation File
+*
+* cjson schema
+*
+* DESCRIPTION:
+*   compile a JSON Schema subset into flat validation nodes, checked by
+*   the decoder while it parses, see cjson_decode_opt_t.schema.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   strings are compared as they are in the text, escapes not decoded,
+*   lengths count characters, an escape sequence counts as one.
+*
+************************************************************************************/
+
+#include <cjson.h>
+
+#define _schema_type_bit(t)             (1u << (t))
+
+static int _schema_grow(void **items, int64_t *capacity, int64_t count, size_t item_size)
+{
+    int64_t n = 0;
+    void *p = NULL;
+
+    if (count < *capacity) {
+        return 0;
+    }
+
+    n = (*capacity == 0) ? 8 : *capacity * 2;
+    p = my_realloc(*items, n * item_size);
+    if (p == NULL) {
+        return -1;
+    }
+
+    *items = p;
+    *capacity = n;
+
+    return 0;
+}
+
+static int64_t _schema_new_node(cjson_schema_t *s)
+{
+    cjson_schema_node_t *node = NULL;
+
+    if (_schema_grow((void**)&(s->nodes), &(s->node_capacity), s->node_count, sizeof(cjson_schema_node_t)) < 0) {
+        return -1;
+    }
+
+    node = &(s->nodes[s->node_count]);
+    memset(node, 0, sizeof(cjson_schema_node_t));
+    node->min_len = -1;
+    node->max_len = -1;
+    node->items = -1;
+
+    return s->node_count++;
+}
+
+static int _schema_add_prop(cjson_schema_t *s, const tchar_t *name, int64_t len, int64_t node)
+{
+    if (_schema_grow((void**)&(s->props), &(s->prop_capacity), s->prop_count, sizeof(cjson_schema_prop_t)) < 0) {
+        return -1;
+    }
+
+    if (cjson_key_set(&(s->props[s->prop_count].name), name, len) < 0) {
+        return -1;
+    }
+    s->props[s->prop_count].node = node;
+    s->prop_count++;
+
+    return 0;
+}
+
+static long double _schema_number(const cjson_value_t *val)
+{
+    long double n = (long double)val->cjson_numval;
+    int i = 0;
+
+    for (i = 0; i < val->cjson_numscale; i++) {
+        n /= 10.0L;
+    }
+
+    return n;
+}
+
+// type name => type bit
+static uint32_t _schema_type(const tchar_t *name, int64_t len, uint32_t *flags)
+{
+    static const struct {
+        const tchar_t       *name;
+        cjson_valuetype_e   type;
+    } names[] = {
+        { _T("null"),       _cjson_value_null_ },
+        { _T("boolean"),    _cjson_value_bool_ },
+        { _T("object"),     _cjson_value_object_ },
+        { _T("array"),      _cjson_value_array_ },
+        { _T("number"),     _cjson_value_number_ },
+        { _T("string"),     _cjson_value_string_ },
+        { _T("integer"),    _cjson_value_number_ },
+    };
+    size_t i = 0;
+
+    for (i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if ((int64_t)strlen(names[i].name) == len && memcmp(names[i].name, name, len * sizeof(tchar_t)) == 0) {
+            if (i == sizeof(names) / sizeof(names[0]) - 1) {
+                *flags |= _cjson_schema_integer_;
+            }
+            return _schema_type_bit(names[i].type);
+        }
+    }
+
+    return 0;
+}
+
+static int _schema_compile_types(cjson_schema_node_t *node, const cjson_value_t *val)
+{
+    int64_t i = 0;
+    int number = 0;
+    uint32_t bit = 0;
+    const cjson_value_t *v = val;
+    int64_t n = 1;
+
+    if (val->value_type == _cjson_value_array_) {
+        v = val->cjson_arrval->elem;
+        n = val->cjson_arrval->count;
+    }
+
+    for (i = 0; i < n; i++, v++) {
+        if (v->value_type != _cjson_value_string_) {
+            return -1;
+        }
+
+        bit = _schema_type(cjson_value_str(v), cjson_value_strlen(v), &(node->flags));
+        if (bit == 0) {
+            return -1;
+        }
+
+        // "number" takes any number, even with "integer"
+        if (bit == _schema_type_bit(_cjson_value_number_) && strcmp(cjson_value_str(v), _T("number")) == 0) {
+            number = 1;
+        }
+        node->types |= bit;
+    }
+
+    if (number) {
+        node->flags &= ~_cjson_schema_integer_;
+    }
+
+    return 0;
+}
+
+static int _schema_compile_enum(cjson_schema_t *s, int64_t idx, const cjson_value_t *val)
+{
+    int64_t i = 0;
+    cjson_value_t *e = NULL;
+    const cjson_value_t *v = NULL;
+
+    if (val->value_type != _cjson_value_array_) {
+        return -1;
+    }
+
+    s->nodes[idx].enum_first = s->enum_count;
+
+    for (i = 0; i < val->cjson_arrval->count; i++) {
+        v = &(val->cjson_arrval->elem[i]);
+        if (v->value_type == _cjson_value_array_ || v->value_type == _cjson_value_object_) {
+            return -1; // scalars only
+        }
+
+        if (_schema_grow((void**)&(s->enums), &(s->enum_capacity), s->enum_count, sizeof(cjson_value_t)) < 0) {
+            return -1;
+        }
+
+        e = &(s->enums[s->enum_count]);
+        *e = *v;
+        if (v->value_type == _cjson_value_string_ && cjson_value_set_string(e, cjson_value_str(v), cjson_value_strlen(v)) < 0) {
+            return -1;
+        }
+        s->enum_count++;
+        s->nodes[idx].enum_count++;
+    }
+
+    return 0;
+}
+
+static int64_t _schema_compile_node(cjson_schema_t *s, const cjson_object_t *obj);
+
+// properties & required, the props of a node are kept together
+static int _schema_compile_props(cjson_schema_t *s, int64_t idx, const cjson_value_t *props, const cjson_value_t *required)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+    int64_t len = 0;
+    int64_t index = 0;
+    int64_t *nodes = NULL;
+    const tchar_t *key = NULL;
+    const cjson_value_t *v = NULL;
+    position_t pos;
+    int ret = -1;
+
+    if (props) {
+        if (props->value_type != _cjson_value_object_) {
+            return -1;
+        }
+
+        n = props->cjson_objval->count;
+        nodes = (int64_t*)my_malloc((n + 1) * sizeof(int64_t));
+        if (nodes == NULL) {
+            return -1;
+        }
+
+        // sub schemas first, they add props of their own
+        for (i = 0, v = cjson_object_first_value(props->cjson_objval, &pos); v; i++, v = cjson_object_next_value(props->cjson_objval, &pos)) {
+            if (v->value_type != _cjson_value_object_) {
+                goto lbl_done;
+            }
+            nodes[i] = _schema_compile_node(s, v->cjson_objval);
+            if (nodes[i] < 0) {
+                goto lbl_done;
+            }
+        }
+    }
+
+    s->nodes[idx].prop_first = s->prop_count;
+
+    for (i = 0, v = (props ? cjson_object_first_value(props->cjson_objval, &pos) : NULL); v; i++, v = cjson_object_next_value(props->cjson_objval, &pos)) {
+        key = cjson_object_key(props->cjson_objval, v, &len);
+        if (_schema_add_prop(s, key, len, nodes[i]) < 0) {
+            goto lbl_done;
+        }
+        s->nodes[idx].prop_count++;
+    }
+
+    if (required) {
+        if (required->value_type != _cjson_value_array_) {
+            goto lbl_done;
+        }
+
+        for (i = 0; i < required->cjson_arrval->count; i++) {
+            v = &(required->cjson_arrval->elem[i]);
+            if (v->value_type != _cjson_value_string_) {
+                goto lbl_done;
+            }
+
+            // required, but without a sub schema
+            if (cjson_schema_property(s, &(s->nodes[idx]), cjson_value_str(v), cjson_value_strlen(v), &index) == NULL && index < 0) {
+                if (_schema_add_prop(s, cjson_value_str(v), cjson_value_strlen(v), -1) < 0) {
+                    goto lbl_done;
+                }
+                index = s->nodes[idx].prop_count++;
+            }
+
+            if (index >= CJSON_SCHEMA_REQUIRED_MAX) {
+                goto lbl_done;
+            }
+            s->nodes[idx].required |= (1ULL << index);
+        }
+    }
+
+    ret = 0;
+
+lbl_done:
+
+    if (nodes) {
+        my_free(nodes);
+    }
+
+    return ret;
+}
+
+// schema object => node, return its index, -1 for error
+static int64_t _schema_compile_node(cjson_schema_t *s, const cjson_object_t *obj)
+{
+    int64_t idx = 0;
+    int64_t len = 0;
+    int64_t items = 0;
+    const tchar_t *key = NULL;
+    const cjson_value_t *v = NULL;
+    const cjson_value_t *props = NULL;
+    const cjson_value_t *required = NULL;
+    cjson_schema_node_t *node = NULL;
+    position_t pos;
+
+    idx = _schema_new_node(s);
+    if (idx < 0) {
+        return -1;
+    }
+
+    for (v = cjson_object_first_value((cjson_object_t*)obj, &pos); v; v = cjson_object_next_value((cjson_object_t*)obj, &pos)) {
+        key = cjson_object_key(obj, v, &len);
+        node = &(s->nodes[idx]); // nodes move as sub schemas are added
+
+#define _keyword_is(name)   (len == (int64_t)(sizeof(name) / sizeof(tchar_t) - 1) && memcmp(key, (name), len * sizeof(tchar_t)) == 0)
+        if (_keyword_is(_T("type"))) {
+            if (_schema_compile_types(node, v) < 0) {
+                return -1;
+            }
+        } else if (_keyword_is(_T("enum"))) {
+            if (_schema_compile_enum(s, idx, v) < 0) {
+                return -1;
+            }
+        } else if (_keyword_is(_T("properties"))) {
+            props = v;
+        } else if (_keyword_is(_T("required"))) {
+            required = v;
+        } else if (_keyword_is(_T("items"))) {
+            if (v->value_type != _cjson_value_object_) {
+                return -1;
+            }
+            items = _schema_compile_node(s, v->cjson_objval);
+            if (items < 0) {
+                return -1;
+            }
+            s->nodes[idx].items = items;
+        } else if (v->value_type == _cjson_value_number_) {
+            if (_keyword_is(_T("minimum"))) {
+                node->minimum = _schema_number(v);
+                node->flags |= _cjson_schema_minimum_;
+            } else if (_keyword_is(_T("maximum"))) {
+                node->maximum = _schema_number(v);
+                node->flags |= _cjson_schema_maximum_;
+            } else if (_keyword_is(_T("exclusiveMinimum"))) {
+                node->minimum = _schema_number(v);
+                node->flags |= _cjson_schema_minimum_ | _cjson_schema_exclusive_min_;
+            } else if (_keyword_is(_T("exclusiveMaximum"))) {
+                node->maximum = _schema_number(v);
+                node->flags |= _cjson_schema_maximum_ | _cjson_schema_exclusive_max_;
+            } else if (_keyword_is(_T("minLength")) || _keyword_is(_T("minItems"))) {
+                node->min_len = (int64_t)_schema_number(v);
+            } else if (_keyword_is(_T("maxLength")) || _keyword_is(_T("maxItems"))) {
+                node->max_len = (int64_t)_schema_number(v);
+            }
+        }
+#undef _keyword_is
+    }
+
+    if ((props || required) && _schema_compile_props(s, idx, props, required) < 0) {
+        return -1;
+    }
+
+    return idx;
+}
+
+cjson_schema_t* cjson_schema_compile(const cjson_t *schema_doc)
+{
+    cjson_schema_t *s = NULL;
+
+    if (schema_doc == NULL || schema_doc->object == NULL) {
+        return NULL;
+    }
+
+    s = (cjson_schema_t*)my_malloc(sizeof(cjson_schema_t));
+    if (s == NULL) {
+        return NULL;
+    }
+    memset(s, 0, sizeof(cjson_schema_t));
+
+    if (_schema_compile_node(s, schema_doc->object) != 0) {
+        cjson_schema_free(s);
+        return NULL;
+    }
+
+    return s;
+}
+
+void cjson_schema_free(cjson_schema_t *schema)
+{
+    int64_t i = 0;
+
+    if (schema == NULL) {
+        return;
+    }
+
+    for (i = 0; i < schema->prop_count; i++) {
+        cjson_key_free(&(schema->props[i].name));
+    }
+
+    for (i = 0; i < schema->enum_count; i++) {
+        cjson_value_free(&(schema->enums[i]));
+    }
+
+    if (schema->nodes) {
+        my_free(schema->nodes);
+    }
+    if (schema->props) {
+        my_free(schema->props);
+    }
+    if (schema->enums) {
+        my_free(schema->enums);
+    }
+
+    my_free(schema);
+}
+
+//===========================================================
+// checks, a NULL node accepts anything
+const cjson_schema_node_t* cjson_schema_property(const cjson_schema_t *schema, const cjson_schema_node_t *node, const tchar_t *key, int64_t len, int64_t *index)
+{
+    int64_t i = 0;
+    const cjson_schema_prop_t *prop = NULL;
+
+    *index = -1;
+
+    if (node == NULL) {
+        return NULL;
+    }
+
+    prop = &(schema->props[node->prop_first]);
+    for (i = 0; i < node->prop_count; i++, prop++) {
+        if (cjson_key_len(&(prop->name)) == len && memcmp(cjson_key_str(&(prop->name)), key, len * sizeof(tchar_t)) == 0) {
+            *index = i;
+            return (prop->node < 0 ? NULL : &(schema->nodes[prop->node]));
+        }
+    }
+
+    return NULL;
+}
+
+const cjson_schema_node_t* cjson_schema_items(const cjson_schema_t *schema, const cjson_schema_node_t *node)
+{
+    if (node == NULL || node->items < 0) {
+        return NULL;
+    }
+
+    return &(schema->nodes[node->items]);
+}
+
+int cjson_schema_check_type(const cjson_schema_node_t *node, cjson_valuetype_e type)
+{
+    if (node == NULL || node->types == 0) {
+        return 0;
+    }
+
+    return ((node->types & _schema_type_bit(type)) ? 0 : -1);
+}
+
+// chars of a string as in the text, an escape counts as one, utf-8 by code point
+static int64_t _schema_strlen(const tchar_t *s, int64_t len)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+
+    while (i < len) {
+        if (s[i] == _T('\\')) {
+            i += (s[i + 1] == _T('u')) ? 6 : 2;
+        } else {
+            i++;
+            while (i < len && ((unsigned char)s[i] & 0xc0) == 0x80) {
+                i++;
+            }
+        }
+        n++;
+    }
+
+    return n;
+}
+
+// number with trailing zeros of the fraction dropped
+static void _schema_number_normalize(const cjson_value_t *val, int64_t *n, int *scale)
+{
+    *n = val->cjson_numval;
+    *scale = val->cjson_numscale;
+
+    while (*scale > 0 && *n % 10 == 0) {
+        *n /= 10;
+        (*scale)--;
+    }
+}
+
+static int _schema_value_equal(const cjson_value_t *a, const cjson_value_t *b)
+{
+    int64_t an = 0;
+    int64_t bn = 0;
+    int as = 0;
+    int bs = 0;
+
+    if (a->value_type != b->value_type) {
+        return 0;
+    }
+
+    switch (a->value_type) {
+    case _cjson_value_null_:
+        return 1;
+    case _cjson_value_bool_:
+        return (!a->cjson_boolval == !b->cjson_boolval);
+    case _cjson_value_number_:
+        _schema_number_normalize(a, &an, &as);
+        _schema_number_normalize(b, &bn, &bs);
+        return (an == bn && as == bs);
+    case _cjson_value_string_:
+        return (cjson_value_strlen(a) == cjson_value_strlen(b)
+            && memcmp(cjson_value_str(a), cjson_value_str(b), cjson_value_strlen(a) * sizeof(tchar_t)) == 0);
+    default:
+        break;
+    }
+
+    return 0;
+}
+
+static int _schema_check_number(const cjson_schema_node_t *node, const cjson_value_t *val)
+{
+    int64_t n = 0;
+    int scale = 0;
+    long double d = 0;
+
+    if (node->flags & _cjson_schema_integer_) {
+        _schema_number_normalize(val, &n, &scale);
+        if (scale > 0) {
+            return -1;
+        }
+    }
+
+    if ((node->flags & (_cjson_schema_minimum_ | _cjson_schema_maximum_)) == 0) {
+        return 0;
+    }
+
+    d = _schema_number(val);
+
+    if (node->flags & _cjson_schema_minimum_) {
+        if (d < node->minimum || ((node->flags & _cjson_schema_exclusive_min_) && d == node->minimum)) {
+            return -1;
+        }
+    }
+
+    if (node->flags & _cjson_schema_maximum_) {
+        if (d > node->maximum || ((node->flags & _cjson_schema_exclusive_max_) && d == node->maximum)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+int cjson_schema_check_value(const cjson_schema_t *schema, const cjson_schema_node_t *node, const cjson_value_t *val)
+{
+    int64_t i = 0;
+    int64_t len = -1;
+
+    if (node == NULL) {
+        return 0;
+    }
+
+    if (cjson_schema_check_type(node, (cjson_valuetype_e)val->value_type) < 0) {
+        return -1;
+    }
+
+    switch (val->value_type) {
+    case _cjson_value_number_:
+        if (_schema_check_number(node, val) < 0) {
+            return -1;
+        }
+        break;
+    case _cjson_value_string_:
+        if (node->min_len >= 0 || node->max_len >= 0) {
+            len = _schema_strlen(cjson_value_str(val), cjson_value_strlen(val));
+        }
+        break;
+    case _cjson_value_array_:
+        len = val->cjson_arrval->count;
+        break;
+    default:
+        break;
+    }
+
+    if (len >= 0 && ((node->min_len >= 0 && len < node->min_len) || (node->max_len >= 0 && len > node->max_len))) {
+        return -1;
+    }
+
+    if (node->enum_count > 0) {
+        for (i = 0; i < node->enum_count; i++) {
+            if (_schema_value_equal(&(schema->enums[node->enum_first + i]), val)) {
+                return 0;
+            }
+        }
+        return -1;
+    }
+
+    return 0;
+}
+
+int cjson_schema_check_required(const cjson_schema_node_t *node, uint64_t seen)
+{
+    if (node == NULL) {
+        return 0;
+    }
+
+    return ((node->required & ~seen) == 0 ? 0 : -1);
+}
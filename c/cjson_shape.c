@@ -0,0 +1,203 @@
+/************************************************************************************
+* cjson_shape.c: Implementation File
+*
+* cjson object shape cache
+*
+* DESCRIPTION:
+*   interns the ordered key lists of decoded objects. Records sharing a
+*   layout keep one shape pointer and their values only, instead of a copy
+*   of every key.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   the cache owns its shapes, objects pointing to them must be freed
+*   before the cache.
+*
+************************************************************************************/
+
+#include <cjson.h>
+#include <murmurhash.h>
+
+#define _shape_hash_seed_               0x9747b28c
+#define _shape_init_buckets_            64
+
+// hash of the key sequence
+static uint32_t _shape_hash(const cjson_objkey_t *keys, int64_t count)
+{
+    int64_t i = 0;
+    uint32_t h = _shape_hash_seed_;
+
+    for (i = 0; i < count; i++) {
+        h = murmurhash3_32(cjson_key_str(&keys[i]), cjson_key_len(&keys[i]) * sizeof(tchar_t), h);
+    }
+
+    return h;
+}
+
+#define _shape_hint_slot(key, len)      (murmurhash3_32((key), (len) * sizeof(tchar_t), _shape_hash_seed_) & (CJSON_SHAPE_HINT_SLOTS - 1))
+
+static int _shape_equal(const cjson_shape_t *shape, const cjson_objkey_t *keys, int64_t count)
+{
+    int64_t i = 0;
+    int64_t len = 0;
+
+    if (shape->count != count) {
+        return 0;
+    }
+
+    for (i = 0; i < count; i++) {
+        len = cjson_key_len(&keys[i]);
+        if (cjson_key_len(&(shape->keys[i])) != len
+            || memcmp(cjson_key_str(&(shape->keys[i])), cjson_key_str(&keys[i]), len * sizeof(tchar_t)) != 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void _shape_free(cjson_shape_t *shape)
+{
+    int64_t i = 0;
+
+    for (i = 0; i < shape->count; i++) {
+        cjson_key_free(&(shape->keys[i]));
+    }
+
+    my_free(shape);
+}
+
+static int _shape_cache_rehash(cjson_shape_cache_t *cache)
+{
+    int64_t i = 0;
+    int64_t n = cache->bucket_count * 2;
+    cjson_shape_t **buckets = NULL;
+    cjson_shape_t *shape = NULL;
+    cjson_shape_t *next = NULL;
+
+    buckets = (cjson_shape_t**)my_malloc(n * sizeof(cjson_shape_t*));
+    if (buckets == NULL) {
+        return -1;
+    }
+    memset(buckets, 0, n * sizeof(cjson_shape_t*));
+
+    for (i = 0; i < cache->bucket_count; i++) {
+        for (shape = cache->buckets[i]; shape; shape = next) {
+            next = shape->next;
+            shape->next = buckets[shape->hash & (n - 1)];
+            buckets[shape->hash & (n - 1)] = shape;
+        }
+    }
+
+    my_free(cache->buckets);
+    cache->buckets = buckets;
+    cache->bucket_count = n;
+
+    return 0;
+}
+
+cjson_shape_cache_t* cjson_shape_cache_create(void)
+{
+    cjson_shape_cache_t *cache = NULL;
+
+    cache = (cjson_shape_cache_t*)my_malloc(sizeof(cjson_shape_cache_t));
+    if (cache == NULL) {
+        return NULL;
+    }
+    memset(cache, 0, sizeof(cjson_shape_cache_t));
+
+    cache->buckets = (cjson_shape_t**)my_malloc(_shape_init_buckets_ * sizeof(cjson_shape_t*));
+    if (cache->buckets == NULL) {
+        my_free(cache);
+        return NULL;
+    }
+    memset(cache->buckets, 0, _shape_init_buckets_ * sizeof(cjson_shape_t*));
+    cache->bucket_count = _shape_init_buckets_;
+
+    return cache;
+}
+
+void cjson_shape_cache_free(cjson_shape_cache_t *cache)
+{
+    int64_t i = 0;
+    cjson_shape_t *shape = NULL;
+    cjson_shape_t *next = NULL;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    for (i = 0; i < cache->bucket_count; i++) {
+        for (shape = cache->buckets[i]; shape; shape = next) {
+            next = shape->next;
+            _shape_free(shape);
+        }
+    }
+
+    my_free(cache->buckets);
+    my_free(cache);
+}
+
+const cjson_shape_t* cjson_shape_cache_intern(cjson_shape_cache_t *cache, const cjson_objkey_t *keys, int64_t count)
+{
+    int64_t i = 0;
+    uint32_t hash = 0;
+    cjson_shape_t *shape = NULL;
+
+    if (count <= 0 || count > CJSON_SHAPE_KEYS_MAX) {
+        return NULL;
+    }
+
+    hash = _shape_hash(keys, count);
+    for (shape = cache->buckets[hash & (cache->bucket_count - 1)]; shape; shape = shape->next) {
+        if (shape->hash == hash && _shape_equal(shape, keys, count)) {
+            goto lbl_done;
+        }
+    }
+
+    if (cache->count >= CJSON_SHAPE_CACHE_MAX) {
+        return NULL;
+    }
+
+    if (cache->count >= cache->bucket_count && _shape_cache_rehash(cache) < 0) {
+        return NULL;
+    }
+
+    // the key list & the key hashes follow the shape
+    shape = (cjson_shape_t*)my_malloc(sizeof(cjson_shape_t) + count * (sizeof(cjson_objkey_t) + sizeof(uint32_t)));
+    if (shape == NULL) {
+        return NULL;
+    }
+    shape->keys = (cjson_objkey_t*)(shape + 1);
+    shape->key_hashes = (uint32_t*)(shape->keys + count);
+    shape->count = 0;
+    shape->hash = hash;
+
+    for (i = 0; i < count; i++) {
+        if (cjson_key_set(&(shape->keys[i]), cjson_key_str(&keys[i]), cjson_key_len(&keys[i])) < 0) {
+            _shape_free(shape);
+            return NULL;
+        }
+        shape->key_hashes[i] = murmurhash3_32(cjson_key_str(&keys[i]), cjson_key_len(&keys[i]) * sizeof(tchar_t), CJSON_KEY_HASH_SEED);
+        shape->count++;
+    }
+
+    shape->next = cache->buckets[hash & (cache->bucket_count - 1)];
+    cache->buckets[hash & (cache->bucket_count - 1)] = shape;
+    cache->count++;
+
+lbl_done:
+
+    cache->hints[_shape_hint_slot(cjson_key_str(&keys[0]), cjson_key_len(&keys[0]))] = shape;
+
+    return shape;
+}
+
+const cjson_shape_t* cjson_shape_cache_hint(const cjson_shape_cache_t *cache, const tchar_t *key, int64_t len)
+{
+    return cache->hints[_shape_hint_slot(key, len)];
+}
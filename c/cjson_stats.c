@@ -0,0 +1,206 @@
+/************************************************************************************
+* cjson_stats.c: Implementation File
+*
+* cjson decode profile
+*
+* DESCRIPTION:
+*   the counters of CJSON_PROFILE builds: calls, bytes & cycles of every
+*   decoder token handler, allocations and the nesting depth of containers.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   every thread counts into its own block without atomics. The blocks
+*   are kept after their thread exits, a snapshot adds all of them up, and
+*   is approximate while other threads are decoding.
+*
+************************************************************************************/
+
+#include <cjson.h>
+#include <pthread.h>
+
+static const tchar_t *_stats_handler_names[CJSON_STATS_HANDLERS] = {
+    _T("string"), _T("escape"), _T("array"), _T("array_done"), _T("object"), _T("object_done"),
+    _T("item_done"), _T("colon_done"), _T("number"), _T("bool"), _T("null"),
+};
+
+#if defined(CJSON_PROFILE)
+struct __stats_block_t {
+    cjson_stats_t           stats;
+    struct __stats_block_t  *next;
+};
+typedef struct __stats_block_t          _stats_block_t;
+
+static __thread _stats_block_t *_stats_local = NULL;
+static _stats_block_t *_stats_blocks = NULL;
+static pthread_mutex_t _stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+cjson_stats_t* cjson_stats_local(void)
+{
+    _stats_block_t *block = _stats_local;
+
+    if (block) {
+        return &(block->stats);
+    }
+
+    // counted nowhere if out of memory
+    block = (_stats_block_t*)my_malloc(sizeof(_stats_block_t));
+    if (block == NULL) {
+        static __thread cjson_stats_t lost;
+        return &lost;
+    }
+    memset(block, 0, sizeof(_stats_block_t));
+
+    pthread_mutex_lock(&_stats_lock);
+    block->next = _stats_blocks;
+    _stats_blocks = block;
+    pthread_mutex_unlock(&_stats_lock);
+
+    _stats_local = block;
+
+    return &(block->stats);
+}
+
+int cjson_stats_snapshot(cjson_stats_t *stats)
+{
+    int i = 0;
+    _stats_block_t *block = NULL;
+
+    memset(stats, 0, sizeof(cjson_stats_t));
+
+    pthread_mutex_lock(&_stats_lock);
+    for (block = _stats_blocks; block; block = block->next) {
+        for (i = 0; i < CJSON_STATS_HANDLERS; i++) {
+            stats->handlers[i].calls += block->stats.handlers[i].calls;
+            stats->handlers[i].bytes += block->stats.handlers[i].bytes;
+            stats->handlers[i].cycles += block->stats.handlers[i].cycles;
+        }
+        for (i = 0; i < CJSON_STATS_DEPTH_MAX; i++) {
+            stats->depth[i] += block->stats.depth[i];
+        }
+        stats->docs += block->stats.docs;
+        stats->allocs += block->stats.allocs;
+        stats->alloc_bytes += block->stats.alloc_bytes;
+    }
+    pthread_mutex_unlock(&_stats_lock);
+
+    return 0;
+}
+
+void cjson_stats_reset(void)
+{
+    _stats_block_t *block = NULL;
+
+    pthread_mutex_lock(&_stats_lock);
+    for (block = _stats_blocks; block; block = block->next) {
+        memset(&(block->stats), 0, sizeof(cjson_stats_t));
+    }
+    pthread_mutex_unlock(&_stats_lock);
+}
+#else
+int cjson_stats_snapshot(cjson_stats_t *stats)
+{
+    memset(stats, 0, sizeof(cjson_stats_t));
+
+    return -1;
+}
+
+void cjson_stats_reset(void)
+{
+}
+#endif
+
+//===========================================================
+// stats => document
+static int _stats_set_number(cjson_object_t *obj, const tchar_t *key, uint64_t n)
+{
+    cjson_value_t val;
+
+    cjson_value_set_number(&val, (int64_t)n, 1);
+
+    return cjson_object_set_value(obj, key, &val);
+}
+
+static int _stats_set_container(cjson_object_t *obj, const tchar_t *key, cjson_valuetype_e type, cjson_value_t *val)
+{
+    size_t size = (type == _cjson_value_object_) ? sizeof(cjson_object_t) : sizeof(cjson_array_t);
+
+    val->value_type = type;
+    val->cjson_valptr = cjson_alloc(NULL, size);
+    if (val->cjson_valptr == NULL) {
+        return -1;
+    }
+    memset(val->cjson_valptr, 0, size);
+
+    if (cjson_object_set_value(obj, key, val) < 0) {
+        cjson_value_free(val);
+        return -1;
+    }
+
+    // the object holds it now
+    *val = *cjson_object_get_value(obj, key);
+
+    return 0;
+}
+
+int cjson_stats_to_json(const cjson_stats_t *stats, cjson_t *json)
+{
+    int i = 0;
+    int n = 0;
+    cjson_object_t *obj = NULL;
+    cjson_value_t handlers;
+    cjson_value_t handler;
+    cjson_value_t depth;
+    cjson_value_t val;
+
+    obj = (cjson_object_t*)cjson_alloc(NULL, sizeof(cjson_object_t));
+    if (obj == NULL) {
+        return -1;
+    }
+    memset(obj, 0, sizeof(cjson_object_t));
+
+    if (_stats_set_number(obj, _T("docs"), stats->docs) < 0
+        || _stats_set_number(obj, _T("allocs"), stats->allocs) < 0
+        || _stats_set_number(obj, _T("alloc_bytes"), stats->alloc_bytes) < 0
+        || _stats_set_container(obj, _T("handlers"), _cjson_value_object_, &handlers) < 0) {
+        goto lbl_err;
+    }
+
+    for (i = 0; i < CJSON_STATS_HANDLERS; i++) {
+        if (_stats_set_container(handlers.cjson_objval, _stats_handler_names[i], _cjson_value_object_, &handler) < 0
+            || _stats_set_number(handler.cjson_objval, _T("calls"), stats->handlers[i].calls) < 0
+            || _stats_set_number(handler.cjson_objval, _T("bytes"), stats->handlers[i].bytes) < 0
+            || _stats_set_number(handler.cjson_objval, _T("cycles"), stats->handlers[i].cycles) < 0) {
+            goto lbl_err;
+        }
+    }
+
+    // containers at depth 1, 2, ... up to the deepest seen
+    if (_stats_set_container(obj, _T("depth"), _cjson_value_array_, &depth) < 0) {
+        goto lbl_err;
+    }
+    for (i = 0; i < CJSON_STATS_DEPTH_MAX; i++) {
+        if (stats->depth[i]) {
+            n = i + 1;
+        }
+    }
+    for (i = 0; i < n; i++) {
+        cjson_value_set_number(&val, (int64_t)stats->depth[i], 1);
+        if (cjson_array_add(depth.cjson_arrval, &val) < 0) {
+            goto lbl_err;
+        }
+    }
+
+    json->object = obj;
+
+    return 0;
+
+lbl_err:
+
+    cjson_object_free(obj);
+
+    return -1;
+}
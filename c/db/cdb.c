@@ -21,6 +21,7 @@ int init_kvdbe(kvdbe_t *kvdbe, cdb_type_e db_type)
 {
     int ret = 0;
 
+    kvdbe->notfound = _CDB_NOTFOUND_;
     switch (db_type) {
         case _cdb_bdb_:
             ret = cdb_init_bdbe(kvdbe);
@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <stdint.h>
 
 
 #if defined(__cplusplus)
@@ -78,6 +79,10 @@ enum _cdb_type_e {
 #define _CDBO_RDONLY_           0x0004
 #define _CDBO_TRUNCATE_         0x0008
 
+// get: no such key, from the layers in front of an engine; engines have
+// their own code in kvdbe_t.notfound
+#define _CDB_NOTFOUND_          1
+
 
 struct _kvdbe_t {
     void        *engine;
@@ -92,6 +97,7 @@ struct _kvdbe_t {
     int (*closedb)(kvdbe_t *dbe, kvdb_t *db);
 
     cdb_type_e  db_type;
+    int         notfound;   // what get returns for no such key
 };
 
 struct _kvdb_t {
@@ -107,12 +113,39 @@ struct _kvdb_t {
     int (*traverse)(kvdb_t *db, kvdbt_t *key, kvdbt_t *value);
 };
 
+typedef struct {
+    int64_t     gets;
+    int64_t     skipped;            // answered by the filter
+    int64_t     false_positives;    // passed the filter, not in the db
+    int64_t     dels;
+} kvdb_bloom_stats_t;
+
 /********************************************************************
 *        Functions
 *********************************************************************/
 
 int init_kvdbe(kvdbe_t *kvdbe, cdb_type_e db_type);
 
+// write through cache of capacity entries in front of backing, db is
+// then used like any other kvdb_t. A get with value->data NULL gets the
+// cached bytes, valid till the next call.
+int kvdb_cache_open(kvdb_t *db, kvdb_t *backing, size_t capacity);
+int kvdb_cache_close(kvdb_t *db);
+
+// blocked bloom filter in front of backing, gets of keys never put return
+// _CDB_NOTFOUND_ without the engine, so does a get the engine has no key
+// for. Sized for expected_keys at bits_per_key (10 for about 1% false
+// positives), saved to path on close, e.g. the db file name + ".bloom",
+// NULL for none. generation is the caller's count of the db's states, to
+// bump whenever the db is written without this layer; a filter saved at
+// another generation is not used. Without a saved filter the db is
+// scanned in the background, gets go to the engine till then.
+int kvdb_bloom_open(kvdb_t *db, kvdb_t *backing, const char *path, uint64_t generation, size_t expected_keys, int bits_per_key);
+int kvdb_bloom_close(kvdb_t *db);
+int kvdb_bloom_rebuild(kvdb_t *db);
+int kvdb_bloom_wait(kvdb_t *db);
+int kvdb_bloom_stats(const kvdb_t *db, kvdb_bloom_stats_t *stats);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -0,0 +1,968 @@
+/************************************************************************************
+* csketch.c: Implementation File
+*
+* HyperLogLog++ & count-min sketches
+*
+* DESCRIPTION:
+*   distinct counts & key frequencies of a stream in fixed memory, keys
+*   hashed once with murmurhash3_128. Partial sketches, e.g. one per
+*   worker thread, are merged, or serialized to a kvdbt_t and merged
+*   elsewhere.
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   HyperLogLog++ as in Heule et al: 64-bit hashes, no large range
+*   correction, a sparse list of (index at p' = 25, rank) entries while
+*   it is smaller than the registers, linear counting on it. Dense
+*   estimates switch to linear counting below 5/2 m, the empirical bias
+*   tables are left out.
+*   count-min rows come from h1 + i * h2. The heavy hitters are a min heap
+*   of k keys, a key replaces the least one once its estimate is above.
+*   the register max, counter add & register sum kernels are AVX2 where
+*   the cpu has it.
+*   not thread safe, a sketch per thread.
+*
+************************************************************************************/
+#include <csketch.h>
+#include <chashmap.h>
+#include <murmurhash.h>
+#include <math.h>
+
+//gcc -O2 -I. -I.. -c csketch.c
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define _sketch_x86_
+#include <immintrin.h>
+#endif
+
+#define _sketch_magic_                  0x48435343 // "CSCH"
+#define _sketch_version_                1
+#define _sketch_type_hll_               1
+#define _sketch_type_cm_                2
+
+#define _hll_sparse_bits_               (CSKETCH_HLL_SPARSE_P)
+#define _hll_sparse_slack_              256 // room for unsorted entries past the sparse limit
+#define _hll_entry(idx, rank)           (((uint32_t)(idx) << 6) | (uint32_t)(rank))
+#define _hll_entry_idx(e)               ((e) >> 6)
+#define _hll_entry_rank(e)              ((e) & 0x3f)
+// ranks count the zeros after the index bits, + 1
+#define _hll_rank_max(p)                (64 - (p) + 1)
+
+//====================================================================
+// kernels
+struct __sketch_kernels_t {
+    const char  *isa;
+    void        (*max_u8)(uint8_t *dst, const uint8_t *src, int64_t n);
+    void        (*add_u64)(uint64_t *dst, const uint64_t *src, int64_t n);
+    double      (*hll_sum)(const uint8_t *regs, int64_t n, int64_t *zeros); // sum of 2^-reg
+};
+typedef struct __sketch_kernels_t       _sketch_kernels_t;
+
+static void _max_u8_scalar(uint8_t *dst, const uint8_t *src, int64_t n)
+{
+    int64_t i = 0;
+
+    for (i = 0; i < n; i++) {
+        dst[i] = (src[i] > dst[i]) ? src[i] : dst[i];
+    }
+}
+
+static void _add_u64_scalar(uint64_t *dst, const uint64_t *src, int64_t n)
+{
+    int64_t i = 0;
+
+    for (i = 0; i < n; i++) {
+        dst[i] += src[i];
+    }
+}
+
+static double _hll_sum_scalar(const uint8_t *regs, int64_t n, int64_t *zeros)
+{
+    int64_t hist[64] = {0};
+    int64_t i = 0;
+    double sum = 0;
+
+    // by value, 64 ldexp() instead of n
+    for (i = 0; i < n; i++) {
+        hist[regs[i]]++;
+    }
+    for (i = 63; i >= 0; i--) {
+        sum += ldexp((double)hist[i], -(int)i);
+    }
+    *zeros = hist[0];
+
+    return sum;
+}
+
+#if defined(_sketch_x86_)
+__attribute__((target("avx2")))
+static void _max_u8_avx2(uint8_t *dst, const uint8_t *src, int64_t n)
+{
+    int64_t i = 0;
+    __m256i a;
+    __m256i b;
+
+    for (i = 0; i + 32 <= n; i += 32) {
+        a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_max_epu8(a, b));
+    }
+    _max_u8_scalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void _add_u64_avx2(uint64_t *dst, const uint64_t *src, int64_t n)
+{
+    int64_t i = 0;
+    __m256i a;
+    __m256i b;
+
+    for (i = 0; i + 4 <= n; i += 4) {
+        a = _mm256_loadu_si256((const __m256i*)(dst + i));
+        b = _mm256_loadu_si256((const __m256i*)(src + i));
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_add_epi64(a, b));
+    }
+    _add_u64_scalar(dst + i, src + i, n - i);
+}
+
+// 2^-r built as a double: exponent 1023 - r, no mantissa
+__attribute__((target("avx2,popcnt")))
+static double _hll_sum_avx2(const uint8_t *regs, int64_t n, int64_t *zeros)
+{
+    const __m256i bias = _mm256_set1_epi64x(1023);
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    __m256d acc2 = _mm256_setzero_pd();
+    __m256d acc3 = _mm256_setzero_pd();
+    __m128i r;
+    double lanes[4];
+    int64_t z = 0;
+    int64_t i = 0;
+
+#define _hll_lanes(v)       _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_sub_epi64(bias, _mm256_cvtepu8_epi64(v)), 52))
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        r = _mm_loadu_si128((const __m128i*)(regs + i));
+        z += __builtin_popcount((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(r, _mm_setzero_si128())));
+        acc0 = _mm256_add_pd(acc0, _hll_lanes(r));
+        acc1 = _mm256_add_pd(acc1, _hll_lanes(_mm_srli_si128(r, 4)));
+        acc2 = _mm256_add_pd(acc2, _hll_lanes(_mm_srli_si128(r, 8)));
+        acc3 = _mm256_add_pd(acc3, _hll_lanes(_mm_srli_si128(r, 12)));
+    }
+
+#undef _hll_lanes
+
+    _mm256_storeu_pd(lanes, _mm256_add_pd(_mm256_add_pd(acc0, acc1), _mm256_add_pd(acc2, acc3)));
+
+    // n is a power of 2 & at least 16, no tail
+    *zeros = z;
+
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+#endif
+
+static const _sketch_kernels_t _kernels_scalar = { "scalar", _max_u8_scalar, _add_u64_scalar, _hll_sum_scalar };
+#if defined(_sketch_x86_)
+static const _sketch_kernels_t _kernels_avx2 = { "avx2", _max_u8_avx2, _add_u64_avx2, _hll_sum_avx2 };
+#endif
+
+static const _sketch_kernels_t *_kernels = NULL;
+
+static const _sketch_kernels_t* _sketch_kernels(void)
+{
+    const _sketch_kernels_t *k = __atomic_load_n(&_kernels, __ATOMIC_ACQUIRE);
+#if defined(_sketch_x86_)
+    const char *want = NULL;
+#endif
+
+    if (k) {
+        return k;
+    }
+
+    k = &_kernels_scalar;
+#if defined(_sketch_x86_)
+    // CSKETCH_ISA=scalar in the environment, to compare against
+    want = getenv("CSKETCH_ISA");
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && (want == NULL || strcmp(want, "scalar") != 0)) {
+        k = &_kernels_avx2;
+    }
+#endif
+
+    // the same value from any thread
+    __atomic_store_n(&_kernels, k, __ATOMIC_RELEASE);
+
+    return k;
+}
+
+const char* csketch_isa(void)
+{
+    return _sketch_kernels()->isa;
+}
+
+//====================================================================
+// HyperLogLog++
+csketch_hll_t* csketch_hll_create(int p)
+{
+    csketch_hll_t *hll = NULL;
+
+    if (p < CSKETCH_HLL_P_MIN || p > CSKETCH_HLL_P_MAX) {
+        return NULL;
+    }
+
+    hll = (csketch_hll_t*)malloc(sizeof(csketch_hll_t));
+    if (hll == NULL) {
+        return NULL;
+    }
+    memset(hll, 0, sizeof(csketch_hll_t));
+    hll->p = p;
+
+    return hll;
+}
+
+void csketch_hll_free(csketch_hll_t *hll)
+{
+    if (hll == NULL) {
+        return;
+    }
+
+    free(hll->regs);
+    free(hll->sparse);
+    free(hll);
+}
+
+static int _hll_to_dense(csketch_hll_t *hll);
+static void _hll_dense_entry(csketch_hll_t *hll, uint32_t e);
+
+static int _hll_cmp_entry(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*)a;
+    uint32_t y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+// sorted & one entry per index, the highest rank
+static void _hll_sparse_flush(csketch_hll_t *hll)
+{
+    int64_t i = 0;
+    int64_t n = 0;
+
+    if (hll->sparse_sorted == hll->sparse_count) {
+        return;
+    }
+
+    qsort(hll->sparse, hll->sparse_count, sizeof(uint32_t), _hll_cmp_entry);
+    for (i = 0; i < hll->sparse_count; i++) {
+        if (n > 0 && _hll_entry_idx(hll->sparse[n - 1]) == _hll_entry_idx(hll->sparse[i])) {
+            hll->sparse[n - 1] = hll->sparse[i]; // same index, higher rank
+        } else {
+            hll->sparse[n++] = hll->sparse[i];
+        }
+    }
+    hll->sparse_count = n;
+    hll->sparse_sorted = n;
+}
+
+// sparse while the entries take less than the registers
+#define _hll_sparse_max(hll)            (((int64_t)1 << (hll)->p) / (int64_t)sizeof(uint32_t))
+
+static int _hll_sparse_add(csketch_hll_t *hll, uint32_t entry)
+{
+    int64_t n = 0;
+    uint32_t *p = NULL;
+
+    if (hll->sparse_count == hll->sparse_capacity) {
+        _hll_sparse_flush(hll);
+        if (hll->sparse_count >= _hll_sparse_max(hll)) {
+            if (_hll_to_dense(hll) < 0) {
+                return -1;
+            }
+            _hll_dense_entry(hll, entry);
+            return 0;
+        }
+    }
+
+    if (hll->sparse_count == hll->sparse_capacity) {
+        n = hll->sparse_capacity ? hll->sparse_capacity * 2 : 16;
+        n = (n > _hll_sparse_max(hll) + _hll_sparse_slack_) ? _hll_sparse_max(hll) + _hll_sparse_slack_ : n;
+        p = (uint32_t*)realloc(hll->sparse, n * sizeof(uint32_t));
+        if (p == NULL) {
+            return -1;
+        }
+        hll->sparse = p;
+        hll->sparse_capacity = n;
+    }
+    hll->sparse[hll->sparse_count++] = entry;
+
+    return 0;
+}
+
+static void _hll_dense_set(csketch_hll_t *hll, uint32_t idx, uint8_t rank)
+{
+    if (rank > hll->regs[idx]) {
+        hll->regs[idx] = rank;
+    }
+}
+
+// sparse entry => register & rank at p
+static void _hll_dense_entry(csketch_hll_t *hll, uint32_t e)
+{
+    int shift = _hll_sparse_bits_ - hll->p;
+    uint32_t idx = _hll_entry_idx(e);
+    uint32_t low = idx & ((1u << shift) - 1);
+    uint8_t rank = 0;
+
+    // rank of the bits after the p index bits: in the low index bits, or after them
+    rank = low ? (uint8_t)(__builtin_clz(low) - (32 - shift) + 1) : (uint8_t)(shift + _hll_entry_rank(e));
+    _hll_dense_set(hll, idx >> shift, rank);
+}
+
+static int _hll_to_dense(csketch_hll_t *hll)
+{
+    int64_t i = 0;
+
+    hll->regs = (uint8_t*)calloc((size_t)1 << hll->p, 1);
+    if (hll->regs == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < hll->sparse_count; i++) {
+        _hll_dense_entry(hll, hll->sparse[i]);
+    }
+    free(hll->sparse);
+    hll->sparse = NULL;
+    hll->sparse_count = 0;
+    hll->sparse_sorted = 0;
+    hll->sparse_capacity = 0;
+
+    return 0;
+}
+
+void csketch_hll_add_hash(csketch_hll_t *hll, uint64_t hash)
+{
+    uint64_t w = 0;
+
+    if (hll->regs) {
+        w = hash << hll->p;
+        _hll_dense_set(hll, (uint32_t)(hash >> (64 - hll->p)), (uint8_t)(w ? __builtin_clzll(w) + 1 : _hll_rank_max(hll->p)));
+        return;
+    }
+
+    w = hash << _hll_sparse_bits_;
+    // out of memory: the key is not counted
+    _hll_sparse_add(hll, _hll_entry(hash >> (64 - _hll_sparse_bits_), w ? __builtin_clzll(w) + 1 : _hll_rank_max(_hll_sparse_bits_)));
+}
+
+void csketch_hll_add(csketch_hll_t *hll, const void *key, size_t len)
+{
+    uint128_t h;
+
+    murmurhash3_128(key, len, CSKETCH_SEED, &h);
+    csketch_hll_add_hash(hll, h.h1);
+}
+
+double csketch_hll_estimate(csketch_hll_t *hll)
+{
+    double m = (double)((int64_t)1 << hll->p);
+    double mp = (double)((int64_t)1 << _hll_sparse_bits_);
+    double alpha = 0;
+    double e = 0;
+    int64_t zeros = 0;
+
+    // linear counting at p', the sparse list has no collisions to speak of
+    if (hll->regs == NULL) {
+        _hll_sparse_flush(hll);
+        return mp * log(mp / (mp - (double)hll->sparse_count));
+    }
+
+    switch (hll->p) {
+        case 4:
+            alpha = 0.673;
+            break;
+        case 5:
+            alpha = 0.697;
+            break;
+        case 6:
+            alpha = 0.709;
+            break;
+        default:
+            alpha = 0.7213 / (1.0 + 1.079 / m);
+            break;
+    }
+
+    e = alpha * m * m / _sketch_kernels()->hll_sum(hll->regs, (int64_t)m, &zeros);
+    if (e <= 2.5 * m && zeros > 0) {
+        e = m * log(m / (double)zeros);
+    }
+
+    return e;
+}
+
+int csketch_hll_merge(csketch_hll_t *dst, csketch_hll_t *src)
+{
+    int64_t i = 0;
+
+    if (dst->p != src->p) {
+        return -1;
+    }
+
+    if (src->regs == NULL) {
+        for (i = 0; i < src->sparse_count; i++) {
+            if (dst->regs) {
+                _hll_dense_entry(dst, src->sparse[i]);
+            } else if (_hll_sparse_add(dst, src->sparse[i]) < 0) {
+                return -1;
+            }
+        }
+        return 0;
+    }
+
+    if (dst->regs == NULL && _hll_to_dense(dst) < 0) {
+        return -1;
+    }
+    _sketch_kernels()->max_u8(dst->regs, src->regs, (int64_t)1 << dst->p);
+
+    return 0;
+}
+
+//====================================================================
+// count-min & top k
+struct __cm_probe_t {
+    const void  *key;
+    size_t      len;
+};
+typedef struct __cm_probe_t             _cm_probe_t;
+
+static const chashmap_type_t _top_index_type = { sizeof(uint32_t), 0, NULL, NULL };
+
+#define _cm_row(cm, i)                  ((cm)->counters + (i) * (cm)->width)
+#define _cm_col(cm, h, i)               (((h)->h1 + (uint64_t)(i) * (h)->h2) & (uint64_t)((cm)->width - 1))
+#define _top_hash(h)                    ((uint32_t)((h)->h1 >> 32))
+#define _top_item(cm, pos)              (&((cm)->items[(cm)->heap[(pos)]]))
+
+csketch_cm_t* csketch_cm_create(int64_t width, int64_t depth, int64_t k)
+{
+    csketch_cm_t *cm = NULL;
+
+    // width a power of 2, rows are masked
+    if (width <= 0 || (width & (width - 1)) != 0 || depth <= 0 || k < 0 || k > CSKETCH_CM_K_MAX) {
+        return NULL;
+    }
+    if ((uint64_t)width > SIZE_MAX / sizeof(uint64_t) / (uint64_t)depth) {
+        return NULL;
+    }
+
+    cm = (csketch_cm_t*)malloc(sizeof(csketch_cm_t));
+    if (cm == NULL) {
+        return NULL;
+    }
+    memset(cm, 0, sizeof(csketch_cm_t));
+    cm->width = width;
+    cm->depth = depth;
+    cm->k = k;
+
+    cm->counters = (uint64_t*)calloc(width * depth, sizeof(uint64_t));
+    if (cm->counters == NULL) {
+        goto lbl_err;
+    }
+
+    if (k > 0) {
+        cm->items = (csketch_item_t*)calloc(k, sizeof(csketch_item_t));
+        cm->heap = (int64_t*)calloc(k, sizeof(int64_t));
+        cm->top_index = chashmap_create(&_top_index_type, k);
+        if (cm->items == NULL || cm->heap == NULL || cm->top_index == NULL) {
+            goto lbl_err;
+        }
+    }
+
+    return cm;
+
+lbl_err:
+
+    csketch_cm_free(cm);
+
+    return NULL;
+}
+
+void csketch_cm_free(csketch_cm_t *cm)
+{
+    int64_t i = 0;
+
+    if (cm == NULL) {
+        return;
+    }
+
+    for (i = 0; i < cm->top_count; i++) {
+        free(cm->items[i].key);
+    }
+    free(cm->items);
+    free(cm->heap);
+    chashmap_free(cm->top_index);
+    free(cm->counters);
+    free(cm);
+}
+
+static uint64_t _cm_estimate(const csketch_cm_t *cm, const uint128_t *h)
+{
+    uint64_t est = UINT64_MAX;
+    uint64_t c = 0;
+    int64_t i = 0;
+
+    for (i = 0; i < cm->depth; i++) {
+        c = _cm_row(cm, i)[_cm_col(cm, h, i)];
+        est = (c < est) ? c : est;
+    }
+
+    return est;
+}
+
+uint64_t csketch_cm_estimate(const csketch_cm_t *cm, const void *key, size_t len)
+{
+    uint128_t h;
+
+    murmurhash3_128(key, len, CSKETCH_SEED, &h);
+
+    return _cm_estimate(cm, &h);
+}
+
+// heap of item indexes, the least count on top
+static void _top_swap(csketch_cm_t *cm, int64_t a, int64_t b)
+{
+    int64_t t = cm->heap[a];
+
+    cm->heap[a] = cm->heap[b];
+    cm->heap[b] = t;
+    cm->items[cm->heap[a]].heap_pos = a;
+    cm->items[cm->heap[b]].heap_pos = b;
+}
+
+static void _top_down(csketch_cm_t *cm, int64_t pos)
+{
+    int64_t least = pos;
+    int64_t c = 0;
+
+    for (;;) {
+        for (c = 2 * pos + 1; c <= 2 * pos + 2 && c < cm->top_count; c++) {
+            if (_top_item(cm, c)->count < _top_item(cm, least)->count) {
+                least = c;
+            }
+        }
+        if (least == pos) {
+            return;
+        }
+        _top_swap(cm, pos, least);
+        pos = least;
+    }
+}
+
+static void _top_up(csketch_cm_t *cm, int64_t pos)
+{
+    while (pos > 0 && _top_item(cm, pos)->count < _top_item(cm, (pos - 1) / 2)->count) {
+        _top_swap(cm, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static int _top_match_key(void *ctx, const void *probe, const void *key)
+{
+    const csketch_item_t *item = &(((const csketch_cm_t*)ctx)->items[*(const uint32_t*)key]);
+    const _cm_probe_t *p = (const _cm_probe_t*)probe;
+
+    return item->len == p->len && memcmp(item->key, p->key, p->len) == 0;
+}
+
+static int _top_match_slot(void *ctx, const void *probe, const void *key)
+{
+    (void)ctx;
+
+    return *(const uint32_t*)probe == *(const uint32_t*)key;
+}
+
+// the key's count is now est, it may take the place of the least one
+static int _top_offer(csketch_cm_t *cm, const void *key, size_t len, const uint128_t *h, uint64_t est)
+{
+    _cm_probe_t probe = { key, len };
+    csketch_item_t *item = NULL;
+    uint32_t *pos = NULL;
+    uint32_t i = 0;
+    uint128_t old;
+    void *copy = NULL;
+
+    if (cm->k == 0) {
+        return 0;
+    }
+
+    pos = (uint32_t*)chashmap_find_with(cm->top_index, _top_hash(h), _top_match_key, cm, &probe);
+    if (pos) {
+        item = &(cm->items[*pos]);
+        item->count = est;
+        _top_down(cm, item->heap_pos);
+        return 0;
+    }
+
+    if (cm->top_count == cm->k && est <= _top_item(cm, 0)->count) {
+        return 0;
+    }
+
+    copy = malloc(len ? len : 1);
+    if (copy == NULL) {
+        return -1;
+    }
+    memcpy(copy, key, len);
+
+    if (cm->top_count < cm->k) {
+        i = (uint32_t)cm->top_count;
+        cm->heap[cm->top_count] = i;
+        cm->items[i].heap_pos = cm->top_count;
+        cm->top_count++;
+    } else {
+        // the least one leaves
+        i = (uint32_t)cm->heap[0];
+        item = &(cm->items[i]);
+        murmurhash3_128(item->key, item->len, CSKETCH_SEED, &old);
+        pos = (uint32_t*)chashmap_find_with(cm->top_index, _top_hash(&old), _top_match_slot, cm, &i);
+        if (pos) {
+            chashmap_erase_entry(cm->top_index, pos);
+        }
+        free(item->key);
+    }
+
+    if (chashmap_insert_h(cm->top_index, &i, _top_hash(h), NULL, NULL) == NULL) {
+        free(copy);
+        item = &(cm->items[i]);
+        item->key = NULL;
+        item->len = 0;
+        item->count = 0; // an empty key at the top, the next one replaces it
+        _top_up(cm, item->heap_pos);
+        return -1;
+    }
+
+    item = &(cm->items[i]);
+    item->key = copy;
+    item->len = len;
+    item->count = est;
+    _top_down(cm, item->heap_pos);
+    _top_up(cm, item->heap_pos);
+
+    return 0;
+}
+
+int csketch_cm_add(csketch_cm_t *cm, const void *key, size_t len, uint64_t count)
+{
+    uint128_t h;
+    int64_t i = 0;
+
+    murmurhash3_128(key, len, CSKETCH_SEED, &h);
+    for (i = 0; i < cm->depth; i++) {
+        _cm_row(cm, i)[_cm_col(cm, &h, i)] += count;
+    }
+    cm->total += count;
+
+    return _top_offer(cm, key, len, &h, _cm_estimate(cm, &h));
+}
+
+int csketch_cm_merge(csketch_cm_t *dst, const csketch_cm_t *src)
+{
+    uint128_t h;
+    int64_t i = 0;
+    const csketch_item_t *item = NULL;
+
+    if (dst->width != src->width || dst->depth != src->depth) {
+        return -1;
+    }
+
+    _sketch_kernels()->add_u64(dst->counters, src->counters, dst->width * dst->depth);
+    dst->total += src->total;
+
+    // candidates: both tops, with the merged estimates
+    for (i = 0; i < dst->top_count; i++) {
+        item = &(dst->items[i]);
+        murmurhash3_128(item->key, item->len, CSKETCH_SEED, &h);
+        dst->items[i].count = _cm_estimate(dst, &h);
+    }
+    for (i = dst->top_count / 2; i >= 0 && dst->top_count > 0; i--) {
+        _top_down(dst, i);
+    }
+
+    for (i = 0; i < src->top_count; i++) {
+        item = &(src->items[i]);
+        if (item->key == NULL) {
+            continue;
+        }
+        murmurhash3_128(item->key, item->len, CSKETCH_SEED, &h);
+        if (_top_offer(dst, item->key, item->len, &h, _cm_estimate(dst, &h)) < 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+static int _top_cmp_desc(const void *a, const void *b)
+{
+    uint64_t x = ((const csketch_item_t*)a)->count;
+    uint64_t y = ((const csketch_item_t*)b)->count;
+
+    return (x < y) - (x > y);
+}
+
+int64_t csketch_cm_top(const csketch_cm_t *cm, csketch_item_t *out, int64_t n)
+{
+    csketch_item_t *all = NULL;
+    int64_t i = 0;
+    int64_t m = 0;
+
+    all = (csketch_item_t*)malloc((cm->top_count ? cm->top_count : 1) * sizeof(csketch_item_t));
+    if (all == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < cm->top_count; i++) {
+        if (cm->items[i].key) {
+            all[m++] = cm->items[i];
+        }
+    }
+    qsort(all, m, sizeof(csketch_item_t), _top_cmp_desc);
+
+    n = (n < m) ? n : m;
+    memcpy(out, all, n * sizeof(csketch_item_t));
+    free(all);
+
+    return n;
+}
+
+//====================================================================
+// serialization
+struct __sketch_hdr_t {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    type;
+    int64_t     a;          // hll: p,      cm: width
+    int64_t     b;          // hll: sparse, cm: depth
+    int64_t     c;          // hll: count,  cm: k
+    int64_t     d;          // cm: top keys
+    uint64_t    total;      // cm: total
+};
+typedef struct __sketch_hdr_t           _sketch_hdr_t;
+
+// a top key: count, len, then the key
+struct __sketch_key_t {
+    uint64_t    count;
+    uint64_t    len;
+};
+typedef struct __sketch_key_t           _sketch_key_t;
+
+static void _sketch_hdr(_sketch_hdr_t *hdr, uint16_t type)
+{
+    memset(hdr, 0, sizeof(_sketch_hdr_t));
+    hdr->magic = _sketch_magic_;
+    hdr->version = _sketch_version_;
+    hdr->type = type;
+}
+
+static int _sketch_hdr_check(const kvdbt_t *in, _sketch_hdr_t *hdr, uint16_t type)
+{
+    if (in->size < sizeof(_sketch_hdr_t)) {
+        return -1;
+    }
+    memcpy(hdr, in->data, sizeof(_sketch_hdr_t));
+
+    return (hdr->magic == _sketch_magic_ && hdr->version == _sketch_version_ && hdr->type == type) ? 0 : -1;
+}
+
+int csketch_hll_serialize(csketch_hll_t *hll, kvdbt_t *out)
+{
+    _sketch_hdr_t hdr;
+    size_t size = 0;
+
+    _sketch_hdr(&hdr, _sketch_type_hll_);
+    hdr.a = hll->p;
+    if (hll->regs) {
+        hdr.c = (int64_t)1 << hll->p;
+        size = hdr.c;
+    } else {
+        _hll_sparse_flush(hll);
+        hdr.b = 1;
+        hdr.c = hll->sparse_count;
+        size = hdr.c * sizeof(uint32_t);
+    }
+
+    out->data = malloc(sizeof(_sketch_hdr_t) + size);
+    if (out->data == NULL) {
+        return -1;
+    }
+    out->size = sizeof(_sketch_hdr_t) + size;
+    memcpy(out->data, &hdr, sizeof(_sketch_hdr_t));
+    memcpy((char*)out->data + sizeof(_sketch_hdr_t), hll->regs ? (const void*)hll->regs : (const void*)hll->sparse, size);
+
+    return 0;
+}
+
+csketch_hll_t* csketch_hll_deserialize(const kvdbt_t *in)
+{
+    _sketch_hdr_t hdr;
+    csketch_hll_t *hll = NULL;
+    const char *payload = (const char*)in->data + sizeof(_sketch_hdr_t);
+    int64_t i = 0;
+    uint32_t e = 0;
+
+    if (_sketch_hdr_check(in, &hdr, _sketch_type_hll_) < 0 || hdr.a < CSKETCH_HLL_P_MIN || hdr.a > CSKETCH_HLL_P_MAX) {
+        return NULL;
+    }
+
+    hll = csketch_hll_create((int)hdr.a);
+    if (hll == NULL) {
+        return NULL;
+    }
+
+    if (hdr.b == 0) {
+        if (hdr.c != ((int64_t)1 << hll->p) || in->size != sizeof(_sketch_hdr_t) + (size_t)hdr.c || _hll_to_dense(hll) < 0) {
+            goto lbl_err;
+        }
+        memcpy(hll->regs, payload, hdr.c);
+        for (i = 0; i < hdr.c; i++) {
+            if (hll->regs[i] > _hll_rank_max(hll->p)) {
+                goto lbl_err;
+            }
+        }
+        return hll;
+    }
+
+    if (hdr.c < 0 || (uint64_t)hdr.c > (in->size - sizeof(_sketch_hdr_t)) / sizeof(uint32_t)
+        || in->size != sizeof(_sketch_hdr_t) + (size_t)hdr.c * sizeof(uint32_t)) {
+        goto lbl_err;
+    }
+    for (i = 0; i < hdr.c; i++) {
+        memcpy(&e, payload + i * sizeof(uint32_t), sizeof(uint32_t));
+        if (_hll_entry_idx(e) >= (1u << _hll_sparse_bits_) || _hll_entry_rank(e) > _hll_rank_max(_hll_sparse_bits_)) {
+            goto lbl_err;
+        }
+        if (_hll_sparse_add(hll, e) < 0) {
+            goto lbl_err;
+        }
+    }
+
+    return hll;
+
+lbl_err:
+
+    csketch_hll_free(hll);
+
+    return NULL;
+}
+
+int csketch_cm_serialize(const csketch_cm_t *cm, kvdbt_t *out)
+{
+    _sketch_hdr_t hdr;
+    _sketch_key_t key;
+    size_t size = 0;
+    size_t counters = cm->width * cm->depth * sizeof(uint64_t);
+    char *p = NULL;
+    int64_t i = 0;
+
+    _sketch_hdr(&hdr, _sketch_type_cm_);
+    hdr.a = cm->width;
+    hdr.b = cm->depth;
+    hdr.c = cm->k;
+    hdr.total = cm->total;
+
+    size = sizeof(_sketch_hdr_t) + counters;
+    for (i = 0; i < cm->top_count; i++) {
+        if (cm->items[i].key) {
+            size += sizeof(_sketch_key_t) + cm->items[i].len;
+            hdr.d++;
+        }
+    }
+
+    p = (char*)malloc(size);
+    if (p == NULL) {
+        return -1;
+    }
+    out->data = p;
+    out->size = size;
+
+    memcpy(p, &hdr, sizeof(_sketch_hdr_t));
+    p += sizeof(_sketch_hdr_t);
+    memcpy(p, cm->counters, counters);
+    p += counters;
+
+    for (i = 0; i < cm->top_count; i++) {
+        if (cm->items[i].key == NULL) {
+            continue;
+        }
+        key.count = cm->items[i].count;
+        key.len = cm->items[i].len;
+        memcpy(p, &key, sizeof(_sketch_key_t));
+        memcpy(p + sizeof(_sketch_key_t), cm->items[i].key, key.len);
+        p += sizeof(_sketch_key_t) + key.len;
+    }
+
+    return 0;
+}
+
+csketch_cm_t* csketch_cm_deserialize(const kvdbt_t *in)
+{
+    _sketch_hdr_t hdr;
+    _sketch_key_t key;
+    csketch_cm_t *cm = NULL;
+    const char *p = (const char*)in->data + sizeof(_sketch_hdr_t);
+    const char *end = (const char*)in->data + in->size;
+    uint128_t h;
+    int64_t i = 0;
+
+    if (_sketch_hdr_check(in, &hdr, _sketch_type_cm_) < 0) {
+        return NULL;
+    }
+    // the counters must be there before they are allocated
+    if (hdr.a <= 0 || hdr.b <= 0 || (uint64_t)hdr.a > (in->size - sizeof(_sketch_hdr_t)) / sizeof(uint64_t) / (uint64_t)hdr.b) {
+        return NULL;
+    }
+    if (hdr.d < 0 || hdr.d > hdr.c) {
+        return NULL;
+    }
+
+    cm = csketch_cm_create(hdr.a, hdr.b, hdr.c);
+    if (cm == NULL) {
+        return NULL;
+    }
+
+    if ((size_t)(end - p) < cm->width * cm->depth * sizeof(uint64_t)) {
+        goto lbl_err;
+    }
+    memcpy(cm->counters, p, cm->width * cm->depth * sizeof(uint64_t));
+    p += cm->width * cm->depth * sizeof(uint64_t);
+    cm->total = hdr.total;
+
+    for (i = 0; i < hdr.d; i++) {
+        if ((size_t)(end - p) < sizeof(_sketch_key_t)) {
+            goto lbl_err;
+        }
+        memcpy(&key, p, sizeof(_sketch_key_t));
+        p += sizeof(_sketch_key_t);
+        if ((uint64_t)(end - p) < key.len) {
+            goto lbl_err;
+        }
+        murmurhash3_128(p, key.len, CSKETCH_SEED, &h);
+        if (_top_offer(cm, p, key.len, &h, key.count) < 0) {
+            goto lbl_err;
+        }
+        p += key.len;
+    }
+
+    if (p != end) {
+        goto lbl_err;
+    }
+
+    return cm;
+
+lbl_err:
+
+    csketch_cm_free(cm);
+
+    return NULL;
+}
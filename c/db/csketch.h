@@ -0,0 +1,124 @@
+/************************************************************************************
+* csketch.h : header file
+*
+* Sketches Definition header: HyperLogLog & count-min
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+* Copyright (c) 2026. All Rights Reserved.
+*
+* This code may be used in compiled form in any way you desire. This
+* file may be redistributed unmodified by any means PROVIDING it is
+* not sold for profit without the authors written consent, and
+* providing that this notice and the authors name and all copyright
+* notices remains intact.
+*
+* An email letting me know how you are using it would be nice as well.
+*
+* This file is provided "as is" with no expressed or implied warranty.
+* The author accepts no liability for any damage/loss of business that
+* this product may cause.
+*
+************************************************************************************/
+
+#if !defined(__CSKETCH_H__)
+#define __CSKETCH_H__
+
+#include <cdb.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+/********************************************************************
+*        Macros
+*********************************************************************/
+// HyperLogLog precision, 2^p registers, standard error 1.04 / sqrt(2^p)
+#define CSKETCH_HLL_P_MIN               4
+#define CSKETCH_HLL_P_MAX               18
+// sparse entries keep the index at this precision
+#define CSKETCH_HLL_SPARSE_P            25
+
+// most heavy hitters a count-min sketch keeps
+#define CSKETCH_CM_K_MAX                (1 << 20)
+
+#define CSKETCH_SEED                    0x3c6ef372
+
+/********************************************************************
+*        Data Types
+*********************************************************************/
+struct _chashmap_t;
+
+// HyperLogLog++: sparse till the entries would take more than the
+// registers, then dense. Sketches of the same p merge.
+struct _csketch_hll_t {
+    uint8_t                 *regs;          // 2^p registers, NULL while sparse
+    uint32_t                *sparse;        // index at CSKETCH_HLL_SPARSE_P << 6 | rank
+    int64_t                 sparse_count;
+    int64_t                 sparse_sorted;  // [0, sparse_sorted) sorted & unique
+    int64_t                 sparse_capacity;
+    int                     p;
+};
+typedef struct _csketch_hll_t           csketch_hll_t;
+
+// a key & its estimated count
+struct _csketch_item_t {
+    void                    *key;
+    size_t                  len;
+    uint64_t                count;
+    int64_t                 heap_pos;
+};
+typedef struct _csketch_item_t          csketch_item_t;
+
+// count-min, depth rows of width counters, with the k most frequent keys
+// seen so far in a min heap. Sketches of the same width & depth merge.
+struct _csketch_cm_t {
+    uint64_t                *counters;  // depth * width
+    int64_t                 width;      // power of 2
+    int64_t                 depth;
+    uint64_t                total;      // sum of the counts added
+    csketch_item_t          *items;     // k, heap entries point here
+    int64_t                 *heap;      // item indexes, least count first
+    int64_t                 top_count;
+    int64_t                 k;
+    struct _chashmap_t      *top_index; // item index, by key
+};
+typedef struct _csketch_cm_t            csketch_cm_t;
+
+/********************************************************************
+*        Functions
+*********************************************************************/
+csketch_hll_t* csketch_hll_create(int p);
+void csketch_hll_free(csketch_hll_t *hll);
+void csketch_hll_add(csketch_hll_t *hll, const void *key, size_t len);
+// h1 of murmurhash3_128(key, len, CSKETCH_SEED)
+void csketch_hll_add_hash(csketch_hll_t *hll, uint64_t hash);
+double csketch_hll_estimate(csketch_hll_t *hll);
+// dst |= src, -1 if p differs
+int csketch_hll_merge(csketch_hll_t *dst, csketch_hll_t *src);
+
+// width ~ e / error, depth ~ ln(1 / (1 - confidence)), k keys kept, 0 for
+// none, up to CSKETCH_CM_K_MAX
+csketch_cm_t* csketch_cm_create(int64_t width, int64_t depth, int64_t k);
+void csketch_cm_free(csketch_cm_t *cm);
+int csketch_cm_add(csketch_cm_t *cm, const void *key, size_t len, uint64_t count);
+uint64_t csketch_cm_estimate(const csketch_cm_t *cm, const void *key, size_t len);
+// dst += src, the top keys of both are estimated again, -1 if the sizes differ
+int csketch_cm_merge(csketch_cm_t *dst, const csketch_cm_t *src);
+// the top keys, most frequent first, up to n, keys belong to the sketch
+int64_t csketch_cm_top(const csketch_cm_t *cm, csketch_item_t *out, int64_t n);
+
+// out->data is malloc'ed, free() it. Host byte order.
+int csketch_hll_serialize(csketch_hll_t *hll, kvdbt_t *out);
+csketch_hll_t* csketch_hll_deserialize(const kvdbt_t *in);
+int csketch_cm_serialize(const csketch_cm_t *cm, kvdbt_t *out);
+csketch_cm_t* csketch_cm_deserialize(const kvdbt_t *in);
+
+// kernel in use: "avx2" or "scalar", CSKETCH_ISA in the environment picks one
+const char* csketch_isa(void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /*__CSKETCH_H__*/
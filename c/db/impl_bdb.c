@@ -40,6 +40,7 @@ int cdb_init_bdbe(kvdbe_t *kvdbe)
     kvdbe->opendb = _bdbe_opendb;
     kvdbe->removedb = _bdbe_removedb;
     kvdbe->closedb = _bdbe_closedb;
+    kvdbe->notfound = DB_NOTFOUND;
 
     //kvdbe->engine = NULL;
     //kvdbe->path = NULL;
@@ -0,0 +1,453 @@
+/************************************************************************************
+* kvdb_bloom.c: Implementation File
+*
+* KV DB bloom filter
+*
+* DESCRIPTION:
+*   blocked bloom filter in front of any kvdb_t, a get of a key the filter
+*   has never seen returns _CDB_NOTFOUND_ without asking the engine, the
+*   engine's own not found code is mapped to it. A key
+*   sets k bits in one 64 byte block, so a lookup touches 1 cache line.
+*   The bits come from murmurhash3_128 by double hashing: h1 picks the
+*   block, h2 gives the start & the step inside it.
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   puts add their key. Dels can't take bits out, they are counted, and
+*   once they are half of the keys the filter is rebuilt.
+*   Until a filter covers every key of the db, gets go to the engine:
+*   without a saved filter, a thread scans the db with reset_cursor() &
+*   traverse() on open & rebuild, so the backing db must allow that next
+*   to the caller's own calls (e.g. DB_THREAD), and the caller must not
+*   traverse meanwhile.
+*   the filter is saved on close with the caller's db generation & the db
+*   name, & removed when loaded: a crash leaves no stale file behind, a
+*   file of another generation or db is ignored, the next open scans again.
+*   not thread safe otherwise.
+*
+************************************************************************************/
+#include <cdb.h>
+#include <murmurhash.h>
+#include <pthread.h>
+#include <unistd.h>
+
+//gcc -I. -I.. -c kvdb_bloom.c
+
+#define _bloom_block_bits_          512 // a cache line
+#define _bloom_block_words_         (_bloom_block_bits_ / 64)
+#define _bloom_k_max_               16
+#define _bloom_seed_                0x5bd1e995
+#define _bloom_magic_               0x4642564b // "KVBF"
+#define _bloom_version_             2
+
+// saved filter
+struct __bloom_file_t {
+    uint32_t    magic;
+    uint32_t    version;
+    uint64_t    nblocks;
+    uint32_t    k;
+    uint32_t    seed;
+    int64_t     keys;
+    uint64_t    generation; // the caller's, of the db state the filter covers
+    uint32_t    name_hash;  // of the db name
+    uint32_t    reserved;
+};
+typedef struct __bloom_file_t       _bloom_file_t;
+
+struct __kvdb_bloom_t {
+    kvdb_t              *backing;
+    uint64_t            *bits;      // nblocks blocks
+    uint64_t            nblocks;
+    uint32_t            k;
+    int                 notfound;   // the backing get's code for no such key
+    uint64_t            generation;
+    int                 ready;      // covers every key, atomic
+    int                 scanning;
+    pthread_t           scanner;
+    char                *path;      // saved here on close, NULL for none
+    int64_t             keys;       // added since the last build
+    int64_t             dels;       // since the last build
+    kvdb_bloom_stats_t  stats;
+};
+typedef struct __kvdb_bloom_t       _kvdb_bloom_t;
+
+//===============================================
+// filter
+static void _bloom_hash(const kvdbt_t *key, uint128_t *h)
+{
+    murmurhash3_128(key->data, key->size, _bloom_seed_, h);
+}
+
+static uint64_t* _bloom_block(const _kvdb_bloom_t *bf, const uint128_t *h)
+{
+    return bf->bits + (h->h1 % bf->nblocks) * _bloom_block_words_;
+}
+
+// the scanner & the caller's puts may add at the same time
+static void _bloom_add(_kvdb_bloom_t *bf, const uint128_t *h)
+{
+    uint64_t *block = _bloom_block(bf, h);
+    uint32_t a = (uint32_t)h->h2;
+    uint32_t b = (uint32_t)(h->h2 >> 32) | 1;
+    uint32_t bit = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < bf->k; i++) {
+        bit = (a + i * b) & (_bloom_block_bits_ - 1);
+        __atomic_fetch_or(&block[bit >> 6], 1ull << (bit & 63), __ATOMIC_RELAXED);
+    }
+}
+
+static int _bloom_maybe(const _kvdb_bloom_t *bf, const uint128_t *h)
+{
+    const uint64_t *block = _bloom_block(bf, h);
+    uint32_t a = (uint32_t)h->h2;
+    uint32_t b = (uint32_t)(h->h2 >> 32) | 1;
+    uint32_t bit = 0;
+    uint32_t i = 0;
+
+    for (i = 0; i < bf->k; i++) {
+        bit = (a + i * b) & (_bloom_block_bits_ - 1);
+        if ((block[bit >> 6] & (1ull << (bit & 63))) == 0) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static void* _bloom_scan(void *arg)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)arg;
+    kvdb_t *db = bf->backing;
+    kvdbt_t key;
+    kvdbt_t value;
+    uint128_t h;
+
+    if (db->reset_cursor(db) != 0) {
+        return NULL;
+    }
+
+    for (;;) {
+        memset(&key, 0, sizeof(kvdbt_t));
+        memset(&value, 0, sizeof(kvdbt_t));
+        if (db->traverse(db, &key, &value) != 0) {
+            break;
+        }
+        _bloom_hash(&key, &h);
+        _bloom_add(bf, &h);
+        __atomic_fetch_add(&(bf->keys), 1, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&(bf->ready), 1, __ATOMIC_RELEASE);
+
+    return NULL;
+}
+
+static void _bloom_scan_wait(_kvdb_bloom_t *bf)
+{
+    if (bf->scanning) {
+        pthread_join(bf->scanner, NULL);
+        bf->scanning = 0;
+    }
+}
+
+// empty filter, filled by a scan in the background
+static int _bloom_scan_start(_kvdb_bloom_t *bf)
+{
+    // no scan, the filter stays as it is
+    if (bf->backing->reset_cursor == NULL || bf->backing->traverse == NULL) {
+        return -1;
+    }
+
+    _bloom_scan_wait(bf);
+
+    __atomic_store_n(&(bf->ready), 0, __ATOMIC_RELEASE);
+    memset(bf->bits, 0, bf->nblocks * _bloom_block_words_ * sizeof(uint64_t));
+    bf->keys = 0;
+    bf->dels = 0;
+
+    if (pthread_create(&(bf->scanner), NULL, _bloom_scan, bf) != 0) {
+        return -1;
+    }
+    bf->scanning = 1;
+
+    return 0;
+}
+
+//===============================================
+// saved filter
+static uint32_t _bloom_name_hash(const _kvdb_bloom_t *bf)
+{
+    const char *name = bf->backing->name ? bf->backing->name : "";
+
+    return murmurhash3_32(name, strlen(name), _bloom_seed_);
+}
+
+static int _bloom_load(_kvdb_bloom_t *bf)
+{
+    FILE *fp = NULL;
+    _bloom_file_t hdr;
+    size_t size = bf->nblocks * _bloom_block_words_ * sizeof(uint64_t);
+    int ret = -1;
+
+    if (bf->path == NULL) {
+        return -1;
+    }
+
+    fp = fopen(bf->path, "rb");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    if (fread(&hdr, sizeof(hdr), 1, fp) == 1 && hdr.magic == _bloom_magic_ && hdr.version == _bloom_version_
+        && hdr.nblocks == bf->nblocks && hdr.k == bf->k && hdr.seed == _bloom_seed_
+        && hdr.generation == bf->generation && hdr.name_hash == _bloom_name_hash(bf) && hdr.keys >= 0
+        && fread(bf->bits, 1, size, fp) == size) {
+        bf->keys = hdr.keys;
+        ret = 0;
+    }
+    fclose(fp);
+
+    // good for this run only, a crash must not leave it behind
+    unlink(bf->path);
+
+    return ret;
+}
+
+static int _bloom_save(const _kvdb_bloom_t *bf)
+{
+    FILE *fp = NULL;
+    _bloom_file_t hdr;
+    size_t size = bf->nblocks * _bloom_block_words_ * sizeof(uint64_t);
+    char *tmp = NULL;
+    int ret = -1;
+
+    tmp = (char*)malloc(strlen(bf->path) + 5);
+    if (tmp == NULL) {
+        return -1;
+    }
+    sprintf(tmp, "%s.tmp", bf->path);
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.magic = _bloom_magic_;
+    hdr.version = _bloom_version_;
+    hdr.nblocks = bf->nblocks;
+    hdr.k = bf->k;
+    hdr.seed = _bloom_seed_;
+    hdr.keys = bf->keys;
+    hdr.generation = bf->generation;
+    hdr.name_hash = _bloom_name_hash(bf);
+
+    fp = fopen(tmp, "wb");
+    if (fp) {
+        if (fwrite(&hdr, sizeof(hdr), 1, fp) == 1 && fwrite(bf->bits, 1, size, fp) == size) {
+            ret = 0;
+        }
+        if (fclose(fp) != 0) {
+            ret = -1;
+        }
+        if (ret == 0) {
+            ret = (rename(tmp, bf->path) == 0) ? 0 : -1;
+        }
+        if (ret < 0) {
+            unlink(tmp);
+        }
+    }
+    free(tmp);
+
+    return ret;
+}
+
+//===============================================
+// kvdb_t
+static int _bloom_get(kvdb_t *db, const kvdbt_t *key, kvdbt_t *value)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)(db->mdl);
+    uint128_t h;
+    int ready = 0;
+    int ret = 0;
+
+    bf->stats.gets++;
+
+    ready = __atomic_load_n(&(bf->ready), __ATOMIC_ACQUIRE);
+    if (ready) {
+        _bloom_hash(key, &h);
+        if (!_bloom_maybe(bf, &h)) {
+            bf->stats.skipped++;
+            return _CDB_NOTFOUND_;
+        }
+    }
+
+    // other errors are the engine's, as they are
+    ret = bf->backing->get(bf->backing, key, value);
+    if (ret == bf->notfound || ret == _CDB_NOTFOUND_) {
+        bf->stats.false_positives += ready;
+        return _CDB_NOTFOUND_;
+    }
+
+    return ret;
+}
+
+static int _bloom_put(kvdb_t *db, const kvdbt_t *key, const kvdbt_t *value)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)(db->mdl);
+    uint128_t h;
+
+    // in the filter first, a get must never miss a key the db has
+    _bloom_hash(key, &h);
+    _bloom_add(bf, &h);
+    __atomic_fetch_add(&(bf->keys), 1, __ATOMIC_RELAXED);
+
+    return bf->backing->put(bf->backing, key, value);
+}
+
+static int _bloom_del(kvdb_t *db, const kvdbt_t *key)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)(db->mdl);
+    int ret = 0;
+
+    ret = bf->backing->del(bf->backing, key);
+    if (ret != 0) {
+        return ret;
+    }
+
+    // bits of deleted keys only cost false positives, until they are many
+    bf->stats.dels++;
+    bf->dels++;
+    if (__atomic_load_n(&(bf->ready), __ATOMIC_ACQUIRE) && bf->dels > __atomic_load_n(&(bf->keys), __ATOMIC_RELAXED) / 2) {
+        _bloom_scan_start(bf);
+    }
+
+    return 0;
+}
+
+static int _bloom_reset_cursor(kvdb_t *db)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)(db->mdl);
+
+    return bf->backing->reset_cursor(bf->backing);
+}
+
+static int _bloom_traverse(kvdb_t *db, kvdbt_t *key, kvdbt_t *value)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)(db->mdl);
+
+    return bf->backing->traverse(bf->backing, key, value);
+}
+
+//===============================================
+int kvdb_bloom_open(kvdb_t *db, kvdb_t *backing, const char *path, uint64_t generation, size_t expected_keys, int bits_per_key)
+{
+    _kvdb_bloom_t *bf = NULL;
+    uint64_t bits = 0;
+
+    if (db == NULL || backing == NULL || bits_per_key <= 0) {
+        return -1;
+    }
+
+    bf = (_kvdb_bloom_t*)malloc(sizeof(_kvdb_bloom_t));
+    if (bf == NULL) {
+        return -1;
+    }
+    memset(bf, 0, sizeof(_kvdb_bloom_t));
+
+    bits = (uint64_t)(expected_keys ? expected_keys : 1) * (uint64_t)bits_per_key;
+    bf->nblocks = (bits + _bloom_block_bits_ - 1) / _bloom_block_bits_;
+    // k = bits per key * ln 2
+    bf->k = (uint32_t)(bits_per_key * 693 / 1000);
+    bf->k = (bf->k < 1) ? 1 : ((bf->k > _bloom_k_max_) ? _bloom_k_max_ : bf->k);
+    bf->backing = backing;
+    bf->generation = generation;
+    // layers keep the engine's dbe
+    bf->notfound = (backing->dbe && backing->dbe->notfound) ? backing->dbe->notfound : _CDB_NOTFOUND_;
+
+    if (posix_memalign((void**)&(bf->bits), 64, bf->nblocks * _bloom_block_words_ * sizeof(uint64_t)) != 0) {
+        free(bf);
+        return -1;
+    }
+    memset(bf->bits, 0, bf->nblocks * _bloom_block_words_ * sizeof(uint64_t));
+
+    if (path) {
+        bf->path = strdup(path);
+        if (bf->path == NULL) {
+            free(bf->bits);
+            free(bf);
+            return -1;
+        }
+    }
+
+    if (_bloom_load(bf) == 0) {
+        bf->ready = 1;
+    } else {
+        _bloom_scan_start(bf);
+    }
+
+    memset(db, 0, sizeof(kvdb_t));
+    db->dbe = backing->dbe;
+    db->mdl = bf;
+    db->name = backing->name;
+    db->get = _bloom_get;
+    db->put = _bloom_put;
+    db->del = _bloom_del;
+    db->reset_cursor = _bloom_reset_cursor;
+    db->traverse = _bloom_traverse;
+
+    return 0;
+}
+
+// the backing db stays open
+int kvdb_bloom_close(kvdb_t *db)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)(db->mdl);
+    int ret = 0;
+
+    if (bf == NULL) {
+        return -1;
+    }
+
+    _bloom_scan_wait(bf);
+    if (bf->path && bf->ready) {
+        ret = _bloom_save(bf);
+    }
+
+    free(bf->path);
+    free(bf->bits);
+    free(bf);
+
+    db->mdl = NULL;
+
+    return ret;
+}
+
+int kvdb_bloom_rebuild(kvdb_t *db)
+{
+    return _bloom_scan_start((_kvdb_bloom_t*)(db->mdl));
+}
+
+// waits for a running scan, 0 if the filter covers the db then
+int kvdb_bloom_wait(kvdb_t *db)
+{
+    _kvdb_bloom_t *bf = (_kvdb_bloom_t*)(db->mdl);
+
+    _bloom_scan_wait(bf);
+
+    return bf->ready ? 0 : -1;
+}
+
+int kvdb_bloom_stats(const kvdb_t *db, kvdb_bloom_stats_t *stats)
+{
+    const _kvdb_bloom_t *bf = (const _kvdb_bloom_t*)(db->mdl);
+
+    if (bf == NULL || stats == NULL) {
+        return -1;
+    }
+
+    *stats = bf->stats;
+
+    return 0;
+}
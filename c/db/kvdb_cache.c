@@ -0,0 +1,304 @@
+/************************************************************************************
+* kvdb_cache.c: Implementation File
+*
+* KV DB cache
+*
+* DESCRIPTION:
+*   in process, write through cache in front of any kvdb_t. Entries are
+*   slots in an array, a chashmap indexes them by key, CLOCK picks the
+*   slot to reuse when the cache is full.
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   puts & dels go to the backing db first, the cache follows only if
+*   they succeed. Not thread safe.
+*
+************************************************************************************/
+#include <cdb.h>
+#include <chashmap.h>
+#include <murmurhash.h>
+
+//gcc -I. -I.. -c kvdb_cache.c
+
+struct __cache_slot_t {
+    void        *key;       // key, then value, one block
+    size_t      key_size;
+    size_t      val_size;
+    uint32_t    hash;
+    uint8_t     used;
+    uint8_t     ref;        // hit since the hand last passed
+};
+typedef struct __cache_slot_t       _cache_slot_t;
+
+struct __kvdb_cache_t {
+    kvdb_t          *backing;
+    chashmap_t      *map;   // slot index, by the slot's key
+    _cache_slot_t   *slots;
+    size_t          capacity;
+    size_t          count;
+    size_t          hand;   // CLOCK
+};
+typedef struct __kvdb_cache_t       _kvdb_cache_t;
+
+static const chashmap_type_t _cache_map_type = { sizeof(uint32_t), 0, NULL, NULL };
+
+#define _cache_hash(key)            murmurhash3_32((key)->data, (key)->size, CHASHMAP_SEED)
+#define _slot_val(s)                ((void*)((char*)(s)->key + (s)->key_size))
+
+//===============================================
+// the map keeps slot indexes, keys are compared in the slots
+static int _cache_match_key(void *ctx, const void *probe, const void *key)
+{
+    const _cache_slot_t *s = &(((_kvdb_cache_t*)ctx)->slots[*(const uint32_t*)key]);
+    const kvdbt_t *k = (const kvdbt_t*)probe;
+
+    return s->key_size == k->size && memcmp(s->key, k->data, k->size) == 0;
+}
+
+static int _cache_match_slot(void *ctx, const void *probe, const void *key)
+{
+    (void)ctx;
+
+    return *(const uint32_t*)probe == *(const uint32_t*)key;
+}
+
+static uint32_t* _cache_find(_kvdb_cache_t *cache, const kvdbt_t *key, uint32_t hash)
+{
+    return (uint32_t*)chashmap_find_with(cache->map, hash, _cache_match_key, cache, key);
+}
+
+static void _cache_drop(_kvdb_cache_t *cache, uint32_t i)
+{
+    _cache_slot_t *s = &(cache->slots[i]);
+    void *e = NULL;
+
+    e = chashmap_find_with(cache->map, s->hash, _cache_match_slot, cache, &i);
+    if (e) {
+        chashmap_erase_entry(cache->map, e);
+    }
+
+    free(s->key);
+    memset(s, 0, sizeof(_cache_slot_t));
+    cache->count--;
+}
+
+// a free slot, evicts one if the cache is full
+static uint32_t _cache_victim(_kvdb_cache_t *cache)
+{
+    _cache_slot_t *s = NULL;
+    uint32_t i = 0;
+
+    for (;;) {
+        i = (uint32_t)cache->hand;
+        s = &(cache->slots[i]);
+        cache->hand = (cache->hand + 1) % cache->capacity;
+
+        if (!s->used) {
+            return i;
+        }
+        if (s->ref) {
+            s->ref = 0;
+        } else if (cache->count == cache->capacity) {
+            _cache_drop(cache, i);
+            return i;
+        }
+    }
+}
+
+static int _cache_set(_kvdb_cache_t *cache, const kvdbt_t *key, uint32_t hash, const kvdbt_t *value)
+{
+    uint32_t *pos = NULL;
+    uint32_t i = 0;
+    _cache_slot_t *s = NULL;
+    void *block = NULL;
+
+    block = malloc(key->size + value->size);
+    if (block == NULL) {
+        return -1;
+    }
+    memcpy(block, key->data, key->size);
+    memcpy((char*)block + key->size, value->data, value->size);
+
+    pos = _cache_find(cache, key, hash);
+    if (pos) {
+        s = &(cache->slots[*pos]);
+        free(s->key);
+    } else {
+        i = _cache_victim(cache);
+        if (chashmap_insert_h(cache->map, &i, hash, NULL, NULL) == NULL) {
+            free(block);
+            return -1;
+        }
+        s = &(cache->slots[i]);
+        s->used = 1;
+        s->hash = hash;
+        cache->count++;
+    }
+
+    s->key = block;
+    s->key_size = key->size;
+    s->val_size = value->size;
+    s->ref = 1;
+
+    return 0;
+}
+
+//===============================================
+// kvdb_t
+static int _cache_get(kvdb_t *db, const kvdbt_t *key, kvdbt_t *value)
+{
+    _kvdb_cache_t *cache = (_kvdb_cache_t*)(db->mdl);
+    uint32_t hash = _cache_hash(key);
+    uint32_t *pos = NULL;
+    _cache_slot_t *s = NULL;
+    int ret = 0;
+
+    pos = _cache_find(cache, key, hash);
+    if (pos == NULL) {
+        ret = cache->backing->get(cache->backing, key, value);
+        if (ret == 0) {
+            _cache_set(cache, key, hash, value); // a miss next time, if it fails
+        }
+        return ret;
+    }
+
+    s = &(cache->slots[*pos]);
+    s->ref = 1;
+
+    // no buffer, the cached value, good till the next call
+    if (value->data == NULL) {
+        value->data = _slot_val(s);
+        value->size = s->val_size;
+        return 0;
+    }
+
+    if (value->size < s->val_size) {
+        value->size = s->val_size;
+        return -1;
+    }
+    memcpy(value->data, _slot_val(s), s->val_size);
+    value->size = s->val_size;
+
+    return 0;
+}
+
+static int _cache_put(kvdb_t *db, const kvdbt_t *key, const kvdbt_t *value)
+{
+    _kvdb_cache_t *cache = (_kvdb_cache_t*)(db->mdl);
+    uint32_t hash = _cache_hash(key);
+    uint32_t *pos = NULL;
+    int ret = 0;
+
+    ret = cache->backing->put(cache->backing, key, value);
+    if (ret != 0) {
+        return ret;
+    }
+
+    // a stale entry must not stay
+    if (_cache_set(cache, key, hash, value) < 0) {
+        pos = _cache_find(cache, key, hash);
+        if (pos) {
+            _cache_drop(cache, *pos);
+        }
+    }
+
+    return 0;
+}
+
+static int _cache_del(kvdb_t *db, const kvdbt_t *key)
+{
+    _kvdb_cache_t *cache = (_kvdb_cache_t*)(db->mdl);
+    uint32_t *pos = NULL;
+    int ret = 0;
+
+    ret = cache->backing->del(cache->backing, key);
+    if (ret != 0) {
+        return ret;
+    }
+
+    pos = _cache_find(cache, key, _cache_hash(key));
+    if (pos) {
+        _cache_drop(cache, *pos);
+    }
+
+    return 0;
+}
+
+static int _cache_reset_cursor(kvdb_t *db)
+{
+    _kvdb_cache_t *cache = (_kvdb_cache_t*)(db->mdl);
+
+    return cache->backing->reset_cursor(cache->backing);
+}
+
+static int _cache_traverse(kvdb_t *db, kvdbt_t *key, kvdbt_t *value)
+{
+    _kvdb_cache_t *cache = (_kvdb_cache_t*)(db->mdl);
+
+    return cache->backing->traverse(cache->backing, key, value);
+}
+
+//===============================================
+int kvdb_cache_open(kvdb_t *db, kvdb_t *backing, size_t capacity)
+{
+    _kvdb_cache_t *cache = NULL;
+
+    if (db == NULL || backing == NULL || capacity == 0 || capacity > UINT32_MAX) {
+        return -1;
+    }
+
+    cache = (_kvdb_cache_t*)malloc(sizeof(_kvdb_cache_t));
+    if (cache == NULL) {
+        return -1;
+    }
+    memset(cache, 0, sizeof(_kvdb_cache_t));
+
+    cache->slots = (_cache_slot_t*)calloc(capacity, sizeof(_cache_slot_t));
+    cache->map = chashmap_create(&_cache_map_type, (int64_t)capacity);
+    if (cache->slots == NULL || cache->map == NULL) {
+        free(cache->slots);
+        chashmap_free(cache->map);
+        free(cache);
+        return -1;
+    }
+    cache->backing = backing;
+    cache->capacity = capacity;
+
+    memset(db, 0, sizeof(kvdb_t));
+    db->dbe = backing->dbe;
+    db->mdl = cache;
+    db->name = backing->name;
+    db->get = _cache_get;
+    db->put = _cache_put;
+    db->del = _cache_del;
+    db->reset_cursor = _cache_reset_cursor;
+    db->traverse = _cache_traverse;
+
+    return 0;
+}
+
+// the backing db stays open
+int kvdb_cache_close(kvdb_t *db)
+{
+    _kvdb_cache_t *cache = (_kvdb_cache_t*)(db->mdl);
+    size_t i = 0;
+
+    if (cache == NULL) {
+        return -1;
+    }
+
+    for (i = 0; i < cache->capacity; i++) {
+        free(cache->slots[i].key);
+    }
+    free(cache->slots);
+    chashmap_free(cache->map);
+    free(cache);
+
+    db->mdl = NULL;
+
+    return 0;
+}
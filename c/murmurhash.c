@@ -1,15 +1,8 @@
-#include <stdint.h>
-#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
 #include <time.h>
-
-// Define a struct to hold the 128-bit hash value
-typedef struct {
-    uint64_t h1; // First 64 bits of the hash
-    uint64_t h2; // Second 64 bits of the hash
-} uint128_t;
+#include <murmurhash.h>
 
 // by default: little endian
 #if !defined(_big_endian_)
@@ -30,7 +23,8 @@ uint32_t murmurhash3_32(const void *key, size_t len, uint32_t seed)
     // Process each 4-byte block
     const uint32_t *blocks = (const uint32_t *)(data + nblocks * 4);
     for (i = -nblocks; i; i++) {
-        uint32_t k1 = blocks[i]; // Read a 4-byte block
+        uint32_t k1;
+        memcpy(&k1, &blocks[i], sizeof(k1)); // Read a 4-byte block, keys may be unaligned
 
         // Mix the block
         k1 *= c1;
@@ -50,8 +44,10 @@ uint32_t murmurhash3_32(const void *key, size_t len, uint32_t seed)
     switch (len & 3) { // len % 4
         case 3:
             k1 ^= tail[2] << 16; // Process third byte
+            // fall through
         case 2:
             k1 ^= tail[1] << 8; // Process second byte
+            // fall through
         case 1:
             k1 ^= tail[0]; // Process first byte
             k1 *= c1;
@@ -122,37 +118,51 @@ void murmurhash3_128(const void *key, size_t len, uint32_t seed, uint128_t *out)
     switch (len & 15) { // len % 16
         case 15:
             k2 ^= (uint64_t)tail[14] << 48;
+            // fall through
         case 14:
             k2 ^= (uint64_t)tail[13] << 40;
+            // fall through
         case 13:
             k2 ^= (uint64_t)tail[12] << 32;
+            // fall through
         case 12:
             k2 ^= (uint64_t)tail[11] << 24;
+            // fall through
         case 11:
             k2 ^= (uint64_t)tail[10] << 16;
+            // fall through
         case 10:
             k2 ^= (uint64_t)tail[9] << 8;
+            // fall through
         case 9:
             k2 ^= (uint64_t)tail[8] << 0;
             k2 *= c2;
             k2 = (k2 << 33) | (k2 >> 31); // Rotate left by 33 bits
             k2 *= c1;
             h2 ^= k2;
+            // fall through
 
         case 8:
             k1 ^= (uint64_t)tail[7] << 56;
+            // fall through
         case 7:
             k1 ^= (uint64_t)tail[6] << 48;
+            // fall through
         case 6:
             k1 ^= (uint64_t)tail[5] << 40;
+            // fall through
         case 5:
             k1 ^= (uint64_t)tail[4] << 32;
+            // fall through
         case 4:
             k1 ^= (uint64_t)tail[3] << 24;
+            // fall through
         case 3:
             k1 ^= (uint64_t)tail[2] << 16;
+            // fall through
         case 2:
             k1 ^= (uint64_t)tail[1] << 8;
+            // fall through
         case 1:
             k1 ^= (uint64_t)tail[0] << 0;
             k1 *= c1;
@@ -225,7 +235,8 @@ uint32_t murmurhash3_32(const void *key, size_t len, uint32_t seed)
     // Process each 4-byte block
     const uint32_t *blocks = (const uint32_t *)(data + nblocks * 4);
     for (i = -nblocks; i; i++) {
-        uint32_t k1 = blocks[i]; // Read a 4-byte block
+        uint32_t k1;
+        memcpy(&k1, &blocks[i], sizeof(k1)); // Read a 4-byte block, keys may be unaligned
 
         // Convert big-endian to host byte order
         k1 = big_endian_to_host32(k1);
@@ -391,12 +402,238 @@ void murmurhash3_128(const void *key, size_t len, uint32_t seed, uint128_t *out)
 }
 #endif
 
+//====================================================================
+// streaming
+#if !defined(_big_endian_)
+#define _block32(p, k)      memcpy(&(k), (p), sizeof(uint32_t))
+#define _block64(p, k)      memcpy(&(k), (p), sizeof(uint64_t))
+#else
+#define _block32(p, k)      do { memcpy(&(k), (p), sizeof(uint32_t)); (k) = big_endian_to_host32((k)); } while (0)
+#define _block64(p, k)      do { memcpy(&(k), (p), sizeof(uint64_t)); (k) = big_endian_to_host64((k)); } while (0)
+#endif
+
+void murmurhash3_32_init(murmurhash3_32_state_t *st, uint32_t seed)
+{
+    st->h1 = seed;
+    st->tail_len = 0;
+    st->total = 0;
+}
+
+void murmurhash3_32_update(murmurhash3_32_state_t *st, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint32_t k1 = 0;
+
+    st->total += len;
+
+    // complete the block left over from the last piece
+    if (st->tail_len > 0) {
+        while (len > 0 && st->tail_len < 4) {
+            st->tail[st->tail_len++] = *p++;
+            len--;
+        }
+        if (st->tail_len < 4) {
+            return;
+        }
+        _block32(st->tail, k1);
+        st->h1 = _murmurhash3_32_round(st->h1, k1);
+        st->tail_len = 0;
+    }
+
+    for (; len >= 4; p += 4, len -= 4) {
+        _block32(p, k1);
+        st->h1 = _murmurhash3_32_round(st->h1, k1);
+    }
+
+    memcpy(st->tail, p, len);
+    st->tail_len = (uint32_t)len;
+}
+
+uint32_t murmurhash3_32_final(const murmurhash3_32_state_t *st)
+{
+    uint32_t h1 = st->h1;
+    uint32_t k1 = 0;
+
+    switch (st->tail_len) {
+        case 3:
+            k1 ^= st->tail[2] << 16;
+            // fall through
+        case 2:
+            k1 ^= st->tail[1] << 8;
+            // fall through
+        case 1:
+            k1 ^= st->tail[0];
+            k1 *= 0xcc9e2d51;
+            k1 = (k1 << 15) | (k1 >> 17);
+            k1 *= 0x1b873593;
+            h1 ^= k1;
+    }
+
+    return murmurhash3_fmix32(h1 ^ (uint32_t)st->total);
+}
+
+static inline void _mix128_block(uint64_t *h1, uint64_t *h2, uint64_t k1, uint64_t k2)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+
+    k1 *= c1;
+    k1 = (k1 << 31) | (k1 >> 33);
+    k1 *= c2;
+    *h1 ^= k1;
+
+    *h1 = (*h1 << 27) | (*h1 >> 37);
+    *h1 += *h2;
+    *h1 = *h1 * 5 + 0x52dce729;
+
+    k2 *= c2;
+    k2 = (k2 << 33) | (k2 >> 31);
+    k2 *= c1;
+    *h2 ^= k2;
+
+    *h2 = (*h2 << 31) | (*h2 >> 33);
+    *h2 += *h1;
+    *h2 = *h2 * 5 + 0x38495ab5;
+}
+
+void murmurhash3_128_init(murmurhash3_128_state_t *st, uint32_t seed)
+{
+    st->h1 = seed;
+    st->h2 = seed;
+    st->total = 0;
+    st->tail_len = 0;
+}
+
+void murmurhash3_128_update(murmurhash3_128_state_t *st, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+    size_t n = 0;
+
+    st->total += len;
+
+    // complete the block left over from the last piece
+    if (st->tail_len > 0) {
+        n = 16 - st->tail_len;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(st->tail + st->tail_len, p, n);
+        st->tail_len += (uint32_t)n;
+        p += n;
+        len -= n;
+        if (st->tail_len < 16) {
+            return;
+        }
+        _block64(st->tail, k1);
+        _block64(st->tail + 8, k2);
+        _mix128_block(&st->h1, &st->h2, k1, k2);
+        st->tail_len = 0;
+    }
+
+    for (; len >= 16; p += 16, len -= 16) {
+        _block64(p, k1);
+        _block64(p + 8, k2);
+        _mix128_block(&st->h1, &st->h2, k1, k2);
+    }
+
+    memcpy(st->tail, p, len);
+    st->tail_len = (uint32_t)len;
+}
+
+void murmurhash3_128_final(const murmurhash3_128_state_t *st, uint128_t *out)
+{
+    const uint64_t c1 = 0x87c37b91114253d5ULL;
+    const uint64_t c2 = 0x4cf5ad432745937fULL;
+    const uint8_t *tail = st->tail;
+    uint64_t h1 = st->h1;
+    uint64_t h2 = st->h2;
+    uint64_t k1 = 0;
+    uint64_t k2 = 0;
+
+    switch (st->tail_len) {
+        case 15:
+            k2 ^= (uint64_t)tail[14] << 48;
+            // fall through
+        case 14:
+            k2 ^= (uint64_t)tail[13] << 40;
+            // fall through
+        case 13:
+            k2 ^= (uint64_t)tail[12] << 32;
+            // fall through
+        case 12:
+            k2 ^= (uint64_t)tail[11] << 24;
+            // fall through
+        case 11:
+            k2 ^= (uint64_t)tail[10] << 16;
+            // fall through
+        case 10:
+            k2 ^= (uint64_t)tail[9] << 8;
+            // fall through
+        case 9:
+            k2 ^= (uint64_t)tail[8] << 0;
+            k2 *= c2;
+            k2 = (k2 << 33) | (k2 >> 31);
+            k2 *= c1;
+            h2 ^= k2;
+            // fall through
+
+        case 8:
+            k1 ^= (uint64_t)tail[7] << 56;
+            // fall through
+        case 7:
+            k1 ^= (uint64_t)tail[6] << 48;
+            // fall through
+        case 6:
+            k1 ^= (uint64_t)tail[5] << 40;
+            // fall through
+        case 5:
+            k1 ^= (uint64_t)tail[4] << 32;
+            // fall through
+        case 4:
+            k1 ^= (uint64_t)tail[3] << 24;
+            // fall through
+        case 3:
+            k1 ^= (uint64_t)tail[2] << 16;
+            // fall through
+        case 2:
+            k1 ^= (uint64_t)tail[1] << 8;
+            // fall through
+        case 1:
+            k1 ^= (uint64_t)tail[0] << 0;
+            k1 *= c1;
+            k1 = (k1 << 31) | (k1 >> 33);
+            k1 *= c2;
+            h1 ^= k1;
+    }
+
+    h1 ^= st->total;
+    h2 ^= st->total;
+
+    h1 += h2;
+    h2 += h1;
+
+    h1 = murmurhash3_fmix64(h1);
+    h2 = murmurhash3_fmix64(h2);
+
+    h1 += h2;
+    h2 += h1;
+
+    out->h1 = h1;
+    out->h2 = h2;
+}
+
 int _test_main(int argc, char *argv[])
 {
     const char *str = "Hello, World!";
     uint32_t seed = 42; // Seed value
 
     int choice;
+
+    (void)argc;
+    (void)argv;
+
     printf("Choose MurmurHash3 version:\n");
     printf("1. 32-bit\n");
     printf("2. 128-bit\n");
@@ -0,0 +1,150 @@
+/************************************************************************************
+* murmurhash.h : header file
+*
+* MurmurHash3 Definition header
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+* Copyright (c) 2026. All Rights Reserved.
+*
+************************************************************************************/
+
+#if !defined(__MURMURHASH_H__)
+#define __MURMURHASH_H__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+// Define a struct to hold the 128-bit hash value
+typedef struct {
+    uint64_t h1; // First 64 bits of the hash
+    uint64_t h2; // Second 64 bits of the hash
+} uint128_t;
+
+// streaming state, the key may come in pieces of any size
+typedef struct {
+    uint32_t h1;
+    uint32_t tail_len;  // bytes in tail, less than a block
+    uint64_t total;     // bytes so far
+    uint8_t  tail[4];
+} murmurhash3_32_state_t;
+
+typedef struct {
+    uint64_t h1;
+    uint64_t h2;
+    uint64_t total;     // bytes so far
+    uint32_t tail_len;  // bytes in tail, less than a block
+    uint8_t  tail[16];
+} murmurhash3_128_state_t;
+
+// MurmurHash3 32-bit
+uint32_t murmurhash3_32(const void *key, size_t len, uint32_t seed);
+// MurmurHash3 128-bit, x64 variant
+void murmurhash3_128(const void *key, size_t len, uint32_t seed, uint128_t *out);
+// init, update for every piece, final: the same hash as the one-shot function
+// of all the pieces back to back
+void murmurhash3_32_init(murmurhash3_32_state_t *st, uint32_t seed);
+void murmurhash3_32_update(murmurhash3_32_state_t *st, const void *data, size_t len);
+uint32_t murmurhash3_32_final(const murmurhash3_32_state_t *st);
+void murmurhash3_128_init(murmurhash3_128_state_t *st, uint32_t seed);
+void murmurhash3_128_update(murmurhash3_128_state_t *st, const void *data, size_t len);
+void murmurhash3_128_final(const murmurhash3_128_state_t *st, uint128_t *out);
+
+// MurmurHash3 32-bit of n keys, out[i] == murmurhash3_32(keys[i], lens[i], seed)
+// SIMD lanes where the cpu has them, see murmurhash_batch.c
+void murmurhash3_32_batch(const void *const keys[], const size_t lens[], size_t n, uint32_t seed, uint32_t out[]);
+// kernel in use: "avx512", "avx2" or "scalar"
+const char* murmurhash3_32_batch_isa(void);
+// use kernel isa, NULL for the best the cpu has, -1 if it has no such kernel
+int murmurhash3_32_batch_use(const char *isa);
+
+#if defined(_big_endian_)
+uint32_t big_endian_to_host32(uint32_t value);
+uint64_t big_endian_to_host64(uint64_t value);
+#define _murmurhash_block32(k)          big_endian_to_host32((k))
+#else
+#define _murmurhash_block32(k)          (k)
+#endif
+
+// fixed width keys, inline, the same hash as murmurhash3_32() of the key's bytes
+
+// MurmurHash3 finalizers, full avalanche of one word
+static inline uint32_t murmurhash3_fmix32(uint32_t h)
+{
+    h ^= h >> 16;
+    h *= 0x85ebca6b;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35;
+    h ^= h >> 16;
+
+    return h;
+}
+
+static inline uint64_t murmurhash3_fmix64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+
+    return k;
+}
+
+static inline uint32_t _murmurhash3_32_round(uint32_t h1, uint32_t k1)
+{
+    k1 *= 0xcc9e2d51;
+    k1 = (k1 << 15) | (k1 >> 17);
+    k1 *= 0x1b873593;
+
+    h1 ^= k1;
+    h1 = (h1 << 13) | (h1 >> 19);
+    return h1 * 5 + 0xe6546b64;
+}
+
+// murmurhash3_32(&key, 4, seed)
+static inline uint32_t murmurhash3_32_u32(uint32_t key, uint32_t seed)
+{
+    uint32_t h1 = _murmurhash3_32_round(seed, _murmurhash_block32(key));
+
+    return murmurhash3_fmix32(h1 ^ 4);
+}
+
+// murmurhash3_32(&key, 8, seed)
+static inline uint32_t murmurhash3_32_u64(uint64_t key, uint32_t seed)
+{
+    uint32_t blocks[2];
+    uint32_t h1 = seed;
+
+    memcpy(blocks, &key, sizeof(key));
+    h1 = _murmurhash3_32_round(h1, _murmurhash_block32(blocks[0]));
+    h1 = _murmurhash3_32_round(h1, _murmurhash_block32(blocks[1]));
+
+    return murmurhash3_fmix32(h1 ^ 8);
+}
+
+// murmurhash3_32(key, 16, seed)
+static inline uint32_t murmurhash3_32_128bit(const void *key, uint32_t seed)
+{
+    uint32_t blocks[4];
+    uint32_t h1 = seed;
+
+    memcpy(blocks, key, sizeof(blocks));
+    h1 = _murmurhash3_32_round(h1, _murmurhash_block32(blocks[0]));
+    h1 = _murmurhash3_32_round(h1, _murmurhash_block32(blocks[1]));
+    h1 = _murmurhash3_32_round(h1, _murmurhash_block32(blocks[2]));
+    h1 = _murmurhash3_32_round(h1, _murmurhash_block32(blocks[3]));
+
+    return murmurhash3_fmix32(h1 ^ 16);
+}
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /*__MURMURHASH_H__*/
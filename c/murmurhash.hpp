@@ -0,0 +1,104 @@
+/************************************************************************************
+* murmurhash.hpp : header file
+*
+* MurmurHash3 at compile time
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   constexpr murmurhash3_32, bit for bit the one of murmurhash.c on a
+*   little endian machine. Blocks are put together byte by byte, so it
+*   runs in constant expressions.
+*
+************************************************************************************/
+
+#if !defined(__MURMURHASH_HPP__)
+#define __MURMURHASH_HPP__
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include <murmurhash.h>
+
+namespace murmurhash {
+
+constexpr uint32_t rotl32(uint32_t x, int r) noexcept
+{
+    return (x << r) | (x >> (32 - r));
+}
+
+constexpr uint32_t murmurhash3_32(const char *key, size_t len, uint32_t seed) noexcept
+{
+    const uint32_t c1 = 0xcc9e2d51;
+    const uint32_t c2 = 0x1b873593;
+    const size_t nblocks = len / 4;
+
+    uint32_t h1 = seed;
+    uint32_t k1 = 0;
+    size_t i = 0;
+
+    for (i = 0; i < nblocks; i++) {
+        const char *p = key + i * 4;
+
+        k1 = static_cast<uint32_t>(static_cast<uint8_t>(p[0]))
+            | (static_cast<uint32_t>(static_cast<uint8_t>(p[1])) << 8)
+            | (static_cast<uint32_t>(static_cast<uint8_t>(p[2])) << 16)
+            | (static_cast<uint32_t>(static_cast<uint8_t>(p[3])) << 24);
+
+        k1 *= c1;
+        k1 = rotl32(k1, 15);
+        k1 *= c2;
+
+        h1 ^= k1;
+        h1 = rotl32(h1, 13);
+        h1 = h1 * 5 + 0xe6546b64;
+    }
+
+    const char *tail = key + nblocks * 4;
+    k1 = 0;
+
+    switch (len & 3) {
+        case 3:
+            k1 ^= static_cast<uint32_t>(static_cast<uint8_t>(tail[2])) << 16;
+            [[fallthrough]];
+        case 2:
+            k1 ^= static_cast<uint32_t>(static_cast<uint8_t>(tail[1])) << 8;
+            [[fallthrough]];
+        case 1:
+            k1 ^= static_cast<uint32_t>(static_cast<uint8_t>(tail[0]));
+            k1 *= c1;
+            k1 = rotl32(k1, 15);
+            k1 *= c2;
+            h1 ^= k1;
+    }
+
+    h1 ^= static_cast<uint32_t>(len);
+    h1 ^= h1 >> 16;
+    h1 *= 0x85ebca6b;
+    h1 ^= h1 >> 13;
+    h1 *= 0xc2b2ae35;
+    h1 ^= h1 >> 16;
+
+    return h1;
+}
+
+constexpr uint32_t murmurhash3_32(std::string_view key, uint32_t seed) noexcept
+{
+    return murmurhash3_32(key.data(), key.size(), seed);
+}
+
+// reference values of murmurhash.c
+static_assert(murmurhash3_32("", 0, 0) == 0x00000000u);
+static_assert(murmurhash3_32("", 0, 1) == 0x514e28b7u);
+static_assert(murmurhash3_32("", 0, 0xffffffffu) == 0x81f16f39u);
+static_assert(murmurhash3_32("\xff\xff\xff\xff", 4, 0) == 0x76293b50u);
+static_assert(murmurhash3_32("\x21\x43\x65\x87", 4, 0) == 0xf55b516bu);
+static_assert(murmurhash3_32("\x21\x43\x65", 3, 0) == 0x7e4a8634u);
+static_assert(murmurhash3_32("Hello, world!", 13, 0x9747b28cu) == 0x24884cbau);
+
+} // namespace murmurhash
+
+#endif /*__MURMURHASH_HPP__*/
@@ -0,0 +1,307 @@
+/************************************************************************************
+* murmurhash_batch.c: Implementation File
+*
+* MurmurHash3 32-bit over many keys at once
+*
+* DESCRIPTION:
+*   hashes keys in SIMD lanes, 16 at a time with AVX-512, 8 with AVX2,
+*   one by one elsewhere. The kernel is picked once from the cpu.
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   results are those of murmurhash3_32(), key by key. Lanes of a group
+*   run as long as the longest key of the group, keys of similar length
+*   next to each other go fastest. Blocks are gathered by address, a lane
+*   reads its own key only.
+*
+************************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <murmurhash.h>
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(_big_endian_)
+#define _mm_batch_x86_ // lanes gather by 64-bit key pointers
+#include <immintrin.h>
+#endif
+
+#define _mm_c1_                         0xcc9e2d51
+#define _mm_c2_                         0x1b873593
+
+// keys longer than this go to the scalar function, lane block counts are int32
+#define _mm_lane_len_max_               ((size_t)1 << 30)
+
+typedef void (*_pfn_batch_t)(const void *const keys[], const size_t lens[], size_t n, uint32_t seed, uint32_t out[]);
+
+static void _batch_scalar(const void *const keys[], const size_t lens[], size_t n, uint32_t seed, uint32_t out[])
+{
+    size_t i = 0;
+
+    for (i = 0; i < n; i++) {
+        out[i] = murmurhash3_32(keys[i], lens[i], seed);
+    }
+}
+
+#if defined(_mm_batch_x86_)
+// tail bytes of a key, before mixing, 0 if none
+static inline uint32_t _tail_k1(const void *key, size_t len)
+{
+    const uint8_t *tail = (const uint8_t *)key + (len & ~(size_t)3);
+    uint32_t k1 = 0;
+
+    switch (len & 3) {
+        case 3:
+            k1 ^= tail[2] << 16;
+            // fall through
+        case 2:
+            k1 ^= tail[1] << 8;
+            // fall through
+        case 1:
+            k1 ^= tail[0];
+    }
+
+    return k1;
+}
+
+// lanes hold ints of the group, 0 if the group has to go scalar
+static inline int _group_prepare(const void *const keys[], const size_t lens[], int lanes,
+    int32_t nblocks[], uint32_t tails[], uint32_t lens32[], int32_t *max_blocks)
+{
+    int i = 0;
+
+    *max_blocks = 0;
+    for (i = 0; i < lanes; i++) {
+        if (lens[i] >= _mm_lane_len_max_) {
+            return 0;
+        }
+        nblocks[i] = (int32_t)(lens[i] / 4);
+        tails[i] = _tail_k1(keys[i], lens[i]);
+        lens32[i] = (uint32_t)lens[i];
+        if (nblocks[i] > *max_blocks) {
+            *max_blocks = nblocks[i];
+        }
+    }
+
+    return 1;
+}
+
+//====================================================================
+// AVX2, 8 lanes
+#define _avx2_rotl(x, r)                _mm256_or_si256(_mm256_slli_epi32((x), (r)), _mm256_srli_epi32((x), 32 - (r)))
+
+__attribute__((target("avx2")))
+static inline __m256i _avx2_fmix(__m256i h)
+{
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0x85ebca6b));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 13));
+    h = _mm256_mullo_epi32(h, _mm256_set1_epi32((int)0xc2b2ae35));
+    h = _mm256_xor_si256(h, _mm256_srli_epi32(h, 16));
+
+    return h;
+}
+
+__attribute__((target("avx2")))
+static inline __m256i _avx2_mix_k1(__m256i k)
+{
+    k = _mm256_mullo_epi32(k, _mm256_set1_epi32((int)_mm_c1_));
+    k = _avx2_rotl(k, 15);
+    k = _mm256_mullo_epi32(k, _mm256_set1_epi32((int)_mm_c2_));
+
+    return k;
+}
+
+__attribute__((target("avx2")))
+static void _batch_avx2(const void *const keys[], const size_t lens[], size_t n, uint32_t seed, uint32_t out[])
+{
+    int32_t nblocks[8] __attribute__((aligned(32)));
+    uint32_t tails[8] __attribute__((aligned(32)));
+    uint32_t lens32[8] __attribute__((aligned(32)));
+    int32_t max_blocks = 0;
+    int32_t j = 0;
+    size_t i = 0;
+
+    for (i = 0; i + 8 <= n; i += 8) {
+        if (!_group_prepare(&keys[i], &lens[i], 8, nblocks, tails, lens32, &max_blocks)) {
+            _batch_scalar(&keys[i], &lens[i], 8, seed, &out[i]);
+            continue;
+        }
+
+        __m256i ptr_lo = _mm256_loadu_si256((const __m256i*)&keys[i]);
+        __m256i ptr_hi = _mm256_loadu_si256((const __m256i*)&keys[i + 4]);
+        __m256i nb = _mm256_load_si256((const __m256i*)nblocks);
+        __m256i h = _mm256_set1_epi32((int)seed);
+        __m256i off = _mm256_setzero_si256();
+        __m256i four = _mm256_set1_epi64x(4);
+
+        for (j = 0; j < max_blocks; j++) {
+            // lanes with a block j
+            __m256i active = _mm256_cmpgt_epi32(nb, _mm256_set1_epi32(j));
+            __m128i lo = _mm_setzero_si128();
+            __m128i hi = _mm_setzero_si128();
+
+            lo = _mm256_mask_i64gather_epi32(lo, (const int*)0, _mm256_add_epi64(ptr_lo, off), _mm256_castsi256_si128(active), 1);
+            hi = _mm256_mask_i64gather_epi32(hi, (const int*)0, _mm256_add_epi64(ptr_hi, off), _mm256_extracti128_si256(active, 1), 1);
+            off = _mm256_add_epi64(off, four);
+
+            __m256i k = _avx2_mix_k1(_mm256_set_m128i(hi, lo));
+            __m256i hn = _mm256_xor_si256(h, k);
+            hn = _avx2_rotl(hn, 13);
+            hn = _mm256_add_epi32(_mm256_mullo_epi32(hn, _mm256_set1_epi32(5)), _mm256_set1_epi32((int)0xe6546b64));
+
+            h = _mm256_blendv_epi8(h, hn, active);
+        }
+
+        // a lane without tail bytes mixes in 0, which changes nothing
+        h = _mm256_xor_si256(h, _avx2_mix_k1(_mm256_load_si256((const __m256i*)tails)));
+        h = _mm256_xor_si256(h, _mm256_load_si256((const __m256i*)lens32));
+        h = _avx2_fmix(h);
+
+        _mm256_storeu_si256((__m256i*)&out[i], h);
+    }
+
+    _batch_scalar(&keys[i], &lens[i], n - i, seed, &out[i]);
+}
+
+//====================================================================
+// AVX-512, 16 lanes
+__attribute__((target("avx512f")))
+static inline __m512i _avx512_mix_k1(__m512i k)
+{
+    k = _mm512_mullo_epi32(k, _mm512_set1_epi32((int)_mm_c1_));
+    k = _mm512_rol_epi32(k, 15);
+    k = _mm512_mullo_epi32(k, _mm512_set1_epi32((int)_mm_c2_));
+
+    return k;
+}
+
+__attribute__((target("avx512f")))
+static void _batch_avx512(const void *const keys[], const size_t lens[], size_t n, uint32_t seed, uint32_t out[])
+{
+    int32_t nblocks[16] __attribute__((aligned(64)));
+    uint32_t tails[16] __attribute__((aligned(64)));
+    uint32_t lens32[16] __attribute__((aligned(64)));
+    int32_t max_blocks = 0;
+    int32_t j = 0;
+    size_t i = 0;
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        if (!_group_prepare(&keys[i], &lens[i], 16, nblocks, tails, lens32, &max_blocks)) {
+            _batch_scalar(&keys[i], &lens[i], 16, seed, &out[i]);
+            continue;
+        }
+
+        __m512i ptr_lo = _mm512_loadu_si512((const void*)&keys[i]);
+        __m512i ptr_hi = _mm512_loadu_si512((const void*)&keys[i + 8]);
+        __m512i nb = _mm512_load_si512((const void*)nblocks);
+        __m512i h = _mm512_set1_epi32((int)seed);
+        __m512i off = _mm512_setzero_si512();
+        __m512i four = _mm512_set1_epi64(4);
+
+        for (j = 0; j < max_blocks; j++) {
+            // lanes with a block j
+            __mmask16 active = _mm512_cmpgt_epi32_mask(nb, _mm512_set1_epi32(j));
+            __m256i lo = _mm256_setzero_si256();
+            __m256i hi = _mm256_setzero_si256();
+
+            lo = _mm512_mask_i64gather_epi32(lo, (__mmask8)active, _mm512_add_epi64(ptr_lo, off), (const void*)0, 1);
+            hi = _mm512_mask_i64gather_epi32(hi, (__mmask8)(active >> 8), _mm512_add_epi64(ptr_hi, off), (const void*)0, 1);
+            off = _mm512_add_epi64(off, four);
+
+            __m512i k = _avx512_mix_k1(_mm512_inserti64x4(_mm512_castsi256_si512(lo), hi, 1));
+            __m512i hn = _mm512_rol_epi32(_mm512_xor_si512(h, k), 13);
+            hn = _mm512_add_epi32(_mm512_mullo_epi32(hn, _mm512_set1_epi32(5)), _mm512_set1_epi32((int)0xe6546b64));
+
+            h = _mm512_mask_mov_epi32(h, active, hn);
+        }
+
+        // a lane without tail bytes mixes in 0, which changes nothing
+        h = _mm512_xor_si512(h, _avx512_mix_k1(_mm512_load_si512((const void*)tails)));
+        h = _mm512_xor_si512(h, _mm512_load_si512((const void*)lens32));
+
+        h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 16));
+        h = _mm512_mullo_epi32(h, _mm512_set1_epi32((int)0x85ebca6b));
+        h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 13));
+        h = _mm512_mullo_epi32(h, _mm512_set1_epi32((int)0xc2b2ae35));
+        h = _mm512_xor_si512(h, _mm512_srli_epi32(h, 16));
+
+        _mm512_storeu_si512((void*)&out[i], h);
+    }
+
+    // the rest fits the 8 lanes of AVX2, avx512f implies it
+    _batch_avx2(&keys[i], &lens[i], n - i, seed, &out[i]);
+}
+#endif
+
+//====================================================================
+// dispatch
+static _pfn_batch_t _batch_fn = NULL;
+static const char *_batch_isa = NULL;
+
+// want: kernel name, NULL for the best one, -1 if the cpu has no such kernel
+static int _batch_select(const char *want)
+{
+    _pfn_batch_t fn = _batch_scalar;
+    const char *isa = "scalar";
+
+#if defined(_mm_batch_x86_)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && (want == NULL || strcmp(want, "avx512") == 0)) {
+        fn = _batch_avx512;
+        isa = "avx512";
+    }
+    else if (__builtin_cpu_supports("avx2") && (want == NULL || strcmp(want, "avx2") == 0)) {
+        fn = _batch_avx2;
+        isa = "avx2";
+    }
+#endif
+
+    if (want && strcmp(want, isa) != 0) {
+        return -1;
+    }
+
+    // the same values from any thread, a race only repeats the work
+    _batch_isa = isa;
+    __atomic_store_n(&_batch_fn, fn, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+static void _batch_init(void)
+{
+    // MURMURHASH_BATCH_ISA in the environment picks the kernel, e.g. "scalar" to compare against
+    if (_batch_select(getenv("MURMURHASH_BATCH_ISA")) < 0) {
+        _batch_select(NULL);
+    }
+}
+
+void murmurhash3_32_batch(const void *const keys[], const size_t lens[], size_t n, uint32_t seed, uint32_t out[])
+{
+    _pfn_batch_t fn = __atomic_load_n(&_batch_fn, __ATOMIC_ACQUIRE);
+
+    if (fn == NULL) {
+        _batch_init();
+        fn = _batch_fn;
+    }
+
+    fn(keys, lens, n, seed, out);
+}
+
+const char* murmurhash3_32_batch_isa(void)
+{
+    if (__atomic_load_n(&_batch_fn, __ATOMIC_ACQUIRE) == NULL) {
+        _batch_init();
+    }
+
+    return _batch_isa;
+}
+
+int murmurhash3_32_batch_use(const char *isa)
+{
+    return _batch_select(isa);
+}
@@ -0,0 +1,461 @@
+/************************************************************************************
+* murmurhash_bench.c: Implementation File
+*
+* MurmurHash3 verification, quality & throughput
+*
+* DESCRIPTION:
+*   verify  : reference vectors & the SMHasher verification values, for
+*             the one-shot, streaming, fixed width & batch functions
+*   quality : avalanche (bit flip bias) & bucket distribution
+*   speed   : GB/s & cycles per hash, 1 byte to 1 MB keys, aligned and
+*             unaligned
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* Copyright (c) 2026. All Rights Reserved.
+*
+* REMARKS:
+*   one JSON line per result on stdout, exit status 1 if a check fails.
+*   A _big_endian_ build is verified by running it on a big endian cpu,
+*   the expected values are the same.
+*   usage: murmurhash_bench [verify|quality|speed|all]
+*
+************************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <murmurhash.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define _cycles()                   __rdtsc()
+#define _cycles_unit_               "cycles"
+#else
+#define _cycles()                   _now_ns()
+#define _cycles_unit_               "ns"
+#endif
+
+#define _countof(a)                 ((int)(sizeof(a) / sizeof((a)[0])))
+
+static int _failures = 0;
+static volatile uint32_t _sink = 0; // keeps the timed hashes
+
+static uint64_t _now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static uint64_t _rnd_state = 0x2545f4914f6cdd1dull;
+
+static uint64_t _rnd(void)
+{
+    // xorshift64*, fixed sequence
+    _rnd_state ^= _rnd_state >> 12;
+    _rnd_state ^= _rnd_state << 25;
+    _rnd_state ^= _rnd_state >> 27;
+
+    return _rnd_state * 0x2545f4914f6cdd1dull;
+}
+
+static void _rnd_fill(uint8_t *p, size_t len)
+{
+    size_t i = 0;
+
+    for (i = 0; i < len; i++) {
+        p[i] = (uint8_t)(_rnd() >> 56);
+    }
+}
+
+static void _check(const char *path, const char *what, uint64_t expected, uint64_t got)
+{
+    int ok = (expected == got);
+
+    printf("{\"test\": \"verify\", \"path\": \"%s\", \"case\": \"%s\", \"expected\": \"0x%08llx\", \"got\": \"0x%08llx\", \"ok\": %s}\n",
+        path, what, (unsigned long long)expected, (unsigned long long)got, ok ? "true" : "false");
+    _failures += !ok;
+}
+
+//====================================================================
+// verify
+typedef void (*_pfn_hash_t)(const void *key, size_t len, uint32_t seed, void *out);
+
+static void _x86_32(const void *key, size_t len, uint32_t seed, void *out)
+{
+    uint32_t h = murmurhash3_32(key, len, seed);
+
+    memcpy(out, &h, 4);
+}
+
+static void _x64_128(const void *key, size_t len, uint32_t seed, void *out)
+{
+    uint128_t h;
+
+    murmurhash3_128(key, len, seed, &h);
+    memcpy(out, &h.h1, 8);
+    memcpy((uint8_t*)out + 8, &h.h2, 8);
+}
+
+// streaming, in pieces of 1, 2, 3 ... bytes
+static void _x86_32_stream(const void *key, size_t len, uint32_t seed, void *out)
+{
+    murmurhash3_32_state_t st;
+    size_t off = 0;
+    size_t n = 1;
+    uint32_t h = 0;
+
+    murmurhash3_32_init(&st, seed);
+    for (off = 0; off < len; off += n, n++) {
+        murmurhash3_32_update(&st, (const uint8_t*)key + off, (n < len - off) ? n : len - off);
+    }
+    h = murmurhash3_32_final(&st);
+    memcpy(out, &h, 4);
+}
+
+static void _x64_128_stream(const void *key, size_t len, uint32_t seed, void *out)
+{
+    murmurhash3_128_state_t st;
+    uint128_t h;
+    size_t off = 0;
+    size_t n = 1;
+
+    murmurhash3_128_init(&st, seed);
+    for (off = 0; off < len; off += n, n++) {
+        murmurhash3_128_update(&st, (const uint8_t*)key + off, (n < len - off) ? n : len - off);
+    }
+    murmurhash3_128_final(&st, &h);
+    memcpy(out, &h.h1, 8);
+    memcpy((uint8_t*)out + 8, &h.h2, 8);
+}
+
+// SMHasher VerificationTest(): keys {}, {0}, {0, 1} ... {0 .. 254} with
+// seed 256 - len, the hashes back to back hashed with seed 0, the first
+// 4 bytes of that as a little endian word
+static uint32_t _smhasher_verification(_pfn_hash_t fn, int hashbytes)
+{
+    uint8_t key[256];
+    uint8_t hashes[256 * 16];
+    uint8_t final[16];
+    int i = 0;
+
+    memset(hashes, 0, sizeof(hashes));
+    for (i = 0; i < 256; i++) {
+        key[i] = (uint8_t)i;
+        fn(key, i, 256 - i, &hashes[i * hashbytes]);
+    }
+    fn(hashes, 256 * hashbytes, 0, final);
+
+    return (uint32_t)final[0] | ((uint32_t)final[1] << 8) | ((uint32_t)final[2] << 16) | ((uint32_t)final[3] << 24);
+}
+
+static void _verify_batch(void)
+{
+    static const char *const isas[] = { "scalar", "avx2", "avx512" };
+    enum { _n_ = 1000 };
+    const void *keys[_n_];
+    size_t lens[_n_];
+    uint32_t out[_n_];
+    uint8_t *pool = NULL;
+    char what[64];
+    int i = 0;
+    int k = 0;
+    int bad = 0;
+
+    pool = (uint8_t*)malloc(_n_ * 128);
+    _rnd_fill(pool, _n_ * 128);
+    for (i = 0; i < _n_; i++) {
+        keys[i] = pool + i * 128 + (i & 7); // unaligned too
+        lens[i] = (size_t)(_rnd() % 120);
+    }
+
+    for (k = 0; k < _countof(isas); k++) {
+        if (murmurhash3_32_batch_use(isas[k]) < 0) {
+            printf("{\"test\": \"verify\", \"path\": \"batch_%s\", \"skipped\": \"not on this cpu\"}\n", isas[k]);
+            continue;
+        }
+
+        murmurhash3_32_batch(keys, lens, _n_, 0x9747b28c, out);
+        for (i = 0, bad = 0; i < _n_; i++) {
+            bad += (out[i] != murmurhash3_32(keys[i], lens[i], 0x9747b28c));
+        }
+        snprintf(what, sizeof(what), "batch_%s", isas[k]);
+        _check(what, "1000 keys 0-119 bytes, mismatches", 0, bad);
+    }
+
+    murmurhash3_32_batch_use(NULL);
+    free(pool);
+}
+
+static void _verify(void)
+{
+    static const uint8_t fox[] = "The quick brown fox jumps over the lazy dog";
+    uint8_t buf[64];
+    uint128_t h;
+    uint64_t v = 0;
+    int i = 0;
+    int bad = 0;
+
+    // reference vectors
+    _check("x86_32", "('', 0)", 0x00000000, murmurhash3_32("", 0, 0));
+    _check("x86_32", "('', 1)", 0x514e28b7, murmurhash3_32("", 0, 1));
+    _check("x86_32", "('', 0xffffffff)", 0x81f16f39, murmurhash3_32("", 0, 0xffffffff));
+    _check("x86_32", "(ff ff ff ff, 0)", 0x76293b50, murmurhash3_32("\xff\xff\xff\xff", 4, 0));
+    _check("x86_32", "(21 43 65 87, 0)", 0xf55b516b, murmurhash3_32("\x21\x43\x65\x87", 4, 0));
+    _check("x86_32", "(21 43 65, 0)", 0x7e4a8634, murmurhash3_32("\x21\x43\x65", 3, 0));
+    _check("x86_32", "('Hello, world!', 0x9747b28c)", 0x24884cba, murmurhash3_32("Hello, world!", 13, 0x9747b28c));
+
+    murmurhash3_128("", 0, 0, &h);
+    _check("x64_128", "('', 0) h1", 0, h.h1);
+    _check("x64_128", "('', 0) h2", 0, h.h2);
+    murmurhash3_128(fox, sizeof(fox) - 1, 0, &h);
+    _check("x64_128", "(fox, 0) h1", 0xe34bbc7bbc071b6cull, h.h1);
+    _check("x64_128", "(fox, 0) h2", 0x7a433ca9c49a9347ull, h.h2);
+
+    // SMHasher
+    _check("x86_32", "smhasher verification", 0xb0f57ee3, _smhasher_verification(_x86_32, 4));
+    _check("x64_128", "smhasher verification", 0x6384ba69, _smhasher_verification(_x64_128, 16));
+    _check("x86_32_stream", "smhasher verification", 0xb0f57ee3, _smhasher_verification(_x86_32_stream, 4));
+    _check("x64_128_stream", "smhasher verification", 0x6384ba69, _smhasher_verification(_x64_128_stream, 16));
+
+    // fixed width, against the one-shot function
+    for (i = 0, bad = 0; i < 100000; i++) {
+        uint32_t seed = (uint32_t)_rnd();
+        uint32_t a = (uint32_t)_rnd();
+
+        v = _rnd();
+        _rnd_fill(buf, 16);
+        bad += (murmurhash3_32_u32(a, seed) != murmurhash3_32(&a, 4, seed));
+        bad += (murmurhash3_32_u64(v, seed) != murmurhash3_32(&v, 8, seed));
+        bad += (murmurhash3_32_128bit(buf + (i & 7), seed) != murmurhash3_32(buf + (i & 7), 16, seed));
+    }
+    _check("fixed_width", "u32/u64/128bit, mismatches", 0, bad);
+
+    _verify_batch();
+}
+
+//====================================================================
+// quality
+// worst bias over all (input bit, output bit) pairs: |2 * P(flip) - 1|,
+// 0 is ideal, SMHasher fails above 0.01
+static void _avalanche(const char *path, _pfn_hash_t fn, int hashbytes, int keybytes, int reps)
+{
+    uint32_t *flips = NULL;
+    uint8_t key[64];
+    uint8_t h0[16];
+    uint8_t h1[16];
+    int inbits = keybytes * 8;
+    int outbits = hashbytes * 8;
+    int r = 0;
+    int i = 0;
+    int o = 0;
+    double worst = 0;
+    double bias = 0;
+
+    flips = (uint32_t*)calloc((size_t)inbits * outbits, sizeof(uint32_t));
+
+    for (r = 0; r < reps; r++) {
+        _rnd_fill(key, keybytes);
+        fn(key, keybytes, 0, h0);
+        for (i = 0; i < inbits; i++) {
+            key[i / 8] ^= (uint8_t)(1 << (i % 8));
+            fn(key, keybytes, 0, h1);
+            key[i / 8] ^= (uint8_t)(1 << (i % 8));
+            for (o = 0; o < outbits; o++) {
+                flips[i * outbits + o] += ((h0[o / 8] ^ h1[o / 8]) >> (o % 8)) & 1;
+            }
+        }
+    }
+
+    for (i = 0; i < inbits * outbits; i++) {
+        bias = fabs(2.0 * flips[i] / reps - 1.0);
+        if (bias > worst) {
+            worst = bias;
+        }
+    }
+
+    printf("{\"test\": \"avalanche\", \"path\": \"%s\", \"key_bytes\": %d, \"reps\": %d, \"worst_bias\": %.5f, \"ok\": %s}\n",
+        path, keybytes, reps, worst, worst < 0.01 ? "true" : "false");
+    _failures += (worst >= 0.01);
+
+    free(flips);
+}
+
+// sequential & random keys into 2^bits buckets by the low bits,
+// chi-square over its expected value, about 1.0 for a good hash
+static void _distribution(const char *what, int sequential, int keybytes)
+{
+    enum { _bits_ = 16, _keys_ = 1 << 22 };
+    uint32_t *buckets = NULL;
+    uint8_t key[32];
+    uint64_t v = 0;
+    double expect = (double)_keys_ / (1 << _bits_);
+    double chi = 0;
+    double ratio = 0;
+    int i = 0;
+
+    buckets = (uint32_t*)calloc(1 << _bits_, sizeof(uint32_t));
+    memset(key, 0, sizeof(key));
+
+    for (i = 0; i < _keys_; i++) {
+        if (sequential) {
+            v = (uint64_t)i;
+            memcpy(key, &v, sizeof(v));
+        }
+        else {
+            _rnd_fill(key, keybytes);
+        }
+        buckets[murmurhash3_32(key, keybytes, 0) & ((1 << _bits_) - 1)]++;
+    }
+
+    for (i = 0; i < (1 << _bits_); i++) {
+        chi += (buckets[i] - expect) * (buckets[i] - expect) / expect;
+    }
+    ratio = chi / ((1 << _bits_) - 1);
+
+    printf("{\"test\": \"distribution\", \"path\": \"x86_32\", \"keys\": \"%s\", \"key_bytes\": %d, \"buckets\": %d, \"chi2_ratio\": %.4f, \"ok\": %s}\n",
+        what, keybytes, 1 << _bits_, ratio, (ratio < 1.05) ? "true" : "false");
+    _failures += (ratio >= 1.05);
+
+    free(buckets);
+}
+
+static void _quality(void)
+{
+    static const int keybytes[] = { 4, 8, 16 };
+    int i = 0;
+
+    for (i = 0; i < _countof(keybytes); i++) {
+        _avalanche("x86_32", _x86_32, 4, keybytes[i], 300000);
+        _avalanche("x64_128", _x64_128, 16, keybytes[i], 300000);
+    }
+
+    _distribution("sequential", 1, 8);
+    _distribution("random", 0, 8);
+    _distribution("random", 0, 24);
+}
+
+//====================================================================
+// speed
+static void _speed_one(const char *path, _pfn_hash_t fn, const uint8_t *buf, size_t len, int aligned)
+{
+    uint8_t out[16];
+    uint64_t iters = 0;
+    uint64_t n = 0;
+    uint64_t t0 = 0;
+    uint64_t c0 = 0;
+    uint64_t ns = 0;
+    uint64_t cycles = 0;
+
+    // about 0.1s per case, at least 3 rounds
+    iters = 1 + (64ull << 20) / (len + 16);
+    t0 = _now_ns();
+    c0 = _cycles();
+    for (;;) {
+        for (n = 0; n < iters; n++) {
+            fn(buf, len, (uint32_t)n, out);
+            _sink += out[0];
+        }
+        ns = _now_ns() - t0;
+        cycles = _cycles() - c0;
+        if (ns >= 100000000ull) {
+            break;
+        }
+        iters *= 2;
+        t0 = _now_ns();
+        c0 = _cycles();
+    }
+
+    printf("{\"test\": \"speed\", \"path\": \"%s\", \"key_bytes\": %zu, \"aligned\": %s, \"gb_s\": %.3f, \"%s_hash\": %.1f}\n",
+        path, len, aligned ? "true" : "false", (double)len * iters / ns, _cycles_unit_, (double)cycles / iters);
+    fflush(stdout);
+}
+
+static void _speed_batch(size_t len)
+{
+    enum { _n_ = 4096 };
+    static const void *keys[_n_];
+    static size_t lens[_n_];
+    static uint32_t out[_n_];
+    uint8_t *pool = NULL;
+    uint64_t iters = 0;
+    uint64_t n = 0;
+    uint64_t t0 = 0;
+    uint64_t c0 = 0;
+    uint64_t ns = 0;
+    uint64_t cycles = 0;
+    int i = 0;
+
+    pool = (uint8_t*)malloc(_n_ * (len + 1));
+    _rnd_fill(pool, _n_ * (len + 1));
+    for (i = 0; i < _n_; i++) {
+        keys[i] = pool + i * (len + 1);
+        lens[i] = len;
+    }
+
+    for (iters = 16; ; iters *= 2) {
+        t0 = _now_ns();
+        c0 = _cycles();
+        for (n = 0; n < iters; n++) {
+            murmurhash3_32_batch(keys, lens, _n_, (uint32_t)n, out);
+            _sink += out[0];
+        }
+        ns = _now_ns() - t0;
+        cycles = _cycles() - c0;
+        if (ns >= 100000000ull) {
+            break;
+        }
+    }
+
+    printf("{\"test\": \"speed\", \"path\": \"batch_%s\", \"key_bytes\": %zu, \"aligned\": false, \"gb_s\": %.3f, \"%s_hash\": %.1f}\n",
+        murmurhash3_32_batch_isa(), len, (double)len * iters * _n_ / ns, _cycles_unit_, (double)cycles / (iters * _n_));
+    fflush(stdout);
+    free(pool);
+}
+
+static void _speed(void)
+{
+    size_t len = 0;
+    uint8_t *buf = NULL;
+
+    buf = (uint8_t*)aligned_alloc(64, (1 << 20) + 64);
+    _rnd_fill(buf, (1 << 20) + 64);
+
+    for (len = 1; len <= (1 << 20); len *= 4) {
+        _speed_one("x86_32", _x86_32, buf, len, 1);
+        _speed_one("x86_32", _x86_32, buf + 1, len, 0);
+        _speed_one("x64_128", _x64_128, buf, len, 1);
+        _speed_one("x64_128", _x64_128, buf + 1, len, 0);
+        _speed_one("x86_32_stream", _x86_32_stream, buf, len, 1);
+    }
+
+    for (len = 4; len <= 64; len *= 2) {
+        _speed_batch(len);
+    }
+
+    free(buf);
+}
+
+//gcc -O2 -I. murmurhash_bench.c murmurhash.c murmurhash_batch.c -o murmurhash_bench -lm
+int main(int argc, char *arg[])
+{
+    const char *what = (argc > 1 ? arg[1] : "all");
+    int all = (strcmp(what, "all") == 0);
+
+    if (all || strcmp(what, "verify") == 0) {
+        _verify();
+    }
+    if (all || strcmp(what, "quality") == 0) {
+        _quality();
+    }
+    if (all || strcmp(what, "speed") == 0) {
+        _speed();
+    }
+
+    return (_failures > 0);
+}
@@ -0,0 +1,125 @@
+/************************************************************************************
+* chashmap_test.c: Implementation File
+*
+* chashmap regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   random operations against a shadow array, & a map kept at a fixed
+*   size under insert/erase churn, whose overflow bits must not pile up.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <chashmap.h>
+#include "ctest.h"
+
+//gcc -O2 -I.. chashmap_test.c ../chashmap.c ../murmurhash.c -o chashmap_test
+
+static uint64_t _rnd_state = 0x9e3779b97f4a7c15ull;
+
+static uint64_t _rnd(void)
+{
+    _rnd_state ^= _rnd_state >> 12;
+    _rnd_state ^= _rnd_state << 25;
+    _rnd_state ^= _rnd_state >> 27;
+
+    return _rnd_state * 0x2545f4914f6cdd1dull;
+}
+
+static const chashmap_type_t _u64_type = { sizeof(uint64_t), sizeof(uint64_t), NULL, NULL };
+
+// keys 0 .. range-1, present[] says which are in the map
+static void _test_shadow(void)
+{
+    const int64_t range = 5000;
+    chashmap_t *map = chashmap_create(&_u64_type, 0);
+    uint8_t *present = (uint8_t*)calloc(range, 1);
+    int64_t count = 0;
+    int64_t i = 0;
+    int64_t pos = 0;
+    uint64_t key = 0;
+    uint64_t val = 0;
+    int inserted = 0;
+    void *e = NULL;
+
+    for (i = 0; i < 400000; i++) {
+        key = _rnd() % range;
+        val = key * 3;
+        if (_rnd() & 1) {
+            e = chashmap_insert(map, &key, &val, &inserted);
+            CTEST_CHECK(e != NULL && inserted == !present[key]);
+            count += !present[key];
+            present[key] = 1;
+        } else {
+            CTEST_CHECK(chashmap_erase(map, &key) == (present[key] ? 0 : -1));
+            count -= present[key];
+            present[key] = 0;
+        }
+    }
+
+    CTEST_CHECK(chashmap_count(map) == count);
+    for (key = 0; key < (uint64_t)range; key++) {
+        e = chashmap_find(map, &key);
+        CTEST_CHECK((e != NULL) == present[key]);
+        CTEST_CHECK(e == NULL || *(uint64_t*)chashmap_entry_val(map, e) == key * 3);
+    }
+
+    for (i = 0, e = chashmap_first(map, &pos); e; e = chashmap_next(map, &pos)) {
+        i++;
+    }
+    CTEST_CHECK(i == count);
+
+    free(present);
+    chashmap_free(map);
+}
+
+// a cache like map: full at its size, the oldest key goes for each new one
+static void _test_churn(void)
+{
+    const int64_t n = 50000;
+    chashmap_t *map = chashmap_create(&_u64_type, n);
+    int64_t groups = map->group_mask + 1;
+    int64_t filled = 0;
+    int64_t peak = 0;
+    uint64_t key = 0;
+    int64_t i = 0;
+
+    for (key = 0; key < (uint64_t)n; key++) {
+        chashmap_insert(map, &key, &key, NULL);
+    }
+    filled = map->overflow_groups;
+
+    for (i = 0; i < 40 * n; i++, key++) {
+        uint64_t old = key - (uint64_t)n;
+
+        CTEST_CHECK(chashmap_erase(map, &old) == 0);
+        chashmap_insert(map, &key, &key, NULL);
+        if (map->overflow_groups > peak) {
+            peak = map->overflow_groups;
+        }
+    }
+
+    CTEST_CHECK(chashmap_count(map) == n);
+    CTEST_CHECK(map->group_mask + 1 == groups);
+    for (i = 0; i < n; i++) {
+        uint64_t k = key - 1 - (uint64_t)i;
+        CTEST_CHECK(chashmap_find(map, &k) != NULL);
+    }
+    // stale overflow bits set it in every group, a miss then probed them all
+    CTEST_CHECK(peak < groups * 3 / 4);
+    CTEST_CHECK(map->overflow_groups <= filled * 2);
+
+    chashmap_free(map);
+}
+
+int main(void)
+{
+    _test_shadow();
+    _test_churn();
+
+    return ctest_result("chashmap_test");
+}
@@ -0,0 +1,159 @@
+/************************************************************************************
+* cjson_alloc_test.c: Implementation File
+*
+* allocator regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   slab blocks are distinct & reused, blocks freed by another thread come
+*   back to their slab, the counters of all threads add up in the stats.
+*
+************************************************************************************/
+
+#include <string.h>
+#include <pthread.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_alloc_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_alloc_test -lpthread -lm
+
+#define _block_amount_                  4096
+#define _block_size_                    40
+
+static void* _blocks[_block_amount_];
+
+// slabs are 64KB, aligned to it
+#define _slab_base(p)                   ((uintptr_t)(p) & ~((uintptr_t)64 * 1024 - 1))
+
+// allocators of their own, more than the slots of a thread
+#define _extra_amount_                  12
+
+static void* _extra_alloc(void *ctx, size_t size)
+{
+    (void)ctx;
+
+    return malloc(size);
+}
+
+static void _extra_free(void *ctx, void *p, size_t size)
+{
+    (void)ctx;
+    (void)size;
+
+    free(p);
+}
+
+static void* _free_routine(void *arg)
+{
+    int64_t i = 0;
+
+    (void)arg;
+
+    for (i = 0; i < _block_amount_; i++) {
+        cjson_free(cjson_slab_allocator(), _blocks[i], _block_size_);
+    }
+
+    return NULL;
+}
+
+static void _test_slab(void)
+{
+    int64_t i = 0;
+    int64_t j = 0;
+    int64_t reused = 0;
+    int64_t intact = 0;
+    void *again[_block_amount_];
+    cjson_allocator_t *a = cjson_slab_allocator();
+    cjson_alloc_stats_t before;
+    cjson_alloc_stats_t after;
+    pthread_t thread;
+
+    cjson_allocator_stats(a, &before);
+
+    for (i = 0; i < _block_amount_; i++) {
+        _blocks[i] = cjson_alloc(a, _block_size_);
+        CTEST_CHECK(_blocks[i] != NULL);
+        memset(_blocks[i], (int)i, _block_size_);
+    }
+    // no block handed out twice, none overwritten
+    for (i = 0; i < _block_amount_; i++) {
+        for (j = 0; j < _block_size_ && ((unsigned char*)_blocks[i])[j] == (unsigned char)i; j++) {
+        }
+        intact += (j == _block_size_);
+    }
+    CTEST_CHECK(intact == _block_amount_);
+
+    cjson_allocator_stats(a, &after);
+    CTEST_CHECK(after.allocs - before.allocs == _block_amount_);
+    CTEST_CHECK(after.live_bytes - before.live_bytes == _block_amount_ * _block_size_);
+
+    // freed by another thread, counted there
+    CTEST_CHECK(pthread_create(&thread, NULL, _free_routine, NULL) == 0);
+    pthread_join(thread, NULL);
+
+    cjson_allocator_stats(a, &after);
+    CTEST_CHECK(after.frees - before.frees == _block_amount_);
+    CTEST_CHECK(after.live_bytes == before.live_bytes);
+
+    // the remote frees come back to this thread's slabs, no new slab
+    for (i = 0; i < _block_amount_; i++) {
+        again[i] = cjson_alloc(a, _block_size_);
+        for (j = 0; j < _block_amount_; j++) {
+            if (_slab_base(again[i]) == _slab_base(_blocks[j])) {
+                reused++;
+                break;
+            }
+        }
+    }
+    CTEST_CHECK(reused == _block_amount_);
+
+    for (i = 0; i < _block_amount_; i++) {
+        cjson_free(a, again[i], _block_size_);
+    }
+
+    // past the slab classes
+    again[0] = cjson_alloc(a, 4096);
+    again[0] = cjson_realloc(a, again[0], 4096, 16);
+    CTEST_CHECK(again[0] != NULL);
+    cjson_free(a, again[0], 16);
+
+    cjson_allocator_stats(a, &after);
+    CTEST_CHECK(after.live_bytes == before.live_bytes);
+    CTEST_CHECK(cjson_alloc_usable(a, 33) == 48);
+}
+
+static void _test_extra(void)
+{
+    int i = 0;
+    int64_t live = cjson_memory_live();
+    void *p[_extra_amount_];
+    cjson_allocator_t extra[_extra_amount_];
+    cjson_alloc_stats_t stats;
+
+    memset(extra, 0, sizeof(extra));
+
+    for (i = 0; i < _extra_amount_; i++) {
+        extra[i].alloc = _extra_alloc;
+        extra[i].free = _extra_free;
+        p[i] = cjson_alloc(&(extra[i]), 100 + i);
+        p[i] = cjson_realloc(&(extra[i]), p[i], 100 + i, 200 + i);
+    }
+    CTEST_CHECK(cjson_memory_live() - live == _extra_amount_ * 200 + _extra_amount_ * (_extra_amount_ - 1) / 2);
+
+    for (i = 0; i < _extra_amount_; i++) {
+        cjson_allocator_stats(&(extra[i]), &stats);
+        CTEST_CHECK(stats.allocs == 2 && stats.frees == 1 && stats.bytes == 300 + 2 * i && stats.live_bytes == 200 + i);
+        cjson_free(&(extra[i]), p[i], 200 + i);
+    }
+    CTEST_CHECK(cjson_memory_live() == live);
+}
+
+int main(void)
+{
+    _test_slab();
+    _test_extra();
+
+    return ctest_result("cjson_alloc_test");
+}
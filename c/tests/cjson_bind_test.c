@@ -0,0 +1,173 @@
+/************************************************************************************
+* cjson_bind_test.c: Implementation File
+*
+* direct binding regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   field ranges, string escapes & buffer sizes, nested objects, & field
+*   tables a perfect hash can't be built for.
+*
+************************************************************************************/
+
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_bind_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_bind_test -lpthread -lm
+
+struct __test_addr_t {
+    char            city[8];
+    int32_t         zip;
+};
+typedef struct __test_addr_t        _test_addr_t;
+
+struct __test_user_t {
+    int64_t         id;
+    int32_t         age;
+    char            name[16];
+    double          score;
+    int             active;
+    cjson_number_t  price;
+    _test_addr_t    addr;
+};
+typedef struct __test_user_t        _test_user_t;
+
+static const cjson_field_t _addr_fields[] = {
+    CJSON_FIELD(_test_addr_t, city, _cjson_field_string_),
+    CJSON_FIELD(_test_addr_t, zip, _cjson_field_int32_),
+};
+
+static cjson_binding_t* _user_binding(cjson_binding_t *addr)
+{
+    cjson_field_t fields[] = {
+        CJSON_FIELD(_test_user_t, id, _cjson_field_int64_),
+        CJSON_FIELD(_test_user_t, age, _cjson_field_int32_),
+        CJSON_FIELD(_test_user_t, name, _cjson_field_string_),
+        CJSON_FIELD(_test_user_t, score, _cjson_field_double_),
+        CJSON_FIELD(_test_user_t, active, _cjson_field_bool_),
+        CJSON_FIELD(_test_user_t, price, _cjson_field_number_),
+        CJSON_FIELD_OBJECT(_test_user_t, addr, addr),
+    };
+    static cjson_field_t kept[7];
+
+    memcpy(kept, fields, sizeof(fields));
+
+    return cjson_binding_compile(kept, 7);
+}
+
+static int64_t _bind(const cjson_binding_t *b, const tchar_t *text, _test_user_t *u)
+{
+    memset(u, 0, sizeof(_test_user_t));
+
+    return cjson_bind(b, text, u);
+}
+
+static void _test_values(const cjson_binding_t *b)
+{
+    const tchar_t *text = _T("{\"id\": 9007199254740993, \"age\": -41.9, \"name\": \"a\\\"b\\\\c\\n\", \"score\": 2.5,")
+        _T(" \"active\": true, \"price\": 19.99, \"x\": [1, {\"y\": \"}\"}], \"addr\": {\"city\": \"NYC\", \"zip\": 10001}} tail");
+    _test_user_t u;
+
+    CTEST_CHECK(_bind(b, text, &u) == (int64_t)(strlen(text) - 5));
+    CTEST_CHECK(u.id == 9007199254740993ll);
+    CTEST_CHECK(u.age == -41);
+    CTEST_CHECK(strcmp(u.name, "a\"b\\c\n") == 0);
+    CTEST_CHECK(u.score == 2.5);
+    CTEST_CHECK(u.active == 1);
+    CTEST_CHECK(u.price.number == 1999 && u.price.divisor == 100);
+    CTEST_CHECK(strcmp(u.addr.city, "NYC") == 0 && u.addr.zip == 10001);
+}
+
+static void _test_ranges(const cjson_binding_t *b)
+{
+    _test_user_t u;
+
+    CTEST_CHECK(_bind(b, _T("{\"age\": 2147483647}"), &u) > 0 && u.age == INT32_MAX);
+    CTEST_CHECK(_bind(b, _T("{\"age\": -2147483648}"), &u) > 0 && u.age == INT32_MIN);
+    CTEST_CHECK(_bind(b, _T("{\"age\": 2147483648}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"age\": -2147483649}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"age\": 4294967296}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"age\": 1e10}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"addr\": {\"zip\": 3000000000}}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"id\": 9223372036854775807}"), &u) > 0 && u.id == INT64_MAX);
+    CTEST_CHECK(_bind(b, _T("{\"id\": 9223372036854775808}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"id\": 1e19}"), &u) < 0);
+}
+
+static void _test_strings(const cjson_binding_t *b)
+{
+    _test_user_t u;
+
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\/\\b\\f\\r\\t\"}"), &u) > 0 && strcmp(u.name, "/\b\f\r\t") == 0);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"caf\\u00e9 \\u20ac\"}"), &u) > 0 && strcmp(u.name, "caf\xc3\xa9 \xe2\x82\xac") == 0);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\ud83d\\ude00\"}"), &u) > 0 && strcmp(u.name, "\xf0\x9f\x98\x80") == 0);
+
+    // 15 chars & the '\0' fit, escapes count once decoded
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"0123456789abcdef\"}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"0123456789abcde\"}"), &u) > 0 && strlen(u.name) == 15);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\u0041\\u0042\\u0043\\u0044\\u0045\\u0046\\u0047\\u0048\"}"), &u) > 0 && strcmp(u.name, "ABCDEFGH") == 0);
+    CTEST_CHECK(_bind(b, _T("{\"addr\": {\"city\": \"\\u20ac\\u20ac\\u20ac\"}}"), &u) < 0);
+
+    // bad escapes
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\x\"}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\u12g4\"}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\ud83d\"}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\ude00\"}"), &u) < 0);
+    CTEST_CHECK(_bind(b, _T("{\"name\": \"\\u00\"}"), &u) < 0);
+}
+
+static void _test_compile(void)
+{
+    struct {
+        int32_t     a;
+        int32_t     b;
+    } s;
+    cjson_field_t dup[] = {
+        { _T("a"), _cjson_field_int32_, 0, sizeof(s.a), NULL },
+        { _T("b"), _cjson_field_int32_, sizeof(s.a), sizeof(s.b), NULL },
+        { _T("a"), _cjson_field_int32_, sizeof(s.a), sizeof(s.b), NULL },
+    };
+    static cjson_field_t many[20000];
+    static tchar_t names[20000][8];
+    cjson_binding_t *b = NULL;
+    int i = 0;
+
+    CTEST_CHECK(cjson_binding_compile(dup, 3) == NULL);
+    CTEST_CHECK(cjson_binding_compile(dup, 0) == NULL);
+
+    for (i = 0; i < 20000; i++) {
+        snprintf(names[i], sizeof(names[i]), "f%d", i);
+        many[i].name = names[i];
+        many[i].type = _cjson_field_int32_;
+        many[i].size = sizeof(int32_t);
+    }
+    b = cjson_binding_compile(many, 1000);
+    CTEST_CHECK(b != NULL);
+    cjson_binding_free(b);
+
+    // more than the largest table can separate: NULL, not a 16G table
+    CTEST_CHECK(cjson_binding_compile(many, 20000) == NULL);
+
+    many[999].name = names[3];
+    CTEST_CHECK(cjson_binding_compile(many, 1000) == NULL);
+}
+
+int main(void)
+{
+    cjson_binding_t *addr = cjson_binding_compile(_addr_fields, 2);
+    cjson_binding_t *user = _user_binding(addr);
+
+    CTEST_CHECK(addr != NULL && user != NULL);
+    _test_values(user);
+    _test_ranges(user);
+    _test_strings(user);
+    _test_compile();
+
+    cjson_binding_free(user);
+    cjson_binding_free(addr);
+
+    return ctest_result("cjson_bind_test");
+}
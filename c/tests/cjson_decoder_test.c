@@ -0,0 +1,71 @@
+/************************************************************************************
+* cjson_decoder_test.c: Implementation File
+*
+* decoder regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   a document cut short anywhere is rejected, the decoder never reads past
+*   the '\0' that ends it.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_decoder_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_decoder_test -lpthread -lm
+
+static const tchar_t *_doc_text = _T("{\"a\": 1, \"b\": [1, [2, {}], {\"c\": \"s\"}], \"d\": {\"e\": null, \"f\": [true]}}");
+
+// 0 if text decodes, -1 if not
+static int _decode(const tchar_t *text, int flags)
+{
+    cjson_decode_opt_t opt;
+    cjson_t json;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.flags = flags;
+
+    if (cjson_decode_ex(text, &json, &opt) < 0) {
+        return -1;
+    }
+    cjson_object_free(json.object);
+
+    return 0;
+}
+
+// every prefix of the document, in a buffer of its own length
+static void _test_prefixes(int flags)
+{
+    int64_t n = 0;
+    int64_t len = (int64_t)strlen(_doc_text);
+    tchar_t *text = NULL;
+
+    CTEST_CHECK(_decode(_doc_text, flags) == 0);
+
+    for (n = 1; n < len; n++) {
+        text = (tchar_t*)malloc((n + 1) * sizeof(tchar_t));
+        memcpy(text, _doc_text, n * sizeof(tchar_t));
+        text[n] = _T('\0');
+        CTEST_CHECK(_decode(text, flags) < 0);
+        free(text);
+    }
+}
+
+int main(void)
+{
+    CTEST_CHECK(_decode(_T("{\"a\":1"), 0) < 0);
+    CTEST_CHECK(_decode(_T("{\"a\":[1"), 0) < 0);
+    CTEST_CHECK(_decode(_T("{\"a\":[1}"), 0) < 0);
+    CTEST_CHECK(_decode(_T("{\"a\":{}"), 0) < 0);
+    CTEST_CHECK(_decode(_T("{\"a\":1}"), 0) == 0);
+
+    _test_prefixes(0);
+    _test_prefixes(CJSON_DECODE_SPANS);
+
+    return ctest_result("cjson_decoder_test");
+}
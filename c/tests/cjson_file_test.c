@@ -0,0 +1,109 @@
+/************************************************************************************
+* cjson_file_test.c: Implementation File
+*
+* file decoder regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   files of a page size multiple end at the zero page after the mapping,
+*   empty, truncated & missing files fail without a document.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_file_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_file_test -lpthread -lm
+
+static const int _flags[] = {
+    0, CJSON_FILE_SEQUENTIAL, CJSON_FILE_POPULATE, CJSON_FILE_PREFETCH, CJSON_FILE_HUGEPAGE | CJSON_FILE_SEQUENTIAL,
+};
+
+// len bytes of text, padded with spaces before the closing '}' when text
+// is shorter, to a file. Return its path in path
+static int _write_file(char *path, const char *text, size_t len)
+{
+    int fd = -1;
+    size_t n = strlen(text);
+    char *buf = (char*)malloc(len + 1);
+
+    strcpy(path, "/tmp/cjson_file_test_XXXXXX");
+    fd = mkstemp(path);
+    if (fd < 0 || buf == NULL) {
+        free(buf);
+        return -1;
+    }
+
+    if (n >= len) {
+        memcpy(buf, text, len);
+    } else {
+        memcpy(buf, text, n - 1);
+        memset(buf + n - 1, ' ', len - n);
+        buf[len - 1] = '}';
+    }
+
+    n = (size_t)write(fd, buf, len);
+    close(fd);
+    free(buf);
+
+    return (n == len ? 0 : -1);
+}
+
+// decodes the file of len bytes of text with every flag, 1 if all agree with ok
+static int _decode(const char *text, size_t len, int ok)
+{
+    int ret = 1;
+    size_t i = 0;
+    char path[64];
+    cjson_t json;
+
+    if (_write_file(path, text, len) < 0) {
+        return 0;
+    }
+
+    for (i = 0; i < sizeof(_flags) / sizeof(_flags[0]); i++) {
+        json.object = (cjson_object_t*)path; // must be reset
+        if (cjson_decode_file(path, &json, _flags[i]) == 0) {
+            ret = ret && ok && json.object != NULL && cjson_object_get_value(json.object, _T("a")) != NULL;
+            cjson_object_free(json.object);
+        } else {
+            ret = ret && !ok && json.object == NULL;
+        }
+    }
+
+    unlink(path);
+
+    return ret;
+}
+
+int main(void)
+{
+    const char *text = "{\"a\": [1, 2, 3], \"s\": \"a string that the file cuts\"}";
+    size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+    cjson_t json;
+
+    CTEST_CHECK(_decode(text, strlen(text), 1));
+
+    // the last byte of the file is the last of a page
+    CTEST_CHECK(_decode(text, page_size, 1));
+    CTEST_CHECK(_decode(text, page_size * 3, 1));
+    CTEST_CHECK(_decode(text, page_size - 1, 1));
+    CTEST_CHECK(_decode(text, page_size + 1, 1));
+
+    CTEST_CHECK(_decode(text, 0, 0));
+    // cut in the string
+    CTEST_CHECK(_decode(text, strlen(text) - 10, 0));
+    // cut after a value, {"a": [1, 2, 3] & {"a": [1, 2
+    CTEST_CHECK(_decode(text, 15, 0));
+    CTEST_CHECK(_decode(text, 11, 0));
+
+    CTEST_CHECK(cjson_decode_file("/nonexistent/cjson_file_test.json", &json, 0) < 0 && json.object == NULL);
+    CTEST_CHECK(cjson_decode_file(NULL, &json, 0) < 0);
+
+    return ctest_result("cjson_file_test");
+}
@@ -0,0 +1,187 @@
+/************************************************************************************
+* cjson_frozen_test.c: Implementation File
+*
+* frozen image regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   an image reads back as the document it was frozen from, a corrupt
+*   image is rejected value by value, never read outside of.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_frozen_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_frozen_test -lpthread -lm
+
+static const tchar_t *_doc_text = _T("{\"id\": 12, \"pi\": -3.1415, \"ok\": true, \"no\": null, "
+    "\"name\": \"a string longer than inline\", \"list\": [1, \"s\", {\"k\": false}, []], \"empty\": {}}");
+
+// 1 if the frozen value is the document value
+static int _same(const cjson_frozen_t *fz, const cjson_fvalue_t *fv, const cjson_value_t *val)
+{
+    int64_t i = 0;
+    int64_t len = 0;
+    const tchar_t *s = NULL;
+    const tchar_t *key = NULL;
+    const cjson_fvalue_t *child = NULL;
+    cjson_value_t *vc = NULL;
+    cjson_number_t num;
+
+    if (fv == NULL || fv->value_type != val->value_type) {
+        return 0;
+    }
+
+    switch (val->value_type) {
+    case _cjson_value_number_:
+        return (cjson_frozen_number(fv, &num) == 0 && num.number == val->cjson_numval && fv->scale == val->cjson_numscale);
+    case _cjson_value_bool_:
+        return ((fv->__fv.boolval != 0) == (val->cjson_boolval != 0));
+    case _cjson_value_string_:
+        s = cjson_frozen_string(fz, fv, &len);
+        return (s && len == cjson_value_strlen(val) && memcmp(s, cjson_value_str(val), len * sizeof(tchar_t)) == 0);
+    case _cjson_value_array_:
+        if ((int64_t)fv->len != val->cjson_arrval->count) {
+            return 0;
+        }
+        for (i = 0; i < val->cjson_arrval->count; i++) {
+            if (!_same(fz, cjson_frozen_array_at(fz, fv, i), cjson_array_get(val->cjson_arrval, i))) {
+                return 0;
+            }
+        }
+        return (cjson_frozen_array_at(fz, fv, i) == NULL);
+    case _cjson_value_object_:
+        if ((int64_t)fv->len != val->cjson_objval->count) {
+            return 0;
+        }
+        for (i = 0; i < val->cjson_objval->count; i++) {
+            child = cjson_frozen_object_at(fz, fv, i, &key);
+            vc = &(val->cjson_objval->vals[i]);
+            if (child == NULL || strcmp(key, cjson_object_key(val->cjson_objval, vc, NULL)) != 0 || !_same(fz, child, vc)
+                || cjson_frozen_object_get(fz, fv, key) != child) {
+                return 0;
+            }
+        }
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+// reads every value it can reach, the result doesn't matter
+static void _walk(const cjson_frozen_t *fz, const cjson_fvalue_t *fv, int depth)
+{
+    int64_t i = 0;
+    int64_t len = 0;
+    const tchar_t *key = NULL;
+    const cjson_fvalue_t *child = NULL;
+    cjson_number_t num;
+
+    if (fv == NULL || depth > 8) {
+        return;
+    }
+
+    cjson_frozen_number(fv, &num);
+    cjson_frozen_string(fz, fv, &len);
+
+    for (i = 0; i < (int64_t)fv->len && i < 16; i++) {
+        child = cjson_frozen_object_at(fz, fv, i, &key);
+        if (child) {
+            cjson_frozen_object_get(fz, fv, key);
+        }
+        _walk(fz, child, depth + 1);
+        _walk(fz, cjson_frozen_array_at(fz, fv, i), depth + 1);
+    }
+}
+
+static void _test_round_trip(const cjson_t *json, const uint8_t *image, int64_t size)
+{
+    cjson_frozen_t fz;
+    cjson_value_t root_data;
+
+    root_data.value_type = _cjson_value_object_;
+    root_data.cjson_objval = json->object;
+
+    CTEST_CHECK(cjson_frozen_open(&fz, image, size) == 0);
+    CTEST_CHECK(_same(&fz, cjson_frozen_root(&fz), &root_data));
+    CTEST_CHECK(cjson_frozen_object_get(&fz, cjson_frozen_root(&fz), _T("missing")) == NULL);
+
+    CTEST_CHECK(cjson_frozen_open(&fz, image, size - 1) < 0);
+    CTEST_CHECK(cjson_frozen_open(&fz, image + 8, size - 8) < 0);
+}
+
+static void _test_corrupt(const uint8_t *image, int64_t size)
+{
+    int64_t i = 0;
+    int bit = 0;
+    uint8_t *bad = (uint8_t*)malloc(size);
+    cjson_frozen_header_t *hdr = (cjson_frozen_header_t*)bad;
+    cjson_fkv_t *kv = NULL;
+    const tchar_t *key = NULL;
+    cjson_frozen_t fz;
+    cjson_number_t num;
+
+    // the root's entries at an offset that wraps
+    memcpy(bad, image, size);
+    hdr->root.__fv.off = (uint64_t)-8;
+    CTEST_CHECK(cjson_frozen_open(&fz, bad, size) == 0);
+    CTEST_CHECK(cjson_frozen_object_at(&fz, cjson_frozen_root(&fz), 0, NULL) == NULL);
+    CTEST_CHECK(cjson_frozen_object_get(&fz, cjson_frozen_root(&fz), _T("id")) == NULL);
+
+    // not aligned
+    hdr->root.__fv.off = ((cjson_frozen_header_t*)image)->root.__fv.off + 4;
+    CTEST_CHECK(cjson_frozen_object_at(&fz, cjson_frozen_root(&fz), 0, NULL) == NULL);
+
+    // "id" is the first entry, a number, then "pi"
+    memcpy(bad, image, size);
+    kv = (cjson_fkv_t*)(bad + hdr->root.__fv.off);
+    CTEST_CHECK(cjson_frozen_open(&fz, bad, size) == 0);
+    CTEST_CHECK(cjson_frozen_number(&(kv[1].value), &num) == 0 && num.divisor == 10000);
+    kv[1].value.scale = CJSON_NUMBER_SCALE_MAX + 1;
+    CTEST_CHECK(cjson_frozen_number(&(kv[1].value), &num) < 0);
+
+    // a key without its '\0'
+    bad[kv[0].key_off + kv[0].key_len] = 'x';
+    CTEST_CHECK(cjson_frozen_object_at(&fz, cjson_frozen_root(&fz), 0, &key) == NULL);
+
+    // every single bit flip, read all that can be reached
+    for (i = 0; i < size; i++) {
+        for (bit = 0; bit < 8; bit++) {
+            memcpy(bad, image, size);
+            bad[i] ^= (uint8_t)(1 << bit);
+            if (cjson_frozen_open(&fz, bad, size) == 0) {
+                _walk(&fz, cjson_frozen_root(&fz), 0);
+            }
+        }
+    }
+
+    free(bad);
+}
+
+int main(void)
+{
+    int64_t size = 0;
+    uint8_t *image = NULL;
+    cjson_t json;
+
+    CTEST_CHECK(cjson_decode(_doc_text, &json) == 0);
+
+    size = cjson_freeze(&json, NULL, 0);
+    CTEST_CHECK(size > (int64_t)sizeof(cjson_frozen_header_t));
+    image = (uint8_t*)malloc(size);
+    CTEST_CHECK(cjson_freeze(&json, image, size - 1) < 0);
+    CTEST_CHECK(cjson_freeze(&json, image, size) == size);
+
+    _test_round_trip(&json, image, size);
+    _test_corrupt(image, size);
+
+    free(image);
+    cjson_object_free(json.object);
+
+    return ctest_result("cjson_frozen_test");
+}
@@ -0,0 +1,173 @@
+/************************************************************************************
+* cjson_hpp_test.cpp: Implementation File
+*
+* C++ layer regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   documents parsed into a pmr resource, walked, read with & without
+*   escapes, dumped & parsed again to the same document. Literal keys hash
+*   as the C side does, & find members of plain, indexed & shaped objects.
+*
+************************************************************************************/
+
+#include <cstring>
+#include <string>
+#include <cjson.hpp>
+#include "ctest.h"
+
+using namespace cjson::literals;
+
+//gcc -c -I.. ../cjson_*.c ../murmurhash.c ../chashmap.c && g++ -std=c++20 -I.. cjson_hpp_test.cpp *.o -o cjson_hpp_test -lpthread -lm
+
+static const char *_doc_text = "{\"id\": 7, \"pi\": 3.25, \"ok\": true, \"none\": null, "
+    "\"esc\": \"a\\\"b\\\\c\\u00e9\\n\", \"plain\": \"no escapes here\", \"list\": [1, \"two\", {\"k\": false}]}";
+
+// 1 if both documents hold the same values
+static int _equal(const cjson::document &a, const cjson::document &b)
+{
+    cjson_value_t va;
+    cjson_value_t vb;
+
+    va.value_type = _cjson_value_object_;
+    va.cjson_objval = a.get()->object;
+    vb.value_type = _cjson_value_object_;
+    vb.cjson_objval = b.get()->object;
+
+    return cjson_value_equal(&va, &vb);
+}
+
+static void _test_read(const cjson::document &doc)
+{
+    std::string buf;
+    size_t n = 0;
+    const char *keys[] = { "id", "pi", "ok", "none", "esc", "plain", "list" };
+
+    CTEST_CHECK(doc.size() == 7);
+    for (cjson::member m : doc) {
+        CTEST_CHECK(n < 7 && m.key == keys[n] && m.value);
+        n++;
+    }
+    CTEST_CHECK(n == 7);
+
+    CTEST_CHECK(doc["id"].as_int64() == 7);
+    CTEST_CHECK(doc["pi"].as_double() == 3.25);
+    CTEST_CHECK(!doc["pi"].get_int64());
+    CTEST_CHECK(doc["ok"].as_bool());
+    CTEST_CHECK(doc["none"].is_null());
+    CTEST_CHECK(!doc["missing"]);
+
+    // escaped in the document, decoded into buf
+    CTEST_CHECK(doc["esc"].as_raw_string() == "a\\\"b\\\\c\\u00e9\\n");
+    CTEST_CHECK(doc["esc"].get_string(buf) == std::string_view("a\"b\\c\xc3\xa9\n"));
+    CTEST_CHECK(buf == "a\"b\\c\xc3\xa9\n");
+    CTEST_CHECK(doc["esc"].as_string() == "a\"b\\c\xc3\xa9\n");
+
+    // no escapes, straight from the document
+    buf.clear();
+    CTEST_CHECK(doc["plain"].get_string(buf)->data() == doc["plain"].as_raw_string().data());
+    CTEST_CHECK(buf.empty());
+    CTEST_CHECK(!doc["id"].get_string(buf));
+
+    auto list = doc["list"].as_array();
+    CTEST_CHECK(list.size() == 3);
+    CTEST_CHECK(list[0].as_int64() == 1);
+    CTEST_CHECK(list[1].as_string() == "two");
+    CTEST_CHECK(list[2]["k"].is_bool() && !list[2]["k"].as_bool());
+    CTEST_CHECK(!list[3]);
+    CTEST_CHECK(list.end() - list.begin() == 3);
+
+    try {
+        doc["id"].as_string();
+        CTEST_CHECK(0);
+    } catch (const cjson::error&) {
+    }
+}
+
+static void _test_pmr(void)
+{
+    char arena[16 * 1024];
+    std::pmr::monotonic_buffer_resource mr(arena, sizeof(arena));
+    cjson::resource_allocator alloc(&mr);
+    cjson_alloc_stats_t stats;
+
+    {
+        cjson::document doc = cjson::document::parse(_doc_text, alloc);
+        cjson::document again;
+
+        _test_read(doc);
+
+        again = cjson::document::parse(doc.dump());
+        CTEST_CHECK(_equal(doc, again));
+    }
+
+    // every node went through the resource & came back
+    cjson_allocator_stats(alloc.get(), &stats);
+    CTEST_CHECK(stats.allocs > 0 && stats.allocs == stats.frees && stats.live_bytes == 0);
+}
+
+static void _test_bad(void)
+{
+    const char *bad[] = { "[1, 2]", "\"s\"", "7", "", "{\"a\": 1" };
+
+    for (const char *text : bad) {
+        try {
+            cjson::document doc = cjson::document::parse(text);
+            CTEST_CHECK(0);
+        } catch (const cjson::error&) {
+        }
+    }
+}
+
+// compile time hash == run time hash, & the lookups through it
+static void _test_key(int flags, cjson_shape_cache_t *shapes)
+{
+    std::string text = "{\"id\": 1, \"user_id\": 2, \"a_rather_long_key_name_here\": 3";
+    cjson_decode_opt_t opt{};
+    cjson_t json{ nullptr };
+    constexpr cjson::key k = "user_id"_key;
+
+    // past CJSON_OBJECT_INDEX_MIN keys for an index
+    for (int i = 0; i < CJSON_OBJECT_INDEX_MIN; i++) {
+        text += ", \"k" + std::to_string(i) + "\": " + std::to_string(i);
+    }
+    text += "}";
+
+    CTEST_CHECK(k.hash() == murmurhash3_32("user_id", 7, CJSON_KEY_HASH_SEED));
+    CTEST_CHECK("a_rather_long_key_name_here"_key.hash() == murmurhash3_32("a_rather_long_key_name_here", 27, CJSON_KEY_HASH_SEED));
+
+    opt.flags = flags;
+    opt.shapes = shapes;
+    CTEST_CHECK(cjson_decode_ex(text.c_str(), &json, &opt) == 0);
+    cjson::document doc(json);
+
+    const cjson_value_t *v = cjson_object_get_value_h(doc.get()->object, k.str().data(), static_cast<int64_t>(k.str().size()), k.hash());
+    CTEST_CHECK(v && v == doc["user_id"].get());
+    CTEST_CHECK(doc[k].get_int64() == 2);
+    CTEST_CHECK(doc["id"_key].get_int64() == 1);
+    CTEST_CHECK(doc["a_rather_long_key_name_here"_key].get_int64() == 3);
+    CTEST_CHECK(doc["k15"_key].get_int64() == 15);
+    CTEST_CHECK(!doc["user"_key] && !doc["user_idx"_key]);
+}
+
+int main(void)
+{
+    cjson_shape_cache_t *shapes = cjson_shape_cache_create();
+
+    cjson::document doc = cjson::document::parse(std::string(_doc_text));
+
+    _test_read(doc);
+    _test_pmr();
+    _test_bad();
+
+    _test_key(0, nullptr);
+    _test_key(CJSON_DECODE_INDEX, nullptr);
+    // the second document of the layout is shaped
+    _test_key(0, shapes);
+    _test_key(CJSON_DECODE_INDEX, shapes);
+    cjson_shape_cache_free(shapes);
+
+    return ctest_result("cjson_hpp_test");
+}
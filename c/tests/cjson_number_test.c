@@ -0,0 +1,88 @@
+/************************************************************************************
+* cjson_number_test.c: Implementation File
+*
+* number scanner regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   int64 limits, scale clamping, huge exponents & values that must fail.
+*
+************************************************************************************/
+
+#include <string.h>
+#include <time.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_number_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_number_test -lpthread -lm
+
+static void _check_number(const tchar_t *text, int64_t numval, int scale)
+{
+    cjson_value_t val;
+    int64_t ret = cjson_scan_number(text, &val);
+
+    CTEST_CHECK(ret == (int64_t)strlen(text));
+    CTEST_CHECK(ret < 0 || val.cjson_numval == numval);
+    CTEST_CHECK(ret < 0 || val.cjson_numscale == scale);
+    if (ret >= 0 && (val.cjson_numval != numval || val.cjson_numscale != scale)) {
+        fprintf(stderr, "  %s: %lld / 10^%d\n", text, (long long)val.cjson_numval, val.cjson_numscale);
+    }
+}
+
+static void _check_fails(const tchar_t *text)
+{
+    cjson_value_t val;
+    cjson_t json;
+    tchar_t doc[128];
+
+    CTEST_CHECK(cjson_scan_number(text, &val) < 0);
+
+    snprintf(doc, sizeof(doc), "{\"n\": %s}", text);
+    CTEST_CHECK(cjson_decode(doc, &json) != 0);
+}
+
+int main(void)
+{
+    clock_t t = 0;
+
+    _check_number(_T("0"), 0, 0);
+    _check_number(_T("-0.5"), -5, 1);
+    _check_number(_T("+30"), 30, 0);
+    _check_number(_T("-10000.98e-3"), -1000098, 5);
+    _check_number(_T("1.25e2"), 125, 0);
+    _check_number(_T("1.5e1"), 15, 0);
+    _check_number(_T("9223372036854775807"), INT64_MAX, 0);
+    _check_number(_T("-9223372036854775808"), INT64_MIN, 0);
+    _check_number(_T("922337203685477580.7e1"), INT64_MAX, 0);
+    _check_number(_T("1e18"), 1000000000000000000ll, 0);
+
+    // digits past int64 in the fraction are dropped
+    _check_number(_T("1.00000000000000000000001"), 1000000000000000000ll, 18);
+    // integer digits past int64 count, a negative exponent brings them back
+    _check_number(_T("92233720368547758070e-1"), INT64_MAX, 0);
+
+    // scale clamps, tiny values are 0
+    _check_number(_T("1e-18"), 1, 18);
+    _check_number(_T("1e-19"), 0, 18);
+    _check_number(_T("123e-20"), 1, 18);
+    _check_number(_T("0e999999999999"), 0, 0);
+    _check_number(_T("0.000e5"), 0, 0);
+
+    // huge exponents saturate, no loop per unit
+    t = clock();
+    _check_number(_T("1e-2000000000"), 0, 18);
+    _check_number(_T("1e-99999999999999999999999"), 0, 18);
+    CTEST_CHECK(clock() - t < CLOCKS_PER_SEC / 10);
+
+    // no wrapping
+    _check_fails(_T("1e19"));
+    _check_fails(_T("9223372036854775808"));
+    _check_fails(_T("-9223372036854775809"));
+    _check_fails(_T("99999999999999999999"));
+    _check_fails(_T("1e2000000000"));
+    _check_fails(_T("0.1e20"));
+
+    return ctest_result("cjson_number_test");
+}
@@ -0,0 +1,178 @@
+/************************************************************************************
+* cjson_object_test.c: Implementation File
+*
+* object regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   the key index has to agree with a plain scan as keys are removed,
+*   duplicate keys included. Both iterators see the same entries.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cjson.h>
+#include <chashmap.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_object_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_object_test -lpthread -lm
+
+#define _key_count_                 24
+
+// the value of key, from the index of a & by a scan of b
+static void _check_same(cjson_object_t *a, cjson_object_t *b, const tchar_t *key)
+{
+    cjson_value_t *va = cjson_object_get_value(a, key);
+    cjson_value_t *vb = cjson_object_get_value(b, key);
+
+    CTEST_CHECK((va == NULL) == (vb == NULL));
+    CTEST_CHECK(va == NULL || va->cjson_numval == vb->cjson_numval);
+}
+
+static void _test_index_remove(cjson_shape_cache_t *shapes)
+{
+    tchar_t text[1024];
+    tchar_t key[16];
+    int64_t off = 0;
+    int64_t i = 0;
+    int64_t k = 0;
+    cjson_decode_opt_t opt;
+    cjson_t indexed;
+    cjson_t plain;
+
+    // k0 .. k23, then k3 & k5 again
+    off += snprintf(text + off, sizeof(text) - off, "{");
+    for (i = 0; i < _key_count_; i++) {
+        off += snprintf(text + off, sizeof(text) - off, "\"k%lld\": %lld, ", (long long)i, (long long)i);
+    }
+    snprintf(text + off, sizeof(text) - off, "\"k3\": 103, \"k5\": 105}");
+
+    memset(&opt, 0, sizeof(opt));
+    opt.flags = CJSON_DECODE_INDEX;
+    opt.shapes = shapes;
+    CTEST_CHECK(cjson_decode_ex(text, &indexed, &opt) == 0);
+    CTEST_CHECK(cjson_decode(text, &plain) == 0);
+    CTEST_CHECK(indexed.object->index != NULL);
+    CTEST_CHECK(plain.object->index == NULL);
+
+    for (k = 0; k < 12; k++) {
+        // removes the first k3 & the first k5, then the others
+        snprintf(key, sizeof(key), "k%lld", (long long)((k * 7) % _key_count_));
+        if (k == 4) {
+            strcpy(key, "k3");
+        }
+        CTEST_CHECK(cjson_object_remove(indexed.object, key, NULL) == cjson_object_remove(plain.object, key, NULL));
+
+        for (i = 0; i < _key_count_; i++) {
+            snprintf(key, sizeof(key), "k%lld", (long long)i);
+            _check_same(indexed.object, plain.object, key);
+        }
+    }
+    CTEST_CHECK(indexed.object->index != NULL);
+    CTEST_CHECK(chashmap_count(indexed.object->index) <= indexed.object->count);
+
+    cjson_object_free(indexed.object);
+    cjson_object_free(plain.object);
+}
+
+// kv entries & values in place agree, for plain & shaped objects
+static void _test_iterate(cjson_shape_cache_t *shapes)
+{
+    const tchar_t *text = _T("{\"id\": 1, \"a_rather_long_key_name_here\": 2, \"s\": \"x\"}");
+    int64_t len = 0;
+    int64_t n = 0;
+    int64_t m = 0;
+    const tchar_t *key = NULL;
+    cjson_kv_t *kv = NULL;
+    cjson_kv_t *inner_kv = NULL;
+    cjson_value_t *val = NULL;
+    cjson_kv_t outer;
+    cjson_kv_t inner;
+    position_t pos;
+    position_t vpos;
+    position_t ipos;
+    cjson_decode_opt_t opt;
+    cjson_t json;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.shapes = shapes;
+    CTEST_CHECK(cjson_decode_ex(text, &json, &opt) == 0);
+
+    kv = cjson_object_first(json.object, &pos, &outer);
+    val = cjson_object_first_value(json.object, &vpos);
+    for (; kv && val; n++) {
+        key = cjson_object_key(json.object, val, &len);
+        CTEST_CHECK(kv == &outer);
+        CTEST_CHECK(cjson_kv_keylen(kv) == len);
+        CTEST_CHECK(memcmp(cjson_kv_key(kv), key, len * sizeof(tchar_t)) == 0);
+        CTEST_CHECK(kv->value.value_type == val->value_type);
+
+        // a nested loop over the same object leaves the outer entry as it was
+        for (m = 0, inner_kv = cjson_object_first(json.object, &ipos, &inner); inner_kv; m++) {
+            inner_kv = cjson_object_next(json.object, &ipos, &inner);
+        }
+        CTEST_CHECK(m == 3);
+        CTEST_CHECK(cjson_kv_keylen(kv) == len && memcmp(cjson_kv_key(kv), key, len * sizeof(tchar_t)) == 0);
+
+        kv = cjson_object_next(json.object, &pos, &outer);
+        val = cjson_object_next_value(json.object, &vpos);
+    }
+    CTEST_CHECK(kv == NULL && val == NULL && n == 3);
+
+    cjson_object_free(json.object);
+}
+
+// bytes past ASCII between tokens are skipped like other unknown chars
+static void _test_non_ascii(void)
+{
+    cjson_t json;
+
+    CTEST_CHECK(cjson_decode(_T("{\"a\": 1, \xc3\xa9 \"b\": \"\xc3\xa9\"}"), &json) == 0);
+    CTEST_CHECK(cjson_object_get_value(json.object, _T("b")) != NULL);
+    cjson_object_free(json.object);
+}
+
+// every buffer shorter than the text is too small, nothing written past it
+static void _test_encode_short(void)
+{
+    const tchar_t *text = _T("{\"k\":null,\"a\":[1,true,\"s\"],\"o\":{}}");
+    int64_t len = (int64_t)strlen(text);
+    int64_t n = 0;
+    tchar_t *buf = NULL;
+    cjson_t json;
+
+    CTEST_CHECK(cjson_decode(text, &json) == 0);
+
+    for (n = 0; n < len; n++) {
+        buf = (tchar_t*)malloc((n ? n : 1) * sizeof(tchar_t));
+        CTEST_CHECK(cjson_encode(&json, buf, n) == CJSON_ENCODE_SHORT);
+        free(buf);
+    }
+
+    buf = (tchar_t*)malloc(len * sizeof(tchar_t));
+    CTEST_CHECK(cjson_encode(&json, buf, len) == len && memcmp(buf, text, len * sizeof(tchar_t)) == 0);
+    free(buf);
+
+    cjson_object_free(json.object);
+}
+
+int main(void)
+{
+    cjson_shape_cache_t *shapes = cjson_shape_cache_create();
+
+    _test_index_remove(NULL);
+    // twice, the second document is shaped
+    _test_index_remove(shapes);
+    _test_index_remove(shapes);
+    _test_iterate(NULL);
+    _test_iterate(shapes);
+    _test_iterate(shapes);
+    cjson_shape_cache_free(shapes);
+    _test_non_ascii();
+    _test_encode_short();
+
+    return ctest_result("cjson_object_test");
+}
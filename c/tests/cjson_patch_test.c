@@ -0,0 +1,139 @@
+/************************************************************************************
+* cjson_patch_test.c: Implementation File
+*
+* patch, merge patch & diff regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   a patch that fails part way leaves the document & its shared versions
+*   as they were, the diff of two documents patches one into the other.
+*
+************************************************************************************/
+
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_patch_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_patch_test -lpthread -lm
+
+static const tchar_t *_doc_text = _T("{\"a\": 1, \"b\": {\"c\": [1, 2, 3], \"d\": \"a string longer than inline\"}, \"e\": [{\"f\": 1}]}");
+
+// 1 if the document is the one of text
+static int _is(const cjson_t *json, const tchar_t *text)
+{
+    int ret = 0;
+    cjson_t expect;
+    cjson_value_t a;
+    cjson_value_t b;
+
+    if (cjson_decode(text, &expect) < 0) {
+        return 0;
+    }
+
+    a.value_type = _cjson_value_object_;
+    a.cjson_objval = json->object;
+    b.value_type = _cjson_value_object_;
+    b.cjson_objval = expect.object;
+    ret = cjson_value_equal(&a, &b);
+
+    cjson_object_free(expect.object);
+
+    return ret;
+}
+
+// {"p": ops} => ops applied to the document of text, 1 if it ends as expect
+static int _patch(const tchar_t *text, const tchar_t *ops, int ok, const tchar_t *expect)
+{
+    int ret = 0;
+    cjson_t json;
+    cjson_t shared;
+    cjson_t patch;
+    cjson_value_t *p = NULL;
+
+    if (cjson_decode(text, &json) < 0 || cjson_decode(ops, &patch) < 0) {
+        return 0;
+    }
+    cjson_share(&json, &shared);
+
+    p = cjson_object_get_value(patch.object, _T("p"));
+    if (p && p->value_type == _cjson_value_array_) {
+        ret = ((cjson_patch_apply(&json, p->cjson_arrval) == 0) == ok);
+    } else if (p && p->value_type == _cjson_value_object_) {
+        ret = ((cjson_merge_patch_apply(&json, p->cjson_objval) == 0) == ok);
+    }
+
+    ret = ret && _is(&json, expect) && _is(&shared, text);
+
+    cjson_object_free(json.object);
+    cjson_object_free(shared.object);
+    cjson_object_free(patch.object);
+
+    return ret;
+}
+
+static void _test_patch(void)
+{
+    CTEST_CHECK(_patch(_doc_text,
+        _T("{\"p\": [{\"op\": \"add\", \"path\": \"/b/c/1\", \"value\": 9}, {\"op\": \"remove\", \"path\": \"/a\"}]}"), 1,
+        _T("{\"b\": {\"c\": [1, 9, 2, 3], \"d\": \"a string longer than inline\"}, \"e\": [{\"f\": 1}]}")));
+
+    CTEST_CHECK(_patch(_doc_text,
+        _T("{\"p\": [{\"op\": \"move\", \"from\": \"/e/0/f\", \"path\": \"/g\"}, {\"op\": \"copy\", \"from\": \"/b/d\", \"path\": \"/h\"}]}"), 1,
+        _T("{\"a\": 1, \"b\": {\"c\": [1, 2, 3], \"d\": \"a string longer than inline\"}, \"e\": [{}], \"g\": 1, \"h\": \"a string longer than inline\"}")));
+
+    // the last op fails, the first ones are undone
+    CTEST_CHECK(_patch(_doc_text,
+        _T("{\"p\": [{\"op\": \"replace\", \"path\": \"/b/c/0\", \"value\": 7}, {\"op\": \"remove\", \"path\": \"/e/0/f\"}, {\"op\": \"test\", \"path\": \"/a\", \"value\": 2}]}"), 0,
+        _doc_text));
+    CTEST_CHECK(_patch(_doc_text,
+        _T("{\"p\": [{\"op\": \"add\", \"path\": \"/x\", \"value\": {}}, {\"op\": \"remove\", \"path\": \"/nothing\"}]}"), 0,
+        _doc_text));
+    CTEST_CHECK(_patch(_doc_text,
+        _T("{\"p\": [{\"op\": \"remove\", \"path\": \"/b/c/2\"}, {\"op\": \"move\", \"from\": \"/b\", \"path\": \"/b/c\"}]}"), 0,
+        _doc_text));
+    CTEST_CHECK(_patch(_doc_text,
+        _T("{\"p\": [{\"op\": \"remove\", \"path\": \"/a\"}, 5]}"), 0,
+        _doc_text));
+}
+
+static void _test_merge(void)
+{
+    CTEST_CHECK(_patch(_doc_text,
+        _T("{\"p\": {\"a\": null, \"b\": {\"c\": \"x\", \"n\": {\"m\": true}}}}"), 1,
+        _T("{\"b\": {\"c\": \"x\", \"d\": \"a string longer than inline\", \"n\": {\"m\": true}}, \"e\": [{\"f\": 1}]}")));
+}
+
+static void _test_diff(const tchar_t *from_text, const tchar_t *to_text)
+{
+    cjson_t from;
+    cjson_t to;
+    cjson_array_t *patch = NULL;
+
+    CTEST_CHECK(cjson_decode(from_text, &from) == 0);
+    CTEST_CHECK(cjson_decode(to_text, &to) == 0);
+
+    patch = cjson_diff(&from, &to);
+    CTEST_CHECK(patch != NULL);
+    if (patch) {
+        CTEST_CHECK(cjson_patch_apply(&from, patch) == 0);
+        CTEST_CHECK(_is(&from, to_text));
+        cjson_array_free(patch);
+    }
+
+    cjson_object_free(from.object);
+    cjson_object_free(to.object);
+}
+
+int main(void)
+{
+    _test_patch();
+    _test_merge();
+
+    _test_diff(_doc_text, _doc_text);
+    _test_diff(_doc_text, _T("{\"a\": 2, \"b\": {\"c\": [1, 3], \"d\": \"short\"}, \"n\": null}"));
+    _test_diff(_T("{\"a\": [1, 2, 3, 4, 5]}"), _T("{\"a\": [5, {\"k\": [true]}], \"b~/\": 1}"));
+
+    return ctest_result("cjson_patch_test");
+}
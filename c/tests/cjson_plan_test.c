@@ -0,0 +1,137 @@
+/************************************************************************************
+* cjson_plan_test.c: Implementation File
+*
+* encode plan regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   an object of the plan's shape encodes as cjson_encode() does, bound to
+*   a shape or not, one that doesn't fit is left to cjson_encode(), a short
+*   buffer is never written past.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_plan_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_plan_test -lpthread -lm
+
+#define _buf_size_                      1024
+
+static const tchar_t *_plan_keys[] = { _T("id"), _T("name"), _T("q\"t"), _T("tags"), _T("any") };
+static const cjson_valuetype_e _plan_types[] = {
+    _cjson_value_number_, _cjson_value_string_, _cjson_value_bool_, _cjson_value_array_, _cjson_value_unknown_,
+};
+
+// the plan's encode, or cjson_encode() if the object doesn't fit, 1 if it
+// is what cjson_encode() gives, planned tells which it was
+static int _encode(const cjson_plan_t *plan, const cjson_t *json, int *planned)
+{
+    tchar_t expect[_buf_size_];
+    tchar_t buf[_buf_size_];
+    int64_t len = cjson_encode(json, expect, _buf_size_);
+    int64_t n = cjson_plan_encode(plan, json->object, buf, _buf_size_);
+
+    *planned = (n != -1);
+    if (n == -1) {
+        n = cjson_encode(json, buf, _buf_size_);
+    }
+
+    return (len > 0 && n == len && memcmp(buf, expect, len * sizeof(tchar_t)) == 0);
+}
+
+static void _test_match(const cjson_plan_t *plan, cjson_shape_cache_t *shapes)
+{
+    const tchar_t *docs[] = {
+        _T("{\"id\": 1, \"name\": \"n\", \"q\\\"t\": true, \"tags\": [1, {\"a\": null}], \"any\": {\"x\": 1.50}}"),
+        _T("{\"id\": -2.5, \"name\": \"a string longer than inline\", \"q\\\"t\": false, \"tags\": [], \"any\": \"s\"}"),
+        // null fits any type
+        _T("{\"id\": null, \"name\": null, \"q\\\"t\": null, \"tags\": null, \"any\": null}"),
+    };
+    size_t i = 0;
+    int planned = 0;
+    cjson_decode_opt_t opt;
+    cjson_t json;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.shapes = shapes;
+
+    for (i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+        CTEST_CHECK(cjson_decode_ex(docs[i], &json, &opt) == 0);
+        CTEST_CHECK(_encode(plan, &json, &planned) && planned);
+        cjson_object_free(json.object);
+    }
+}
+
+static void _test_fallback(const cjson_plan_t *plan)
+{
+    const tchar_t *docs[] = {
+        _T("{\"name\": \"n\", \"id\": 1, \"q\\\"t\": true, \"tags\": [], \"any\": 0}"),
+        _T("{\"id\": 1, \"name\": \"n\", \"q\\\"t\": true, \"tags\": []}"),
+        _T("{\"id\": 1, \"name\": \"n\", \"q\\\"t\": true, \"tags\": [], \"any\": 0, \"more\": 0}"),
+        _T("{\"id\": 1, \"name\": 5, \"q\\\"t\": true, \"tags\": [], \"any\": 0}"),
+        _T("{\"id\": 1, \"name\": \"n\", \"qt\": true, \"tags\": [], \"any\": 0}"),
+        _T("{}"),
+    };
+    size_t i = 0;
+    int planned = 0;
+    cjson_t json;
+
+    for (i = 0; i < sizeof(docs) / sizeof(docs[0]); i++) {
+        CTEST_CHECK(cjson_decode(docs[i], &json) == 0);
+        CTEST_CHECK(_encode(plan, &json, &planned) && !planned);
+        cjson_object_free(json.object);
+    }
+}
+
+// every buffer shorter than the text is short, none is written past
+static void _test_short(const cjson_plan_t *plan)
+{
+    const tchar_t *text = _T("{\"id\": 1, \"name\": \"n\", \"q\\\"t\": true, \"tags\": [1, 2], \"any\": \"a string longer than inline\"}");
+    tchar_t full[_buf_size_];
+    tchar_t *buf = NULL;
+    int64_t len = 0;
+    int64_t n = 0;
+    int64_t shorts = 0;
+    cjson_t json;
+
+    CTEST_CHECK(cjson_decode(text, &json) == 0);
+    len = cjson_plan_encode(plan, json.object, full, _buf_size_);
+    CTEST_CHECK(len > 0);
+
+    for (n = 0; n < len; n++) {
+        buf = (tchar_t*)malloc((n ? n : 1) * sizeof(tchar_t));
+        shorts += (cjson_plan_encode(plan, json.object, buf, n) == CJSON_ENCODE_SHORT);
+        free(buf);
+    }
+    CTEST_CHECK(shorts == len);
+
+    cjson_object_free(json.object);
+}
+
+int main(void)
+{
+    int64_t count = (int64_t)(sizeof(_plan_keys) / sizeof(_plan_keys[0]));
+    cjson_plan_t *plan = cjson_plan_compile(_plan_keys, _plan_types, count);
+    cjson_shape_cache_t *shapes = cjson_shape_cache_create();
+
+    CTEST_CHECK(plan != NULL && shapes != NULL);
+
+    _test_match(plan, NULL);
+    _test_fallback(plan);
+    _test_short(plan);
+
+    // objects of the bound shape skip the key check
+    CTEST_CHECK(cjson_plan_bind(plan, shapes) == 0);
+    _test_match(plan, shapes);
+    _test_fallback(plan);
+
+    cjson_plan_free(plan);
+    cjson_shape_cache_free(shapes);
+
+    return ctest_result("cjson_plan_test");
+}
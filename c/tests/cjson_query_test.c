@@ -0,0 +1,79 @@
+/************************************************************************************
+* cjson_query_test.c: Implementation File
+*
+* query regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   indexes past the int64 range don't compile, indexes past the array
+*   match nothing, on the document & on the text alike.
+*
+************************************************************************************/
+
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_query_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_query_test -lpthread -lm
+
+static int _count_cb(void *ctx, int64_t query, const cjson_value_t *val)
+{
+    (void)query;
+    (void)val;
+    (*(int64_t*)ctx)++;
+    return 0;
+}
+
+static int _count_text_cb(void *ctx, int64_t query, const tchar_t *text, int64_t len)
+{
+    (void)query;
+    (void)text;
+    (void)len;
+    (*(int64_t*)ctx)++;
+    return 0;
+}
+
+// matches of expr on the document & on the text, -1 if it doesn't compile
+static int64_t _matches(const tchar_t *text, cjson_t *json, const tchar_t *expr)
+{
+    int64_t n = 0;
+    int64_t n_text = 0;
+    cjson_query_t *q = cjson_query_compile(expr);
+
+    if (q == NULL) {
+        return -1;
+    }
+
+    CTEST_CHECK(cjson_query_exec(json, q, _count_cb, &n) == n);
+    CTEST_CHECK(cjson_query_exec_text(text, q, _count_text_cb, &n_text) == n_text);
+    CTEST_CHECK(n == n_text);
+    cjson_query_free(q);
+
+    return n;
+}
+
+int main(void)
+{
+    const tchar_t *text = _T("{\"a\": [10, 20, 30], \"18446744073709551616\": 1}");
+    cjson_t json;
+
+    CTEST_CHECK(cjson_decode(text, &json) == 0);
+
+    CTEST_CHECK(_matches(text, &json, _T("$.a[2]")) == 1);
+    CTEST_CHECK(_matches(text, &json, _T("$.a[3]")) == 0);
+    CTEST_CHECK(_matches(text, &json, _T("$.a[9223372036854775807]")) == 0);
+    CTEST_CHECK(_matches(text, &json, _T("$.a[9223372036854775808]")) < 0);
+    CTEST_CHECK(_matches(text, &json, _T("$.a[18446744073709551626]")) < 0);
+
+    CTEST_CHECK(_matches(text, &json, _T("/a/0")) == 1);
+    CTEST_CHECK(_matches(text, &json, _T("/a/3")) == 0);
+    // too large for an index, still a member name
+    CTEST_CHECK(_matches(text, &json, _T("/a/18446744073709551616")) == 0);
+    CTEST_CHECK(_matches(text, &json, _T("/18446744073709551616")) == 1);
+
+    cjson_object_free(json.object);
+
+    return ctest_result("cjson_query_test");
+}
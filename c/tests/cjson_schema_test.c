@@ -0,0 +1,133 @@
+/************************************************************************************
+* cjson_schema_test.c: Implementation File
+*
+* schema regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   documents decoded with a schema, each keyword accepts & rejects, the
+*   error offset points at the rejected value.
+*
+************************************************************************************/
+
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_schema_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_schema_test -lpthread -lm
+
+static const tchar_t *_schema_text = _T("{"
+    "\"type\": \"object\","
+    "\"required\": [\"id\", \"tags\"],"
+    "\"properties\": {"
+        "\"id\": {\"type\": \"integer\", \"minimum\": 1, \"exclusiveMaximum\": 1000},"
+        "\"name\": {\"type\": \"string\", \"minLength\": 2, \"maxLength\": 4},"
+        "\"kind\": {\"enum\": [\"a\", \"b\", 3]},"
+        "\"tags\": {\"type\": \"array\", \"maxItems\": 2, \"items\": {\"type\": \"string\"}},"
+        "\"sub\": {\"type\": [\"object\", \"null\"], \"required\": [\"x\"]}"
+    "}}");
+
+static cjson_schema_t *_schema = NULL;
+
+// 0 if text is valid, -1 if not, *offset is where
+static int _validate(const tchar_t *text, int64_t *offset)
+{
+    int ret = 0;
+    cjson_decode_opt_t opt;
+    cjson_t json;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.schema = _schema;
+    opt.error_offset = offset;
+    *offset = -1;
+
+    ret = cjson_decode_ex(text, &json, &opt);
+    if (ret == 0) {
+        cjson_object_free(json.object);
+    }
+
+    return ret;
+}
+
+// text is rejected at the value starting with at
+static int _rejected_at(const tchar_t *text, const tchar_t *at)
+{
+    int64_t offset = 0;
+
+    if (_validate(text, &offset) == 0) {
+        return 0;
+    }
+
+    return (offset == (int64_t)(strstr(text, at) - text));
+}
+
+static void _test_keywords(void)
+{
+    int64_t offset = 0;
+
+    CTEST_CHECK(_validate(_T("{\"id\": 1, \"tags\": []}"), &offset) == 0);
+    CTEST_CHECK(_validate(_T("{\"id\": 999, \"name\": \"abcd\", \"kind\": 3, \"tags\": [\"t\", \"u\"], \"sub\": {\"x\": 0}, \"other\": {}}"), &offset) == 0);
+    CTEST_CHECK(_validate(_T("{\"id\": 5, \"tags\": [], \"sub\": null, \"kind\": \"b\"}"), &offset) == 0);
+
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 0, \"tags\": []}"), _T("0,")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1000, \"tags\": []}"), _T("1000")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1.5, \"tags\": []}"), _T("1.5")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": \"1\", \"tags\": []}"), _T("\"1\"")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1, \"name\": \"a\", \"tags\": []}"), _T("\"a\"")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1, \"name\": \"abcde\", \"tags\": []}"), _T("\"abcde\"")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1, \"kind\": \"c\", \"tags\": []}"), _T("\"c\"")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1, \"tags\": [\"t\", 2]}"), _T("2]")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1, \"tags\": [\"t\", \"u\", \"v\"]}"), _T("[\"t\"")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1, \"tags\": [], \"sub\": {\"y\": 1}}"), _T("{\"y\"")));
+    CTEST_CHECK(_rejected_at(_T("{\"id\": 1, \"tags\": [], \"sub\": 7}"), _T("7}")));
+
+    // required, missing at the end of the document
+    CTEST_CHECK(_validate(_T("{\"id\": 1}"), &offset) < 0);
+    CTEST_CHECK(_validate(_T("{\"tags\": []}"), &offset) < 0);
+}
+
+static void _test_compile(const tchar_t *text, int ok)
+{
+    cjson_t doc;
+    cjson_schema_t *s = NULL;
+
+    CTEST_CHECK(cjson_decode(text, &doc) == 0);
+    s = cjson_schema_compile(&doc);
+    CTEST_CHECK((s != NULL) == ok);
+    if (s) {
+        cjson_schema_free(s);
+    }
+    cjson_object_free(doc.object);
+}
+
+int main(void)
+{
+    tchar_t text[4096];
+    int64_t off = 0;
+    int64_t i = 0;
+    cjson_t doc;
+
+    CTEST_CHECK(cjson_decode(_schema_text, &doc) == 0);
+    _schema = cjson_schema_compile(&doc);
+    CTEST_CHECK(_schema != NULL);
+    cjson_object_free(doc.object);
+    if (_schema) {
+        _test_keywords();
+        cjson_schema_free(_schema);
+    }
+
+    _test_compile(_T("{\"type\": \"nothing\"}"), 0);
+    _test_compile(_T("{\"properties\": {\"a\": 1}}"), 0);
+    _test_compile(_T("{\"required\": \"a\"}"), 0);
+
+    // more required properties than the bits of a node
+    for (i = 0; i <= CJSON_SCHEMA_REQUIRED_MAX; i++) {
+        off += snprintf(text + off, sizeof(text) - off, "%s\"p%lld\"", (i ? ", " : "{\"required\": ["), (long long)i);
+    }
+    snprintf(text + off, sizeof(text) - off, "]}");
+    _test_compile(text, 0);
+
+    return ctest_result("cjson_schema_test");
+}
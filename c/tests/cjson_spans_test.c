@@ -0,0 +1,136 @@
+/************************************************************************************
+* cjson_spans_test.c: Implementation File
+*
+* incremental encoding regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   a document decoded with CJSON_DECODE_SPANS & edited encodes as the
+*   same document decoded without spans & edited alike, the containers
+*   the edit didn't reach are copied from the source byte for byte.
+*
+************************************************************************************/
+
+#include <string.h>
+#include <cjson.h>
+#include "ctest.h"
+
+//gcc -I.. cjson_spans_test.c ../cjson_*.c ../murmurhash.c ../chashmap.c -o cjson_spans_test -lpthread -lm
+
+#define _buf_size_                      1024
+
+// the value of text, {"v": value}
+static int _value(const tchar_t *text, cjson_value_t *val)
+{
+    int ret = 0;
+    cjson_t json;
+
+    if (cjson_decode(text, &json) < 0) {
+        return -1;
+    }
+    ret = cjson_object_remove(json.object, _T("v"), val);
+    cjson_object_free(json.object);
+
+    return ret;
+}
+
+// member "m" of "c" of text's document set to value, encoded into buf
+static int64_t _edit_encode(const tchar_t *text, int flags, const tchar_t *value, tchar_t *buf)
+{
+    int64_t n = -1;
+    cjson_value_t *c = NULL;
+    cjson_value_t val;
+    cjson_decode_opt_t opt;
+    cjson_t json;
+
+    memset(&opt, 0, sizeof(opt));
+    opt.flags = flags;
+    if (cjson_decode_ex(text, &json, &opt) < 0) {
+        return -1;
+    }
+
+    c = cjson_object_get_value(json.object, _T("c"));
+    if (value == NULL) {
+        n = cjson_encode(&json, buf, _buf_size_);
+    } else if (c && _value(value, &val) == 0) {
+        if (cjson_object_set_value(c->cjson_objval, _T("m"), &val) == 0) {
+            n = cjson_encode(&json, buf, _buf_size_);
+        } else {
+            cjson_value_free(&val);
+        }
+    }
+
+    cjson_object_free(json.object);
+
+    return n;
+}
+
+// canonical text: every container copied or encoded gives the same chars
+static void _test_canonical(void)
+{
+    const tchar_t *text = _T("{\"a\":{\"x\":[1,2,3]},\"b\":[{\"y\":\"s\"},null],\"c\":{\"m\":1,\"n\":true},\"d\":1.50}");
+    const tchar_t *edits[] = {
+        _T("{\"v\": 2}"), _T("{\"v\": [7, {\"z\": \"w\"}]}"), _T("{\"v\": \"a string longer than inline\"}"),
+    };
+    tchar_t spans[_buf_size_];
+    tchar_t full[_buf_size_];
+    int64_t n = 0;
+    size_t i = 0;
+
+    // unedited, the root span
+    n = _edit_encode(text, CJSON_DECODE_SPANS, NULL, spans);
+    CTEST_CHECK(n == (int64_t)strlen(text) && memcmp(spans, text, n * sizeof(tchar_t)) == 0);
+
+    for (i = 0; i < sizeof(edits) / sizeof(edits[0]); i++) {
+        n = _edit_encode(text, CJSON_DECODE_SPANS, edits[i], spans);
+        CTEST_CHECK(n > 0);
+        CTEST_CHECK(_edit_encode(text, 0, edits[i], full) == n);
+        CTEST_CHECK(memcmp(spans, full, n * sizeof(tchar_t)) == 0);
+    }
+}
+
+// spaced text: the untouched containers keep their spaces, the edited
+// ones & their ancestors are encoded
+static void _test_untouched(void)
+{
+    const tchar_t *text = _T("{ \"a\" : { \"x\" :  [1,2 ,3] } ,\"b\": [ {\"y\":\"s\"} , null ], \"c\" : { \"m\" : 1 } }");
+    const tchar_t *edited = _T("{\"a\": {\"x\": [1, 2, 3]}, \"b\": [{\"y\": \"s\"}, null], \"c\": {\"m\": 2}}");
+    tchar_t spans[_buf_size_ + 1];
+    int64_t n = 0;
+    cjson_t a;
+    cjson_t b;
+    cjson_value_t va;
+    cjson_value_t vb;
+
+    n = _edit_encode(text, CJSON_DECODE_SPANS, _T("{\"v\": 2}"), spans);
+    CTEST_CHECK(n > 0);
+    if (n <= 0) {
+        return;
+    }
+    spans[n] = 0;
+
+    CTEST_CHECK(strstr(spans, _T("{ \"x\" :  [1,2 ,3] }")) != NULL);
+    CTEST_CHECK(strstr(spans, _T("[ {\"y\":\"s\"} , null ]")) != NULL);
+    CTEST_CHECK(strstr(spans, _T("\"c\" : {")) == NULL);
+    CTEST_CHECK(strstr(spans, _T("{ \"a\"")) == NULL);
+
+    CTEST_CHECK(cjson_decode(spans, &a) == 0);
+    CTEST_CHECK(cjson_decode(edited, &b) == 0);
+    va.value_type = _cjson_value_object_;
+    va.cjson_objval = a.object;
+    vb.value_type = _cjson_value_object_;
+    vb.cjson_objval = b.object;
+    CTEST_CHECK(cjson_value_equal(&va, &vb));
+    cjson_object_free(a.object);
+    cjson_object_free(b.object);
+}
+
+int main(void)
+{
+    _test_canonical();
+    _test_untouched();
+
+    return ctest_result("cjson_spans_test");
+}
@@ -0,0 +1,227 @@
+/************************************************************************************
+* csketch_test.c: Implementation File
+*
+* sketch regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   serialize round trips, & corrupt or hostile images that must be
+*   rejected without reading or allocating past what they hold.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <csketch.h>
+#include "ctest.h"
+
+//gcc -I.. -I../db csketch_test.c ../db/csketch.c ../chashmap.c ../murmurhash.c -o csketch_test -lm
+
+// the serialized header, as csketch.c writes it
+struct __test_hdr_t {
+    uint32_t    magic;
+    uint16_t    version;
+    uint16_t    type;
+    int64_t     a;
+    int64_t     b;
+    int64_t     c;
+    int64_t     d;
+    uint64_t    total;
+};
+typedef struct __test_hdr_t         _test_hdr_t;
+
+static csketch_hll_t* _hll_make(int p, int64_t n)
+{
+    csketch_hll_t *hll = csketch_hll_create(p);
+    int64_t i = 0;
+
+    for (i = 0; i < n; i++) {
+        csketch_hll_add(hll, &i, sizeof(i));
+    }
+
+    return hll;
+}
+
+static void _test_hll_round_trip(int64_t n)
+{
+    csketch_hll_t *hll = _hll_make(12, n);
+    csketch_hll_t *copy = NULL;
+    kvdbt_t t;
+
+    CTEST_CHECK(csketch_hll_serialize(hll, &t) == 0);
+    copy = csketch_hll_deserialize(&t);
+    CTEST_CHECK(copy != NULL);
+    CTEST_CHECK(copy && (copy->regs == NULL) == (hll->regs == NULL));
+    CTEST_CHECK(copy && csketch_hll_estimate(copy) == csketch_hll_estimate(hll));
+
+    free(t.data);
+    csketch_hll_free(copy);
+    csketch_hll_free(hll);
+}
+
+// byte at off set to v, must be rejected
+static void _check_hll_rejects(const kvdbt_t *t, size_t off, uint8_t v)
+{
+    kvdbt_t bad;
+
+    bad.size = t->size;
+    bad.data = malloc(t->size);
+    memcpy(bad.data, t->data, t->size);
+    ((uint8_t*)bad.data)[off] = v;
+    CTEST_CHECK(csketch_hll_deserialize(&bad) == NULL);
+    free(bad.data);
+}
+
+static void _test_hll_corrupt(void)
+{
+    csketch_hll_t *dense = _hll_make(12, 100000);
+    csketch_hll_t *sparse = _hll_make(12, 50);
+    kvdbt_t t;
+    kvdbt_t cut;
+    uint32_t e = 0;
+
+    CTEST_CHECK(dense->regs != NULL && sparse->regs == NULL);
+
+    // registers past 64 - p + 1
+    csketch_hll_serialize(dense, &t);
+    _check_hll_rejects(&t, sizeof(_test_hdr_t) + 7, 255);
+    _check_hll_rejects(&t, sizeof(_test_hdr_t), 64 - 12 + 2);
+    cut.data = t.data;
+    cut.size = t.size - 1;
+    CTEST_CHECK(csketch_hll_deserialize(&cut) == NULL);
+    free(t.data);
+
+    // sparse ranks past 64 - 25 + 1, indexes past 25 bits
+    csketch_hll_serialize(sparse, &t);
+    memcpy(&e, (uint8_t*)t.data + sizeof(_test_hdr_t), sizeof(e));
+    _check_hll_rejects(&t, sizeof(_test_hdr_t), (uint8_t)((e & ~0x3fu) | 41));
+    _check_hll_rejects(&t, sizeof(_test_hdr_t) + 3, 0xff);
+    cut.data = t.data;
+    cut.size = t.size - 2;
+    CTEST_CHECK(csketch_hll_deserialize(&cut) == NULL);
+    free(t.data);
+
+    csketch_hll_free(dense);
+    csketch_hll_free(sparse);
+}
+
+static void _test_cm_round_trip(void)
+{
+    csketch_cm_t *cm = csketch_cm_create(1 << 10, 4, 8);
+    csketch_cm_t *copy = NULL;
+    csketch_item_t a[8];
+    csketch_item_t b[8];
+    char key[16];
+    int64_t i = 0;
+    int64_t n = 0;
+    kvdbt_t t;
+
+    for (i = 0; i < 20000; i++) {
+        snprintf(key, sizeof(key), "k%lld", (long long)(i % 97) * (i % 5));
+        csketch_cm_add(cm, key, strlen(key), 1);
+    }
+
+    CTEST_CHECK(csketch_cm_serialize(cm, &t) == 0);
+    copy = csketch_cm_deserialize(&t);
+    CTEST_CHECK(copy != NULL);
+    if (copy) {
+        CTEST_CHECK(copy->total == cm->total);
+        CTEST_CHECK(csketch_cm_estimate(copy, "k0", 2) == csketch_cm_estimate(cm, "k0", 2));
+        n = csketch_cm_top(cm, a, 8);
+        CTEST_CHECK(csketch_cm_top(copy, b, 8) == n);
+        for (i = 0; i < n; i++) {
+            CTEST_CHECK(a[i].count == b[i].count && a[i].len == b[i].len && memcmp(a[i].key, b[i].key, a[i].len) == 0);
+        }
+    }
+
+    free(t.data);
+    csketch_cm_free(copy);
+    csketch_cm_free(cm);
+}
+
+static void _check_cm_hdr_rejects(int64_t width, int64_t depth, int64_t k, int64_t keys, size_t payload)
+{
+    kvdbt_t t;
+    _test_hdr_t hdr;
+    csketch_cm_t *cm = csketch_cm_create(4, 1, 0);
+
+    // a valid header to start from
+    csketch_cm_serialize(cm, &t);
+    memcpy(&hdr, t.data, sizeof(hdr));
+    free(t.data);
+    csketch_cm_free(cm);
+
+    hdr.a = width;
+    hdr.b = depth;
+    hdr.c = k;
+    hdr.d = keys;
+    t.size = sizeof(hdr) + payload;
+    t.data = calloc(1, t.size);
+    memcpy(t.data, &hdr, sizeof(hdr));
+    CTEST_CHECK(csketch_cm_deserialize(&t) == NULL);
+    free(t.data);
+}
+
+static void _test_cm_sizes(void)
+{
+    // width * depth * 8 wraps
+    CTEST_CHECK(csketch_cm_create((int64_t)1 << 62, 4, 0) == NULL);
+    CTEST_CHECK(csketch_cm_create((int64_t)1 << 40, (int64_t)1 << 30, 0) == NULL);
+    CTEST_CHECK(csketch_cm_create(0, 4, 0) == NULL);
+    CTEST_CHECK(csketch_cm_create(6, 4, 0) == NULL);
+    CTEST_CHECK(csketch_cm_create(8, 0, 0) == NULL);
+
+    // headers asking for more than the image holds, nothing allocated
+    _check_cm_hdr_rejects((int64_t)1 << 62, 4, 0, 0, 64);
+    _check_cm_hdr_rejects((int64_t)1 << 40, (int64_t)1 << 20, 0, 0, 64);
+    _check_cm_hdr_rejects(16, 4, 0, 0, 16 * 4 * 8 - 8);
+    _check_cm_hdr_rejects(16, -1, 0, 0, 64);
+    _check_cm_hdr_rejects(4, 1, 2, 3, 4 * 8);
+    _check_cm_hdr_rejects(4, 1, 2, 1, 4 * 8 + 4);
+}
+
+// every byte of an image flipped in turn: rejected or a sketch, no crash
+static void _test_flips(void)
+{
+    csketch_hll_t *hll = _hll_make(4, 30);
+    csketch_cm_t *cm = csketch_cm_create(8, 2, 2);
+    kvdbt_t t;
+    size_t i = 0;
+
+    csketch_cm_add(cm, "abc", 3, 5);
+    csketch_cm_add(cm, "de", 2, 7);
+
+    csketch_hll_serialize(hll, &t);
+    for (i = 0; i < t.size; i++) {
+        ((uint8_t*)t.data)[i] ^= 0xa5;
+        csketch_hll_free(csketch_hll_deserialize(&t));
+        ((uint8_t*)t.data)[i] ^= 0xa5;
+    }
+    free(t.data);
+
+    csketch_cm_serialize(cm, &t);
+    for (i = 0; i < t.size; i++) {
+        ((uint8_t*)t.data)[i] ^= 0x5a;
+        csketch_cm_free(csketch_cm_deserialize(&t));
+        ((uint8_t*)t.data)[i] ^= 0x5a;
+    }
+    free(t.data);
+
+    csketch_hll_free(hll);
+    csketch_cm_free(cm);
+    CTEST_CHECK(1);
+}
+
+int main(void)
+{
+    _test_hll_round_trip(50);
+    _test_hll_round_trip(100000);
+    _test_hll_corrupt();
+    _test_cm_round_trip();
+    _test_cm_sizes();
+    _test_flips();
+
+    return ctest_result("csketch_test");
+}
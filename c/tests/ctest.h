@@ -0,0 +1,37 @@
+/************************************************************************************
+* ctest.h : header file
+*
+* minimal checks for the regression tests
+*
+* AUTHOR    :    cjson contributors
+* DATE      :    Oct. 19, 2026
+*
+* REMARKS:
+*   a failed check prints where & carries on, main returns ctest_result().
+*
+************************************************************************************/
+
+#if !defined(__CTEST_H__)
+#define __CTEST_H__
+
+#include <stdio.h>
+
+static int _ctest_failed = 0;
+static int _ctest_checked = 0;
+
+#define CTEST_CHECK(cond)           do { \
+        _ctest_checked++; \
+        if (!(cond)) { \
+            _ctest_failed++; \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+        } \
+    } while (0)
+
+static int ctest_result(const char *name)
+{
+    printf("%s: %d checks, %d failed\n", name, _ctest_checked, _ctest_failed);
+
+    return _ctest_failed ? 1 : 0;
+}
+
+#endif /*__CTEST_H__*/
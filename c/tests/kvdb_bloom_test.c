@@ -0,0 +1,236 @@
+/************************************************************************************
+* kvdb_bloom_test.c: Implementation File
+*
+* bloom filter layer regression tests
+*
+* AUTHOR    :   cjson contributors
+* DATE      :   Oct. 19, 2026
+*
+* REMARKS:
+*   a memory engine with its own not found code behind the layer: no
+*   false negatives, the code mapped, errors passed through, & saved
+*   filters used only for the generation & db they were saved for.
+*
+************************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <cdb.h>
+#include "ctest.h"
+
+//gcc -I.. -I../db kvdb_bloom_test.c ../db/kvdb_bloom.c ../murmurhash.c -o kvdb_bloom_test -lpthread
+
+#define _key_range_                 20000
+#define _mem_notfound_              (-30988)
+#define _mem_error_                 (-5)
+#define _bloom_path_                "kvdb_bloom_test.bloom"
+
+// keys are ints below _key_range_, _mem_error_key_ fails
+#define _mem_error_key_             (_key_range_ - 1)
+
+static uint8_t _have[_key_range_];
+static int _cursor = 0;
+static int _cursor_key = 0;
+static int _engine_gets = 0;
+static int _scans = 0;
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int _mem_get(kvdb_t *db, const kvdbt_t *key, kvdbt_t *value)
+{
+    int k = *(const int*)key->data;
+    int ret = 0;
+
+    (void)db;
+    (void)value;
+    pthread_mutex_lock(&_lock);
+    _engine_gets++;
+    ret = (k == _mem_error_key_) ? _mem_error_ : (_have[k] ? 0 : _mem_notfound_);
+    pthread_mutex_unlock(&_lock);
+
+    return ret;
+}
+
+static int _mem_put(kvdb_t *db, const kvdbt_t *key, const kvdbt_t *value)
+{
+    (void)db;
+    (void)value;
+    pthread_mutex_lock(&_lock);
+    _have[*(const int*)key->data] = 1;
+    pthread_mutex_unlock(&_lock);
+
+    return 0;
+}
+
+static int _mem_del(kvdb_t *db, const kvdbt_t *key)
+{
+    int k = *(const int*)key->data;
+    int ret = 0;
+
+    (void)db;
+    pthread_mutex_lock(&_lock);
+    ret = _have[k] ? 0 : _mem_notfound_;
+    _have[k] = 0;
+    pthread_mutex_unlock(&_lock);
+
+    return ret;
+}
+
+static int _mem_reset_cursor(kvdb_t *db)
+{
+    (void)db;
+    _cursor = 0;
+    _scans++;
+
+    return 0;
+}
+
+static int _mem_traverse(kvdb_t *db, kvdbt_t *key, kvdbt_t *value)
+{
+    (void)db;
+    (void)value;
+    pthread_mutex_lock(&_lock);
+    while (_cursor < _key_range_ && !_have[_cursor]) {
+        _cursor++;
+    }
+    if (_cursor >= _key_range_) {
+        pthread_mutex_unlock(&_lock);
+        return _mem_notfound_;
+    }
+    _cursor_key = _cursor++;
+    pthread_mutex_unlock(&_lock);
+
+    key->data = &_cursor_key;
+    key->size = sizeof(int);
+
+    return 0;
+}
+
+static void _mem_open(kvdbe_t *dbe, kvdb_t *db, const char *name)
+{
+    memset(dbe, 0, sizeof(kvdbe_t));
+    dbe->notfound = _mem_notfound_;
+
+    memset(db, 0, sizeof(kvdb_t));
+    db->dbe = dbe;
+    db->name = name;
+    db->get = _mem_get;
+    db->put = _mem_put;
+    db->del = _mem_del;
+    db->reset_cursor = _mem_reset_cursor;
+    db->traverse = _mem_traverse;
+}
+
+static int _get(kvdb_t *db, int k)
+{
+    kvdbt_t key = { &k, sizeof(k) };
+    kvdbt_t value = { NULL, 0 };
+
+    return db->get(db, &key, &value);
+}
+
+static void _put(kvdb_t *db, int k)
+{
+    kvdbt_t key = { &k, sizeof(k) };
+    kvdbt_t value = { "x", 2 };
+
+    CTEST_CHECK(db->put(db, &key, &value) == 0);
+}
+
+static void _test_gets(void)
+{
+    kvdbe_t dbe;
+    kvdb_t mem;
+    kvdb_t db;
+    kvdb_bloom_stats_t st;
+    int i = 0;
+    int missing = 0;
+
+    memset(_have, 0, sizeof(_have));
+    for (i = 0; i < _key_range_ / 2; i++) {
+        _have[i] = 1;
+    }
+    _mem_open(&dbe, &mem, "test");
+    unlink(_bloom_path_);
+
+    CTEST_CHECK(kvdb_bloom_open(&db, &mem, _bloom_path_, 1, _key_range_, 10) == 0);
+    // no filter yet, the engine's code still comes back mapped
+    CTEST_CHECK(_get(&db, _key_range_ - 2) == _CDB_NOTFOUND_);
+    for (i = _key_range_ / 2; i < _key_range_ / 2 + 100; i++) {
+        _put(&db, i); // while the scan runs
+    }
+    CTEST_CHECK(kvdb_bloom_wait(&db) == 0);
+
+    // no false negatives
+    for (i = 0; i < _key_range_ / 2 + 100; i++) {
+        missing += (_get(&db, i) != 0);
+    }
+    CTEST_CHECK(missing == 0);
+
+    memset(&st, 0, sizeof(st));
+    kvdb_bloom_stats(&db, &st);
+    _engine_gets = 0;
+    for (i = _key_range_ / 2 + 100; i < _mem_error_key_; i++) {
+        CTEST_CHECK(_get(&db, i) == _CDB_NOTFOUND_);
+    }
+    kvdb_bloom_stats(&db, &st);
+    CTEST_CHECK(st.false_positives == _engine_gets);
+    CTEST_CHECK(st.false_positives < (_key_range_ / 2) / 20);
+
+    // an engine error is not a miss, & not a false positive
+    _put(&db, _mem_error_key_);
+    CTEST_CHECK(_get(&db, _mem_error_key_) == _mem_error_);
+    kvdb_bloom_stats(&db, &st);
+    CTEST_CHECK(st.false_positives == _engine_gets - 1);
+
+    CTEST_CHECK(kvdb_bloom_close(&db) == 0);
+    CTEST_CHECK(access(_bloom_path_, F_OK) == 0);
+}
+
+// a saved filter is used once, & only for its generation & db
+static void _test_saved(void)
+{
+    kvdbe_t dbe;
+    kvdb_t mem;
+    kvdb_t db;
+    int scans = 0;
+
+    _mem_open(&dbe, &mem, "test");
+
+    // written without the layer, the generation moved on
+    _have[_key_range_ - 3] = 1;
+    scans = _scans;
+    CTEST_CHECK(kvdb_bloom_open(&db, &mem, _bloom_path_, 2, _key_range_, 10) == 0);
+    CTEST_CHECK(kvdb_bloom_wait(&db) == 0);
+    CTEST_CHECK(_scans == scans + 1);
+    CTEST_CHECK(_get(&db, _key_range_ - 3) == 0);
+    CTEST_CHECK(kvdb_bloom_close(&db) == 0);
+
+    // the same generation, loaded, no scan
+    scans = _scans;
+    CTEST_CHECK(kvdb_bloom_open(&db, &mem, _bloom_path_, 2, _key_range_, 10) == 0);
+    CTEST_CHECK(access(_bloom_path_, F_OK) != 0);
+    CTEST_CHECK(kvdb_bloom_wait(&db) == 0);
+    CTEST_CHECK(_scans == scans);
+    CTEST_CHECK(_get(&db, _key_range_ - 3) == 0);
+    CTEST_CHECK(kvdb_bloom_close(&db) == 0);
+
+    // another db
+    _mem_open(&dbe, &mem, "other");
+    scans = _scans;
+    CTEST_CHECK(kvdb_bloom_open(&db, &mem, _bloom_path_, 2, _key_range_, 10) == 0);
+    CTEST_CHECK(kvdb_bloom_wait(&db) == 0);
+    CTEST_CHECK(_scans == scans + 1);
+    kvdb_bloom_close(&db);
+
+    unlink(_bloom_path_);
+}
+
+int main(void)
+{
+    _test_gets();
+    _test_saved();
+
+    return ctest_result("kvdb_bloom_test");
+}